@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <memory>
 
 #include "SceneBase.h"
@@ -17,6 +18,8 @@ enum eRendererType {
     RendererAVX = 4,
 	RendererNEON = 8,
     RendererOCL = 16,
+    RendererAVX2 = 32,
+    RendererAVX16 = 64,     ///< AVX2 with 4x4 ray packets, not included in default flags
 };
 
 /** Render region context,
@@ -27,7 +30,7 @@ class RegionContext {
     const rect_t rect_;
 public:
     int iteration = 0;                      ///< Number of rendered samples per pixel
-    std::unique_ptr<float[]> halton_seq;    ///< Sequense of random 2D points
+    std::shared_ptr<const float> halton_seq;    ///< Halton points, shared between regions of the same renderer
 
     explicit RegionContext(const rect_t &rect) : rect_(rect) {}
 
@@ -43,6 +46,15 @@ public:
 /** Base class for all renderer backends
 */
 class RendererBase {
+protected:
+    static const int TexFilterDepthsCount = 8;
+
+    /// Texture filter per ray bounce depth, the last one is used for all deeper bounces
+    eTexFilter tex_filters_[TexFilterDepthsCount] = { TexFilterAnisotropic, TexFilterBilinear, TexFilterBilinear,
+                                                      TexFilterNearest, TexFilterNearest, TexFilterNearest,
+                                                      TexFilterNearest, TexFilterNearest };
+
+    bool traversal_cost_enabled_ = false;
 public:
     virtual ~RendererBase() = default;
 
@@ -71,6 +83,40 @@ public:
     */
     virtual std::shared_ptr<SceneBase> CreateScene() = 0;
 
+    /** @brief Set texture filtering of rays starting from specific bounce depth
+        @param depth bounce depth (0 for primary rays), filter is applied to all deeper bounces too
+        @param filter texture filter
+    */
+    virtual void SetTextureFilter(int depth, eTexFilter filter) {
+        for (int i = std::max(depth, 0); i < TexFilterDepthsCount; i++) {
+            tex_filters_[i] = filter;
+        }
+    }
+
+    /// Texture filter used for rays of specific bounce depth
+    eTexFilter texture_filter(int depth) const {
+        return tex_filters_[std::min(depth, TexFilterDepthsCount - 1)];
+    }
+
+    /** @brief Enable debug mode, which counts visited BVH nodes and tested triangles of each pixel
+        Cost of primary and secondary rays is accumulated over all samples (shadow rays are not counted),
+        counters are reset with Clear. Rendering is slower while enabled
+        @param enable true to enable collection of traversal cost
+    */
+    virtual void EnableTraversalCost(bool enable) {
+        traversal_cost_enabled_ = enable;
+    }
+
+    /// Returns true if traversal cost is collected
+    bool traversal_cost_enabled() const {
+        return traversal_cost_enabled_;
+    }
+
+    /// Returns pointer to traversal cost of pixels (nullptr if debug mode is disabled)
+    virtual const traversal_cost_t *get_traversal_cost_ref() const {
+        return nullptr;
+    }
+
     /** @brief Render image region
         @param s shared pointer to a scene
         @param region image region to render
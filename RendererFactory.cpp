@@ -6,6 +6,8 @@
 #include "internal/RendererRef2.h"
 #include "internal/RendererSSE.h"
 #include "internal/RendererAVX.h"
+#include "internal/RendererAVX2.h"
+#include "internal/RendererAVX16.h"
 #elif defined(__ARM_NEON__) || defined(__aarch64__)
 #include "internal/RendererNEON.h"
 #elif defined(__i386__) || defined(__x86_64__)
@@ -13,6 +15,7 @@
 #endif
 
 #if !defined(DISABLE_OCL)
+#include "internal/MultiRendererOCL.h"
 #include "internal/RendererOCL.h"
 #else
 #pragma message("Compiling without OpenCL support")
@@ -27,7 +30,21 @@ std::shared_ptr<ray::RendererBase> ray::CreateRenderer(const settings_t &s, uint
     if (flags & RendererOCL) {
         log_stream << "ray: Creating OpenCL renderer " << s.w << "x" << s.h << std::endl;
         try {
-            return std::make_shared<ocl::Renderer>(s.w, s.h, s.platform_index, s.device_index);
+            if (s.use_all_devices) {
+                std::vector<std::pair<int, int>> devices;
+                auto platforms = ocl::Renderer::QueryPlatforms();
+                for (int i = 0; i < (int)platforms.size(); i++) {
+                    for (int j = 0; j < (int)platforms[i].devices.size(); j++) {
+                        devices.emplace_back(i, j);
+                    }
+                }
+
+                if (devices.size() > 1) {
+                    log_stream << "ray: Using " << devices.size() << " OpenCL devices" << std::endl;
+                    return std::make_shared<ocl::MultiRenderer>(s.w, s.h, devices, s.program_cache_dir, s.sort_look_back);
+                }
+            }
+            return std::make_shared<ocl::Renderer>(s.w, s.h, s.platform_index, s.device_index, s.program_cache_dir, s.sort_look_back);
         } catch (std::exception &e) {
             log_stream << "ray: Creating OpenCL renderer failed, " << e.what() << std::endl;
         }
@@ -35,39 +52,47 @@ std::shared_ptr<ray::RendererBase> ray::CreateRenderer(const settings_t &s, uint
 #endif
 
 #if !defined(__ANDROID__)
+    if ((flags & RendererAVX16) && features.avx2_supported && features.fma_supported) {
+        log_stream << "ray: Creating AVX16 renderer " << s.w << "x" << s.h << std::endl;
+        return std::make_shared<avx16::Renderer>(s.w, s.h, s.tex_compression);
+    }
+    if ((flags & RendererAVX2) && features.avx2_supported && features.fma_supported) {
+        log_stream << "ray: Creating AVX2 renderer " << s.w << "x" << s.h << std::endl;
+        return std::make_shared<avx2::Renderer>(s.w, s.h, s.tex_compression);
+    }
     if ((flags & RendererAVX) && features.avx_supported) {
         log_stream << "ray: Creating AVX renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<avx::Renderer>(s.w, s.h);
+        return std::make_shared<avx::Renderer>(s.w, s.h, s.tex_compression);
     }
     if ((flags & RendererSSE) && features.sse2_supported) {
         log_stream << "ray: Creating SSE renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<sse::Renderer>(s.w, s.h);
+        return std::make_shared<sse::Renderer>(s.w, s.h, s.tex_compression);
     }
     if (flags & RendererRef) {
         log_stream << "ray: Creating Ref renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<ref::Renderer>(s.w, s.h);
+        return std::make_shared<ref::Renderer>(s.w, s.h, s.tex_compression);
     }
 #elif defined(__ARM_NEON__) || defined(__aarch64__)
     if (flags & RendererNEON) {
         log_stream << "ray: Creating NEON renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<neon::Renderer>(s.w, s.h);
+        return std::make_shared<neon::Renderer>(s.w, s.h, s.tex_compression);
     }
     if (flags & RendererRef) {
         log_stream << "ray: Creating Ref renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<ref::Renderer>(s.w, s.h);
+        return std::make_shared<ref::Renderer>(s.w, s.h, s.tex_compression);
     }
 #elif defined(__i386__) || defined(__x86_64__)
     if ((flags & RendererSSE) && features.sse2_supported) {
         log_stream << "ray: Creating SSE renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<sse::Renderer>(s.w, s.h);
+        return std::make_shared<sse::Renderer>(s.w, s.h, s.tex_compression);
     }
     if (flags & RendererRef) {
         log_stream << "ray: Creating Ref renderer " << s.w << "x" << s.h << std::endl;
-        return std::make_shared<ref::Renderer>(s.w, s.h);
+        return std::make_shared<ref::Renderer>(s.w, s.h, s.tex_compression);
     }
 #endif
     log_stream << "ray: Creating Ref renderer " << s.w << "x" << s.h << std::endl;
-    return std::make_shared<ref::Renderer>(s.w, s.h);
+    return std::make_shared<ref::Renderer>(s.w, s.h, s.tex_compression);
 }
 
 #if !defined(DISABLE_OCL)
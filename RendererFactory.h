@@ -11,12 +11,21 @@
 
 namespace ray {
 /// Default renderer flags used to choose backend, by default tries to create gpu opencl renderer first
-const uint32_t default_renderer_flags = RendererRef | RendererSSE | RendererAVX | RendererNEON | RendererOCL;
+const uint32_t default_renderer_flags = RendererRef | RendererSSE | RendererAVX | RendererAVX2 | RendererNEON | RendererOCL;
 
 struct settings_t {
     int w, h;
+    /// Compression of texture atlas pages for CPU backends
+    eTexCompression tex_compression = TexCompressionNone;
 #if !defined(DISABLE_OCL)
     int platform_index = -1, device_index = -1;
+    /// Directory used to cache compiled OpenCL program binaries, caching is disabled by default (nullptr)
+    const char *program_cache_dir = nullptr;
+    /// Render on all available OpenCL devices at once (platform_index and device_index are ignored)
+    bool use_all_devices = false;
+    /** Sort rays with single pass (decoupled look-back) radix sort. It relies on forward progress between work-groups,
+        which OpenCL does not guarantee, so it must be enabled only for devices known to provide it */
+    bool sort_look_back = false;
 #endif
 };
 
@@ -68,12 +68,23 @@ struct mesh_desc_t {
     std::vector<shape_desc_t> shapes;   ///< Vector of shapes in mesh
 };
 
+/** Callback used to load mip level of streamed texture on demand
+    @param userdata user pointer from texture description
+    @param mip_level requested mip level (0 - full resolution)
+    @param w mip level width
+    @param h mip level height
+    @param out_data array of w * h pixels to fill
+*/
+typedef void (*tex_load_func_t)(void *userdata, int mip_level, int w, int h, pixel_color8_t *out_data);
+
 /// Texture description
 struct tex_desc_t {
-    const pixel_color8_t *data;     ///< Single byte RGBA pixel data
+    const pixel_color8_t *data;     ///< Single byte RGBA pixel data, read in place (can point to memory mapped file)
     int w,                          ///< Texture width
         h;                          ///< Texture height
     bool generate_mipmaps;
+    tex_load_func_t load_func;      ///< Loader of streamed texture (data is ignored if set), null if data is given
+    void *load_userdata;            ///< User pointer passed to loader
 };
 
 /// Environment description
@@ -82,8 +93,17 @@ struct environment_desc_t {
     float sun_col[3];               ///< Sun color
     float sky_col[3];               ///< Sky color
     float sun_softness;             ///< defines shadow softness (0 - had shadow)
+    const pixel_color8_t *env_map;  ///< Optional HDR environment map (lat-long, RGBE texels), replaces sky color
+    int env_map_w,                  ///< Environment map width
+        env_map_h;                  ///< Environment map height
 };
 
+/** Encodes linear color into RGBE texel (shared exponent is stored in alpha)
+    @param rgb linear color
+    @param out_texel encoded texel
+*/
+void EncodeRGBE(const float rgb[3], pixel_color8_t &out_texel);
+
 /** Base Scene class,
     cpu and gpu backends have different implementation of SceneBase
 */
@@ -113,11 +133,38 @@ public:
     */
     virtual uint32_t AddTexture(const tex_desc_t &t) = 0;
 
+    /** @brief Adds batch of textures to scene, mip levels are generated in parallel
+        @param textures array of texture descriptions
+        @param count number of textures
+        @param out_indices array of count new texture indices (0xffffffff for textures that failed to be added)
+    */
+    virtual void AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) = 0;
+
     /** @brief Removes texture with specific index from scene
         @param i texture index
+
+        Index can be reused by textures added later. Texture should not be referenced by materials after removal.
     */
     virtual void RemoveTexture(uint32_t i) = 0;
 
+    /** @brief Moves textures out of the last texture atlas pages and releases pages that become empty
+        @param max_texels limits amount of texture data moved per call, so that compaction can be spread over several frames
+        @return true if nothing is left to compact
+    */
+    virtual bool CompactTextures(size_t max_texels = SIZE_MAX) = 0;
+
+    /** @brief Sets memory budget for mip levels of streamed textures
+        @param size budget in bytes (size of uncompressed texels)
+    */
+    virtual void SetTextureCacheSize(size_t size) = 0;
+
+    /** @brief Loads mip levels of streamed textures requested during rendering, evicts least recently used ones
+        
+        Must not be called concurrently with RenderScene. Until requested mip level is loaded,
+        sampling falls back to the finest resident one.
+    */
+    virtual void UpdateTextureResidency() = 0;
+
     /** @brief Adds material to scene
         @param m material description
         @return New material index
@@ -126,6 +173,8 @@ public:
 
     /** @brief Removes material with specific index from scene
         @param i material index
+
+        Index can be reused by materials added later.
     */
     virtual void RemoveMaterial(uint32_t i) = 0;
 
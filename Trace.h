@@ -0,0 +1,22 @@
+#pragma once
+
+#include <iostream>
+
+/**
+  @file Trace.h
+*/
+
+namespace ray {
+/// Returns true if library is built with ENABLE_TRACING, otherwise no events are recorded
+bool TracingSupported();
+
+/// Discards events recorded by all threads
+void ClearTrace();
+
+/** @brief Writes recorded events in Chrome trace_event JSON format (open with chrome://tracing or ui.perfetto.dev)
+    Each thread keeps only its latest events. Should not be called while rendering is in progress
+    @param out output stream
+    @return false if tracing is not supported or writing failed
+*/
+bool DumpTrace(std::ostream &out);
+}
@@ -23,6 +23,26 @@ struct pixel_color8_t {
 };
 static_assert(sizeof(pixel_color8_t) == 4, "!");
 
+/// Traversal cost of pixel, number of visited BVH nodes and tested triangles
+struct traversal_cost_t {
+    uint32_t nodes, tris;
+};
+static_assert(sizeof(traversal_cost_t) == 8, "!");
+
+/// Storage format of texture atlas pages (used by CPU backends)
+enum eTexCompression {
+    TexCompressionNone, ///< Uncompressed RGBA8
+    TexCompressionBC1,  ///< 4x4 blocks, 4 bits per texel, alpha is dropped
+    TexCompressionBC3,  ///< 4x4 blocks, 8 bits per texel, alpha is stored separately
+};
+
+/// Filtering of surface textures, chosen per ray bounce depth
+enum eTexFilter {
+    TexFilterNearest,       ///< Single texel of mip level picked by ray differentials
+    TexFilterBilinear,      ///< Single bilinear tap at mip level picked by ray differentials
+    TexFilterAnisotropic,   ///< Several trilinear taps along the longer axis of pixel footprint
+};
+
 /// Rectangle struct
 struct rect_t { int x, y, w, h; };
 
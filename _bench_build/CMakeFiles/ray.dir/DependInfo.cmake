@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/_ray.cpp" "CMakeFiles/ray.dir/_ray.cpp.o" "gcc" "CMakeFiles/ray.dir/_ray.cpp.o.d"
+  "/root/repo/_ray_avx.cpp" "CMakeFiles/ray.dir/_ray_avx.cpp.o" "gcc" "CMakeFiles/ray.dir/_ray_avx.cpp.o.d"
+  "/root/repo/_ray_avx16.cpp" "CMakeFiles/ray.dir/_ray_avx16.cpp.o" "gcc" "CMakeFiles/ray.dir/_ray_avx16.cpp.o.d"
+  "/root/repo/_ray_avx2.cpp" "CMakeFiles/ray.dir/_ray_avx2.cpp.o" "gcc" "CMakeFiles/ray.dir/_ray_avx2.cpp.o.d"
+  "/root/repo/_ray_sse.cpp" "CMakeFiles/ray.dir/_ray_sse.cpp.o" "gcc" "CMakeFiles/ray.dir/_ray_sse.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
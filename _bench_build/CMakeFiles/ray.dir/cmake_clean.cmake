@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ray.dir/_ray.cpp.o"
+  "CMakeFiles/ray.dir/_ray.cpp.o.d"
+  "CMakeFiles/ray.dir/_ray_avx.cpp.o"
+  "CMakeFiles/ray.dir/_ray_avx.cpp.o.d"
+  "CMakeFiles/ray.dir/_ray_avx16.cpp.o"
+  "CMakeFiles/ray.dir/_ray_avx16.cpp.o.d"
+  "CMakeFiles/ray.dir/_ray_avx2.cpp.o"
+  "CMakeFiles/ray.dir/_ray_avx2.cpp.o.d"
+  "CMakeFiles/ray.dir/_ray_sse.cpp.o"
+  "CMakeFiles/ray.dir/_ray_sse.cpp.o.d"
+  "libray.a"
+  "libray.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ray.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
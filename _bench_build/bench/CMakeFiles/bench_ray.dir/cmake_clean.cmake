@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_ray.dir/bench_ray.cpp.o"
+  "CMakeFiles/bench_ray.dir/bench_ray.cpp.o.d"
+  "bench_ray"
+  "bench_ray.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_ray.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,37 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_ray.dir/main.cpp.o"
+  "CMakeFiles/test_ray.dir/main.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_backends.cpp.o"
+  "CMakeFiles/test_ray.dir/test_backends.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_data.cpp.o"
+  "CMakeFiles/test_ray.dir/test_data.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_env_map.cpp.o"
+  "CMakeFiles/test_ray.dir/test_env_map.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_halton.cpp.o"
+  "CMakeFiles/test_ray.dir/test_halton.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_primary_ray_gen.cpp.o"
+  "CMakeFiles/test_ray.dir/test_primary_ray_gen.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_render.cpp.o"
+  "CMakeFiles/test_ray.dir/test_render.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_simd.cpp.o"
+  "CMakeFiles/test_ray.dir/test_simd.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_sort.cpp.o"
+  "CMakeFiles/test_ray.dir/test_sort.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_tex_atlas.cpp.o"
+  "CMakeFiles/test_ray.dir/test_tex_atlas.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_tex_mips.cpp.o"
+  "CMakeFiles/test_ray.dir/test_tex_mips.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_tex_streaming.cpp.o"
+  "CMakeFiles/test_ray.dir/test_tex_streaming.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_trace.cpp.o"
+  "CMakeFiles/test_ray.dir/test_trace.cpp.o.d"
+  "CMakeFiles/test_ray.dir/test_traverse.cpp.o"
+  "CMakeFiles/test_ray.dir/test_traverse.cpp.o.d"
+  "test_ray"
+  "test_ray.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_ray.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_tex.dir/bench_tex.cpp.o"
+  "CMakeFiles/bench_tex.dir/bench_tex.cpp.o.d"
+  "bench_tex"
+  "bench_tex.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_tex.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,33 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/tests/main.cpp" "tests/CMakeFiles/test_ray.dir/main.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/main.cpp.o.d"
+  "/root/repo/tests/test_backends.cpp" "tests/CMakeFiles/test_ray.dir/test_backends.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_backends.cpp.o.d"
+  "/root/repo/tests/test_data.cpp" "tests/CMakeFiles/test_ray.dir/test_data.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_data.cpp.o.d"
+  "/root/repo/tests/test_env_map.cpp" "tests/CMakeFiles/test_ray.dir/test_env_map.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_env_map.cpp.o.d"
+  "/root/repo/tests/test_halton.cpp" "tests/CMakeFiles/test_ray.dir/test_halton.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_halton.cpp.o.d"
+  "/root/repo/tests/test_primary_ray_gen.cpp" "tests/CMakeFiles/test_ray.dir/test_primary_ray_gen.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_primary_ray_gen.cpp.o.d"
+  "/root/repo/tests/test_render.cpp" "tests/CMakeFiles/test_ray.dir/test_render.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_render.cpp.o.d"
+  "/root/repo/tests/test_simd.cpp" "tests/CMakeFiles/test_ray.dir/test_simd.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_simd.cpp.o.d"
+  "/root/repo/tests/test_sort.cpp" "tests/CMakeFiles/test_ray.dir/test_sort.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_sort.cpp.o.d"
+  "/root/repo/tests/test_tex_atlas.cpp" "tests/CMakeFiles/test_ray.dir/test_tex_atlas.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_tex_atlas.cpp.o.d"
+  "/root/repo/tests/test_tex_mips.cpp" "tests/CMakeFiles/test_ray.dir/test_tex_mips.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_tex_mips.cpp.o.d"
+  "/root/repo/tests/test_tex_streaming.cpp" "tests/CMakeFiles/test_ray.dir/test_tex_streaming.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_tex_streaming.cpp.o.d"
+  "/root/repo/tests/test_trace.cpp" "tests/CMakeFiles/test_ray.dir/test_trace.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_trace.cpp.o.d"
+  "/root/repo/tests/test_traverse.cpp" "tests/CMakeFiles/test_ray.dir/test_traverse.cpp.o" "gcc" "tests/CMakeFiles/test_ray.dir/test_traverse.cpp.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_build_noocl/CMakeFiles/ray.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -3,9 +3,12 @@
 #include "SceneBase.cpp"
 
 #include "internal/BVHSplit.cpp"
+#include "internal/TexturePacker.cpp"
 #include "internal/TextureSplitter.cpp"
 
 #include "internal/Core.cpp"
+#include "internal/HaltonTable.cpp"
+#include "internal/Trace.cpp"
 
 #include "internal/CoreRef.cpp"
 #include "internal/FramebufferRef.cpp"
@@ -20,6 +23,8 @@
 
 #if defined(__ANDROID__) || defined(DISABLE_OCL)
 #else
+#include "internal/MultiRendererOCL.cpp"
+#include "internal/MultiSceneOCL.cpp"
 #include "internal/RendererOCL.cpp"
 #include "internal/SceneOCL.cpp"
 #include "internal/TextureAtlasOCL.cpp"
@@ -27,10 +32,8 @@
 
 // TODO:
 // make camera fov work
-// add deletion functions for OpenCL backend
 // try again with spatial splits or remove unnecessary indirection
 // add tests for intersection
-// add validation tests (use Cycles)
 
 // DONE:
 // add neon support
@@ -0,0 +1,6 @@
+// MSVC allows setting /arch option only for separate translation units, so put it here.
+// (same as AVX2 backend, but with 4x4 ray packets made of register pairs)
+
+#if !defined(__ANDROID__)
+#include "internal/RendererAVX16.cpp"
+#endif
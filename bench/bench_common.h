@@ -0,0 +1,116 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace bench {
+/// Named benchmark parameter, written to report either as string or as number
+struct param_t {
+    std::string key, str;
+    double num;
+    bool is_num;
+
+    param_t(const char *_key, const char *_str) : key(_key), str(_str), num(0.0), is_num(false) {}
+    param_t(const char *_key, const std::string &_str) : key(_key), str(_str), num(0.0), is_num(false) {}
+    param_t(const char *_key, double _num) : key(_key), num(_num), is_num(true) {}
+};
+
+struct result_t {
+    std::string name;
+    std::vector<param_t> params;
+    double value;
+    std::string unit;
+};
+
+/** Runs func until at least min_time seconds elapsed, number of runs is doubled each round.
+    Returns average time of one run in seconds
+*/
+template <typename F>
+double Measure(F &&func, double min_time) {
+    func(); // warmup
+
+    for (long long runs = 1;; runs *= 2) {
+        const auto time_start = std::chrono::high_resolution_clock::now();
+        for (long long i = 0; i < runs; i++) {
+            func();
+        }
+        const double elapsed = std::chrono::duration<double>{ std::chrono::high_resolution_clock::now() - time_start }.count();
+        if (elapsed >= min_time) return elapsed / double(runs);
+    }
+}
+
+/// Collects results and writes them as JSON document { "benchmark": name, "results": [...] }
+class Report {
+    std::string name_;
+    std::vector<result_t> results_;
+
+    static void WriteString(FILE *f, const std::string &s) {
+        fputc('"', f);
+        for (char c : s) {
+            if (c == '"' || c == '\\') fputc('\\', f);
+            fputc(c, f);
+        }
+        fputc('"', f);
+    }
+public:
+    explicit Report(const char *name) : name_(name) {}
+
+    void Add(const char *name, std::vector<param_t> params, double value, const char *unit) {
+        results_.push_back({ name, std::move(params), value, unit });
+    }
+
+    const std::vector<result_t> &results() const { return results_; }
+
+    /// Writes report to file, or to stdout if file_name is null
+    bool Write(const char *file_name) const {
+        FILE *f = file_name ? fopen(file_name, "w") : stdout;
+        if (!f) return false;
+
+        fprintf(f, "{\n  \"benchmark\": ");
+        WriteString(f, name_);
+        fprintf(f, ",\n  \"results\": [");
+        for (size_t i = 0; i < results_.size(); i++) {
+            const auto &r = results_[i];
+
+            fprintf(f, i ? ",\n    { \"name\": " : "\n    { \"name\": ");
+            WriteString(f, r.name);
+            for (const auto &p : r.params) {
+                fprintf(f, ", ");
+                WriteString(f, p.key);
+                fprintf(f, ": ");
+                if (p.is_num) {
+                    fprintf(f, "%.9g", p.num);
+                } else {
+                    WriteString(f, p.str);
+                }
+            }
+            fprintf(f, ", \"value\": %.6g, \"unit\": ", r.value);
+            WriteString(f, r.unit);
+            fprintf(f, " }");
+        }
+        fprintf(f, "\n  ]\n}\n");
+
+        if (f != stdout) fclose(f);
+        return true;
+    }
+};
+
+/// Parses common command line options: [-o <out.json>] [-t <min seconds per case>]
+inline bool ParseArgs(int argc, char *argv[], const char *&out_file, double &min_time) {
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            out_file = argv[++i];
+        } else if (arg == "-t" && i + 1 < argc) {
+            min_time = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [-o <out.json>] [-t <min seconds per case>]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+}
@@ -0,0 +1,560 @@
+#include "bench_common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include "../RendererFactory.h"
+#include "../internal/CoreRef.h"
+#include "../internal/HaltonTable.h"
+#include "../internal/SceneRef.h"
+#include "../internal/simd/detect.h"
+
+namespace {
+const int ImageRes = 256;
+
+/// Scene with acceleration structures exposed, so that single stages of renderer can be called directly
+class BenchScene : public ray::ref::Scene {
+public:
+    using Scene::nodes_;
+    using Scene::tris_;
+    using Scene::tri_indices_;
+    using Scene::transforms_;
+    using Scene::meshes_;
+    using Scene::mesh_instances_;
+    using Scene::mi_indices_;
+    using Scene::vertices_;
+    using Scene::vtx_indices_;
+    using Scene::materials_;
+    using Scene::textures_;
+    using Scene::texture_atlas_;
+    using Scene::env_;
+    using Scene::macro_nodes_start_;
+};
+
+/// Parameters of stage measurements, which are written to report
+struct stage_params_t {
+    const char *scene, *backend;
+    int width;
+};
+
+void AddRays(bench::Report &report, const char *name, const stage_params_t &params, const char *rays, double rays_count, double elapsed) {
+    report.Add(name, { { "scene", params.scene }, { "backend", params.backend }, { "width", double(params.width) }, { "rays", rays } },
+               rays_count / elapsed * 0.000001, "Mrays/s");
+}
+}
+
+#if !defined(__ANDROID__)
+#include "../internal/RendererSSE.h"
+#include "../internal/RendererAVX.h"
+#include "../internal/RendererAVX2.h"
+#include "../internal/RendererAVX16.h"
+
+#define NS sse
+#include "bench_ray_simd.ipp"
+#undef NS
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx")
+#endif
+#define NS avx
+#include "bench_ray_simd.ipp"
+#undef NS
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2,fma")
+#endif
+#define NS avx2
+#include "bench_ray_simd.ipp"
+#undef NS
+#define NS avx16
+#include "bench_ray_simd.ipp"
+#undef NS
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+namespace {
+enum eMatSlot { MatDiffuse, MatGlossy, MatGlass, MatSlotsCount };
+
+/// Triangle list with PxyzNxyzTuv layout, shapes are ranges of indices with one material
+struct geometry_t {
+    std::vector<float> attrs;
+    std::vector<uint32_t> indices;
+    struct shape_t {
+        eMatSlot mat;
+        size_t start, count;
+    };
+    std::vector<shape_t> shapes;
+
+    void AddShape(eMatSlot mat, size_t start) {
+        shapes.push_back({ mat, start, indices.size() - start });
+    }
+};
+
+struct instance_t {
+    int mesh;
+    float xform[16];
+};
+
+struct scene_desc_t {
+    const char *name;
+    std::vector<geometry_t> meshes;
+    std::vector<instance_t> instances;
+    float cam_origin[3], cam_fwd[3];
+};
+
+void Normalize(float v[3]) {
+    const float l = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    v[0] /= l; v[1] /= l; v[2] /= l;
+}
+
+void AppendSphere(geometry_t &g, const float center[3], float radius, int slices, int stacks) {
+    const uint32_t first = uint32_t(g.attrs.size() / 8);
+
+    for (int j = 0; j <= stacks; j++) {
+        const float theta = 3.14159265f * j / stacks;
+        for (int i = 0; i <= slices; i++) {
+            const float phi = 2 * 3.14159265f * i / slices;
+            const float n[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+
+            g.attrs.insert(g.attrs.end(), { center[0] + radius * n[0], center[1] + radius * n[1], center[2] + radius * n[2],
+                                            n[0], n[1], n[2], float(i) / slices, float(j) / stacks });
+        }
+    }
+
+    for (int j = 0; j < stacks; j++) {
+        for (int i = 0; i < slices; i++) {
+            const uint32_t i0 = first + j * (slices + 1) + i, i1 = i0 + slices + 1;
+            if (j != 0) g.indices.insert(g.indices.end(), { i0, i0 + 1, i1 });
+            if (j != stacks - 1) g.indices.insert(g.indices.end(), { i0 + 1, i1 + 1, i1 });
+        }
+    }
+}
+
+/** Classic sphere-flake: every sphere has 9 children of third of its radius (6 around equator, 3 on top).
+    Spheres are added level by level, each level gets its own material
+*/
+geometry_t GenerateSphereFlake(int depth, int slices, int stacks) {
+    struct sphere_t {
+        float c[3], r, up[3];
+    };
+
+    std::vector<sphere_t> level = { { { 0, 0, 0 }, 1.0f, { 0, 1, 0 } } };
+
+    geometry_t g;
+    for (int d = 0; d <= depth; d++) {
+        const size_t start = g.indices.size();
+
+        std::vector<sphere_t> next;
+        for (const sphere_t &s : level) {
+            AppendSphere(g, s.c, s.r, slices, stacks);
+            if (d == depth) continue;
+
+            // basis around up direction
+            float t[3] = { s.up[1], s.up[2], s.up[0] };
+            const float dt = t[0] * s.up[0] + t[1] * s.up[1] + t[2] * s.up[2];
+            for (int k = 0; k < 3; k++) t[k] -= dt * s.up[k];
+            Normalize(t);
+            const float b[3] = { s.up[1] * t[2] - s.up[2] * t[1], s.up[2] * t[0] - s.up[0] * t[2], s.up[0] * t[1] - s.up[1] * t[0] };
+
+            for (int k = 0; k < 9; k++) {
+                const float elev = k < 6 ? 0.0f : 1.0f, azim = k < 6 ? k * 3.14159265f / 3 : (k - 6) * 2 * 3.14159265f / 3 + 0.5f;
+                float dir[3];
+                for (int c = 0; c < 3; c++) {
+                    dir[c] = std::cos(elev) * (std::cos(azim) * t[c] + std::sin(azim) * b[c]) + std::sin(elev) * s.up[c];
+                }
+                Normalize(dir);
+
+                const float r = s.r / 3;
+                next.push_back({ { s.c[0] + dir[0] * (s.r + r), s.c[1] + dir[1] * (s.r + r), s.c[2] + dir[2] * (s.r + r) }, r,
+                                 { dir[0], dir[1], dir[2] } });
+            }
+        }
+
+        g.AddShape(d % 3 == 0 ? MatGlossy : (d % 3 == 1 ? MatDiffuse : MatGlass), start);
+        level = std::move(next);
+    }
+
+    return g;
+}
+
+geometry_t GenerateQuad(float size, float y) {
+    geometry_t g;
+    g.attrs = { -size, y, -size,    0, 1, 0,    0, 0,
+                 size, y, -size,    0, 1, 0,    1, 0,
+                 size, y,  size,    0, 1, 0,    1, 1,
+                -size, y,  size,    0, 1, 0,    0, 1 };
+    g.indices = { 0, 2, 1, 0, 3, 2 };
+    g.AddShape(MatDiffuse, 0);
+    return g;
+}
+
+/// Randomly placed and oriented small triangles inside of cube, worst case for BVH quality and ray coherence
+geometry_t GenerateTriangleSoup(int count, float extent, float tri_size) {
+    uint32_t rnd = 12345;
+    auto next = [&rnd]() {
+        rnd = rnd * 1664525u + 1013904223u;
+        return float(rnd >> 8) / (1 << 24);
+    };
+
+    geometry_t g;
+    for (int i = 0; i < count; i++) {
+        const float c[3] = { (2 * next() - 1) * extent, (2 * next() - 1) * extent, (2 * next() - 1) * extent };
+
+        float p[3][3];
+        for (int j = 0; j < 3; j++) {
+            for (int k = 0; k < 3; k++) {
+                p[j][k] = c[k] + (2 * next() - 1) * tri_size;
+            }
+        }
+
+        const float e1[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] },
+                    e2[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+        Normalize(n);
+
+        for (int j = 0; j < 3; j++) {
+            g.attrs.insert(g.attrs.end(), { p[j][0], p[j][1], p[j][2], n[0], n[1], n[2], float(j == 1), float(j == 2) });
+            g.indices.push_back(uint32_t(3 * i + j));
+        }
+    }
+    g.AddShape(MatDiffuse, 0);
+
+    return g;
+}
+
+std::vector<scene_desc_t> GenerateScenes() {
+    std::vector<scene_desc_t> scenes(3);
+
+    {   // single large mesh with uneven triangle density
+        scene_desc_t &s = scenes[0];
+        s.name = "sphereflake";
+        s.meshes.push_back(GenerateSphereFlake(3, 16, 8));
+        s.meshes.push_back(GenerateQuad(4.0f, -1.0f));
+        s.instances.push_back({ 0, { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 } });
+        s.instances.push_back({ 1, { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 } });
+        s.cam_origin[0] = 0.0f; s.cam_origin[1] = 1.5f; s.cam_origin[2] = 4.0f;
+        s.cam_fwd[0] = 0.0f; s.cam_fwd[1] = -0.35f; s.cam_fwd[2] = -1.0f;
+    }
+
+    {   // many instances of one mesh, stresses macro tree and ray transformation
+        scene_desc_t &s = scenes[1];
+        s.name = "instanced_grid";
+        s.meshes.push_back(GenerateSphereFlake(2, 12, 6));
+        s.meshes.push_back(GenerateQuad(24.0f, -1.0f));
+        for (int z = 0; z < 16; z++) {
+            for (int x = 0; x < 16; x++) {
+                const float a = 0.4f * (x + z), c = std::cos(a), sn = std::sin(a);
+                s.instances.push_back({ 0, { c, 0, -sn, 0,  0, 1, 0, 0,  sn, 0, c, 0,  (x - 7.5f) * 3.0f, 0, (z - 7.5f) * 3.0f, 1 } });
+            }
+        }
+        s.instances.push_back({ 1, { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 } });
+        s.cam_origin[0] = 0.0f; s.cam_origin[1] = 10.0f; s.cam_origin[2] = 30.0f;
+        s.cam_fwd[0] = 0.0f; s.cam_fwd[1] = -0.4f; s.cam_fwd[2] = -1.0f;
+    }
+
+    {
+        scene_desc_t &s = scenes[2];
+        s.name = "triangle_soup";
+        s.meshes.push_back(GenerateTriangleSoup(250000, 2.0f, 0.05f));
+        s.instances.push_back({ 0, { 1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0,  0, 0, 0, 1 } });
+        s.cam_origin[0] = 0.0f; s.cam_origin[1] = 0.0f; s.cam_origin[2] = 6.0f;
+        s.cam_fwd[0] = 0.0f; s.cam_fwd[1] = 0.0f; s.cam_fwd[2] = -1.0f;
+    }
+
+    for (scene_desc_t &s : scenes) {
+        Normalize(s.cam_fwd);
+    }
+
+    return scenes;
+}
+
+void BuildScene(const scene_desc_t &desc, ray::SceneBase &s) {
+    using namespace ray;
+
+    environment_desc_t env = {};
+    env.sun_dir[0] = 0.3f; env.sun_dir[1] = 1.0f; env.sun_dir[2] = 0.2f;
+    Normalize(env.sun_dir);
+    env.sun_col[0] = env.sun_col[1] = env.sun_col[2] = 1.0f;
+    env.sky_col[0] = 0.4f; env.sky_col[1] = 0.5f; env.sky_col[2] = 0.6f;
+    env.sun_softness = 0.0f;
+    s.SetEnvironment(env);
+
+    std::vector<pixel_color8_t> white(4 * 4, { 255, 255, 255, 255 });
+
+    tex_desc_t tex_desc = {};
+    tex_desc.data = &white[0];
+    tex_desc.w = tex_desc.h = 4;
+    tex_desc.generate_mipmaps = true;
+    const uint32_t white_tex = s.AddTexture(tex_desc);
+
+    uint32_t mats[MatSlotsCount];
+    {
+        mat_desc_t mat_desc;
+        mat_desc.main_texture = white_tex;
+
+        mat_desc.type = DiffuseMaterial;
+        mat_desc.main_color[0] = 0.8f; mat_desc.main_color[1] = 0.7f; mat_desc.main_color[2] = 0.6f;
+        mats[MatDiffuse] = s.AddMaterial(mat_desc);
+
+        mat_desc.type = GlossyMaterial;
+        mat_desc.roughness = 0.1f;
+        mats[MatGlossy] = s.AddMaterial(mat_desc);
+
+        mat_desc.type = RefractiveMaterial;
+        mat_desc.roughness = 0.0f;
+        mat_desc.ior = 1.5f;
+        mats[MatGlass] = s.AddMaterial(mat_desc);
+    }
+
+    std::vector<uint32_t> meshes;
+    for (const geometry_t &g : desc.meshes) {
+        mesh_desc_t mesh_desc;
+        mesh_desc.prim_type = TriangleList;
+        mesh_desc.layout = PxyzNxyzTuv;
+        mesh_desc.vtx_attrs = &g.attrs[0];
+        mesh_desc.vtx_attrs_count = g.attrs.size() / 8;
+        mesh_desc.vtx_indices = &g.indices[0];
+        mesh_desc.vtx_indices_count = g.indices.size();
+        for (const auto &sh : g.shapes) {
+            mesh_desc.shapes.push_back({ mats[sh.mat], sh.start, sh.count });
+        }
+
+        meshes.push_back(s.AddMesh(mesh_desc));
+    }
+
+    for (const instance_t &inst : desc.instances) {
+        s.AddMeshInstance(meshes[inst.mesh], inst.xform);
+    }
+
+    s.set_current_cam(s.AddCamera(ray::Persp, desc.cam_origin, desc.cam_fwd, 45.0f));
+}
+
+void BenchStagesRef(const BenchScene &s, const ray::camera_t &cam, const float *halton, const stage_params_t &params,
+                    double min_time, bench::Report &report) {
+    using namespace ray;
+    using namespace ray::ref;
+
+    const uint32_t root = s.macro_nodes_start_;
+    const float *root_min = s.nodes_[root].bbox[0], *root_max = s.nodes_[root].bbox[1];
+    const float cell_size[3] = { (root_max[0] - root_min[0]) / 255, (root_max[1] - root_min[1]) / 255, (root_max[2] - root_min[2]) / 255 };
+
+    const auto &env = s.env_;
+
+    aligned_vector<ray_packet_t> primary_rays;
+    GeneratePrimaryRays(1, cam, { 0, 0, ImageRes, ImageRes }, ImageRes, ImageRes, halton, primary_rays);
+
+    auto trace = [&](const aligned_vector<ray_packet_t> &rays, int count, aligned_vector<hit_data_t> &inters) {
+        for (int i = 0; i < count; i++) {
+            inters[i] = {};
+            inters[i].id = rays[i].id;
+            Traverse_MacroTree_CPU(rays[i], &s.nodes_[0], root, &s.mesh_instances_[0], &s.mi_indices_[0], &s.meshes_[0],
+                                   &s.transforms_[0], &s.tris_[0], &s.tri_indices_[0], inters[i]);
+        }
+    };
+
+    const int primary_count = int(primary_rays.size());
+    aligned_vector<hit_data_t> primary_inters(primary_count);
+
+    AddRays(report, "Traverse_MacroTree_CPU", params, "primary", primary_count,
+            bench::Measure([&]() { trace(primary_rays, primary_count, primary_inters); }, min_time));
+
+    aligned_vector<ray_packet_t> secondary_rays(primary_count);
+    int secondary_count = 0;
+
+    volatile float checksum = 0.0f;
+    AddRays(report, "ShadeSurface", params, "primary", primary_count, bench::Measure([&]() {
+        secondary_count = 0;
+        float sum = 0.0f;
+        for (int i = 0; i < primary_count; i++) {
+            const hit_data_t &inter = primary_inters[i];
+            const pixel_color_t col = ShadeSurface(inter.id.y * ImageRes + inter.id.x, 1, halton + HaltonBounceOffset(0), inter, primary_rays[i], env,
+                                                   &s.mesh_instances_[0], &s.mi_indices_[0], &s.meshes_[0], &s.transforms_[0], &s.vtx_indices_[0],
+                                                   &s.vertices_[0], &s.nodes_[0], root, &s.tris_[0], &s.tri_indices_[0], &s.materials_[0],
+                                                   &s.textures_[0], s.texture_atlas_, TexFilterBilinear, nullptr, &secondary_rays[0], &secondary_count);
+            sum += col.r;
+        }
+        checksum = checksum + sum;
+    }, min_time));
+
+    // sorting is done in place, so unsorted rays are restored before each run
+    aligned_vector<ray_packet_t> sorted_rays(secondary_rays.begin(), secondary_rays.begin() + secondary_count);
+    std::vector<uint32_t> hash_values(secondary_count), scan_values(secondary_count), skeleton(secondary_count);
+    std::vector<int> head_flags(secondary_count);
+    std::vector<ray_chunk_t> chunks(secondary_count), chunks_temp(secondary_count);
+
+    if (secondary_count) {
+        AddRays(report, "SortRays", params, "secondary", secondary_count, bench::Measure([&]() {
+            std::copy(secondary_rays.begin(), secondary_rays.begin() + secondary_count, sorted_rays.begin());
+            SortRays(&sorted_rays[0], size_t(secondary_count), root_min, cell_size, &hash_values[0], &head_flags[0], &scan_values[0],
+                     &chunks[0], &chunks_temp[0], &skeleton[0]);
+        }, min_time));
+
+        aligned_vector<hit_data_t> secondary_inters(secondary_count);
+        AddRays(report, "Traverse_MacroTree_CPU", params, "secondary", secondary_count,
+                bench::Measure([&]() { trace(sorted_rays, secondary_count, secondary_inters); }, min_time));
+    }
+
+    // rays from primary hits towards sun
+    aligned_vector<ray_packet_t> shadow_rays;
+    for (int i = 0; i < primary_count; i++) {
+        const hit_data_t &inter = primary_inters[i];
+        if (!inter.mask_values[0]) continue;
+
+        ray_packet_t r = primary_rays[i];
+        for (int k = 0; k < 3; k++) {
+            r.o[k] = r.o[k] + r.d[k] * inter.t + env.sun_dir[k] * 0.001f;
+            r.d[k] = env.sun_dir[k];
+        }
+        shadow_rays.push_back(r);
+    }
+
+    const int shadow_count = int(shadow_rays.size());
+    if (shadow_count) {
+        aligned_vector<hit_data_t> shadow_inters(shadow_count);
+        AddRays(report, "Traverse_MacroTree_CPU", params, "shadow", shadow_count,
+                bench::Measure([&]() { trace(shadow_rays, shadow_count, shadow_inters); }, min_time));
+    }
+}
+
+using BenchStagesFunc = void(*)(const BenchScene &s, const ray::camera_t &cam, const float *halton, const stage_params_t &params,
+                                double min_time, bench::Report &report);
+
+struct backend_t {
+    const char *name;
+    ray::eRendererType type;
+    int width;
+    BenchStagesFunc bench_stages;
+};
+}
+
+int main(int argc, char *argv[]) {
+    using namespace ray;
+
+    const char *out_file = nullptr;
+    double min_time = 0.05;
+    if (!bench::ParseArgs(argc, argv, out_file, min_time)) return -1;
+
+    std::vector<backend_t> backends = { { "ref", RendererRef, 1, BenchStagesRef } };
+#if !defined(__ANDROID__)
+    const auto features = GetCpuFeatures();
+    if (features.sse2_supported) {
+        backends.push_back({ "sse", RendererSSE, sse::RayPacketSize, sse::BenchStages });
+    }
+    if (features.avx_supported) {
+        backends.push_back({ "avx", RendererAVX, avx::RayPacketSize, avx::BenchStages });
+    }
+    if (features.avx2_supported && features.fma_supported) {
+        backends.push_back({ "avx2", RendererAVX2, avx2::RayPacketSize, avx2::BenchStages });
+        backends.push_back({ "avx16", RendererAVX16, avx16::RayPacketSize, avx16::BenchStages });
+    }
+#endif
+
+    settings_t settings;
+    settings.w = settings.h = ImageRes;
+
+    HaltonTable halton_table;
+    const auto halton = halton_table.Get(1);
+
+    bench::Report report("bench_ray");
+
+    // SIMD backends are expected to render faster than ref, anything else is reported as failure
+    bool slower_than_ref = false;
+
+    const auto scenes = GenerateScenes();
+    for (const scene_desc_t &desc : scenes) {
+        size_t tris_count = 0;
+        for (const geometry_t &g : desc.meshes) {
+            tris_count += g.indices.size() / 3;
+        }
+
+        {   // largest mesh of scene, BVH is built from scratch each run
+            const geometry_t &g = desc.meshes[0];
+
+            std::vector<bvh_node_t> nodes;
+            std::vector<tri_accel_t> tris;
+            std::vector<uint32_t> tri_indices;
+
+            const double elapsed = bench::Measure([&]() {
+                nodes.clear();
+                tris.clear();
+                tri_indices.clear();
+                PreprocessMesh(&g.attrs[0], g.attrs.size() / 8, &g.indices[0], g.indices.size(), PxyzNxyzTuv, nodes, tris, tri_indices);
+            }, min_time);
+
+            report.Add("PreprocessMesh", { { "scene", desc.name }, { "tris", double(g.indices.size() / 3) } },
+                       double(g.indices.size() / 3) / elapsed * 0.000001, "Mtris/s");
+        }
+
+        auto scene = std::make_shared<BenchScene>();
+        BuildScene(desc, *scene);
+        const camera_t &cam = scene->GetCamera(scene->current_cam());
+
+        for (const backend_t &backend : backends) {
+            const stage_params_t params = { desc.name, backend.name, backend.width };
+            backend.bench_stages(*scene, cam, halton.get(), params, min_time, report);
+        }
+
+        // whole frames, only camera rays are counted
+        auto render_backends = backends;
+        render_backends.push_back({ "ocl", RendererOCL, 1, nullptr });
+        double ref_rate = 0.0;
+        for (const backend_t &backend : render_backends) {
+            std::stringstream log;
+            auto r = CreateRenderer(settings, backend.type, log);
+            if (r->type() != backend.type) continue;
+
+            std::shared_ptr<SceneBase> s = scene;
+            if (backend.type == RendererOCL) {
+                s = r->CreateScene();
+                BuildScene(desc, *s);
+            }
+
+            r->Clear();
+            RegionContext region({ 0, 0, ImageRes, ImageRes });
+
+            const double elapsed = bench::Measure([&]() { r->RenderScene(s, region); }, min_time);
+            const double rate = double(ImageRes * ImageRes) / elapsed * 0.000001;
+
+            report.Add("RenderScene", { { "scene", desc.name }, { "backend", backend.name }, { "tris", double(tris_count) },
+                                        { "res", double(ImageRes) } },
+                       rate, "Mrays/s");
+
+            // ref goes first, cpu backends are compared against it
+            if (backend.type == RendererRef) {
+                ref_rate = rate;
+            } else if (backend.type != RendererOCL) {
+                report.Add("RenderSceneSpeedup", { { "scene", desc.name }, { "backend", backend.name } }, rate / ref_rate, "x ref");
+                if (rate < ref_rate) {
+                    fprintf(stderr, "%s backend is slower than ref on %s scene (%.3f vs %.3f Mrays/s)\n", backend.name, desc.name, rate, ref_rate);
+                    slower_than_ref = true;
+                }
+            }
+        }
+    }
+
+    if (!report.Write(out_file)) {
+        fprintf(stderr, "Failed to write %s\n", out_file);
+        return -1;
+    }
+
+    return slower_than_ref ? -1 : 0;
+}
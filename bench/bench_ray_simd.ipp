@@ -0,0 +1,120 @@
+// Included with NS defined, renderer header of backend must be included before
+
+namespace ray {
+namespace NS {
+void BenchStages(const BenchScene &s, const camera_t &cam, const float *halton, const stage_params_t &params,
+                 double min_time, bench::Report &report) {
+    const int S = RayPacketSize;
+
+    auto active_count = [](const aligned_vector<simd_ivec<S>> &masks, int count) {
+        int ret = 0;
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < S; j++) {
+                if (masks[i][j]) ret++;
+            }
+        }
+        return ret;
+    };
+
+    const uint32_t root = s.macro_nodes_start_;
+    const float *root_min = s.nodes_[root].bbox[0], *root_max = s.nodes_[root].bbox[1];
+    const float cell_size[3] = { (root_max[0] - root_min[0]) / 255, (root_max[1] - root_min[1]) / 255, (root_max[2] - root_min[2]) / 255 };
+
+    environment_t env;
+    memcpy(&env.sun_dir[0], &s.env_.sun_dir[0], 3 * sizeof(float));
+    memcpy(&env.sun_col[0], &s.env_.sun_col[0], 3 * sizeof(float));
+    memcpy(&env.sky_col[0], &s.env_.sky_col[0], 3 * sizeof(float));
+    env.sun_softness = s.env_.sun_softness;
+    env.env_map = s.env_.env_map;
+
+    aligned_vector<ray_packet_t<S>> primary_rays;
+    GeneratePrimaryRays<RayPacketDimX, RayPacketDimY>(1, cam, { 0, 0, ImageRes, ImageRes }, ImageRes, ImageRes, halton, primary_rays);
+
+    auto trace = [&](const aligned_vector<ray_packet_t<S>> &rays, const aligned_vector<simd_ivec<S>> &masks, int count,
+                     aligned_vector<hit_data_t<S>> &inters) {
+        for (int i = 0; i < count; i++) {
+            inters[i] = {};
+            inters[i].xy = rays[i].xy;
+            Traverse_MacroTree_CPU(rays[i], masks[i], &s.nodes_[0], root, &s.mesh_instances_[0], &s.mi_indices_[0], &s.meshes_[0],
+                                   &s.transforms_[0], &s.tris_[0], &s.tri_indices_[0], inters[i]);
+        }
+    };
+
+    const int primary_count = int(primary_rays.size());
+    const aligned_vector<simd_ivec<S>> primary_masks(primary_count, simd_ivec<S>{ -1 });
+    aligned_vector<hit_data_t<S>> primary_inters(primary_count);
+
+    AddRays(report, "Traverse_MacroTree_CPU", params, "primary", primary_count * S,
+            bench::Measure([&]() { trace(primary_rays, primary_masks, primary_count, primary_inters); }, min_time));
+
+    aligned_vector<ray_packet_t<S>> secondary_rays(primary_count);
+    aligned_vector<simd_ivec<S>> secondary_masks(primary_count);
+    int secondary_count = 0;
+
+    volatile float checksum = 0.0f;
+    AddRays(report, "ShadeSurface", params, "primary", primary_count * S, bench::Measure([&]() {
+        secondary_count = 0;
+        std::fill(secondary_masks.begin(), secondary_masks.end(), simd_ivec<S>{ 0 });
+
+        simd_fvec<S> sum = { 0.0f };
+        for (int i = 0; i < primary_count; i++) {
+            const hit_data_t<S> &inter = primary_inters[i];
+            const simd_ivec<S> index = (inter.xy & 0x0000FFFF) * ImageRes + (inter.xy >> 16);
+
+            simd_fvec<S> out_rgba[4] = { 0.0f };
+            ShadeSurface(index, 1, halton + HaltonBounceOffset(0), inter, primary_rays[i], env, &s.mesh_instances_[0], &s.mi_indices_[0],
+                         &s.meshes_[0], &s.transforms_[0], &s.vtx_indices_[0], &s.vertices_[0], &s.nodes_[0], root, &s.tris_[0],
+                         &s.tri_indices_[0], &s.materials_[0], &s.textures_[0], s.texture_atlas_, TexFilterBilinear, nullptr, out_rgba,
+                         &secondary_masks[0], &secondary_rays[0], &secondary_count);
+            sum += out_rgba[0];
+        }
+        checksum = checksum + sum[0];
+    }, min_time));
+
+    const int secondary_active = active_count(secondary_masks, secondary_count);
+
+    // sorting is done in place, so unsorted rays are restored before each run
+    aligned_vector<ray_packet_t<S>> sorted_rays(secondary_rays.begin(), secondary_rays.begin() + secondary_count);
+    aligned_vector<simd_ivec<S>> sorted_masks(secondary_masks.begin(), secondary_masks.begin() + secondary_count);
+    aligned_vector<simd_ivec<S>> hash_values(secondary_count);
+    std::vector<int> head_flags(secondary_count * S);
+    std::vector<uint32_t> scan_values(secondary_count * S), skeleton(secondary_count * S);
+    std::vector<ray_chunk_t> chunks(secondary_count * S), chunks_temp(secondary_count * S);
+
+    int sorted_count = secondary_count;
+    if (secondary_count) {
+        AddRays(report, "SortRays", params, "secondary", secondary_active, bench::Measure([&]() {
+            std::copy(secondary_rays.begin(), secondary_rays.begin() + secondary_count, sorted_rays.begin());
+            std::copy(secondary_masks.begin(), secondary_masks.begin() + secondary_count, sorted_masks.begin());
+            sorted_count = secondary_count;
+            SortRays(&sorted_rays[0], &sorted_masks[0], sorted_count, root_min, cell_size, &hash_values[0], &head_flags[0],
+                     &scan_values[0], &chunks[0], &chunks_temp[0], &skeleton[0]);
+        }, min_time));
+
+        aligned_vector<hit_data_t<S>> secondary_inters(sorted_count);
+        AddRays(report, "Traverse_MacroTree_CPU", params, "secondary", secondary_active,
+                bench::Measure([&]() { trace(sorted_rays, sorted_masks, sorted_count, secondary_inters); }, min_time));
+    }
+
+    // rays from primary hits towards sun, packets keep screen layout and are masked by hits
+    aligned_vector<ray_packet_t<S>> shadow_rays(primary_rays);
+    aligned_vector<simd_ivec<S>> shadow_masks(primary_count);
+    for (int i = 0; i < primary_count; i++) {
+        const hit_data_t<S> &inter = primary_inters[i];
+        ray_packet_t<S> &r = shadow_rays[i];
+        for (int k = 0; k < 3; k++) {
+            r.o[k] = r.o[k] + r.d[k] * inter.t + env.sun_dir[k] * 0.001f;
+            r.d[k] = { env.sun_dir[k] };
+        }
+        shadow_masks[i] = inter.mask;
+    }
+
+    const int shadow_active = active_count(shadow_masks, primary_count);
+    if (shadow_active) {
+        aligned_vector<hit_data_t<S>> shadow_inters(primary_count);
+        AddRays(report, "Traverse_MacroTree_CPU", params, "shadow", shadow_active,
+                bench::Measure([&]() { trace(shadow_rays, shadow_masks, primary_count, shadow_inters); }, min_time));
+    }
+}
+}
+}
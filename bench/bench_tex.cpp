@@ -0,0 +1,336 @@
+#include "bench_common.h"
+
+#include <cmath>
+#include <vector>
+
+#include "../internal/CoreRef.h"
+#include "../internal/TextureAtlasRef.h"
+#include "../internal/TexturePacker.h"
+#include "../internal/TextureSplitter.h"
+#include "../internal/TextureUtilsRef.h"
+#include "../internal/simd/detect.h"
+
+namespace {
+enum eSampleFunc { FuncNearest, FuncBilinear, FuncTrilinear, FuncAnisotropic };
+
+const char *FuncNames[] = { "SampleNearest", "SampleBilinear", "SampleTrilinear", "SampleAnisotropic" };
+
+/// UV coordinates ordered packet by packet, the way renderer traces screen tiles
+struct uv_stream_t {
+    std::vector<float> u, v;
+};
+}
+
+#if !defined(__ANDROID__)
+#include "../internal/RendererSSE.h"
+#include "../internal/RendererAVX.h"
+#include "../internal/RendererAVX2.h"
+#include "../internal/RendererAVX16.h"
+
+#define NS sse
+#include "bench_tex_simd.ipp"
+#undef NS
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx")
+#endif
+#define NS avx
+#include "bench_tex_simd.ipp"
+#undef NS
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2,fma")
+#endif
+#define NS avx2
+#include "bench_tex_simd.ipp"
+#undef NS
+#define NS avx16
+#include "bench_tex_simd.ipp"
+#undef NS
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+namespace {
+const int TexRes = 1024, ScreenRes = 256;
+
+float SampleStreamRef(eSampleFunc func, const ray::ref::TextureAtlas &atlas, const ray::texture_t &t, const uv_stream_t &stream,
+                      float lod, const float duv_dx[2], const float duv_dy[2]) {
+    using namespace ray::ref;
+
+    const simd_fvec2 _duv_dx = { duv_dx[0], duv_dx[1] }, _duv_dy = { duv_dy[0], duv_dy[1] };
+
+    simd_fvec4 sum = { 0.0f };
+
+    for (size_t i = 0; i < stream.u.size(); i++) {
+        const simd_fvec2 uvs = { stream.u[i], stream.v[i] };
+
+        switch (func) {
+        case FuncNearest:
+            sum += SampleNearest(atlas, t, uvs, lod);
+            break;
+        case FuncBilinear:
+            sum += SampleBilinear(atlas, t, uvs, int(lod));
+            break;
+        case FuncTrilinear:
+            sum += SampleTrilinear(atlas, t, uvs, lod);
+            break;
+        case FuncAnisotropic:
+            sum += SampleAnisotropic(atlas, t, uvs, _duv_dx, _duv_dy);
+            break;
+        }
+    }
+
+    return sum[0] + sum[3];
+}
+
+using SampleStreamFunc = float(*)(eSampleFunc func, const ray::ref::TextureAtlas &atlas, const ray::texture_t &t, const uv_stream_t &stream,
+                                  float lod, const float duv_dx[2], const float duv_dy[2]);
+
+struct backend_t {
+    const char *name;
+    int packet_dims[2];
+    SampleStreamFunc sample_stream;
+};
+
+float ValueNoise(int x, int y, int seed) {
+    uint32_t h = uint32_t(x) * 374761393u + uint32_t(y) * 668265263u + uint32_t(seed) * 2147483647u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return float((h ^ (h >> 16)) & 0xffff) / 65535.0f;
+}
+
+float SmoothNoise(float x, float y, int seed) {
+    const int ix = (int)std::floor(x), iy = (int)std::floor(y);
+    float fx = x - ix, fy = y - iy;
+    fx = fx * fx * (3 - 2 * fx);
+    fy = fy * fy * (3 - 2 * fy);
+
+    const float n0 = ValueNoise(ix, iy, seed) * (1 - fx) + ValueNoise(ix + 1, iy, seed) * fx,
+                n1 = ValueNoise(ix, iy + 1, seed) * (1 - fx) + ValueNoise(ix + 1, iy + 1, seed) * fx;
+    return n0 * (1 - fy) + n1 * fy;
+}
+
+/// Stone-like albedo: fractal noise tinted between two colors, with mortar lines of brick pattern
+std::vector<ray::pixel_color8_t> GenerateTexture(int res) {
+    std::vector<ray::pixel_color8_t> tex(size_t(res) * res);
+
+    const float brick_w = res / 8.0f, brick_h = res / 16.0f;
+
+    for (int y = 0; y < res; y++) {
+        for (int x = 0; x < res; x++) {
+            float n = 0.0f, amp = 0.5f, freq = 8.0f / res;
+            for (int octave = 0; octave < 6; octave++) {
+                n += amp * SmoothNoise(x * freq, y * freq, octave);
+                amp *= 0.5f;
+                freq *= 2.0f;
+            }
+
+            const int row = int(y / brick_h);
+            const float bx = std::fmod(x + (row % 2) * 0.5f * brick_w, brick_w), by = std::fmod(float(y), brick_h);
+            const bool mortar = bx < 2.0f || by < 2.0f;
+
+            const float r = mortar ? 0.6f : 0.35f + 0.4f * n,
+                        g = mortar ? 0.58f : 0.2f + 0.25f * n,
+                        b = mortar ? 0.55f : 0.15f + 0.15f * n;
+
+            tex[size_t(y) * res + x] = { uint8_t(r * 255), uint8_t(g * 255), uint8_t(b * 255), uint8_t(mortar ? 255 : 200 + 55 * n) };
+        }
+    }
+
+    return tex;
+}
+
+/** Coherent stream walks texture like screen walks a rotated plane, one pixel step covers 2^lod texels.
+    Random stream has uniformly distributed coordinates
+*/
+uv_stream_t GenerateStream(bool coherent, int lod, const int packet_dims[2]) {
+    uv_stream_t ret;
+    ret.u.reserve(ScreenRes * ScreenRes);
+    ret.v.reserve(ScreenRes * ScreenRes);
+
+    const float step = float(1 << lod) / TexRes, c = std::cos(0.5f) * step, s = std::sin(0.5f) * step;
+
+    uint32_t rnd = 12345;
+    for (int py = 0; py < ScreenRes; py += packet_dims[1]) {
+        for (int px = 0; px < ScreenRes; px += packet_dims[0]) {
+            for (int y = py; y < py + packet_dims[1]; y++) {
+                for (int x = px; x < px + packet_dims[0]; x++) {
+                    if (coherent) {
+                        ret.u.push_back(0.1f + x * c - y * s);
+                        ret.v.push_back(0.2f + x * s + y * c);
+                    } else {
+                        rnd = rnd * 1664525u + 1013904223u;
+                        ret.u.push_back(float(rnd >> 8) / (1 << 24));
+                        rnd = rnd * 1664525u + 1013904223u;
+                        ret.v.push_back(float(rnd >> 8) / (1 << 24));
+                    }
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+/// Places textures the way atlas does (first page that fits, new page otherwise), returns occupancy of used pages
+template <typename Packer>
+double PackTextures(const std::vector<std::pair<int, int>> &sizes) {
+    const int page_res[2] = { ray::MAX_TEXTURE_SIZE, ray::MAX_TEXTURE_SIZE };
+
+    std::vector<Packer> pages;
+    long long used_texels = 0;
+
+    for (const auto &sz : sizes) {
+        const int res[2] = { sz.first, sz.second };
+        int pos[2];
+
+        size_t page = 0;
+        for (; page < pages.size(); page++) {
+            if (pages[page].Allocate(res, pos) != -1) break;
+        }
+        if (page == pages.size()) {
+            pages.emplace_back(page_res);
+            pages.back().Allocate(res, pos);
+        }
+
+        used_texels += (long long)res[0] * res[1];
+    }
+
+    return double(used_texels) / (double(pages.size()) * page_res[0] * page_res[1]);
+}
+
+const char *CompressionName(ray::eTexCompression compression) {
+    if (compression == ray::TexCompressionNone) return "none";
+    else if (compression == ray::TexCompressionBC1) return "bc1";
+    else return "bc3";
+}
+}
+
+int main(int argc, char *argv[]) {
+    using namespace ray;
+
+    const char *out_file = nullptr;
+    double min_time = 0.05;
+    if (!bench::ParseArgs(argc, argv, out_file, min_time)) return -1;
+
+    std::vector<backend_t> backends = { { "ref", { 1, 1 }, SampleStreamRef } };
+#if !defined(__ANDROID__)
+    const auto features = GetCpuFeatures();
+    if (features.sse2_supported) {
+        backends.push_back({ "sse", { sse::RayPacketDimX, sse::RayPacketDimY }, sse::SampleStream });
+    }
+    if (features.avx_supported) {
+        backends.push_back({ "avx", { avx::RayPacketDimX, avx::RayPacketDimY }, avx::SampleStream });
+    }
+    if (features.avx2_supported && features.fma_supported) {
+        backends.push_back({ "avx2", { avx2::RayPacketDimX, avx2::RayPacketDimY }, avx2::SampleStream });
+        backends.push_back({ "avx16", { avx16::RayPacketDimX, avx16::RayPacketDimY }, avx16::SampleStream });
+    }
+#endif
+
+    const auto tex_data = GenerateTexture(TexRes);
+    const int tex_res[2] = { TexRes, TexRes };
+
+    bench::Report report("bench_tex");
+
+    const eTexCompression compressions[] = { TexCompressionNone, TexCompressionBC1 };
+    for (const eTexCompression compression : compressions) {
+        ref::TextureAtlas atlas(2048, 2048, 1, compression);
+
+        texture_t t;
+        if (!ref::AllocateTextureMips(atlas, &tex_data[0], tex_res, true, t)) {
+            fprintf(stderr, "Failed to allocate texture\n");
+            return -1;
+        }
+
+        for (const auto &backend : backends) {
+            const int width = backend.packet_dims[0] * backend.packet_dims[1];
+
+            for (const bool coherent : { true, false }) {
+                for (const int lod : { 0, 2, 4 }) {
+                    const auto stream = GenerateStream(coherent, lod, backend.packet_dims);
+
+                    // footprint with 4:1 anisotropy, minor axis matches stream step
+                    const float step = float(1 << lod) / TexRes;
+                    const float duv_dx[2] = { 4 * step * std::cos(0.5f), 4 * step * std::sin(0.5f) },
+                                duv_dy[2] = { -step * std::sin(0.5f), step * std::cos(0.5f) };
+
+                    for (const eSampleFunc func : { FuncNearest, FuncBilinear, FuncTrilinear, FuncAnisotropic }) {
+                        // trilinear is measured between levels
+                        const float _lod = func == FuncTrilinear ? lod + 0.5f : float(lod);
+
+                        volatile float checksum = 0.0f;
+                        const double elapsed = bench::Measure([&]() {
+                            checksum = checksum + backend.sample_stream(func, atlas, t, stream, _lod, duv_dx, duv_dy);
+                        }, min_time);
+
+                        report.Add(FuncNames[func], { { "backend", backend.name }, { "width", double(width) },
+                                                      { "compression", CompressionName(compression) },
+                                                      { "stream", coherent ? "coherent" : "random" }, { "lod", double(lod) } },
+                                   double(stream.u.size()) / elapsed * 0.000001, "Msamples/s");
+                    }
+                }
+            }
+        }
+    }
+
+    {   // mip chains of texture batch
+        const int BatchSize = 16;
+
+        tex_desc_t descs[BatchSize] = {};
+        for (auto &d : descs) {
+            d.data = &tex_data[0];
+            d.w = d.h = TexRes;
+            d.generate_mipmaps = true;
+        }
+
+        std::vector<ref::mip_chain_t> chains(BatchSize);
+        const double elapsed = bench::Measure([&]() {
+            ref::GenerateMipChains(descs, BatchSize, &chains[0]);
+        }, min_time);
+
+        report.Add("GenerateMipChains", { { "batch", double(BatchSize) }, { "res", double(TexRes) } },
+                   double(BatchSize) * TexRes * TexRes / elapsed * 0.000001, "Mtexels/s");
+    }
+
+    {   // atlas packing of many small textures, sizes are log-uniform with random aspect, 1px border included
+        std::vector<std::pair<int, int>> sizes;
+
+        uint32_t rnd = 12345;
+        for (int i = 0; i < 20000; i++) {
+            rnd = rnd * 1664525u + 1013904223u;
+            const int size = 4 << ((rnd >> 8) % 7);
+            const int aspect = (rnd >> 16) % 3;
+            const bool flip = ((rnd >> 20) & 1) != 0;
+
+            const int w = size + 2, h = (size >> aspect) + 2;
+            sizes.emplace_back(flip ? h : w, flip ? w : h);
+        }
+
+        double occupancy = 0.0;
+        double elapsed = bench::Measure([&]() { occupancy = PackTextures<TextureSplitter>(sizes); }, min_time);
+        report.Add("TextureSplitter", { { "textures", double(sizes.size()) }, { "occupancy", occupancy } }, elapsed * 1000.0, "ms");
+
+        elapsed = bench::Measure([&]() { occupancy = PackTextures<TexturePacker>(sizes); }, min_time);
+        report.Add("TexturePacker", { { "textures", double(sizes.size()) }, { "occupancy", occupancy } }, elapsed * 1000.0, "ms");
+    }
+
+    if (!report.Write(out_file)) {
+        fprintf(stderr, "Failed to write %s\n", out_file);
+        return -1;
+    }
+}
@@ -0,0 +1,43 @@
+// Included with NS defined, renderer header of backend must be included before
+
+namespace ray {
+namespace NS {
+float SampleStream(eSampleFunc func, const ref::TextureAtlas &atlas, const texture_t &t, const uv_stream_t &stream,
+                   float lod, const float duv_dx[2], const float duv_dy[2]) {
+    const int S = RayPacketSize;
+
+    const simd_ivec<S> mask = { -1 }, ilod = { int(lod) };
+    const simd_fvec<S> flod = { lod },
+                       _duv_dx[2] = { { duv_dx[0] }, { duv_dx[1] } },
+                       _duv_dy[2] = { { duv_dy[0] }, { duv_dy[1] } };
+
+    simd_fvec<S> sum = { 0.0f };
+
+    for (size_t i = 0; i + S <= stream.u.size(); i += S) {
+        const simd_fvec<S> uvs[2] = { simd_fvec<S>{ &stream.u[i] }, simd_fvec<S>{ &stream.v[i] } };
+
+        simd_fvec<S> col[4];
+        switch (func) {
+        case FuncNearest:
+            SampleNearest(atlas, t, uvs, flod, mask, col);
+            break;
+        case FuncBilinear:
+            SampleBilinear(atlas, t, uvs, ilod, mask, col);
+            break;
+        case FuncTrilinear:
+            SampleTrilinear(atlas, t, uvs, flod, mask, col);
+            break;
+        case FuncAnisotropic:
+            SampleAnisotropic(atlas, t, uvs, _duv_dx, _duv_dy, mask, col);
+            break;
+        }
+
+        sum += col[0] + col[3];
+    }
+
+    float ret = 0.0f;
+    for (int i = 0; i < S; i++) ret += sum[i];
+    return ret;
+}
+}
+}
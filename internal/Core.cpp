@@ -8,6 +8,7 @@
 #include <vector>
 
 #include "BVHSplit.h"
+#include "Trace.h"
 
 namespace ray {
 const float axis_aligned_normal_eps = 0.000001f;
@@ -17,6 +18,18 @@ force_inline ref::simd_fvec3 cross(const ref::simd_fvec3 &v1, const ref::simd_fv
              v1[2] * v2[0] - v1[0] * v2[2],
              v1[0] * v2[1] - v1[1] * v2[0] };
 }
+
+// lat-long mapping, y axis points up
+force_inline void EnvMapDirToUV(const float dir[3], float &u, float &v) {
+    u = 0.5f + std::atan2(dir[2], dir[0]) / (2 * PI);
+    v = std::acos(std::max(std::min(dir[1], 1.0f), -1.0f)) / PI;
+}
+
+force_inline int EnvMapCellIndex(const env_map_t &env, float u, float v) {
+    const int x = std::min(int(u * env.cells_res[0]), env.cells_res[0] - 1),
+              y = std::min(int(v * env.cells_res[1]), env.cells_res[1] - 1);
+    return y * env.cells_res[0] + x;
+}
 }
 
 const float ray::uint8_to_float_table[] = {
@@ -132,6 +145,8 @@ void ray::PreprocessTri(const float *p, int stride, tri_accel_t *acc) {
 
 uint32_t ray::PreprocessMesh(const float *attrs, size_t attrs_count, const uint32_t *vtx_indices, size_t vtx_indices_count, eVertexLayout layout,
                              std::vector<bvh_node_t> &out_nodes, std::vector<tri_accel_t> &out_tris, std::vector<uint32_t> &out_tri_indices) {
+    TRACE_SCOPE("PreprocessMesh");
+
     assert(vtx_indices_count && vtx_indices_count % 3 == 0);
     assert(layout == PxyzNxyzTuv);
 
@@ -170,6 +185,8 @@ uint32_t ray::PreprocessMesh(const float *attrs, size_t attrs_count, const uint3
 
 uint32_t ray::PreprocessPrims(const prim_t *prims, size_t prims_count,
                               std::vector<bvh_node_t> &out_nodes, std::vector<uint32_t> &out_indices) {
+    TRACE_SCOPE("PreprocessPrims");
+
     struct prims_coll_t {
         std::vector<uint32_t> indices;
         ref::simd_fvec3 min = { std::numeric_limits<float>::max() }, max = { std::numeric_limits<float>::lowest() };
@@ -374,4 +391,164 @@ void ray::InverseMatrix(const float mat[16], float out_mat[16]) {
     out_mat[13] = inv_det *   (mat[0] * A1223 - mat[1] * A0223 + mat[2] * A0123);
     out_mat[14] = inv_det * -(mat[0] * A1213 - mat[1] * A0213 + mat[2] * A0113);
     out_mat[15] = inv_det *   (mat[0] * A1212 - mat[1] * A0212 + mat[2] * A0112);
-}
\ No newline at end of file
+}
+
+void ray::EncodeRGBE(const float rgb[3], pixel_color8_t &out_texel) {
+    const float v = std::max(rgb[0], std::max(rgb[1], rgb[2]));
+    if (v < 1e-32f) {
+        out_texel = { 0, 0, 0, 0 };
+        return;
+    }
+
+    int e;
+    const float f = std::frexp(v, &e) * 256.0f / v;
+
+    out_texel.r = uint8_t(std::max(rgb[0], 0.0f) * f);
+    out_texel.g = uint8_t(std::max(rgb[1], 0.0f) * f);
+    out_texel.b = uint8_t(std::max(rgb[2], 0.0f) * f);
+    out_texel.a = uint8_t(e + 128);
+}
+
+void ray::BuildEnvMapCells(const pixel_color8_t *texels, const int res[2], std::vector<env_cell_t> &out_cells, int out_cells_res[2]) {
+    const int cw = std::min(res[0], ENV_CELLS_RES_X), ch = std::min(res[1], ENV_CELLS_RES_Y);
+    const int count = cw * ch;
+
+    std::vector<double> weights(count);
+    double total = 0.0;
+
+    for (int cy = 0; cy < ch; cy++) {
+        const int y0 = cy * res[1] / ch, y1 = std::max((cy + 1) * res[1] / ch, y0 + 1);
+        // solid angle of lat-long cell is proportional to sine of its polar angle
+        const double sin_theta = std::sin(PI * (cy + 0.5) / ch);
+
+        for (int cx = 0; cx < cw; cx++) {
+            const int x0 = cx * res[0] / cw, x1 = std::max((cx + 1) * res[0] / cw, x0 + 1);
+
+            double lum = 0.0;
+            for (int y = y0; y < y1; y++) {
+                for (int x = x0; x < x1; x++) {
+                    float rgb[3];
+                    DecodeRGBE(texels[y * res[0] + x], rgb);
+                    lum += 0.2126 * rgb[0] + 0.7152 * rgb[1] + 0.0722 * rgb[2];
+                }
+            }
+
+            const double w = sin_theta * lum / ((y1 - y0) * (x1 - x0));
+            weights[cy * cw + cx] = w;
+            total += w;
+        }
+    }
+
+    if (total <= 0.0) {
+        // black map, fall back to uniform sphere sampling
+        for (int cy = 0; cy < ch; cy++) {
+            for (int cx = 0; cx < cw; cx++) {
+                weights[cy * cw + cx] = std::sin(PI * (cy + 0.5) / ch);
+                total += weights[cy * cw + cx];
+            }
+        }
+    }
+
+    out_cells.resize(count);
+
+    // Vose's alias method
+    std::vector<double> scaled(count);
+    std::vector<uint32_t> small, large;
+    for (int i = 0; i < count; i++) {
+        out_cells[i].pdf = float(weights[i] / total);
+        out_cells[i].alias = uint32_t(i);
+        out_cells[i].pad = 0;
+
+        scaled[i] = weights[i] * count / total;
+        if (scaled[i] < 1.0) {
+            small.push_back(uint32_t(i));
+        } else {
+            large.push_back(uint32_t(i));
+        }
+    }
+
+    while (!small.empty() && !large.empty()) {
+        const uint32_t s = small.back(), l = large.back();
+        small.pop_back();
+
+        out_cells[s].q = float(scaled[s]);
+        out_cells[s].alias = l;
+
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // leftovers differ from 1 only by rounding error
+    for (uint32_t i : small) out_cells[i].q = 1.0f;
+    for (uint32_t i : large) out_cells[i].q = 1.0f;
+
+    out_cells_res[0] = cw;
+    out_cells_res[1] = ch;
+}
+
+void ray::EvalEnvMap(const env_map_t &env, const float dir[3], float out_col[3]) {
+    float u, v;
+    EnvMapDirToUV(dir, u, v);
+
+    const float fx = u * env.res[0] - 0.5f, fy = v * env.res[1] - 0.5f;
+    const float _x0 = std::floor(fx), _y0 = std::floor(fy);
+    const float kx = fx - _x0, ky = fy - _y0;
+
+    // wraps around horizontally, clamps at poles
+    const int x0 = (int(_x0) + env.res[0]) % env.res[0], x1 = (x0 + 1) % env.res[0];
+    const int y0 = std::max(int(_y0), 0), y1 = std::min(int(_y0) + 1, env.res[1] - 1);
+
+    float c00[3], c01[3], c10[3], c11[3];
+    DecodeRGBE(env.texels[y0 * env.res[0] + x0], c00);
+    DecodeRGBE(env.texels[y0 * env.res[0] + x1], c01);
+    DecodeRGBE(env.texels[y1 * env.res[0] + x0], c10);
+    DecodeRGBE(env.texels[y1 * env.res[0] + x1], c11);
+
+    for (int i = 0; i < 3; i++) {
+        out_col[i] = (c00[i] * (1 - kx) + c01[i] * kx) * (1 - ky) + (c10[i] * (1 - kx) + c11[i] * kx) * ky;
+    }
+}
+
+float ray::EnvMapPdf(const env_map_t &env, const float dir[3]) {
+    const float sin_theta = std::sqrt(std::max(1.0f - dir[1] * dir[1], 0.0f));
+    if (sin_theta <= 0.0f) return 0.0f;
+
+    float u, v;
+    EnvMapDirToUV(dir, u, v);
+
+    const int count = env.cells_res[0] * env.cells_res[1];
+    return env.cells[EnvMapCellIndex(env, u, v)].pdf * count / (2 * PI * PI * sin_theta);
+}
+
+float ray::SampleEnvMap(const env_map_t &env, float r1, float r2, float out_dir[3]) {
+    const int count = env.cells_res[0] * env.cells_res[1];
+
+    // fractional part is reused to pick between cell and its alias, then as position inside of cell
+    const float f = r1 * count;
+    int i = std::min(int(f), count - 1);
+    float k = std::min(f - i, 0.99999994f);
+
+    const env_cell_t &c = env.cells[i];
+    if (k < c.q) {
+        k = k / c.q;
+    } else {
+        k = (k - c.q) / (1.0f - c.q);
+        i = int(c.alias);
+    }
+
+    const float u = (i % env.cells_res[0] + k) / env.cells_res[0],
+                v = (i / env.cells_res[0] + r2) / env.cells_res[1];
+
+    const float theta = v * PI, phi = (u - 0.5f) * 2 * PI;
+    const float sin_theta = std::sin(theta);
+
+    out_dir[0] = sin_theta * std::cos(phi);
+    out_dir[1] = std::cos(theta);
+    out_dir[2] = sin_theta * std::sin(phi);
+
+    if (sin_theta <= 0.0f) return 0.0f;
+    return env.cells[i].pdf * count / (2 * PI * PI * sin_theta);
+}
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <cstdint>
+#include <vector>
 
 #include "../SceneBase.h"
 #include "../Types.h"
@@ -68,6 +71,70 @@ struct texture_t {
 };
 static_assert(sizeof(texture_t) == 64, "!");
 
+/// Value of texture request, which was not sampled during render pass
+const int8_t TexNotRequested = 127;
+
+/** Records mip level requested by shading for streamed texture.
+    Level is relative to the finest resident one (negative values request finer levels).
+*/
+force_inline void RequestTextureLod(int8_t *requests, uint32_t index, float lod) {
+    const int _lod = (lod > -NUM_MIP_LEVELS) ? (lod < NUM_MIP_LEVELS ? int(lod + NUM_MIP_LEVELS) - NUM_MIP_LEVELS : NUM_MIP_LEVELS) : -NUM_MIP_LEVELS;
+    if (_lod < requests[index]) requests[index] = int8_t(_lod);
+}
+
+/// Mip level for single tap filtering, pixel footprint is approximated by its longer axis
+force_inline float IsotropicTextureLod(const texture_t &t, const float duv_dx[2], const float duv_dy[2]) {
+    const float dx[2] = { duv_dx[0] * t.size[0], duv_dx[1] * t.size[1] },
+                dy[2] = { duv_dy[0] * t.size[0], duv_dy[1] * t.size[1] };
+    const float l = std::max(dx[0] * dx[0] + dx[1] * dx[1], dy[0] * dy[0] + dy[1] * dy[1]);
+    return 0.5f * std::log2(l);
+}
+
+/// Cell of alias table used for importance sampling of environment map
+struct env_cell_t {
+    float q;            // probability of keeping this cell instead of its alias
+    float pdf;          // probability of picking this cell
+    uint32_t alias;
+    uint32_t pad;
+};
+static_assert(sizeof(env_cell_t) == 16, "!");
+
+/// Maximal resolution of grid of environment map cells, texels are averaged into cells
+const int ENV_CELLS_RES_X = 256;
+const int ENV_CELLS_RES_Y = 128;
+
+/// Lat-long HDR environment map with alias table over its cells
+struct env_map_t {
+    const pixel_color8_t *texels = nullptr;
+    const env_cell_t *cells = nullptr;
+    int res[2] = {}, cells_res[2] = {};
+};
+
+force_inline void DecodeRGBE(const pixel_color8_t &t, float out_rgb[3]) {
+    const float f = t.a ? std::ldexp(1.0f, int(t.a) - (128 + 8)) : 0.0f;
+    out_rgb[0] = t.r * f;
+    out_rgb[1] = t.g * f;
+    out_rgb[2] = t.b * f;
+}
+
+/// Weight of sample drawn with pdf a, when pdf b is used by other strategy
+force_inline float PowerHeuristic(float a, float b) {
+    const float t = a * a;
+    return t / (b * b + t);
+}
+
+/// Builds alias table over cells of environment map, weighted by luminance and solid angle
+void BuildEnvMapCells(const pixel_color8_t *texels, const int res[2], std::vector<env_cell_t> &out_cells, int out_cells_res[2]);
+
+/// Bilinearly filtered radiance of environment map in direction dir
+void EvalEnvMap(const env_map_t &env, const float dir[3], float out_col[3]);
+
+/// Solid angle pdf of sampling direction dir with SampleEnvMap
+float EnvMapPdf(const env_map_t &env, const float dir[3]);
+
+/// Samples direction proportionally to environment map radiance, returns its solid angle pdf
+float SampleEnvMap(const env_map_t &env, float r1, float r2, float out_dir[3]);
+
 const int MAX_MATERIAL_TEXTURES = 7;
 
 const int NORMALS_TEXTURE = 0;
@@ -113,12 +180,23 @@ void TransformBoundingBox(const float bbox[2][3], const float *xform, float out_
 
 void InverseMatrix(const float mat[16], float out_mat[16]);
 
-const int PrimesCount = 11;
-const int g_primes[PrimesCount] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31 };
-const int g_prime_sums[PrimesCount] = { 0, 2, 5, 10, 17, 28, 41, 58, 77, 100, 129 };
+const int PrimesCount = 27;
+const int g_primes[PrimesCount] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53, 59, 61, 67, 71, 73, 79, 83, 89, 97, 101, 103 };
+const int g_prime_sums[PrimesCount] = { 0, 2, 5, 10, 17, 28, 41, 58, 77, 100, 129, 160, 197, 238, 281, 328, 381, 440, 501, 568, 639, 712, 791, 874, 963, 1060, 1161 };
 
 const int HaltonSeqLen = 256;
 
+/// Dimensions of Halton point used by each shading event (primary hit and every bounce)
+enum eHaltonDim { HaltonMixPick, HaltonLightU, HaltonLightV, HaltonBsdfU, HaltonBsdfV, HaltonDimsPerBounce };
+
+/// First two dimensions jitter primary rays, bounces follow them, dimension d uses base g_primes[d]
+const int HaltonPixelDims = 2;
+const int HaltonDimsCount = HaltonPixelDims + HaltonDimsPerBounce * (MAX_BOUNCES + 1);
+static_assert(HaltonDimsCount <= PrimesCount, "!");
+
+/// Offset to dimensions of shading event in table of Halton points, which is stored dimension by dimension
+inline int HaltonBounceOffset(int depth) { return (HaltonPixelDims + HaltonDimsPerBounce * depth) * HaltonSeqLen; }
+
 struct vertex_t {
     float p[3], n[3], b[3], t0[2];
 };
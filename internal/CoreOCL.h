@@ -6,19 +6,45 @@
 //#define CL_HPP_ENABLE_EXCEPTIONS
 #include <CL/cl2.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 #include "Core.h"
 
 namespace ray {
 namespace ocl {
-struct ray_packet_t {
-    // origin and direction (o.w and d.w are used for pixel coordinates)
-    cl_float4 o, d;
-    // color of ray, determines secondary ray influence
-    cl_float3 c;
-    // derivatives
-    cl_float3 do_dx, dd_dx, do_dy, dd_dy;
+// compact ray layout stored in ray buffers, kernels unpack it to full precision for computations
+struct packed_ray_t {
+    // origin
+    cl_float o[3];
+    // pixel coordinates (14 bits each) and bounce depth (4 bits)
+    cl_uint id;
+    // octahedral encoded direction (2 x 16-bit snorm)
+    cl_uint d;
+    // color of ray (determines secondary ray influence) and ior as half floats
+    cl_ushort c[4];
+    // derivatives as half floats
+    cl_ushort do_dx[4], dd_dx[4], do_dy[4], dd_dy[4];
+    // pdf of diffuse bounce direction (zero if ray cannot be produced by light sampling)
+    cl_float pdf;
 };
-static_assert(sizeof(ray_packet_t) == 112, "!");
+static_assert(sizeof(packed_ray_t) == 64, "!");
+
+/// Largest framebuffer side, pixel coordinates of packed_ray_t::id have to fit in 14 bits
+const int MAX_FRAMEBUFFER_SIZE = (1 << 14) - 1;
+
+inline void DecodeOctahedral(cl_uint e, float out_d[3]) {
+    const float px = float(int16_t(e & 0xffff)) / 32767.0f,
+                py = float(int16_t(e >> 16)) / 32767.0f;
+    float n[3] = { px, py, 1.0f - std::abs(px) - std::abs(py) };
+    const float t = std::max(-n[2], 0.0f);
+    n[0] += n[0] >= 0.0f ? -t : t;
+    n[1] += n[1] >= 0.0f ? -t : t;
+    const float l = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+    for (int i = 0; i < 3; i++) {
+        out_d[i] = n[i] / l;
+    }
+}
 
 const int RayPacketDimX = 1;
 const int RayPacketDimY = 1;
@@ -48,9 +74,26 @@ struct environment_t {
     cl_float3 sun_col;
     cl_float3 sky_col; // TODO: replace with spherical garm.
     cl_float sun_softness;
-    cl_float pad[3];
-    // TODO: add environment texture
+    // resolution of HDR environment map and of its cells (zero if there is no map)
+    cl_ushort env_map_res[2], env_cells_res[2];
+    cl_float pad;
 };
 static_assert(sizeof(environment_t) == 64, "!");
+
+/// Scene features used to compile specialized kernels, code for missing features is compiled out
+enum eSceneFeatures {
+    GlossyMaterials         = (1 << 0),
+    RefractiveMaterials     = (1 << 1),
+    EmissiveMaterials       = (1 << 2),
+    MixMaterials            = (1 << 3),
+    TransparentMaterials    = (1 << 4),
+    NormalMaps              = (1 << 5),
+    MultipleTexturePages    = (1 << 6),
+    EnvironmentMap          = (1 << 7),
+};
+const uint32_t AllSceneFeatures = (1 << 8) - 1;
+
+/// Not a scene feature, selects debug variant of program which counts traversal cost
+const uint32_t CountTraversalCost = (1u << 31);
 }
 }
\ No newline at end of file
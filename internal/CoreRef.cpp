@@ -196,8 +196,8 @@ void ray::ref::GeneratePrimaryRays(int iteration, const camera_t &cam, const rec
             const int index = y * w + x;
             const int hi = (hash(index) + iteration) & (HaltonSeqLen - 1);
 
-            float _x = (float)x + halton[hi * 2];
-            float _y = (float)y + halton[hi * 2 + 1];
+            float _x = (float)x + halton[0 * HaltonSeqLen + hi];
+            float _y = (float)y + halton[1 * HaltonSeqLen + hi];
 
             simd_fvec3 _d = get_pix_dir(_x, _y);
 
@@ -218,6 +218,7 @@ void ray::ref::GeneratePrimaryRays(int iteration, const camera_t &cam, const rec
             out_r.id.x = (uint16_t)x;
             out_r.id.y = (uint16_t)y;
             out_r.ior = 1.0f;
+            out_r.pdf = 0.0f;
         }
     }
 }
@@ -343,9 +344,78 @@ bool ray::ref::IntersectTris(const ray_packet_t &r, const tri_accel_t *tris, con
     return inter.mask_values[0] != 0;
 }
 
-bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t root_index,
-                                      const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
-                                      const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t &inter) {
+namespace ray {
+namespace ref {
+// traversal is instantiated twice, counting of cost is compiled out of normal path
+template <bool CountCost>
+bool _Traverse_MicroTree_CPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t root_index,
+                             const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t &inter, traversal_cost_t *cost) {
+    bool res = false;
+
+    uint32_t cur = root_index;
+    eTraversalSource src = FromSibling;
+
+    if (!is_leaf_node(nodes[root_index])) {
+        cur = near_child(r, nodes[root_index]);
+        src = FromParent;
+    }
+
+    while (true) {
+        switch (src) {
+        case FromChild:
+            if (cur == root_index || cur == 0xffffffff) return res;
+            if (cur == near_child(r, nodes[nodes[cur].parent])) {
+                cur = nodes[cur].sibling;
+                src = FromSibling;
+            } else {
+                cur = nodes[cur].parent;
+                src = FromChild;
+            }
+            break;
+        case FromSibling:
+            if (CountCost) cost->nodes++;
+            if (!bbox_test(r.o, inv_d, inter.t, nodes[cur])) {
+                cur = nodes[cur].parent;
+                src = FromChild;
+            } else if (is_leaf_node(nodes[cur])) {
+                // process leaf
+                if (CountCost) cost->tris += nodes[cur].prim_count;
+                res |= IntersectTris(r, tris, &tri_indices[nodes[cur].prim_index], nodes[cur].prim_count, obj_index, inter);
+
+                cur = nodes[cur].parent;
+                src = FromChild;
+            } else {
+                cur = near_child(r, nodes[cur]);
+                src = FromParent;
+            }
+            break;
+        case FromParent:
+            if (CountCost) cost->nodes++;
+            if (!bbox_test(r.o, inv_d, inter.t, nodes[cur])) {
+                cur = nodes[cur].sibling;
+                src = FromSibling;
+            } else if (is_leaf_node(nodes[cur])) {
+                // process leaf
+                if (CountCost) cost->tris += nodes[cur].prim_count;
+                res |= IntersectTris(r, tris, &tri_indices[nodes[cur].prim_index], nodes[cur].prim_count, obj_index, inter);
+
+                cur = nodes[cur].sibling;
+                src = FromSibling;
+            } else {
+                cur = near_child(r, nodes[cur]);
+                src = FromParent;
+            }
+            break;
+        }
+    }
+
+    return res;
+}
+
+template <bool CountCost>
+bool _Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t root_index,
+                             const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                             const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t &inter, traversal_cost_t *cost) {
     bool res = false;
 
     float inv_d[3];
@@ -372,6 +442,7 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
             }
             break;
         case FromSibling:
+            if (CountCost) cost->nodes++;
             if (!bbox_test(r.o, inv_d, inter.t, nodes[cur])) {
                 cur = nodes[cur].parent;
                 src = FromChild;
@@ -382,6 +453,7 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
                     const auto &m = meshes[mi.mesh_index];
                     const auto &tr = transforms[mi.tr_index];
 
+                    if (CountCost) cost->nodes++;
                     if (!bbox_test(r.o, inv_d, inter.t, mi.bbox_min, mi.bbox_max)) continue;
 
                     ray_packet_t _r = TransformRay(r, tr.inv_xform);
@@ -389,7 +461,7 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
                     float _inv_d[3];
                     safe_invert(_r.d, _inv_d);
 
-                    res |= Traverse_MicroTree_CPU(_r, _inv_d, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter);
+                    res |= _Traverse_MicroTree_CPU<CountCost>(_r, _inv_d, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter, cost);
                 }
 
                 cur = nodes[cur].parent;
@@ -400,6 +472,7 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
             }
             break;
         case FromParent:
+            if (CountCost) cost->nodes++;
             if (!bbox_test(r.o, inv_d, inter.t, nodes[cur])) {
                 cur = nodes[cur].sibling;
                 src = FromSibling;
@@ -410,6 +483,7 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
                     const auto &m = meshes[mi.mesh_index];
                     const auto &tr = transforms[mi.tr_index];
 
+                    if (CountCost) cost->nodes++;
                     if (!bbox_test(r.o, inv_d, inter.t, mi.bbox_min, mi.bbox_max)) continue;
 
                     ray_packet_t _r = TransformRay(r, tr.inv_xform);
@@ -417,7 +491,7 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
                     float _inv_d[3];
                     safe_invert(_r.d, _inv_d);
 
-                    res |= Traverse_MicroTree_CPU(_r, _inv_d, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter);
+                    res |= _Traverse_MicroTree_CPU<CountCost>(_r, _inv_d, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter, cost);
                 }
 
                 cur = nodes[cur].sibling;
@@ -432,6 +506,20 @@ bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *n
 
     return res;
 }
+}
+}
+
+bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t root_index,
+                                      const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                                      const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t &inter) {
+    return _Traverse_MacroTree_CPU<false>(r, nodes, root_index, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter, nullptr);
+}
+
+bool ray::ref::Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t root_index,
+                                      const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                                      const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t &inter, traversal_cost_t &inout_cost) {
+    return _Traverse_MacroTree_CPU<true>(r, nodes, root_index, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter, &inout_cost);
+}
 
 bool ray::ref::Traverse_MacroTree_GPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t root_index,
                                       const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
@@ -498,62 +586,12 @@ bool ray::ref::Traverse_MacroTree_GPU(const ray_packet_t &r, const bvh_node_t *n
 
 bool ray::ref::Traverse_MicroTree_CPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t root_index,
                                       const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t &inter) {
-    bool res = false;
-
-    uint32_t cur = root_index;
-    eTraversalSource src = FromSibling;
-
-    if (!is_leaf_node(nodes[root_index])) {
-        cur = near_child(r, nodes[root_index]);
-        src = FromParent;
-    }
-
-    while (true) {
-        switch (src) {
-        case FromChild:
-            if (cur == root_index || cur == 0xffffffff) return res;
-            if (cur == near_child(r, nodes[nodes[cur].parent])) {
-                cur = nodes[cur].sibling;
-                src = FromSibling;
-            } else {
-                cur = nodes[cur].parent;
-                src = FromChild;
-            }
-            break;
-        case FromSibling:
-            if (!bbox_test(r.o, inv_d, inter.t, nodes[cur])) {
-                cur = nodes[cur].parent;
-                src = FromChild;
-            } else if (is_leaf_node(nodes[cur])) {
-                // process leaf
-                res |= IntersectTris(r, tris, &tri_indices[nodes[cur].prim_index], nodes[cur].prim_count, obj_index, inter);
-
-                cur = nodes[cur].parent;
-                src = FromChild;
-            } else {
-                cur = near_child(r, nodes[cur]);
-                src = FromParent;
-            }
-            break;
-        case FromParent:
-            if (!bbox_test(r.o, inv_d, inter.t, nodes[cur])) {
-                cur = nodes[cur].sibling;
-                src = FromSibling;
-            } else if (is_leaf_node(nodes[cur])) {
-                // process leaf
-                res |= IntersectTris(r, tris, &tri_indices[nodes[cur].prim_index], nodes[cur].prim_count, obj_index, inter);
-
-                cur = nodes[cur].sibling;
-                src = FromSibling;
-            } else {
-                cur = near_child(r, nodes[cur]);
-                src = FromParent;
-            }
-            break;
-        }
-    }
+    return _Traverse_MicroTree_CPU<false>(r, inv_d, nodes, root_index, tris, tri_indices, obj_index, inter, nullptr);
+}
 
-    return res;
+bool ray::ref::Traverse_MicroTree_CPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t root_index,
+                                      const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t &inter, traversal_cost_t &inout_cost) {
+    return _Traverse_MicroTree_CPU<true>(r, inv_d, nodes, root_index, tris, tri_indices, obj_index, inter, &inout_cost);
 }
 
 bool ray::ref::Traverse_MicroTree_GPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t root_index,
@@ -658,10 +696,10 @@ ray::ref::simd_fvec4 ray::ref::SampleBilinear(const TextureAtlas &atlas, const t
 
     _uvs = _uvs * atlas_size - 0.5f;
 
-    const auto &p00 = atlas.Get(page, int(_uvs[0]), int(_uvs[1]));
-    const auto &p01 = atlas.Get(page, int(_uvs[0] + 1), int(_uvs[1]));
-    const auto &p10 = atlas.Get(page, int(_uvs[0]), int(_uvs[1] + 1));
-    const auto &p11 = atlas.Get(page, int(_uvs[0] + 1), int(_uvs[1] + 1));
+    pixel_color8_t p[4];
+    atlas.Get2x2(page, int(_uvs[0]), int(_uvs[1]), p);
+
+    const auto &p00 = p[0], &p01 = p[1], &p10 = p[2], &p11 = p[3];
 
     float kx = _uvs[0] - std::floor(_uvs[0]), ky = _uvs[1] - std::floor(_uvs[1]);
 
@@ -680,10 +718,10 @@ ray::ref::simd_fvec4 ray::ref::SampleBilinear(const TextureAtlas &atlas, const t
 }
 
 ray::ref::simd_fvec4 ray::ref::SampleBilinear(const TextureAtlas &atlas, const simd_fvec2 &uvs, int page) {
-    const auto &p00 = atlas.Get(page, int(uvs[0] + 0), int(uvs[1] + 0));
-    const auto &p01 = atlas.Get(page, int(uvs[0] + 1), int(uvs[1] + 0));
-    const auto &p10 = atlas.Get(page, int(uvs[0] + 0), int(uvs[1] + 1));
-    const auto &p11 = atlas.Get(page, int(uvs[0] + 1), int(uvs[1] + 1));
+    pixel_color8_t p[4];
+    atlas.Get2x2(page, int(uvs[0]), int(uvs[1]), p);
+
+    const auto &p00 = p[0], &p01 = p[1], &p10 = p[2], &p11 = p[3];
 
     simd_fvec2 k = uvs - floor(uvs);
     
@@ -719,11 +757,11 @@ ray::ref::simd_fvec4 ray::ref::SampleAnisotropic(const TextureAtlas &atlas, cons
     simd_fvec2 step;
 
     if (l1 <= l2) {
-        lod = log2(std::min(_duv_dx[0], _duv_dx[1]));
+        lod = std::log2(std::min(_duv_dx[0], _duv_dx[1]));
         k = l1 / l2;
         step = duv_dy;
     } else {
-        lod = log2(std::min(_duv_dy[0], _duv_dy[1]));
+        lod = std::log2(std::min(_duv_dy[0], _duv_dy[1]));
         k = l2 / l1;
         step = duv_dx;
     }
@@ -776,8 +814,17 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
                                           const environment_t &env, const mesh_instance_t *mesh_instances, const uint32_t *mi_indices,
                                           const mesh_t *meshes, const transform_t *transforms, const uint32_t *vtx_indices, const vertex_t *vertices,
                                           const bvh_node_t *nodes, uint32_t node_index, const tri_accel_t *tris, const uint32_t *tri_indices,
-                                          const material_t *materials, const texture_t *textures, const TextureAtlas &tex_atlas, ray_packet_t *out_secondary_rays, int *out_secondary_rays_count) {
+                                          const material_t *materials, const texture_t *textures, const TextureAtlas &tex_atlas, eTexFilter tex_filter, int8_t *out_tex_requests,
+                                          ray_packet_t *out_secondary_rays, int *out_secondary_rays_count) {
     if (!inter.mask_values[0]) {
+        if (env.env_map.texels) {
+            float col[3];
+            EvalEnvMap(env.env_map, ray.d, col);
+
+            // diffuse bounces can also be produced by light sampling, contributions are combined with power heuristic
+            const float weight = ray.pdf > 0.0f ? PowerHeuristic(ray.pdf, EnvMapPdf(env.env_map, ray.d)) : 1.0f;
+            return ray::pixel_color_t{ ray.c[0] * col[0] * weight, ray.c[1] * col[1] * weight, ray.c[2] * col[2] * weight, 1.0f };
+        }
         return ray::pixel_color_t{ ray.c[0] * env.sky_col[0], ray.c[1] * env.sky_col[1], ray.c[2] * env.sky_col[2], 1.0f };
     }
 
@@ -870,8 +917,10 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
     // resolve mix material
     while (mat->type == MixMaterial) {
+        if (out_tex_requests) RequestTextureLod(out_tex_requests, mat->textures[MAIN_TEXTURE], -NUM_MIP_LEVELS);
+
         const auto mix = SampleBilinear(tex_atlas, textures[mat->textures[MAIN_TEXTURE]], uvs, 0) * mat->strength;
-        const float r = halton[hi * 2];
+        const float r = halton[HaltonMixPick * HaltonSeqLen + hi];
 
         // shlick fresnel
         float RR = mat->fresnel + (1.0f - mat->fresnel) * std::pow(1.0f + dot(I, N), 5.0f);
@@ -919,7 +968,35 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
     //////////////////////////////////////////
 
-    auto albedo = SampleAnisotropic(tex_atlas, textures[mat->textures[MAIN_TEXTURE]], uvs, duv_dx, duv_dy);
+    const auto &albedo_tex = textures[mat->textures[MAIN_TEXTURE]];
+
+    // single tap filters take level from the longer axis of footprint, so growing differentials of deep bounces only make it coarser
+    const float lod = (tex_filter != TexFilterAnisotropic) ? IsotropicTextureLod(albedo_tex, value_ptr(duv_dx), value_ptr(duv_dy)) : 0.0f;
+
+    if (out_tex_requests) {
+        // normal map is sampled at the finest level, albedo at the level its filter picks
+        RequestTextureLod(out_tex_requests, mat->textures[NORMALS_TEXTURE], -NUM_MIP_LEVELS);
+
+        if (tex_filter == TexFilterAnisotropic) {
+            const simd_fvec2 sz = { (float)albedo_tex.size[0], (float)albedo_tex.size[1] };
+            const simd_fvec2 _duv_dx = abs(duv_dx * sz), _duv_dy = abs(duv_dy * sz);
+
+            const float aniso_lod = (length(_duv_dx) <= length(_duv_dy)) ? std::log2(std::min(_duv_dx[0], _duv_dx[1])) :
+                                                                           std::log2(std::min(_duv_dy[0], _duv_dy[1]));
+            RequestTextureLod(out_tex_requests, mat->textures[MAIN_TEXTURE], aniso_lod);
+        } else {
+            RequestTextureLod(out_tex_requests, mat->textures[MAIN_TEXTURE], lod + 0.5f);
+        }
+    }
+
+    simd_fvec4 albedo;
+    if (tex_filter == TexFilterAnisotropic) {
+        albedo = SampleAnisotropic(tex_atlas, albedo_tex, uvs, duv_dx, duv_dy);
+    } else {
+        const int _lod = (lod > 0.0f) ? int(std::min(lod + 0.5f, (float)MAX_MIP_LEVEL)) : 0;
+        albedo = (tex_filter == TexFilterBilinear) ? SampleBilinear(tex_atlas, albedo_tex, uvs, _lod) :
+                                                     SampleNearest(tex_atlas, albedo_tex, uvs, float(_lod));
+    }
     albedo[0] *= mat->main_color[0];
     albedo[1] *= mat->main_color[1];
     albedo[2] *= mat->main_color[2];
@@ -933,10 +1010,10 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
         float v = 1;
         if (k > 0) {
-            const float z = 1.0f - halton[hi * 2] * env.sun_softness;
+            const float z = 1.0f - halton[HaltonLightU * HaltonSeqLen + hi] * env.sun_softness;
             const float temp = std::sqrt(1.0f - z * z);
 
-            const float phi = halton[hi * 2 + 1] * 2 * PI;
+            const float phi = halton[HaltonLightV * HaltonSeqLen + hi] * 2 * PI;
             const float cos_phi = std::cos(phi);
             const float sin_phi = std::sin(phi);
 
@@ -960,10 +1037,34 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
         col = simd_fvec3(&albedo[0]) * simd_fvec3(env.sun_col) * v * k;
 
-        const float z = halton[hi * 2];
+        if (env.env_map.texels) {
+            // light sampling of environment map
+            float L[3], env_col[3];
+            const float pdf = SampleEnvMap(env.env_map, halton[HaltonLightU * HaltonSeqLen + hi], halton[HaltonLightV * HaltonSeqLen + hi], L);
+            const float k = dot(N, simd_fvec3(L));
+
+            EvalEnvMap(env.env_map, L, env_col);
+
+            if (pdf > 0.0f && k > 0.0f && (env_col[0] + env_col[1] + env_col[2]) > 0.0f) {
+                ray_packet_t r;
+
+                memcpy(&r.o[0], value_ptr(P + HIT_BIAS * N), 3 * sizeof(float));
+                memcpy(&r.d[0], L, 3 * sizeof(float));
+
+                hit_data_t inter;
+                Traverse_MacroTree_CPU(r, nodes, node_index, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+                if (inter.mask_values[0] == 0) {
+                    // diffuse bounce picks directions uniformly over hemisphere
+                    const float bsdf_pdf = 1.0f / (2 * PI);
+                    col += simd_fvec3(&albedo[0]) * simd_fvec3(env_col) * (k * bsdf_pdf / pdf) * PowerHeuristic(pdf, bsdf_pdf);
+                }
+            }
+        }
+
+        const float z = halton[HaltonBsdfU * HaltonSeqLen + hi];
         const float temp = std::sqrt(1.0f - z * z);
 
-        const float phi = halton[((hash(hi) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
+        const float phi = halton[HaltonBsdfV * HaltonSeqLen + hi] * 2 * PI;
         const float cos_phi = std::cos(phi);
         const float sin_phi = std::sin(phi);
 
@@ -973,6 +1074,7 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
         r.id = ray.id;
         r.ior = ray.ior;
+        r.pdf = 1.0f / (2 * PI);
 
         memcpy(&r.o[0], value_ptr(P + HIT_BIAS * N), 3 * sizeof(float));
         memcpy(&r.d[0], value_ptr(V), 3 * sizeof(float));
@@ -991,10 +1093,10 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
     } else if (mat->type == GlossyMaterial) {
         simd_fvec3 V = reflect(I, dot(I, N) > 0 ? N : -N);
 
-        const float z = 1.0f - halton[hi * 2] * mat->roughness;
+        const float z = 1.0f - halton[HaltonBsdfU * HaltonSeqLen + hi] * mat->roughness;
         const float temp = std::sqrt(1.0f - z * z);
 
-        const float phi = halton[((hash(hi) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
+        const float phi = halton[HaltonBsdfV * HaltonSeqLen + hi] * 2 * PI;
         const float cos_phi = std::cos(phi);
         const float sin_phi = std::sin(phi);
 
@@ -1006,6 +1108,7 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
         r.id = ray.id;
         r.ior = ray.ior;
+        r.pdf = 0.0f;
 
         memcpy(&r.o[0], value_ptr(P + HIT_BIAS * N), 3 * sizeof(float));
         memcpy(&r.d[0], value_ptr(V), 3 * sizeof(float));
@@ -1031,10 +1134,10 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
         float m = eta * cosi - std::sqrt(cost2);
         auto V = eta * I + m * __N;
 
-        const float z = 1.0f - halton[hi * 2] * mat->roughness;
+        const float z = 1.0f - halton[HaltonBsdfU * HaltonSeqLen + hi] * mat->roughness;
         const float temp = std::sqrt(1.0f - z * z);
 
-        const float phi = halton[((hash(hi) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
+        const float phi = halton[HaltonBsdfV * HaltonSeqLen + hi] * 2 * PI;
         const float cos_phi = std::cos(phi);
         const float sin_phi = std::sin(phi);
 
@@ -1052,6 +1155,7 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
 
         r.id = ray.id;
         r.ior = mat->ior;
+        r.pdf = 0.0f;
 
         memcpy(&r.o[0], value_ptr(P + HIT_BIAS * I), 3 * sizeof(float));
         memcpy(&r.d[0], value_ptr(V), 3 * sizeof(float));
@@ -1068,12 +1172,13 @@ ray::pixel_color_t ray::ref::ShadeSurface(const int index, const int iteration,
             out_secondary_rays[index] = r;
         }
     } else if (mat->type == EmissiveMaterial) {
-        col = mat->strength * simd_fvec3(&ray.c[0]) * simd_fvec3(&albedo[0]);
+        col = mat->strength * simd_fvec3(&albedo[0]);
     } else if (mat->type == TransparentMaterial) {
         ray_packet_t r;
 
         r.id = ray.id;
         r.ior = ray.ior;
+        r.pdf = 0.0f;
 
         memcpy(&r.o[0], value_ptr(P + HIT_BIAS * I), 3 * sizeof(float));
         memcpy(&r.d[0], &ray.d[0], 3 * sizeof(float));
@@ -4,8 +4,13 @@
 
 #include "Core.h"
 
+// SIMD backends include this header with their own NS and USE_* defined, they are restored after ref namespace is done
 #pragma push_macro("NS")
+#pragma push_macro("USE_SSE")
+#pragma push_macro("USE_NEON")
 #undef NS
+#undef USE_SSE
+#undef USE_NEON
 
 #define NS ref
 #if defined(_M_AMD64) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP == 2)
@@ -27,6 +32,8 @@
 #undef USE_NEON
 #undef NS
 
+#pragma pop_macro("USE_NEON")
+#pragma pop_macro("USE_SSE")
 #pragma pop_macro("NS")
 
 namespace ray {
@@ -39,6 +46,8 @@ struct ray_packet_t {
     float c[3], ior;
     // derivatives
     float do_dx[3], dd_dx[3], do_dy[3], dd_dy[3];
+    // pdf of diffuse bounce direction (zero if ray cannot be produced by light sampling)
+    float pdf;
 };
 
 const int RayPacketDimX = 1;
@@ -61,6 +70,7 @@ struct environment_t {
     float sun_col[3];
     float sky_col[3];
     float sun_softness;
+    env_map_t env_map;
 };
 
 class TextureAtlas;
@@ -81,6 +91,10 @@ bool IntersectTris(const ray_packet_t &r, const tri_accel_t *tris, const uint32_
 bool Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t node_index,
                             const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
                             const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t &inter);
+// same, but also counts visited nodes and tested triangles (used for traversal cost debug output)
+bool Traverse_MacroTree_CPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t node_index,
+                            const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                            const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t &inter, traversal_cost_t &inout_cost);
 // stack-less gpu-style traversal of outer nodes
 bool Traverse_MacroTree_GPU(const ray_packet_t &r, const bvh_node_t *nodes, uint32_t node_index,
                             const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
@@ -88,6 +102,8 @@ bool Traverse_MacroTree_GPU(const ray_packet_t &r, const bvh_node_t *nodes, uint
 // stack-less cpu-style traversal of inner nodes
 bool Traverse_MicroTree_CPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t node_index,
                             const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t &inter);
+bool Traverse_MicroTree_CPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t node_index,
+                            const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t &inter, traversal_cost_t &inout_cost);
 // stack-less gpu-style traversal of inner nodes
 bool Traverse_MicroTree_GPU(const ray_packet_t &r, const float inv_d[3], const bvh_node_t *nodes, uint32_t node_index,
                             const tri_accel_t *tris, const uint32_t *indices, int obj_index, hit_data_t &inter);
@@ -104,11 +120,12 @@ simd_fvec4 SampleBilinear(const TextureAtlas &atlas, const simd_fvec2 &uvs, int
 simd_fvec4 SampleTrilinear(const TextureAtlas &atlas, const texture_t &t, const simd_fvec2 &uvs, float lod);
 simd_fvec4 SampleAnisotropic(const TextureAtlas &atlas, const texture_t &t, const simd_fvec2 &uvs, const simd_fvec2 &duv_dx, const simd_fvec2 &duv_dy);
 
-// Shade
+// Shade, halton points to dimensions of current bounce (see HaltonBounceOffset)
 ray::pixel_color_t ShadeSurface(const int index, const int iteration, const float *halton, const hit_data_t &inter, const ray_packet_t &ray, 
                                 const environment_t &env, const mesh_instance_t *mesh_instances, const uint32_t *mi_indices,
                                 const mesh_t *meshes, const transform_t *transforms, const uint32_t *vtx_indices, const vertex_t *vertices,
                                 const bvh_node_t *nodes, uint32_t node_index, const tri_accel_t *tris, const uint32_t *tri_indices,
-                                const material_t *materials, const texture_t *textures, const TextureAtlas &tex_atlas, ray_packet_t *out_secondary_rays, int *out_secondary_rays_count);
+                                const material_t *materials, const texture_t *textures, const TextureAtlas &tex_atlas, eTexFilter tex_filter, int8_t *out_tex_requests,
+                                ray_packet_t *out_secondary_rays, int *out_secondary_rays_count);
 }
 }
\ No newline at end of file
@@ -32,6 +32,8 @@ struct ray_packet_t {
     simd_fvec<S> c[4];
     // derivatives
     simd_fvec<S> do_dx[3], dd_dx[3], do_dy[3], dd_dy[3];
+    // pdf of diffuse bounce direction (zero if ray cannot be produced by light sampling)
+    simd_fvec<S> pdf;
     // 16-bit pixel coordinates of rays in packet ((x << 16) | y)
     simd_ivec<S> xy;
 };
@@ -46,7 +48,7 @@ struct hit_data_t {
     simd_ivec<S> xy;
 
     hit_data_t(eUninitialize) {}
-    force_inline hit_data_t() {
+    hit_data_t() {
         mask = { 0 };
         obj_index = { -1 };
         prim_index = { -1 };
@@ -54,11 +56,23 @@ struct hit_data_t {
     }
 };
 
+// traversal cost of rays in packet, number of visited nodes and tested triangles per lane
+template <int S>
+struct traversal_stats_t {
+    simd_ivec<S> nodes, tris;
+
+    traversal_stats_t() {
+        nodes = { 0 };
+        tris = { 0 };
+    }
+};
+
 struct environment_t {
     float sun_dir[3];
     float sun_col[3];
     float sky_col[3];
     float sun_softness;
+    env_map_t env_map;
 };
 
 // Generating rays
@@ -82,10 +96,18 @@ template <int S>
 bool Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
                             const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
                             const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter);
+// same, but also counts visited nodes and tested triangles (used for traversal cost debug output)
+template <int S>
+bool Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
+                            const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                            const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter, traversal_stats_t<S> &inout_stats);
 // stack-less cpu-style traversal of inner nodes
 template <int S>
 bool Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
                             const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t<S> &inter);
+template <int S>
+bool Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
+                            const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t<S> &inter, traversal_stats_t<S> &inout_stats);
 
 // Transform
 template <int S>
@@ -107,13 +129,21 @@ void SampleTrilinear(const ref::TextureAtlas &atlas, const texture_t &t, const s
 template <int S>
 void SampleAnisotropic(const ref::TextureAtlas &atlas, const texture_t &t, const simd_fvec<S> uvs[2], const simd_fvec<S> duv_dx[2], const simd_fvec<S> duv_dy[2], const simd_ivec<S> &mask, simd_fvec<S> out_rgba[4]);
 
-// Shade
+// Environment map, same as scalar functions from Core.h
+template <int S>
+void EvalEnvMap(const env_map_t &env, const simd_fvec<S> dir[3], simd_fvec<S> out_col[3]);
+template <int S>
+simd_fvec<S> EnvMapPdf(const env_map_t &env, const simd_fvec<S> dir[3]);
+template <int S>
+simd_fvec<S> SampleEnvMap(const env_map_t &env, const simd_fvec<S> &r1, const simd_fvec<S> &r2, simd_fvec<S> out_dir[3]);
+
+// Shade, halton points to dimensions of current bounce (see HaltonBounceOffset)
 template <int S>
 void ShadeSurface(const simd_ivec<S> &index, const int iteration, const float *halton, const hit_data_t<S> &inter, const ray_packet_t<S> &ray,
                   const environment_t &env, const mesh_instance_t *mesh_instances, const uint32_t *mi_indices,
                   const mesh_t *meshes, const transform_t *transforms, const uint32_t *vtx_indices, const vertex_t *vertices,
                   const bvh_node_t *nodes, uint32_t node_index, const tri_accel_t *tris, const uint32_t *tri_indices,
-                  const material_t *materials, const texture_t *textures, const ray::ref::TextureAtlas &tex_atlas, simd_fvec<S> out_rgba[4], simd_ivec<S> *out_secondary_masks, ray_packet_t<S> *out_secondary_rays, int *out_secondary_rays_count);
+                  const material_t *materials, const texture_t *textures, const ray::ref::TextureAtlas &tex_atlas, eTexFilter tex_filter, int8_t *out_tex_requests, simd_fvec<S> out_rgba[4], simd_ivec<S> *out_secondary_masks, ray_packet_t<S> *out_secondary_rays, int *out_secondary_rays_count);
 }
 }
 
@@ -134,12 +164,12 @@ force_inline void _IntersectTri(const ray_packet_t<S> &r, const simd_ivec<S> &ra
 
     // from "Ray-Triangle Intersection Algorithm for Modern CPU Architectures" [2007]
 
-    simd_fvec<S> det = r.d[u] * tri.nu + r.d[v] * tri.nv + r.d[w];
-    simd_fvec<S> dett = tri.np - (r.o[u] * tri.nu + r.o[v] * tri.nv + r.o[w]);
-    simd_fvec<S> Du = r.d[u] * dett - (tri.pu - r.o[u]) * det;
-    simd_fvec<S> Dv = r.d[v] * dett - (tri.pv - r.o[v]) * det;
-    simd_fvec<S> detu = tri.e1v * Du - tri.e1u * Dv;
-    simd_fvec<S> detv = tri.e0u * Dv - tri.e0v * Du;
+    simd_fvec<S> det = fmadd(r.d[u], tri.nu, fmadd(r.d[v], tri.nv, r.d[w]));
+    simd_fvec<S> dett = tri.np - fmadd(r.o[u], tri.nu, fmadd(r.o[v], tri.nv, r.o[w]));
+    simd_fvec<S> Du = fmsub(r.d[u], dett, (tri.pu - r.o[u]) * det);
+    simd_fvec<S> Dv = fmsub(r.d[v], dett, (tri.pv - r.o[v]) * det);
+    simd_fvec<S> detu = fmsub(Du, tri.e1v, Dv * tri.e1u);
+    simd_fvec<S> detv = fmsub(Dv, tri.e0u, Du * tri.e0v);
 
     simd_fvec<S> tmpdet0 = det - detu - detv;
 
@@ -173,22 +203,23 @@ force_inline void _IntersectTri(const ray_packet_t<S> &r, const simd_ivec<S> &ra
     where(fmask, inter.v) = bar_v;
 }
 
+// slabs are computed as bbox * inv_d - o * inv_d, so each one is single fused multiply-add
 template <int S>
-force_inline simd_ivec<S> bbox_test(const simd_fvec<S> o[3], const simd_fvec<S> inv_d[3], const simd_fvec<S> &t, const float _bbox_min[3], const float _bbox_max[3]) {
+force_inline simd_ivec<S> bbox_test(const simd_fvec<S> inv_d[3], const simd_fvec<S> neg_inv_d_o[3], const simd_fvec<S> &t, const float _bbox_min[3], const float _bbox_max[3]) {
     simd_fvec<S> low, high, tmin, tmax;
     
-    low = inv_d[0] * (_bbox_min[0] - o[0]);
-    high = inv_d[0] * (_bbox_max[0] - o[0]);
+    low = fmadd(inv_d[0], _bbox_min[0], neg_inv_d_o[0]);
+    high = fmadd(inv_d[0], _bbox_max[0], neg_inv_d_o[0]);
     tmin = min(low, high);
     tmax = max(low, high);
 
-    low = inv_d[1] * (_bbox_min[1] - o[1]);
-    high = inv_d[1] * (_bbox_max[1] - o[1]);
+    low = fmadd(inv_d[1], _bbox_min[1], neg_inv_d_o[1]);
+    high = fmadd(inv_d[1], _bbox_max[1], neg_inv_d_o[1]);
     tmin = max(tmin, min(low, high));
     tmax = min(tmax, max(low, high));
 
-    low = inv_d[2] * (_bbox_min[2] - o[2]);
-    high = inv_d[2] * (_bbox_max[2] - o[2]);
+    low = fmadd(inv_d[2], _bbox_min[2], neg_inv_d_o[2]);
+    high = fmadd(inv_d[2], _bbox_max[2], neg_inv_d_o[2]);
     tmin = max(tmin, min(low, high));
     tmax = min(tmax, max(low, high));
 
@@ -198,8 +229,8 @@ force_inline simd_ivec<S> bbox_test(const simd_fvec<S> o[3], const simd_fvec<S>
 }
 
 template <int S>
-force_inline simd_ivec<S> bbox_test(const simd_fvec<S> o[3], const simd_fvec<S> inv_d[3], const simd_fvec<S> &t, const bvh_node_t &node) {
-    return bbox_test(o, inv_d, t, node.bbox[0], node.bbox[1]);
+force_inline simd_ivec<S> bbox_test(const simd_fvec<S> inv_d[3], const simd_fvec<S> neg_inv_d_o[3], const simd_fvec<S> &t, const bvh_node_t &node) {
+    return bbox_test(inv_d, neg_inv_d_o, t, node.bbox[0], node.bbox[1]);
 }
 
 template <int S>
@@ -251,19 +282,272 @@ struct TraversalState {
     }
 };
 
+// clamped well below float range, so slab offsets -o * inv_d of bbox_test can not overflow
+const float MAX_INV_DIR = 1e30f;
+
 template <int S>
 force_inline void safe_invert(const simd_fvec<S> v[3], simd_fvec<S> inv_v[3]) {
     inv_v[0] = { 1.0f / v[0] };
-    where(v[0] <= FLT_EPS & v[0] >= 0, inv_v[0]) = MAX_DIST;
-    where(v[0] >= -FLT_EPS & v[0] < 0, inv_v[0]) = -MAX_DIST;
+    where(v[0] <= FLT_EPS & v[0] >= 0, inv_v[0]) = MAX_INV_DIR;
+    where(v[0] >= -FLT_EPS & v[0] < 0, inv_v[0]) = -MAX_INV_DIR;
 
     inv_v[1] = { 1.0f / v[1] };
-    where(v[1] <= FLT_EPS & v[1] >= 0, inv_v[1]) = MAX_DIST;
-    where(v[1] >= -FLT_EPS & v[1] < 0, inv_v[1]) = -MAX_DIST;
+    where(v[1] <= FLT_EPS & v[1] >= 0, inv_v[1]) = MAX_INV_DIR;
+    where(v[1] >= -FLT_EPS & v[1] < 0, inv_v[1]) = -MAX_INV_DIR;
 
     inv_v[2] = { 1.0f / v[2] };
-    where(v[2] <= FLT_EPS & v[2] >= 0, inv_v[2]) = MAX_DIST;
-    where(v[2] >= -FLT_EPS & v[2] < 0, inv_v[2]) = -MAX_DIST;
+    where(v[2] <= FLT_EPS & v[2] >= 0, inv_v[2]) = MAX_INV_DIR;
+    where(v[2] >= -FLT_EPS & v[2] < 0, inv_v[2]) = -MAX_INV_DIR;
+}
+
+// Packets with this many active rays or less are traced one ray at a time. Lanes are then used for
+// several triangles of leaf, instead of staying mostly masked out
+template <int S>
+struct SingleRayThreshold {
+    static const int value = S / 2;
+};
+
+const int MAX_STACK_SIZE = 64;
+
+// single ray extracted from packet
+struct ray_single_t {
+    float o[3], d[3], inv_d[3], neg_inv_d_o[3];
+};
+
+struct hit_single_t {
+    int mask, obj_index, prim_index;
+    float t, u, v;
+};
+
+force_inline void safe_invert(const float v[3], float inv_v[3]) {
+    for (int i = 0; i < 3; i++) {
+        inv_v[i] = 1.0f / v[i];
+        if (v[i] <= FLT_EPS && v[i] >= 0) {
+            inv_v[i] = MAX_INV_DIR;
+        } else if (v[i] >= -FLT_EPS && v[i] < 0) {
+            inv_v[i] = -MAX_INV_DIR;
+        }
+    }
+}
+
+force_inline void init_single_ray(const float o[3], const float d[3], ray_single_t &r) {
+    for (int i = 0; i < 3; i++) {
+        r.o[i] = o[i];
+        r.d[i] = d[i];
+    }
+    safe_invert(r.d, r.inv_d);
+    for (int i = 0; i < 3; i++) {
+        r.neg_inv_d_o[i] = -r.inv_d[i] * r.o[i];
+    }
+}
+
+force_inline ray_single_t TransformRay(const ray_single_t &r, const float *xform) {
+    const float o[3] = { r.o[0] * xform[0] + r.o[1] * xform[4] + r.o[2] * xform[8] + xform[12],
+                         r.o[0] * xform[1] + r.o[1] * xform[5] + r.o[2] * xform[9] + xform[13],
+                         r.o[0] * xform[2] + r.o[1] * xform[6] + r.o[2] * xform[10] + xform[14] };
+    const float d[3] = { r.d[0] * xform[0] + r.d[1] * xform[4] + r.d[2] * xform[8],
+                         r.d[0] * xform[1] + r.d[1] * xform[5] + r.d[2] * xform[9],
+                         r.d[0] * xform[2] + r.d[1] * xform[6] + r.d[2] * xform[10] };
+    ray_single_t _r;
+    init_single_ray(o, d, _r);
+    return _r;
+}
+
+force_inline bool bbox_test(const ray_single_t &r, float t, const float bbox_min[3], const float bbox_max[3]) {
+    float tmin = -MAX_DIST, tmax = MAX_DIST;
+    for (int i = 0; i < 3; i++) {
+        const float low = r.inv_d[i] * bbox_min[i] + r.neg_inv_d_o[i],
+                    high = r.inv_d[i] * bbox_max[i] + r.neg_inv_d_o[i];
+        tmin = std::max(tmin, std::min(low, high));
+        tmax = std::min(tmax, std::max(low, high));
+    }
+    return tmin <= tmax && tmin <= t && tmax > 0.0f;
+}
+
+// children are tested one by one, two boxes of binary tree are too few to fill SIMD lanes
+force_inline void bbox_test_children(const ray_single_t &r, float t, const bvh_node_t *nodes, const bvh_node_t &node, bool &out_left, bool &out_right) {
+    out_left = bbox_test(r, t, nodes[node.left_child].bbox[0], nodes[node.left_child].bbox[1]);
+    out_right = bbox_test(r, t, nodes[node.right_child].bbox[0], nodes[node.right_child].bbox[1]);
+}
+
+// intersects single ray with leaf triangles, S triangles at a time
+template <int S>
+force_inline bool IntersectTris(const ray_single_t &r, const tri_accel_t *tris, const uint32_t *indices, uint32_t num_tris, int obj_index, hit_single_t &inter) {
+    const int TriStride = sizeof(tri_accel_t) / sizeof(float);
+    const float *tri_data = &tris[0].nu;
+    const int *tri_idata = &tris[0].ci;
+
+    bool res = false;
+
+    for (uint32_t i = 0; i < num_tris; i += S) {
+        // tail of leaf repeats last triangle, excess lanes are masked out
+        int _index[S], _mask[S];
+        for (int j = 0; j < S; j++) {
+            const uint32_t k = std::min(i + j, num_tris - 1);
+            _index[j] = int(indices[k]) * TriStride;
+            _mask[j] = (i + j < num_tris) ? -1 : 0;
+        }
+
+        const simd_ivec<S> index = { &_index[0] }, tri_mask = { &_mask[0] };
+
+        const simd_fvec<S> nu = gather(tri_data + 0, index), nv = gather(tri_data + 1, index),
+                           np = gather(tri_data + 2, index),
+                           pu = gather(tri_data + 3, index), pv = gather(tri_data + 4, index),
+                           e0u = gather(tri_data + 6, index), e0v = gather(tri_data + 7, index),
+                           e1u = gather(tri_data + 8, index), e1v = gather(tri_data + 9, index);
+
+        // projection axes differ between triangles, so ray components are selected per lane
+        const simd_ivec<S> w = gather(tri_idata, index) & simd_ivec<S>{ TRI_W_BITS };
+        const simd_ivec<S> u = (w == 0) & simd_ivec<S>{ 1 }, v = 2 + (w == 2);
+
+        const simd_fvec<S> dw = gather(r.d, w), du = gather(r.d, u), dv = gather(r.d, v),
+                           ow = gather(r.o, w), ou = gather(r.o, u), ov = gather(r.o, v);
+
+        // from "Ray-Triangle Intersection Algorithm for Modern CPU Architectures" [2007]
+
+        const simd_fvec<S> det = fmadd(du, nu, fmadd(dv, nv, dw));
+        const simd_fvec<S> dett = np - fmadd(ou, nu, fmadd(ov, nv, ow));
+        const simd_fvec<S> Du = fmsub(du, dett, (pu - ou) * det);
+        const simd_fvec<S> Dv = fmsub(dv, dett, (pv - ov) * det);
+        const simd_fvec<S> detu = fmsub(Du, e1v, Dv * e1u);
+        const simd_fvec<S> detv = fmsub(Dv, e0u, Du * e0v);
+
+        const simd_fvec<S> tmpdet0 = det - detu - detv;
+
+        const simd_fvec<S> mm = ((tmpdet0 > -HIT_EPS) & (detu > -HIT_EPS) & (detv > -HIT_EPS)) |
+                                ((tmpdet0 < HIT_EPS) & (detu < HIT_EPS) & (detv < HIT_EPS));
+
+        simd_ivec<S> imask = reinterpret_cast<const simd_ivec<S>&>(mm) & tri_mask;
+        if (imask.all_zeros()) continue;
+
+        const simd_fvec<S> rdet = 1.0f / det;
+        const simd_fvec<S> t = dett * rdet;
+
+        const simd_fvec<S> t_valid = (t < simd_fvec<S>{ inter.t }) & (t > 0.0f);
+        imask = imask & reinterpret_cast<const simd_ivec<S>&>(t_valid);
+        if (imask.all_zeros()) continue;
+
+        // closest of found intersections
+        int closest = -1;
+        for (int j = 0; j < S; j++) {
+            if (imask[j] && t[j] < inter.t) {
+                inter.t = t[j];
+                closest = j;
+            }
+        }
+
+        inter.mask = -1;
+        inter.obj_index = obj_index;
+        inter.prim_index = int(indices[i + closest]);
+        inter.u = detu[closest] * rdet[closest];
+        inter.v = detv[closest] * rdet[closest];
+
+        res = true;
+    }
+
+    return res;
+}
+
+// packet traversal, instantiated twice, counting of cost is compiled out of normal path
+template <int S, bool CountCost>
+bool _Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                             const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                             const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter, traversal_stats_t<S> *stats);
+template <int S, bool CountCost>
+bool _Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                             const tri_accel_t *tris, const uint32_t *indices, int obj_index, hit_data_t<S> &inter, traversal_stats_t<S> *stats);
+
+// traversal with explicit stack of far children, returns false if stack was not enough
+template <int S, bool CountCost>
+bool Traverse_MicroTree_Single(const ray_single_t &r, const bvh_node_t *nodes, uint32_t root_index,
+                               const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_single_t &inter, traversal_cost_t *cost) {
+    uint32_t stack[MAX_STACK_SIZE];
+    int stack_size = 0;
+
+    uint32_t cur = root_index;
+    if (CountCost) cost->nodes++;
+    if (!bbox_test(r, inter.t, nodes[cur].bbox[0], nodes[cur].bbox[1])) return true;
+
+    while (true) {
+        const bvh_node_t &n = nodes[cur];
+
+        if (is_leaf_node(n)) {
+            if (CountCost) cost->tris += n.prim_count;
+            IntersectTris<S>(r, tris, &tri_indices[n.prim_index], n.prim_count, obj_index, inter);
+        } else {
+            bool hit_left, hit_right;
+            if (CountCost) cost->nodes += 2;
+            bbox_test_children(r, inter.t, nodes, n, hit_left, hit_right);
+
+            if (hit_left && hit_right) {
+                if (stack_size == MAX_STACK_SIZE) return false;
+
+                const bool right_first = r.d[n.space_axis] < 0.0f;
+                stack[stack_size++] = right_first ? n.left_child : n.right_child;
+                cur = right_first ? n.right_child : n.left_child;
+                continue;
+            } else if (hit_left || hit_right) {
+                cur = hit_left ? n.left_child : n.right_child;
+                continue;
+            }
+        }
+
+        if (!stack_size) break;
+        cur = stack[--stack_size];
+    }
+
+    return true;
+}
+
+template <int S, bool CountCost>
+bool Traverse_MacroTree_Single(const ray_single_t &r, const bvh_node_t *nodes, uint32_t root_index,
+                               const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                               const tri_accel_t *tris, const uint32_t *tri_indices, hit_single_t &inter, traversal_cost_t *cost) {
+    uint32_t stack[MAX_STACK_SIZE];
+    int stack_size = 0;
+
+    uint32_t cur = root_index;
+    if (CountCost) cost->nodes++;
+    if (!bbox_test(r, inter.t, nodes[cur].bbox[0], nodes[cur].bbox[1])) return true;
+
+    while (true) {
+        const bvh_node_t &n = nodes[cur];
+
+        if (is_leaf_node(n)) {
+            for (uint32_t i = n.prim_index; i < n.prim_index + n.prim_count; i++) {
+                const auto &mi = mesh_instances[mi_indices[i]];
+                const auto &m = meshes[mi.mesh_index];
+                const auto &tr = transforms[mi.tr_index];
+
+                if (CountCost) cost->nodes++;
+                if (!bbox_test(r, inter.t, mi.bbox_min, mi.bbox_max)) continue;
+
+                const ray_single_t _r = TransformRay(r, tr.inv_xform);
+                if (!Traverse_MicroTree_Single<S, CountCost>(_r, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter, cost)) return false;
+            }
+        } else {
+            bool hit_left, hit_right;
+            if (CountCost) cost->nodes += 2;
+            bbox_test_children(r, inter.t, nodes, n, hit_left, hit_right);
+
+            if (hit_left && hit_right) {
+                if (stack_size == MAX_STACK_SIZE) return false;
+
+                const bool right_first = r.d[n.space_axis] < 0.0f;
+                stack[stack_size++] = right_first ? n.left_child : n.right_child;
+                cur = right_first ? n.right_child : n.left_child;
+                continue;
+            } else if (hit_left || hit_right) {
+                cur = hit_left ? n.left_child : n.right_child;
+                continue;
+            }
+        }
+
+        if (!stack_size) break;
+        cur = stack[--stack_size];
+    }
+
+    return true;
 }
 
 template <int S>
@@ -325,6 +609,41 @@ force_inline void reflect(const simd_fvec<S> I[3], const simd_fvec<S> N[3], cons
     res[2] = I[2] - 2.0f * dot_N_I * N[2];
 }
 
+/// Direction with cosine z to axis, rotated by phi around it in frame of T and B
+template <int S>
+force_inline void sample_around_axis(const simd_fvec<S> &z, const simd_fvec<S> &phi, const simd_fvec<S> axis[3],
+                                     const simd_fvec<S> T[3], const simd_fvec<S> B[3], simd_fvec<S> res[3]) {
+    const simd_fvec<S> temp = sqrt(1.0f - z * z);
+
+    simd_fvec<S> sin_phi, cos_phi;
+    sincos(phi, sin_phi, cos_phi);
+
+    res[0] = temp * sin_phi * B[0] + z * axis[0] + temp * cos_phi * T[0];
+    res[1] = temp * sin_phi * B[1] + z * axis[1] + temp * cos_phi * T[1];
+    res[2] = temp * sin_phi * B[2] + z * axis[2] + temp * cos_phi * T[2];
+}
+
+template <int S>
+force_inline void EnvMapDirToUV(const simd_fvec<S> dir[3], simd_fvec<S> &out_u, simd_fvec<S> &out_v) {
+    out_u = 0.5f + atan2(dir[2], dir[0]) * (1.0f / (2 * PI));
+    out_v = acos(min(max(dir[1], simd_fvec<S>{ -1.0f }), simd_fvec<S>{ 1.0f })) * (1.0f / PI);
+}
+
+/// Decodes texels packed as in pixel_color8_t
+template <int S>
+force_inline void DecodeRGBE(const simd_ivec<S> &t, simd_fvec<S> out_rgb[3]) {
+    const simd_ivec<S> c255 = { 255 };
+    const simd_ivec<S> e = (t >> 24) & c255;
+
+    // 2^(e - 136) is assembled directly in exponent bits, smaller exponents would give denormals, they are flushed to zero
+    simd_fvec<S> f = simd_math::as<float>((e - 9) << 23);
+    where((simd_fvec<S>)e < 10.0f, f) = 0.0f;
+
+    out_rgb[0] = (simd_fvec<S>)(t & c255) * f;
+    out_rgb[1] = (simd_fvec<S>)((t >> 8) & c255) * f;
+    out_rgb[2] = (simd_fvec<S>)((t >> 16) & c255) * f;
+}
+
 template <int S>
 force_inline simd_ivec<S> get_ray_hash(const ray_packet_t<S> &r, const simd_ivec<S> &mask, const float root_min[3], const float cell_size[3]) {
     simd_ivec<S> x = (simd_ivec<S>)((r.o[0] - root_min[0]) / cell_size[0]),
@@ -427,13 +746,8 @@ void ray::NS::GeneratePrimaryRays(const int iteration, const camera_t &cam, cons
             simd_ivec<S> index = iyy * w + ixx;
             simd_ivec<S> hi = (hash(index) + iteration) & (HaltonSeqLen - 1);
 
-            simd_fvec<S> fxx = (simd_fvec<S>)ixx,
-                         fyy = (simd_fvec<S>)iyy;
-
-            for (int i = 0; i < S; i++) {
-                fxx[i] += halton[hi[i] * 2];
-                fyy[i] += halton[hi[i] * 2 + 1];
-            }
+            simd_fvec<S> fxx = (simd_fvec<S>)ixx + gather(&halton[0 * HaltonSeqLen], hi),
+                         fyy = (simd_fvec<S>)iyy + gather(&halton[1 * HaltonSeqLen], hi);
 
             simd_fvec<S> _d[3], _dx[3], _dy[3];
             get_pix_dirs(fxx, fyy, _d);
@@ -452,6 +766,7 @@ void ray::NS::GeneratePrimaryRays(const int iteration, const camera_t &cam, cons
             }
 
             out_r.c[3] = { 1.0f };
+            out_r.pdf = { 0.0f };
             out_r.xy = (ixx << 16) | iyy;
         }
     }
@@ -549,6 +864,7 @@ void ray::NS::SortRays(ray_packet_t<S> *rays, simd_ivec<S> *ray_masks, int &seco
                     std::swap(rays[jj].c[0][_jj], rays[kk].c[0][_kk]);
                     std::swap(rays[jj].c[1][_jj], rays[kk].c[1][_kk]);
                     std::swap(rays[jj].c[2][_jj], rays[kk].c[2][_kk]);
+                    std::swap(rays[jj].c[3][_jj], rays[kk].c[3][_kk]);
 
                     std::swap(rays[jj].do_dx[0][_jj], rays[kk].do_dx[0][_kk]);
                     std::swap(rays[jj].do_dx[1][_jj], rays[kk].do_dx[1][_kk]);
@@ -566,6 +882,9 @@ void ray::NS::SortRays(ray_packet_t<S> *rays, simd_ivec<S> *ray_masks, int &seco
                     std::swap(rays[jj].dd_dy[1][_jj], rays[kk].dd_dy[1][_kk]);
                     std::swap(rays[jj].dd_dy[2][_jj], rays[kk].dd_dy[2][_kk]);
 
+                    // pdf of diffuse bounce is used to weight environment hits against light sampling
+                    std::swap(rays[jj].pdf[_jj], rays[kk].pdf[_kk]);
+
                     std::swap(rays[jj].xy[_jj], rays[kk].xy[_kk]);
 
                     std::swap(ray_masks[jj][_jj], ray_masks[kk][_kk]);
@@ -635,18 +954,67 @@ bool ray::NS::IntersectTris(const ray_packet_t<S> &r, const simd_ivec<S> &ray_ma
     return inter.mask.not_all_zeros();
 }
 
-template <int S>
-bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
-                                     const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
-                                     const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter) {
+template <int S, bool CountCost>
+bool ray::NS::_Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                                      const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                                      const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter, traversal_stats_t<S> *stats) {
     bool res = false;
 
+    simd_ivec<S> packet_mask = ray_mask;
+
+    int active_count = 0;
+    for (int j = 0; j < S; j++) {
+        if (ray_mask[j]) active_count++;
+    }
+
+    if (active_count <= SingleRayThreshold<S>::value) {
+        // rays that did not fit into traversal stack stay in packet_mask
+        packet_mask = { 0 };
+
+        for (int j = 0; j < S; j++) {
+            if (!ray_mask[j]) continue;
+
+            const float o[3] = { r.o[0][j], r.o[1][j], r.o[2][j] },
+                        d[3] = { r.d[0][j], r.d[1][j], r.d[2][j] };
+
+            ray_single_t _r;
+            init_single_ray(o, d, _r);
+
+            hit_single_t _inter = { 0, -1, -1, inter.t[j], 0.0f, 0.0f };
+            traversal_cost_t cost = { 0, 0 };
+            const bool finished = Traverse_MacroTree_Single<S, CountCost>(_r, nodes, root_index, mesh_instances, mi_indices, meshes, transforms,
+                                                                          tris, tri_indices, _inter, &cost);
+            if (CountCost) {
+                stats->nodes[j] += int(cost.nodes);
+                stats->tris[j] += int(cost.tris);
+            }
+            if (!finished) {
+                packet_mask[j] = -1;
+                continue;
+            }
+
+            if (_inter.mask) {
+                inter.mask[j] = -1;
+                inter.obj_index[j] = _inter.obj_index;
+                inter.prim_index[j] = _inter.prim_index;
+                inter.t[j] = _inter.t;
+                inter.u[j] = _inter.u;
+                inter.v[j] = _inter.v;
+                res = true;
+            }
+        }
+
+        if (packet_mask.all_zeros()) return res;
+    }
+
     simd_fvec<S> inv_d[3];
     safe_invert(r.d, inv_d);
 
+    const simd_fvec<S> neg_inv_d_o[3] = { -inv_d[0] * r.o[0], -inv_d[1] * r.o[1], -inv_d[2] * r.o[2] };
+
     TraversalState<S> st;
 
-    st.queue[0].mask = ray_mask;
+    st.queue[0].mask = packet_mask;
 
     st.queue[0].src = FromSibling;
     st.queue[0].cur = root_index;
@@ -675,7 +1043,8 @@ bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
             }
             break;
         case FromSibling: {
-            auto mask1 = bbox_test(r.o, inv_d, inter.t, nodes[cur]) & st.queue[st.index].mask;
+            if (CountCost) stats->nodes -= st.queue[st.index].mask;
+            auto mask1 = bbox_test(inv_d, neg_inv_d_o, inter.t, nodes[cur]) & st.queue[st.index].mask;
             if (mask1.all_zeros()) {
                 cur = nodes[cur].parent;
                 src = FromChild;
@@ -696,12 +1065,13 @@ bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
                         const auto &m = meshes[mi.mesh_index];
                         const auto &tr = transforms[mi.tr_index];
 
-                        auto bbox_mask = bbox_test(r.o, inv_d, inter.t, mi.bbox_min, mi.bbox_max) & st.queue[st.index].mask;
+                        if (CountCost) stats->nodes -= st.queue[st.index].mask;
+                        auto bbox_mask = bbox_test(inv_d, neg_inv_d_o, inter.t, mi.bbox_min, mi.bbox_max) & st.queue[st.index].mask;
                         if (bbox_mask.all_zeros()) continue;
 
                         ray_packet_t<S> _r = TransformRay(r, tr.inv_xform);
 
-                        res |= Traverse_MicroTree_CPU(_r, bbox_mask, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter);
+                        res |= _Traverse_MicroTree_CPU<S, CountCost>(_r, bbox_mask, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter, stats);
                     }
 
                     cur = nodes[cur].parent;
@@ -714,7 +1084,8 @@ bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
         }
         break;
         case FromParent: {
-            auto mask1 = bbox_test(r.o, inv_d, inter.t, nodes[cur]) & st.queue[st.index].mask;
+            if (CountCost) stats->nodes -= st.queue[st.index].mask;
+            auto mask1 = bbox_test(inv_d, neg_inv_d_o, inter.t, nodes[cur]) & st.queue[st.index].mask;
             if (mask1.all_zeros()) {
                 cur = nodes[cur].sibling;
                 src = FromSibling;
@@ -735,12 +1106,13 @@ bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
                         const auto &m = meshes[mi.mesh_index];
                         const auto &tr = transforms[mi.tr_index];
 
-                        auto bbox_mask = bbox_test(r.o, inv_d, inter.t, mi.bbox_min, mi.bbox_max) & st.queue[st.index].mask;
+                        if (CountCost) stats->nodes -= st.queue[st.index].mask;
+                        auto bbox_mask = bbox_test(inv_d, neg_inv_d_o, inter.t, mi.bbox_min, mi.bbox_max) & st.queue[st.index].mask;
                         if (bbox_mask.all_zeros()) continue;
 
                         ray_packet_t<S> _r = TransformRay(r, tr.inv_xform);
 
-                        res |= Traverse_MicroTree_CPU(_r, bbox_mask, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter);
+                        res |= _Traverse_MicroTree_CPU<S, CountCost>(_r, bbox_mask, nodes, m.node_index, tris, tri_indices, (int)mi_indices[i], inter, stats);
                     }
 
                     cur = nodes[cur].sibling;
@@ -757,14 +1129,16 @@ bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
     return res;
 }
 
-template <int S>
-bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
-                                     const tri_accel_t *tris, const uint32_t *indices, int obj_index, hit_data_t<S> &inter) {
+template <int S, bool CountCost>
+bool ray::NS::_Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                                      const tri_accel_t *tris, const uint32_t *indices, int obj_index, hit_data_t<S> &inter, traversal_stats_t<S> *stats) {
     bool res = false;
 
     simd_fvec<S> inv_d[3];
     safe_invert(r.d, inv_d);
 
+    const simd_fvec<S> neg_inv_d_o[3] = { -inv_d[0] * r.o[0], -inv_d[1] * r.o[1], -inv_d[2] * r.o[2] };
+
     TraversalState<S> st;
 
     st.queue[0].mask = ray_mask;
@@ -796,7 +1170,8 @@ bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
             }
             break;
         case FromSibling: {
-            auto mask1 = bbox_test(r.o, inv_d, inter.t, nodes[cur]) & st.queue[st.index].mask;
+            if (CountCost) stats->nodes -= st.queue[st.index].mask;
+            auto mask1 = bbox_test(inv_d, neg_inv_d_o, inter.t, nodes[cur]) & st.queue[st.index].mask;
             if (mask1.all_zeros()) {
                 cur = nodes[cur].parent;
                 src = FromChild;
@@ -812,6 +1187,7 @@ bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
 
                 if (is_leaf_node(nodes[cur])) {
                     // process leaf
+                    if (CountCost) stats->tris += st.queue[st.index].mask & simd_ivec<S>{ int(nodes[cur].prim_count) };
                     res |= IntersectTris(r, st.queue[st.index].mask, tris, &indices[nodes[cur].prim_index], nodes[cur].prim_count, obj_index, inter);
 
                     cur = nodes[cur].parent;
@@ -824,7 +1200,8 @@ bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
         }
         break;
         case FromParent: {
-            auto mask1 = bbox_test(r.o, inv_d, inter.t, nodes[cur]) & st.queue[st.index].mask;
+            if (CountCost) stats->nodes -= st.queue[st.index].mask;
+            auto mask1 = bbox_test(inv_d, neg_inv_d_o, inter.t, nodes[cur]) & st.queue[st.index].mask;
             if (mask1.all_zeros()) {
                 cur = nodes[cur].sibling;
                 src = FromSibling;
@@ -840,6 +1217,7 @@ bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
 
                 if (is_leaf_node(nodes[cur])) {
                     // process leaf
+                    if (CountCost) stats->tris += st.queue[st.index].mask & simd_ivec<S>{ int(nodes[cur].prim_count) };
                     res |= IntersectTris(r, st.queue[st.index].mask, tris, &indices[nodes[cur].prim_index], nodes[cur].prim_count, obj_index, inter);
 
                     cur = nodes[cur].sibling;
@@ -856,6 +1234,32 @@ bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S
     return res;
 }
 
+template <int S>
+bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                                     const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                                     const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter) {
+    return _Traverse_MacroTree_CPU<S, false>(r, ray_mask, nodes, root_index, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter, nullptr);
+}
+
+template <int S>
+bool ray::NS::Traverse_MacroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                                     const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                                     const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<S> &inter, traversal_stats_t<S> &inout_stats) {
+    return _Traverse_MacroTree_CPU<S, true>(r, ray_mask, nodes, root_index, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter, &inout_stats);
+}
+
+template <int S>
+bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                                     const tri_accel_t *tris, const uint32_t *indices, int obj_index, hit_data_t<S> &inter) {
+    return _Traverse_MicroTree_CPU<S, false>(r, ray_mask, nodes, root_index, tris, indices, obj_index, inter, nullptr);
+}
+
+template <int S>
+bool ray::NS::Traverse_MicroTree_CPU(const ray_packet_t<S> &r, const simd_ivec<S> &ray_mask, const bvh_node_t *nodes, uint32_t root_index,
+                                     const tri_accel_t *tris, const uint32_t *indices, int obj_index, hit_data_t<S> &inter, traversal_stats_t<S> &inout_stats) {
+    return _Traverse_MicroTree_CPU<S, true>(r, ray_mask, nodes, root_index, tris, indices, obj_index, inter, &inout_stats);
+}
+
 template <int S>
 force_inline ray::NS::ray_packet_t<S> ray::NS::TransformRay(const ray_packet_t<S> &r, const float *xform) {
     ray_packet_t<S> _r = r;
@@ -927,6 +1331,48 @@ void ray::NS::SampleBilinear(const ref::TextureAtlas &atlas, const texture_t &t,
 
     simd_fvec<S> k[2] = { _uvs[0] - floor(_uvs[0]), _uvs[1] - floor(_uvs[1]) };
 
+#if defined(USE_AVX2)
+    if (atlas.compression() == TexCompressionNone) {
+        // lanes usually sample the same level of one texture, then whole footprint is gathered from single page
+        int page = -1;
+        for (int i = 0; i < S; i++) {
+            if (!mask[i]) continue;
+            if (page == -1) {
+                page = t.page[lod[i]];
+            } else if (page != t.page[lod[i]]) {
+                page = -2;
+                break;
+            }
+        }
+
+        if (page >= 0) {
+            const auto *texels = reinterpret_cast<const int *>(atlas.page_data(page));
+            const int tiles_x = int(atlas.size_x()) / 4;
+
+            const simd_ivec<S> x0 = (simd_ivec<S>)floor(_uvs[0]) & mask, y0 = (simd_ivec<S>)floor(_uvs[1]) & mask,
+                               x1 = x0 + 1, y1 = y0 + 1;
+
+            const simd_ivec<S> c3 = { 3 };
+            const simd_ivec<S> row0 = ((y0 >> 2) * tiles_x) << 4, row1 = ((y1 >> 2) * tiles_x) << 4,
+                               col0 = ((x0 >> 2) << 4) + (x0 & c3), col1 = ((x1 >> 2) << 4) + (x1 & c3),
+                               in_row0 = (y0 & c3) << 2, in_row1 = (y1 & c3) << 2;
+
+            const simd_ivec<S> p00 = gather(texels, row0 + in_row0 + col0), p01 = gather(texels, row0 + in_row0 + col1),
+                               p10 = gather(texels, row1 + in_row1 + col0), p11 = gather(texels, row1 + in_row1 + col1);
+
+            const simd_ivec<S> c255 = { 255 };
+            for (int j = 0; j < 4; j++) {
+                const simd_fvec<S> _p00 = (simd_fvec<S>)((p00 >> (8 * j)) & c255), _p01 = (simd_fvec<S>)((p01 >> (8 * j)) & c255),
+                                   _p10 = (simd_fvec<S>)((p10 >> (8 * j)) & c255), _p11 = (simd_fvec<S>)((p11 >> (8 * j)) & c255);
+
+                const simd_fvec<S> p0 = fmadd(_p01 - _p00, k[0], _p00), p1 = fmadd(_p11 - _p10, k[0], _p10);
+                out_rgba[j] = fmadd(p1 - p0, k[1], p0) * (1.0f / 255.0f);
+            }
+            return;
+        }
+    }
+#endif
+
     simd_fvec<S> p0[4], p1[4];
 
     for (int i = 0; i < S; i++) {
@@ -934,10 +1380,10 @@ void ray::NS::SampleBilinear(const ref::TextureAtlas &atlas, const texture_t &t,
 
         int page = t.page[lod[i]];
 
-        const auto &p00 = atlas.Get(page, int(_uvs[0][i]), int(_uvs[1][i]));
-        const auto &p01 = atlas.Get(page, int(_uvs[0][i] + 1), int(_uvs[1][i]));
-        const auto &p10 = atlas.Get(page, int(_uvs[0][i]), int(_uvs[1][i] + 1));
-        const auto &p11 = atlas.Get(page, int(_uvs[0][i] + 1), int(_uvs[1][i] + 1));
+        pixel_color8_t p[4];
+        atlas.Get2x2(page, int(_uvs[0][i]), int(_uvs[1][i]), p);
+
+        const auto &p00 = p[0], &p01 = p[1], &p10 = p[2], &p11 = p[3];
 
         p0[0][i] = p01.r * k[0][i] + p00.r * (1 - k[0][i]);
         p0[1][i] = p01.g * k[0][i] + p00.g * (1 - k[0][i]);
@@ -967,10 +1413,10 @@ void ray::NS::SampleBilinear(const ref::TextureAtlas &atlas, const simd_fvec<S>
     for (int i = 0; i < S; i++) {
         if (!mask[i]) continue;
 
-        const auto &p00 = atlas.Get(page[i], int(uvs[0][i] + 0), int(uvs[1][i] + 0));
-        const auto &p01 = atlas.Get(page[i], int(uvs[0][i] + 1), int(uvs[1][i] + 0));
-        const auto &p10 = atlas.Get(page[i], int(uvs[0][i] + 0), int(uvs[1][i] + 1));
-        const auto &p11 = atlas.Get(page[i], int(uvs[0][i] + 1), int(uvs[1][i] + 1));
+        pixel_color8_t p[4];
+        atlas.Get2x2(page[i], int(uvs[0][i]), int(uvs[1][i]), p);
+
+        const auto &p00 = p[0], &p01 = p[1], &p10 = p[2], &p11 = p[3];
 
         _p00[0][i] = to_norm_float(p00.r);
         _p00[1][i] = to_norm_float(p00.g);
@@ -1036,18 +1482,14 @@ void ray::NS::SampleAnisotropic(const ref::TextureAtlas &atlas, const texture_t
                  k = l2 / l1,
                  step[2] = { duv_dx[0], duv_dx[1] };
 
-    ITERATE(S, { lod[i] = log2(std::min(_duv_dy[0][i], _duv_dy[1][i])); })
+    lod = log2(min(_duv_dy[0], _duv_dy[1]));
 
     auto _mask = l1 <= l2;
     where(_mask, k) = l1 / l2;
     where(_mask, step[0]) = duv_dy[0];
     where(_mask, step[1]) = duv_dy[1];
 
-    ITERATE(S, {
-        if (reinterpret_cast<const simd_ivec<S>&>(_mask)[i]) {
-            lod[i] = log2(std::min(_duv_dx[0][i], _duv_dx[1][i]));
-        }
-    })
+    where(_mask, lod) = log2(min(_duv_dx[0], _duv_dx[1]));
 
     where(lod < 0.0f, lod) = 0.0f;
     where(lod > (float)MAX_MIP_LEVEL, lod) = (float)MAX_MIP_LEVEL;
@@ -1120,20 +1562,132 @@ void ray::NS::SampleAnisotropic(const ref::TextureAtlas &atlas, const texture_t
     ITERATE_4({ out_rgba[i] /= fnum; })
 }
 
+template <int S>
+void ray::NS::EvalEnvMap(const env_map_t &env, const simd_fvec<S> dir[3], simd_fvec<S> out_col[3]) {
+    simd_fvec<S> u, v;
+    EnvMapDirToUV(dir, u, v);
+
+    const simd_fvec<S> fx = u * float(env.res[0]) - 0.5f, fy = v * float(env.res[1]) - 0.5f;
+    const simd_fvec<S> _x0 = floor(fx), _y0 = floor(fy);
+    const simd_fvec<S> kx = fx - _x0, ky = fy - _y0;
+
+    // wraps around horizontally, clamps at poles
+    simd_ivec<S> x0 = (simd_ivec<S>)_x0, x1 = x0 + 1;
+    where(x0 < 0, x0) = x0 + env.res[0];
+    where(x1 > env.res[0] - 1, x1) = x1 - env.res[0];
+
+    const simd_ivec<S> y0 = max((simd_ivec<S>)_y0, simd_ivec<S>{ 0 }) * env.res[0],
+                       y1 = min((simd_ivec<S>)_y0 + 1, simd_ivec<S>{ env.res[1] - 1 }) * env.res[0];
+
+    const auto *texels = reinterpret_cast<const int *>(env.texels);
+
+    simd_fvec<S> c00[3], c01[3], c10[3], c11[3];
+    DecodeRGBE(gather(texels, y0 + x0), c00);
+    DecodeRGBE(gather(texels, y0 + x1), c01);
+    DecodeRGBE(gather(texels, y1 + x0), c10);
+    DecodeRGBE(gather(texels, y1 + x1), c11);
+
+    for (int i = 0; i < 3; i++) {
+        out_col[i] = (c00[i] * (1.0f - kx) + c01[i] * kx) * (1.0f - ky) + (c10[i] * (1.0f - kx) + c11[i] * kx) * ky;
+    }
+}
+
+template <int S>
+ray::NS::simd_fvec<S> ray::NS::EnvMapPdf(const env_map_t &env, const simd_fvec<S> dir[3]) {
+    const simd_fvec<S> sin_theta = sqrt(max(1.0f - dir[1] * dir[1], simd_fvec<S>{ 0.0f }));
+
+    simd_fvec<S> u, v;
+    EnvMapDirToUV(dir, u, v);
+
+    // native float to int conversion rounds to nearest, so cell index is floored explicitly
+    const simd_ivec<S> x = min((simd_ivec<S>)floor(u * float(env.cells_res[0])), simd_ivec<S>{ env.cells_res[0] - 1 }),
+                       y = min((simd_ivec<S>)floor(v * float(env.cells_res[1])), simd_ivec<S>{ env.cells_res[1] - 1 });
+
+    // cells are 16 bytes, pdf is their second word
+    const auto *cells = reinterpret_cast<const float *>(env.cells);
+    const simd_fvec<S> pdf = gather(cells + 1, (y * env.cells_res[0] + x) << 2);
+
+    const int count = env.cells_res[0] * env.cells_res[1];
+
+    simd_fvec<S> ret = pdf * float(count) / ((2 * PI * PI) * sin_theta);
+    where(sin_theta <= 0.0f, ret) = 0.0f;
+    return ret;
+}
+
+template <int S>
+ray::NS::simd_fvec<S> ray::NS::SampleEnvMap(const env_map_t &env, const simd_fvec<S> &r1, const simd_fvec<S> &r2, simd_fvec<S> out_dir[3]) {
+    const int count = env.cells_res[0] * env.cells_res[1];
+
+    // fractional part is reused to pick between cell and its alias, then as position inside of cell
+    const simd_fvec<S> f = r1 * float(count);
+    simd_ivec<S> i = min((simd_ivec<S>)floor(f), simd_ivec<S>{ count - 1 });
+    simd_fvec<S> k = min(f - (simd_fvec<S>)i, simd_fvec<S>{ 0.99999994f });
+
+    const auto *cells_f = reinterpret_cast<const float *>(env.cells);
+    const auto *cells_i = reinterpret_cast<const int *>(env.cells);
+
+    const simd_fvec<S> q = gather(cells_f, i << 2);
+    const simd_ivec<S> alias = gather(cells_i + 2, i << 2);
+
+    const simd_fvec<S> keep = k < q;
+
+    simd_fvec<S> _k = (k - q) / (1.0f - q);
+    where(keep, _k) = k / q;
+    k = _k;
+
+    simd_ivec<S> _i = alias;
+    where(reinterpret_cast<const simd_ivec<S>&>(keep), _i) = i;
+    i = _i;
+
+    const simd_ivec<S> y = i / env.cells_res[0], x = i - y * env.cells_res[0];
+
+    const simd_fvec<S> u = ((simd_fvec<S>)x + k) / float(env.cells_res[0]),
+                       v = ((simd_fvec<S>)y + r2) / float(env.cells_res[1]);
+
+    simd_fvec<S> sin_theta, cos_theta, sin_phi, cos_phi;
+    sincos(v * PI, sin_theta, cos_theta);
+    sincos((u - 0.5f) * (2 * PI), sin_phi, cos_phi);
+
+    out_dir[0] = sin_theta * cos_phi;
+    out_dir[1] = cos_theta;
+    out_dir[2] = sin_theta * sin_phi;
+
+    simd_fvec<S> ret = gather(cells_f + 1, i << 2) * float(count) / ((2 * PI * PI) * sin_theta);
+    where(sin_theta <= 0.0f, ret) = 0.0f;
+    return ret;
+}
+
 template <int S>
 void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, const float *halton, const hit_data_t<S> &inter, const ray_packet_t<S> &ray,
                            const environment_t &env, const mesh_instance_t *mesh_instances, const uint32_t *mi_indices,
                            const mesh_t *meshes, const transform_t *transforms, const uint32_t *vtx_indices, const vertex_t *vertices,
                            const bvh_node_t *nodes, uint32_t node_index, const tri_accel_t *tris, const uint32_t *tri_indices,
-                           const material_t *materials, const texture_t *textures, const ray::ref::TextureAtlas &tex_atlas, simd_fvec<S> out_rgba[4], simd_ivec<S> *out_secondary_masks, ray_packet_t<S> *out_secondary_rays, int *out_secondary_rays_count) {
+                           const material_t *materials, const texture_t *textures, const ray::ref::TextureAtlas &tex_atlas, eTexFilter tex_filter, int8_t *out_tex_requests, simd_fvec<S> out_rgba[4], simd_ivec<S> *out_secondary_masks, ray_packet_t<S> *out_secondary_rays, int *out_secondary_rays_count) {
     out_rgba[3] = { 1.0f };
     
     auto ino_hit = inter.mask ^ simd_ivec<S>(-1);
     auto no_hit = reinterpret_cast<const simd_fvec<S>&>(ino_hit);
     
-    where(no_hit, out_rgba[0]) = ray.c[0] * env.sky_col[0];
-    where(no_hit, out_rgba[1]) = ray.c[1] * env.sky_col[1];
-    where(no_hit, out_rgba[2]) = ray.c[2] * env.sky_col[2];
+    if (env.env_map.texels) {
+        simd_fvec<S> col[3];
+        EvalEnvMap(env.env_map, ray.d, col);
+
+        // diffuse bounces can also be produced by light sampling, contributions are combined with power heuristic
+        simd_fvec<S> weight = { 1.0f };
+        const simd_fvec<S> was_diffuse = ray.pdf > 0.0f;
+        if (reinterpret_cast<const simd_ivec<S>&>(was_diffuse).not_all_zeros()) {
+            const simd_fvec<S> env_pdf = EnvMapPdf(env.env_map, ray.d), t = ray.pdf * ray.pdf;
+            where(was_diffuse, weight) = t / (env_pdf * env_pdf + t);
+        }
+
+        where(no_hit, out_rgba[0]) = ray.c[0] * col[0] * weight;
+        where(no_hit, out_rgba[1]) = ray.c[1] * col[1] * weight;
+        where(no_hit, out_rgba[2]) = ray.c[2] * col[2] * weight;
+    } else {
+        where(no_hit, out_rgba[0]) = ray.c[0] * env.sky_col[0];
+        where(no_hit, out_rgba[1]) = ray.c[1] * env.sky_col[1];
+        where(no_hit, out_rgba[2]) = ray.c[2] * env.sky_col[2];
+    }
     
     if (inter.mask.all_zeros()) return;
 
@@ -1155,9 +1709,32 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
 
     simd_fvec<S> plane_N[3];
 
+#if defined(USE_AVX2)
+    {   // vertex attributes are fetched with hardware gathers, lanes without hit read the first triangle
+        const auto *_vtx_indices = reinterpret_cast<const int *>(vtx_indices);
+        const int VtxStride = sizeof(vertex_t) / sizeof(float);
+
+        const simd_ivec<S> tri_index = (inter_prim_index & inter.mask) * 3;
+        const simd_ivec<S> v1 = gather(_vtx_indices, tri_index) * VtxStride,
+                           v2 = gather(_vtx_indices, tri_index + 1) * VtxStride,
+                           v3 = gather(_vtx_indices, tri_index + 2) * VtxStride;
+
+        for (int j = 0; j < 3; j++) {
+            p1[j] = gather(&vertices->p[j], v1); p2[j] = gather(&vertices->p[j], v2); p3[j] = gather(&vertices->p[j], v3);
+            n1[j] = gather(&vertices->n[j], v1); n2[j] = gather(&vertices->n[j], v2); n3[j] = gather(&vertices->n[j], v3);
+            b1[j] = gather(&vertices->b[j], v1); b2[j] = gather(&vertices->b[j], v2); b3[j] = gather(&vertices->b[j], v3);
+        }
+
+        for (int j = 0; j < 2; j++) {
+            u1[j] = gather(&vertices->t0[j], v1); u2[j] = gather(&vertices->t0[j], v2); u3[j] = gather(&vertices->t0[j], v3);
+        }
+    }
+#endif
+
     for (int i = 0; i < S; i++) {
         if (ino_hit[i]) continue;
 
+#if !defined(USE_AVX2)
         const auto &v1 = vertices[vtx_indices[inter_prim_index[i] * 3 + 0]];
         const auto &v2 = vertices[vtx_indices[inter_prim_index[i] * 3 + 1]];
         const auto &v3 = vertices[vtx_indices[inter_prim_index[i] * 3 + 2]];
@@ -1177,6 +1754,7 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
         b1[0][i] = v1.b[0]; b1[1][i] = v1.b[1]; b1[2][i] = v1.b[2];
         b2[0][i] = v2.b[0]; b2[1][i] = v2.b[1]; b2[2][i] = v2.b[2];
         b3[0][i] = v3.b[0]; b3[1][i] = v3.b[1]; b3[2][i] = v3.b[2];
+#endif
 
         const auto &tri = tris[inter.prim_index[i]];
         uint32_t mi = tri.mi;
@@ -1345,23 +1923,24 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
             const auto *mat = &materials[first_mi];
 
             while (mat->type == MixMaterial) {
+                if (out_tex_requests) RequestTextureLod(out_tex_requests, mat->textures[MAIN_TEXTURE], -NUM_MIP_LEVELS);
+
                 simd_fvec<S> mix[4];
                 SampleBilinear(tex_atlas, textures[mat->textures[MAIN_TEXTURE]], uvs, { 0 }, same_mi, mix);
                 mix[0] *= mat->strength;
 
                 first_mi = 0xffffffff;
 
-                for (int i = 0; i < S; i++) {
-                    if (!same_mi[i]) continue;
+                // shlick fresnel
+                const simd_fvec<S> x = 1.0f + _dot_I_N, x2 = x * x;
+                const simd_fvec<S> RR = clamp(mat->fresnel + (1.0f - mat->fresnel) * x2 * x2 * x, 0.0f, 1.0f);
 
-                    const float r = halton[hi[i] * 2];
+                const simd_fvec<S> r = gather(&halton[HaltonMixPick * HaltonSeqLen], hi);
 
-                    // shlick fresnel
-                    float RR = mat->fresnel + (1.0f - mat->fresnel) * std::pow(1.0f + _dot_I_N[i], 5.0f);
-                    if (RR < 0.0f) RR = 0.0f;
-                    else if (RR > 1.0f) RR = 1.0f;
+                for (int i = 0; i < S; i++) {
+                    if (!same_mi[i]) continue;
 
-                    mat_index[i] = (r * RR < mix[0][i]) ? mat->textures[MIX_MAT1] : mat->textures[MIX_MAT2];
+                    mat_index[i] = (r[i] * RR[i] < mix[0][i]) ? mat->textures[MIX_MAT1] : mat->textures[MIX_MAT2];
                     if (first_mi == 0xffffffff) {
                         first_mi = mat_index[i];
                     }
@@ -1387,7 +1966,54 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
             tex_normal[1] = tex_normal[1] * 2.0f - 1.0f;
             tex_normal[2] = tex_normal[2] * 2.0f - 1.0f;
 
-            SampleAnisotropic(tex_atlas, textures[mat->textures[MAIN_TEXTURE]], uvs, duv_dx, duv_dy, same_mi, tex_albedo);
+            const auto &albedo_tex = textures[mat->textures[MAIN_TEXTURE]];
+
+            // single tap filters take level from the longer axis of footprint, so growing differentials of deep bounces only make it coarser
+            simd_fvec<S> lod = { 0.0f };
+            if (tex_filter != TexFilterAnisotropic) {
+                const float sx = float(albedo_tex.size[0]), sy = float(albedo_tex.size[1]);
+                const simd_fvec<S> dx[2] = { duv_dx[0] * sx, duv_dx[1] * sy },
+                                   dy[2] = { duv_dy[0] * sx, duv_dy[1] * sy };
+                lod = 0.5f * log2(max(dx[0] * dx[0] + dx[1] * dx[1], dy[0] * dy[0] + dy[1] * dy[1]));
+            }
+
+            if (out_tex_requests) {
+                // normal map is sampled at the finest level, albedo at the level its filter picks
+                RequestTextureLod(out_tex_requests, mat->textures[NORMALS_TEXTURE], -NUM_MIP_LEVELS);
+
+                for (int i = 0; i < S; i++) {
+                    if (!same_mi[i]) continue;
+
+                    if (tex_filter == TexFilterAnisotropic) {
+                        const float _duv_dx[2] = { std::abs(duv_dx[0][i] * albedo_tex.size[0]), std::abs(duv_dx[1][i] * albedo_tex.size[1]) },
+                                    _duv_dy[2] = { std::abs(duv_dy[0][i] * albedo_tex.size[0]), std::abs(duv_dy[1][i] * albedo_tex.size[1]) };
+
+                        const float l1 = _duv_dx[0] * _duv_dx[0] + _duv_dx[1] * _duv_dx[1],
+                                    l2 = _duv_dy[0] * _duv_dy[0] + _duv_dy[1] * _duv_dy[1];
+
+                        const float aniso_lod = (l1 <= l2) ? std::log2(std::min(_duv_dx[0], _duv_dx[1])) :
+                                                             std::log2(std::min(_duv_dy[0], _duv_dy[1]));
+                        RequestTextureLod(out_tex_requests, mat->textures[MAIN_TEXTURE], aniso_lod);
+                    } else {
+                        RequestTextureLod(out_tex_requests, mat->textures[MAIN_TEXTURE], lod[i] + 0.5f);
+                    }
+                }
+            }
+
+            if (tex_filter == TexFilterAnisotropic) {
+                SampleAnisotropic(tex_atlas, albedo_tex, uvs, duv_dx, duv_dy, same_mi, tex_albedo);
+            } else {
+                // comparison is false for NaN, such lanes fall back to the finest level
+                simd_fvec<S> _lod = { 0.0f };
+                where(lod > 0.0f, _lod) = min(lod + 0.5f, simd_fvec<S>{ (float)MAX_MIP_LEVEL });
+                _lod = floor(_lod);
+
+                if (tex_filter == TexFilterBilinear) {
+                    SampleBilinear(tex_atlas, albedo_tex, uvs, (simd_ivec<S>)_lod, same_mi, tex_albedo);
+                } else {
+                    SampleNearest(tex_atlas, albedo_tex, uvs, _lod, same_mi, tex_albedo);
+                }
+            }
 
             tex_albedo[0] = pow(tex_albedo[0] * mat->main_color[0], 2.2f);
             tex_albedo[1] = pow(tex_albedo[1] * mat->main_color[1], 2.2f);
@@ -1421,20 +2047,10 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
                     cross(temp, B, TT);
                     cross(temp, TT, BB);
 
-                    for (int i = 0; i < S; i++) {
-                        if (!_mask[i]) continue;
+                    const simd_fvec<S> z = 1.0f - gather(&halton[HaltonLightU * HaltonSeqLen], hi) * env.sun_softness,
+                                       phi = gather(&halton[HaltonLightV * HaltonSeqLen], hi) * (2 * PI);
 
-                        const float z = 1.0f - halton[hi[i] * 2] * env.sun_softness;
-                        const float temp = std::sqrt(1.0f - z * z);
-
-                        const float phi = halton[hi[i] * 2 + 1] * 2 * PI;
-                        const float cos_phi = std::cos(phi);
-                        const float sin_phi = std::sin(phi);
-
-                        V[0][i] = temp * sin_phi * BB[0][i] + z * env.sun_dir[0] + temp * cos_phi * TT[0][i];
-                        V[1][i] = temp * sin_phi * BB[1][i] + z * env.sun_dir[1] + temp * cos_phi * TT[1][i];
-                        V[2][i] = temp * sin_phi * BB[2][i] + z * env.sun_dir[2] + temp * cos_phi * TT[2][i];
-                    }
+                    sample_around_axis(z, phi, temp, TT, BB, V);
 
                     ray_packet_t<S> r;
 
@@ -1460,6 +2076,48 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
                 where(mask, out_rgba[1]) = ray.c[1] * tex_albedo[1] * env.sun_col[1] * v * k;
                 where(mask, out_rgba[2]) = ray.c[2] * tex_albedo[2] * env.sun_col[2] * v * k;
 
+                if (env.env_map.texels) {
+                    // light sampling of environment map
+                    simd_fvec<S> L[3], env_col[3];
+                    const simd_fvec<S> pdf = SampleEnvMap(env.env_map, gather(&halton[HaltonLightU * HaltonSeqLen], hi), gather(&halton[HaltonLightV * HaltonSeqLen], hi), L);
+                    const simd_fvec<S> k = __N[0] * L[0] + __N[1] * L[1] + __N[2] * L[2];
+
+                    EvalEnvMap(env.env_map, L, env_col);
+
+                    // diffuse bounce picks directions uniformly over hemisphere
+                    const float bsdf_pdf = 1.0f / (2 * PI);
+                    const simd_fvec<S> t = pdf * pdf;
+
+                    const simd_fvec<S> use_sample = (pdf > 0.0f) & (k > 0.0f) & ((env_col[0] + env_col[1] + env_col[2]) > 0.0f);
+                    const simd_ivec<S> env_mask = same_mi & reinterpret_cast<const simd_ivec<S>&>(use_sample);
+
+                    simd_fvec<S> env_weight = { 0.0f };
+                    where(use_sample, env_weight) = k * bsdf_pdf / pdf * t / (bsdf_pdf * bsdf_pdf + t);
+
+                    if (env_mask.not_all_zeros()) {
+                        ray_packet_t<S> r;
+
+                        r.o[0] = P[0] + HIT_BIAS * __N[0];
+                        r.o[1] = P[1] + HIT_BIAS * __N[1];
+                        r.o[2] = P[2] + HIT_BIAS * __N[2];
+
+                        r.d[0] = L[0];
+                        r.d[1] = L[1];
+                        r.d[2] = L[2];
+
+                        hit_data_t<S> inter;
+                        Traverse_MacroTree_CPU(r, env_mask, nodes, node_index, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+
+                        where(reinterpret_cast<const simd_fvec<S>&>(inter.mask), env_weight) = 0.0f;
+
+                        const auto &_env_mask = reinterpret_cast<const simd_fvec<S>&>(env_mask);
+
+                        where(_env_mask, out_rgba[0]) = out_rgba[0] + ray.c[0] * tex_albedo[0] * env_col[0] * env_weight;
+                        where(_env_mask, out_rgba[1]) = out_rgba[1] + ray.c[1] * tex_albedo[1] * env_col[1] * env_weight;
+                        where(_env_mask, out_rgba[2]) = out_rgba[2] + ray.c[2] * tex_albedo[2] * env_col[2] * env_weight;
+                    }
+                }
+
                 // !!!!!!!!!!!!
                 simd_fvec<S> rc[3] = { ray.c[0] * tex_albedo[0],
                                        ray.c[1] * tex_albedo[1],
@@ -1467,24 +2125,14 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
 
                 simd_fvec<S> V[3];
 
-                for (int i = 0; i < S; i++) {
-                    if (!same_mi[i]) continue;
-
-                    const float z = 1.0f - halton[hi[i] * 2];
-                    const float temp = std::sqrt(1.0f - z * z);
+                const simd_fvec<S> z = gather(&halton[HaltonBsdfU * HaltonSeqLen], hi),
+                                   phi = gather(&halton[HaltonBsdfV * HaltonSeqLen], hi) * (2 * PI);
 
-                    const float phi = halton[((hash(hi[i]) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
-                    const float cos_phi = std::cos(phi);
-                    const float sin_phi = std::sin(phi);
+                sample_around_axis(z, phi, __N, T, B, V);
 
-                    V[0][i] = temp * sin_phi * B[0][i] + z * __N[0][i] + temp * cos_phi * T[0][i];
-                    V[1][i] = temp * sin_phi * B[1][i] + z * __N[1][i] + temp * cos_phi * T[1][i];
-                    V[2][i] = temp * sin_phi * B[2][i] + z * __N[2][i] + temp * cos_phi * T[2][i];
-
-                    rc[0][i] *= z;
-                    rc[1][i] *= z;
-                    rc[2][i] *= z;
-                }
+                rc[0] *= z;
+                rc[1] *= z;
+                rc[2] *= z;
 
                 simd_fvec<S> thres = dot(rc, rc);
 
@@ -1508,6 +2156,7 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
                     where(new_ray_mask, r.c[1]) = rc[1];
                     where(new_ray_mask, r.c[2]) = rc[2];
                     where(new_ray_mask, r.c[3]) = ray.c[3];
+                    where(new_ray_mask, r.pdf) = 1.0f / (2 * PI);
 
                     where(new_ray_mask, r.do_dx[0]) = do_dx[0];
                     where(new_ray_mask, r.do_dx[1]) = do_dx[1];
@@ -1545,22 +2194,14 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
                                        ray.c[1] /* tex_albedo[1]*/,
                                        ray.c[2] /* tex_albedo[2]*/ };
 
-                for (int i = 0; i < S; i++) {
-                    const float z = 1.0f - halton[hi[i] * 2] * mat->roughness;
-                    const float temp = std::sqrt(1.0f - z * z);
-
-                    const float phi = halton[((hash(hi[i]) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
-                    const float cos_phi = std::cos(phi);
-                    const float sin_phi = std::sin(phi);
+                const simd_fvec<S> z = 1.0f - gather(&halton[HaltonBsdfU * HaltonSeqLen], hi) * mat->roughness,
+                                   phi = gather(&halton[HaltonBsdfV * HaltonSeqLen], hi) * (2 * PI);
 
-                    V[0][i] = temp * sin_phi * BB[0][i] + z * V[0][i] + temp * cos_phi * TT[0][i];
-                    V[1][i] = temp * sin_phi * BB[1][i] + z * V[1][i] + temp * cos_phi * TT[1][i];
-                    V[2][i] = temp * sin_phi * BB[2][i] + z * V[2][i] + temp * cos_phi * TT[2][i];
+                sample_around_axis(z, phi, V, TT, BB, V);
 
-                    rc[0][i] *= z;
-                    rc[1][i] *= z;
-                    rc[2][i] *= z;
-                }
+                rc[0] *= z;
+                rc[1] *= z;
+                rc[2] *= z;
 
                 simd_fvec<S> thres = dot(rc, rc);
 
@@ -1584,6 +2225,7 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
                     where(new_ray_mask, r.c[1]) = rc[1];
                     where(new_ray_mask, r.c[2]) = rc[2];
                     where(new_ray_mask, r.c[3]) = ray.c[3];
+                    where(new_ray_mask, r.pdf) = 0.0f;
 
                     where(new_ray_mask, r.do_dx[0]) = do_dx[0];
                     where(new_ray_mask, r.do_dx[1]) = do_dx[1];
@@ -1632,22 +2274,14 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
 
                 simd_fvec<S> rc[3] = { ray.c[0], ray.c[1], ray.c[2] };
 
-                for (int i = 0; i < S; i++) {
-                    const float z = 1.0f - halton[hi[i] * 2] * mat->roughness;
-                    const float temp = std::sqrt(1.0f - z * z);
-
-                    const float phi = halton[((hash(hi[i]) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
-                    const float cos_phi = std::cos(phi);
-                    const float sin_phi = std::sin(phi);
+                const simd_fvec<S> z = 1.0f - gather(&halton[HaltonBsdfU * HaltonSeqLen], hi) * mat->roughness,
+                                   phi = gather(&halton[HaltonBsdfV * HaltonSeqLen], hi) * (2 * PI);
 
-                    V[0][i] = temp * sin_phi * BB[0][i] + z * V[0][i] + temp * cos_phi * TT[0][i];
-                    V[1][i] = temp * sin_phi * BB[1][i] + z * V[1][i] + temp * cos_phi * TT[1][i];
-                    V[2][i] = temp * sin_phi * BB[2][i] + z * V[2][i] + temp * cos_phi * TT[2][i];
+                sample_around_axis(z, phi, V, TT, BB, V);
 
-                    rc[0][i] *= z;
-                    rc[1][i] *= z;
-                    rc[2][i] *= z;
-                }
+                rc[0] *= z;
+                rc[1] *= z;
+                rc[2] *= z;
 
                 simd_fvec<S> k = (eta - eta * eta * dot(I, plane_N) / dot(V, plane_N));
                 simd_fvec<S> dmdx = k * ddn_dx;
@@ -1675,6 +2309,7 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
                     where(new_ray_mask, r.c[1]) = rc[1];
                     where(new_ray_mask, r.c[2]) = rc[2];
                     where(new_ray_mask, r.c[3]) = mat->ior;
+                    where(new_ray_mask, r.pdf) = 0.0f;
 
                     where(new_ray_mask, r.do_dx[0]) = do_dx[0];
                     where(new_ray_mask, r.do_dx[1]) = do_dx[1];
@@ -1695,9 +2330,9 @@ void ray::NS::ShadeSurface(const simd_ivec<S> &px_index, const int iteration, co
             } else if (mat->type == EmissiveMaterial) {
                 const auto &mask = reinterpret_cast<const simd_fvec<S>&>(same_mi);
 
-                where(mask, out_rgba[0]) = mat->strength * ray.c[0] * mat->main_color[0];
-                where(mask, out_rgba[1]) = mat->strength * ray.c[1] * mat->main_color[1];
-                where(mask, out_rgba[2]) = mat->strength * ray.c[2] * mat->main_color[2];
+                where(mask, out_rgba[0]) = mat->strength * ray.c[0] * tex_albedo[0];
+                where(mask, out_rgba[1]) = mat->strength * ray.c[1] * tex_albedo[1];
+                where(mask, out_rgba[2]) = mat->strength * ray.c[2] * tex_albedo[2];
             }
 
             index++;
@@ -0,0 +1,68 @@
+#include "HaltonTable.h"
+
+#include <functional>
+#include <limits>
+#include <random>
+
+#include "CoreRef.h"
+#include "Halton.h"
+
+ray::HaltonTable::HaltonTable() {
+    auto rand_func = std::bind(std::uniform_int_distribution<int>(), std::mt19937(0));
+    const auto perms = ray::ComputeRadicalInversePermutations(g_primes, PrimesCount, rand_func);
+    perms_.assign(perms.begin(), perms.end());
+}
+
+std::shared_ptr<const float> ray::HaltonTable::Get(int first_index) {
+    std::lock_guard<std::mutex> _(mtx_);
+
+    if (first_index != first_index_) {
+        std::shared_ptr<float> points(new float[HaltonDimsCount * HaltonSeqLen], std::default_delete<float[]>());
+        ComputeHaltonPoints(&perms_[0], first_index, HaltonSeqLen, points.get());
+
+        // regions that still use previous points keep them alive
+        points_ = std::move(points);
+        first_index_ = first_index;
+    }
+
+    return points_;
+}
+
+void ray::ComputeHaltonPoints(const int *perms, int first_index, int count, float *out_points) {
+    using namespace ray::ref;
+
+    for (int d = 0; d < HaltonDimsCount; d++) {
+        const int base = g_primes[d];
+        const int *perm = &perms[g_prime_sums[d]];
+
+        const float inv_base = 1.0f / base;
+        // contribution of infinite tail of zero digits, which are permuted too
+        const float tail = float(perm[0]) / (base - 1);
+
+        for (int i = 0; i < count; i += 4) {
+            simd_ivec4 a = { first_index + i, first_index + i + 1, first_index + i + 2, first_index + i + 3 };
+
+            simd_fvec4 res = { 0.0f }, inv_base_n = { 1.0f };
+
+            while (a.not_all_zeros()) {
+                // mask is computed on floats, indices are exact there, so no punning of int mask is needed
+                const simd_fvec4 active = (simd_fvec4)a > 0.0f;
+
+                // division through float is exact up to one for indices below 2^24
+                simd_ivec4 next = (simd_ivec4)floor((simd_fvec4)a * inv_base);
+                simd_ivec4 digit = a - next * base;
+                where(digit < 0, next) = next - 1;
+                where(digit >= base, next) = next + 1;
+                digit = a - next * base;
+
+                where(active, inv_base_n) = inv_base_n * inv_base;
+                where(active, res) = res + (simd_fvec4)gather(perm, digit) * inv_base_n;
+
+                a = next;
+            }
+
+            res = min(res + inv_base_n * tail, simd_fvec4{ 1.0f - std::numeric_limits<float>::epsilon() });
+            res.copy_to(&out_points[d * count + i]);
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ray {
+/** Table of scrambled Halton points shared by all regions rendered with one renderer,
+    points are recomputed once per HaltonSeqLen iterations instead of once per region
+*/
+class HaltonTable {
+    std::vector<int> perms_;
+
+    std::mutex mtx_;
+    int first_index_ = -1;
+    std::shared_ptr<const float> points_;
+public:
+    HaltonTable();
+
+    const int *permutations() const { return &perms_[0]; }
+
+    /// Returns HaltonSeqLen points starting from first_index, HaltonDimsCount values each, stored dimension by dimension
+    std::shared_ptr<const float> Get(int first_index);
+};
+
+/** Computes count points of scrambled Halton sequence starting from first_index, several points at a time.
+    Dimension d goes to out_points[d * count], count must be multiple of 4 and first_index + count less than 2^24
+*/
+void ComputeHaltonPoints(const int *perms, int first_index, int count, float *out_points);
+}
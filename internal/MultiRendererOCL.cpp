@@ -0,0 +1,191 @@
+#include "MultiRendererOCL.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "MultiSceneOCL.h"
+#include "Trace.h"
+
+ray::ocl::MultiRenderer::MultiRenderer(int w, int h, const std::vector<std::pair<int, int>> &devices, const char *program_cache_dir, bool sort_look_back)
+    : w_(w), h_(h) {
+    if (devices.empty()) throw std::runtime_error("Cannot create OpenCL renderer!");
+
+    for (const auto &d : devices) {
+        renderers_.emplace_back(new ocl::Renderer(w, h, d.first, d.second, program_cache_dir, sort_look_back));
+    }
+
+    throughput_.resize(renderers_.size(), 0.0);
+    frame_pixels_.resize((size_t)w * h);
+}
+
+void ray::ocl::MultiRenderer::Resize(int w, int h) {
+    for (auto &r : renderers_) {
+        r->Resize(w, h);
+    }
+
+    frame_pixels_.resize((size_t)w * h);
+    if (traversal_cost_enabled_) {
+        traversal_cost_.assign((size_t)w * h, { 0, 0 });
+    }
+    sub_regions_.clear();
+
+    w_ = w;
+    h_ = h;
+}
+
+void ray::ocl::MultiRenderer::Clear(const pixel_color_t &c) {
+    for (auto &r : renderers_) {
+        r->Clear(c);
+    }
+    std::fill(frame_pixels_.begin(), frame_pixels_.end(), c);
+    std::fill(traversal_cost_.begin(), traversal_cost_.end(), traversal_cost_t{ 0, 0 });
+}
+
+void ray::ocl::MultiRenderer::EnableTraversalCost(bool enable) {
+    traversal_cost_enabled_ = enable;
+    for (auto &r : renderers_) {
+        r->EnableTraversalCost(enable);
+    }
+
+    if (enable) {
+        traversal_cost_.assign((size_t)w_ * h_, { 0, 0 });
+    } else {
+        traversal_cost_.clear();
+        traversal_cost_.shrink_to_fit();
+    }
+}
+
+std::shared_ptr<ray::SceneBase> ray::ocl::MultiRenderer::CreateScene() {
+    std::vector<std::shared_ptr<ocl::Scene>> scenes;
+    for (auto &r : renderers_) {
+        scenes.push_back(std::dynamic_pointer_cast<ocl::Scene>(r->CreateScene()));
+    }
+    return std::make_shared<ocl::MultiScene>(std::move(scenes));
+}
+
+void ray::ocl::MultiRenderer::SetTextureFilter(int depth, eTexFilter filter) {
+    RendererBase::SetTextureFilter(depth, filter);
+    for (auto &r : renderers_) {
+        r->SetTextureFilter(depth, filter);
+    }
+}
+
+void ray::ocl::MultiRenderer::RenderScene(const std::shared_ptr<SceneBase> &_s, RegionContext &region) {
+    auto s = std::dynamic_pointer_cast<ocl::MultiScene>(_s);
+    if (!s || s->scenes_.size() != renderers_.size()) return;
+
+    const auto rect = region.rect();
+    TRACE_SCOPE("RenderScene", rect);
+
+    s->SyncCameras();
+
+    if (region.iteration == 0 || sub_regions_.empty() ||
+        rect.x != balanced_rect_.x || rect.y != balanced_rect_.y || rect.w != balanced_rect_.w || rect.h != balanced_rect_.h) {
+        Rebalance(rect);
+    }
+
+    std::vector<double> elapsed(renderers_.size(), 0.0);
+
+    {
+        // each renderer has its own context and queue, so devices can work in parallel
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < renderers_.size(); i++) {
+            if (!sub_regions_[i]) continue;
+
+            threads.emplace_back([this, &s, &elapsed, i]() {
+                const auto time_start = std::chrono::high_resolution_clock::now();
+                renderers_[i]->RenderScene(s->scenes_[i], *sub_regions_[i]);
+                elapsed[i] = std::chrono::duration<double>{ std::chrono::high_resolution_clock::now() - time_start }.count();
+            });
+        }
+
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+
+    for (size_t i = 0; i < renderers_.size(); i++) {
+        if (!sub_regions_[i]) continue;
+
+        const auto r = sub_regions_[i]->rect();
+
+        if (elapsed[i] > 0.0) {
+            const double t = r.h / elapsed[i];
+            throughput_[i] = throughput_[i] > 0.0 ? 0.5 * (throughput_[i] + t) : t;
+        }
+
+        // composite band into final image
+        const pixel_color_t *pixels = renderers_[i]->get_pixels_ref();
+        for (int y = r.y; y < r.y + r.h; y++) {
+            memcpy(&frame_pixels_[y * w_ + r.x], &pixels[y * w_ + r.x], sizeof(pixel_color_t) * r.w);
+        }
+
+        const traversal_cost_t *cost = renderers_[i]->get_traversal_cost_ref();
+        if (cost && !traversal_cost_.empty()) {
+            for (int y = r.y; y < r.y + r.h; y++) {
+                memcpy(&traversal_cost_[y * w_ + r.x], &cost[y * w_ + r.x], sizeof(traversal_cost_t) * r.w);
+            }
+        }
+
+        region.iteration = sub_regions_[i]->iteration;
+    }
+}
+
+void ray::ocl::MultiRenderer::Rebalance(const rect_t &rect) {
+    // devices without measurements yet get average weight
+    double known_sum = 0.0;
+    int known_count = 0;
+    for (double t : throughput_) {
+        if (t > 0.0) {
+            known_sum += t;
+            known_count++;
+        }
+    }
+    const double default_weight = known_count ? known_sum / known_count : 1.0;
+
+    std::vector<double> weights(renderers_.size());
+    double total_weight = 0.0;
+    for (size_t i = 0; i < renderers_.size(); i++) {
+        weights[i] = throughput_[i] > 0.0 ? throughput_[i] : default_weight;
+        total_weight += weights[i];
+    }
+
+    sub_regions_.clear();
+    sub_regions_.resize(renderers_.size());
+
+    double acc_weight = 0.0;
+    int y = rect.y;
+    for (size_t i = 0; i < renderers_.size(); i++) {
+        acc_weight += weights[i];
+
+        const int y_end = (i == renderers_.size() - 1) ? (rect.y + rect.h) : (rect.y + (int)(rect.h * acc_weight / total_weight + 0.5));
+        if (y_end > y) {
+            sub_regions_[i].reset(new RegionContext({ rect.x, y, rect.w, y_end - y }));
+        }
+        y = y_end;
+    }
+
+    balanced_rect_ = rect;
+}
+
+void ray::ocl::MultiRenderer::GetStats(stats_t &st) {
+    st = { 0 };
+    for (auto &r : renderers_) {
+        stats_t _st;
+        r->GetStats(_st);
+
+        st.time_primary_ray_gen_us += _st.time_primary_ray_gen_us;
+        st.time_primary_trace_us += _st.time_primary_trace_us;
+        st.time_primary_shade_us += _st.time_primary_shade_us;
+        st.time_secondary_sort_us += _st.time_secondary_sort_us;
+        st.time_secondary_trace_us += _st.time_secondary_trace_us;
+        st.time_secondary_shade_us += _st.time_secondary_shade_us;
+    }
+}
+
+void ray::ocl::MultiRenderer::ResetStats() {
+    for (auto &r : renderers_) {
+        r->ResetStats();
+    }
+}
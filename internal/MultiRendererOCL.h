@@ -0,0 +1,64 @@
+#pragma once
+
+#include "RendererOCL.h"
+
+namespace ray {
+namespace ocl {
+/** Renders frame on several OpenCL devices at once.
+    Image is split into horizontal bands, band height is proportional to measured device throughput.
+    Bands are rebalanced only when accumulation restarts, because each device keeps its own history.
+*/
+class MultiRenderer : public RendererBase {
+protected:
+    std::vector<std::unique_ptr<ocl::Renderer>> renderers_;
+
+    // part of region rendered by each device
+    std::vector<std::unique_ptr<RegionContext>> sub_regions_;
+    rect_t balanced_rect_ = { 0, 0, 0, 0 };
+
+    // measured rows per second
+    std::vector<double> throughput_;
+
+    int w_, h_;
+    std::vector<pixel_color_t> frame_pixels_;
+    std::vector<traversal_cost_t> traversal_cost_;
+
+    void Rebalance(const rect_t &rect);
+public:
+    /** @brief Create renderer
+        @param devices list of (platform index, device index) pairs
+    */
+    MultiRenderer(int w, int h, const std::vector<std::pair<int, int>> &devices, const char *program_cache_dir = nullptr, bool sort_look_back = false);
+    ~MultiRenderer() override = default;
+
+    eRendererType type() const override { return RendererOCL; }
+
+    std::pair<int, int> size() const override {
+        return std::make_pair(w_, h_);
+    }
+
+    const pixel_color_t *get_pixels_ref() const override {
+        return &frame_pixels_[0];
+    }
+
+    const traversal_cost_t *get_traversal_cost_ref() const override {
+        return traversal_cost_.empty() ? nullptr : &traversal_cost_[0];
+    }
+
+    void Resize(int w, int h) override;
+    void Clear(const pixel_color_t &c) override;
+
+    void EnableTraversalCost(bool enable) override;
+
+    std::shared_ptr<SceneBase> CreateScene() override;
+    void SetTextureFilter(int depth, eTexFilter filter) override;
+    void RenderScene(const std::shared_ptr<SceneBase> &s, RegionContext &region) override;
+
+    /// Stats are summed over all devices
+    void GetStats(stats_t &st) override;
+    void ResetStats() override;
+
+    size_t device_count() const { return renderers_.size(); }
+};
+}
+}
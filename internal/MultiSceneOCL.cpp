@@ -0,0 +1,132 @@
+#include "MultiSceneOCL.h"
+
+#include <cassert>
+
+#include "TextureUtilsRef.h"
+
+ray::ocl::MultiScene::MultiScene(std::vector<std::shared_ptr<ocl::Scene>> scenes) : scenes_(std::move(scenes)) {
+    if (scenes_.empty()) throw std::runtime_error("MultiScene requires at least one scene!");
+}
+
+void ray::ocl::MultiScene::SyncCameras() {
+    for (auto &s : scenes_) {
+        s->cams_ = cams_;
+        s->cam_first_free_ = cam_first_free_;
+        s->current_cam_ = current_cam_;
+    }
+}
+
+void ray::ocl::MultiScene::GetEnvironment(environment_desc_t &env) {
+    scenes_[0]->GetEnvironment(env);
+}
+
+void ray::ocl::MultiScene::SetEnvironment(const environment_desc_t &env) {
+    for (auto &s : scenes_) {
+        s->SetEnvironment(env);
+    }
+}
+
+uint32_t ray::ocl::MultiScene::AddTexture(const tex_desc_t &t) {
+    uint32_t index = scenes_[0]->AddTexture(t);
+    for (size_t i = 1; i < scenes_.size(); i++) {
+        uint32_t _index = scenes_[i]->AddTexture(t);
+        assert(_index == index);
+        ((void)_index);
+    }
+    return index;
+}
+
+void ray::ocl::MultiScene::AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) {
+    // mip levels are generated once for all devices
+    std::vector<ref::mip_chain_t> chains(count);
+    ref::GenerateMipChains(textures, count, count ? &chains[0] : nullptr);
+
+    for (size_t i = 0; i < count; i++) {
+        out_indices[i] = scenes_[0]->AddTexture(chains[i]);
+        for (size_t j = 1; j < scenes_.size(); j++) {
+            uint32_t _index = scenes_[j]->AddTexture(chains[i]);
+            assert(_index == out_indices[i]);
+            ((void)_index);
+        }
+    }
+}
+
+void ray::ocl::MultiScene::RemoveTexture(uint32_t i) {
+    for (auto &s : scenes_) {
+        s->RemoveTexture(i);
+    }
+}
+
+bool ray::ocl::MultiScene::CompactTextures(size_t max_texels) {
+    bool done = true;
+    for (auto &s : scenes_) {
+        done &= s->CompactTextures(max_texels);
+    }
+    return done;
+}
+
+void ray::ocl::MultiScene::SetTextureCacheSize(size_t size) {
+    for (auto &s : scenes_) {
+        s->SetTextureCacheSize(size);
+    }
+}
+
+void ray::ocl::MultiScene::UpdateTextureResidency() {
+    for (auto &s : scenes_) {
+        s->UpdateTextureResidency();
+    }
+}
+
+uint32_t ray::ocl::MultiScene::AddMaterial(const mat_desc_t &m) {
+    uint32_t index = scenes_[0]->AddMaterial(m);
+    for (size_t i = 1; i < scenes_.size(); i++) {
+        uint32_t _index = scenes_[i]->AddMaterial(m);
+        assert(_index == index);
+        ((void)_index);
+    }
+    return index;
+}
+
+void ray::ocl::MultiScene::RemoveMaterial(uint32_t i) {
+    for (auto &s : scenes_) {
+        s->RemoveMaterial(i);
+    }
+}
+
+uint32_t ray::ocl::MultiScene::AddMesh(const mesh_desc_t &m) {
+    uint32_t index = scenes_[0]->AddMesh(m);
+    for (size_t i = 1; i < scenes_.size(); i++) {
+        uint32_t _index = scenes_[i]->AddMesh(m);
+        assert(_index == index);
+        ((void)_index);
+    }
+    return index;
+}
+
+void ray::ocl::MultiScene::RemoveMesh(uint32_t i) {
+    for (auto &s : scenes_) {
+        s->RemoveMesh(i);
+    }
+}
+
+uint32_t ray::ocl::MultiScene::AddMeshInstance(uint32_t m_index, const float *xform) {
+    uint32_t index = scenes_[0]->AddMeshInstance(m_index, xform);
+    for (size_t i = 1; i < scenes_.size(); i++) {
+        uint32_t _index = scenes_[i]->AddMeshInstance(m_index, xform);
+        assert(_index == index);
+        ((void)_index);
+    }
+    return index;
+}
+
+void ray::ocl::MultiScene::SetMeshInstanceTransform(uint32_t mi_index, const float *xform) {
+    for (auto &s : scenes_) {
+        s->SetMeshInstanceTransform(mi_index, xform);
+    }
+}
+
+void ray::ocl::MultiScene::RemoveMeshInstance(uint32_t mi_index) {
+    for (auto &s : scenes_) {
+        s->RemoveMeshInstance(mi_index);
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "SceneOCL.h"
+
+namespace ray {
+namespace ocl {
+class MultiRenderer;
+
+/// Scene replicated on several OpenCL devices, each renderer of MultiRenderer gets its own copy
+class MultiScene : public SceneBase {
+protected:
+    friend class ocl::MultiRenderer;
+
+    std::vector<std::shared_ptr<ocl::Scene>> scenes_;
+
+    void SyncCameras();
+public:
+    explicit MultiScene(std::vector<std::shared_ptr<ocl::Scene>> scenes);
+
+    void GetEnvironment(environment_desc_t &env) override;
+    void SetEnvironment(const environment_desc_t &env) override;
+
+    uint32_t AddTexture(const tex_desc_t &t) override;
+    void AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) override;
+    void RemoveTexture(uint32_t i) override;
+    bool CompactTextures(size_t max_texels) override;
+
+    void SetTextureCacheSize(size_t size) override;
+    void UpdateTextureResidency() override;
+
+    uint32_t AddMaterial(const mat_desc_t &m) override;
+    void RemoveMaterial(uint32_t i) override;
+
+    uint32_t AddMesh(const mesh_desc_t &m) override;
+    void RemoveMesh(uint32_t i) override;
+
+    uint32_t AddMeshInstance(uint32_t m_index, const float *xform) override;
+    void SetMeshInstanceTransform(uint32_t mi_index, const float *xform) override;
+    void RemoveMeshInstance(uint32_t mi_index) override;
+
+    uint32_t triangle_count() override {
+        return scenes_[0]->triangle_count();
+    }
+    uint32_t node_count() override {
+        return scenes_[0]->node_count();
+    }
+};
+}
+}
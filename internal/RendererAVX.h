@@ -25,6 +25,11 @@ extern template bool Traverse_MacroTree_CPU<RayPacketSize>(const ray_packet_t<Ra
                                                            const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<RayPacketSize> &inter);
 extern template bool Traverse_MicroTree_CPU<RayPacketSize>(const ray_packet_t<RayPacketSize> &r, const simd_ivec<RayPacketSize> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
                                                            const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t<RayPacketSize> &inter);
+extern template bool Traverse_MacroTree_CPU<RayPacketSize>(const ray_packet_t<RayPacketSize> &r, const simd_ivec<RayPacketSize> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
+                                                           const mesh_instance_t *mesh_instances, const uint32_t *mi_indices, const mesh_t *meshes, const transform_t *transforms,
+                                                           const tri_accel_t *tris, const uint32_t *tri_indices, hit_data_t<RayPacketSize> &inter, traversal_stats_t<RayPacketSize> &inout_stats);
+extern template bool Traverse_MicroTree_CPU<RayPacketSize>(const ray_packet_t<RayPacketSize> &r, const simd_ivec<RayPacketSize> &ray_mask, const bvh_node_t *nodes, uint32_t node_index,
+                                                           const tri_accel_t *tris, const uint32_t *tri_indices, int obj_index, hit_data_t<RayPacketSize> &inter, traversal_stats_t<RayPacketSize> &inout_stats);
 
 extern template ray_packet_t<RayPacketSize> TransformRay<RayPacketSize>(const ray_packet_t<RayPacketSize> &r, const float *xform);
 extern template void TransformNormal<RayPacketSize>(const simd_fvec<RayPacketSize> n[3], const float *inv_xform, simd_fvec<RayPacketSize> out_n[3]);
@@ -40,13 +45,13 @@ extern template void ShadeSurface<RayPacketSize>(const simd_ivec<RayPacketSize>
                                                  const environment_t &env, const mesh_instance_t *mesh_instances, const uint32_t *mi_indices,
                                                  const mesh_t *meshes, const transform_t *transforms, const uint32_t *vtx_indices, const vertex_t *vertices,
                                                  const bvh_node_t *nodes, uint32_t node_index, const tri_accel_t *tris, const uint32_t *tri_indices,
-                                                 const material_t *materials, const texture_t *textures, const ray::ref::TextureAtlas &tex_atlas, simd_fvec<RayPacketSize> out_rgba[4], simd_ivec<RayPacketSize> *out_secondary_masks, ray_packet_t<RayPacketSize> *out_secondary_rays, int *out_secondary_rays_count);
+                                                 const material_t *materials, const texture_t *textures, const ray::ref::TextureAtlas &tex_atlas, eTexFilter tex_filter, int8_t *out_tex_requests, simd_fvec<RayPacketSize> out_rgba[4], simd_ivec<RayPacketSize> *out_secondary_masks, ray_packet_t<RayPacketSize> *out_secondary_rays, int *out_secondary_rays_count);
 
 extern template class RendererSIMD<RayPacketDimX, RayPacketDimY>;
 
 class Renderer : public RendererSIMD<RayPacketDimX, RayPacketDimY> {
 public:
-    Renderer(int w, int h) : RendererSIMD(w, h) {}
+    Renderer(int w, int h, eTexCompression tex_compression = TexCompressionNone) : RendererSIMD(w, h, tex_compression) {}
 
     eRendererType type() const override { return RendererAVX; }
 };
@@ -3,15 +3,30 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <direct.h>
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 #include <chrono>
-#include <random>
+#include <cstdio>
+#include <fstream>
 #include <string>
 #include <utility>
 
 #include "CoreOCL.h"
-#include "Halton.h"
 #include "SceneOCL.h"
 #include "TextureAtlasOCL.h"
+#include "Trace.h"
 
 namespace ray {
 namespace ocl {
@@ -45,10 +60,50 @@ const char *cl_src_postprocess =
 const char *cl_src_transform =
 #include "kernels/transform.cl"
     ;
+
+// ray sorting uses 4-bit digits, key is full 32-bit hash
+const int RadixBits = 4;
+const int RadixSize = 1 << RadixBits;
+const int RadixPasses = 32 / RadixBits;
+
+uint64_t HashString(const std::string &s, uint64_t hash = 14695981039346656037ull) {
+    // FNV-1a
+    for (char c : s) {
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
 }
+
+void MakeDir(const char *path) {
+#if defined(_WIN32)
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+int ProcessId() {
+#if defined(_WIN32)
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
 }
 
-ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index) : w_(w), h_(h), loaded_halton_(-1) {
+/// Atomically replaces file 'to' (if it exists) with file 'from'
+bool RenameOver(const char *from, const char *to) {
+#if defined(_WIN32)
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from, to) == 0;
+#endif
+}
+}
+}
+
+ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index, const char *program_cache_dir, bool sort_look_back)
+    : sort_look_back_(sort_look_back), w_(w), h_(h) {
     std::vector<cl::Platform> platforms;
     cl::Platform::get(&platforms);
     if (platforms.empty()) throw std::runtime_error("Cannot create OpenCL renderer!");
@@ -67,7 +122,7 @@ ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index)
     platform_ = platforms[platform_index];
 
     std::vector<cl::Device> devices;
-    platform_.getDevices(CL_DEVICE_TYPE_GPU, &devices);
+    platform_.getDevices(CL_DEVICE_TYPE_ALL, &devices);
 
     if (devices.empty()) throw std::runtime_error("Cannot create OpenCL renderer!");
 
@@ -75,6 +130,8 @@ ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index)
         device_index = 0;
     }
 
+    if (device_index < 0 || device_index >= (int)devices.size()) throw std::runtime_error("Cannot create OpenCL renderer!");
+
     device_ = devices[device_index];
     //if (device_ != devices[0]) throw std::runtime_error("Cannot create OpenCL renderer!");
 
@@ -85,138 +142,45 @@ ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index)
 
     max_work_group_size_ = device_.getInfo<CL_DEVICE_MAX_WORK_GROUP_SIZE>();
 
-    scan_portion_ = max_work_group_size_;
-    seg_scan_portion_ = std::min(max_work_group_size_, (size_t)64);
+    sort_portion_ = std::min(max_work_group_size_, (size_t)256);
 
     {
-        // create context
+        // create context, it holds only selected device, so several renderers can drive different devices independently
         cl_int error = CL_SUCCESS;
-        context_ = cl::Context(devices, nullptr, nullptr, nullptr, &error);
+        context_ = cl::Context(device_, nullptr, nullptr, nullptr, &error);
         if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
+#if defined(ENABLE_TRACING)
+        // kernel timings are taken from profiling info of events
+        queue_ = cl::CommandQueue(context_, device_, cl::QueueProperties::Profiling, &error);
+        trace_track_ = trace::RegisterTrack(("OpenCL " + device_.getInfo<CL_DEVICE_NAME>()).c_str());
+#else
         queue_ = cl::CommandQueue(context_, device_, cl::QueueProperties::None, &error);
+#endif
         if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
     }
 
     {
         // load kernels
+        program_cache_dir_ = program_cache_dir ? program_cache_dir : "";
 
-        std::string cl_src_defines;
-        cl_src_defines += "#define TRI_W_BITS " + std::to_string(TRI_W_BITS) + "\n";
-        cl_src_defines += "#define TRI_AXIS_ALIGNED_BIT " + std::to_string(TRI_AXIS_ALIGNED_BIT) + "\n";
-        cl_src_defines += "#define HIT_BIAS " + std::to_string(HIT_BIAS) + "f\n";
-        cl_src_defines += "#define HIT_EPS " + std::to_string(HIT_EPS) + "f\n";
-        cl_src_defines += "#define FLT_EPS " + std::to_string(FLT_EPS) + "f\n";
-        cl_src_defines += "#define PI " + std::to_string(PI) + "f\n";
-        cl_src_defines += "#define HaltonSeqLen " + std::to_string(HaltonSeqLen) + "\n";
-        cl_src_defines += "#define MAX_MIP_LEVEL " + std::to_string(MAX_MIP_LEVEL) + "\n";
-        cl_src_defines += "#define NUM_MIP_LEVELS " + std::to_string(NUM_MIP_LEVELS) + "\n";
-        cl_src_defines += "#define MAX_TEXTURE_SIZE " + std::to_string(MAX_TEXTURE_SIZE) + "\n";
-        cl_src_defines += "#define MAX_MATERIAL_TEXTURES " + std::to_string(MAX_MATERIAL_TEXTURES) + "\n";
-        cl_src_defines += "#define DiffuseMaterial " + std::to_string(DiffuseMaterial) + "\n";
-        cl_src_defines += "#define GlossyMaterial " + std::to_string(GlossyMaterial) + "\n";
-        cl_src_defines += "#define RefractiveMaterial " + std::to_string(RefractiveMaterial) + "\n";
-        cl_src_defines += "#define EmissiveMaterial " + std::to_string(EmissiveMaterial) + "\n";
-        cl_src_defines += "#define MixMaterial " + std::to_string(MixMaterial) + "\n";
-        cl_src_defines += "#define TransparentMaterial " + std::to_string(TransparentMaterial) + "\n";
-        cl_src_defines += "#define MAIN_TEXTURE " + std::to_string(MAIN_TEXTURE) + "\n";
-        cl_src_defines += "#define NORMALS_TEXTURE " + std::to_string(NORMALS_TEXTURE) + "\n";
-        cl_src_defines += "#define MIX_MAT1 " + std::to_string(MIX_MAT1) + "\n";
-        cl_src_defines += "#define MIX_MAT2 " + std::to_string(MIX_MAT2) + "\n";
-        cl_src_defines += "#define SCAN_PORTION " + std::to_string(scan_portion_) + "\n";
-        cl_src_defines += "#define SEG_SCAN_PORTION " + std::to_string(seg_scan_portion_) + "\n";
-
-        cl_int error = CL_SUCCESS;
-        cl::Program::Sources srcs = {
-            cl_src_defines,
-            cl_src_types, cl_src_transform, cl_src_primary_ray_gen,
-            cl_src_intersect, cl_src_traverse, cl_src_trace, cl_src_sort,
-            cl_src_texture, cl_src_shade, cl_src_postprocess
-        };
-
-        program_ = cl::Program(context_, srcs, &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-
-        std::string build_opts = "-Werror -cl-strict-aliasing -cl-mad-enable -cl-no-signed-zeros -cl-fast-relaxed-math ";// = "-cl-opt-disable ";
-
-        struct stat info = { 0 };
-        if (stat("./.dumps", &info) == 0 && info.st_mode & S_IFDIR) {
-            build_opts += "-save-temps=./.dumps/ ";
-        }
-
-        error = program_.build(build_opts.c_str());
-        if (error == CL_INVALID_BUILD_OPTIONS) {
-            // -cl-strict-aliasing not supported sometimes, try to build without it
-            build_opts = "-Werror -cl-mad-enable -cl-no-signed-zeros -cl-fast-relaxed-math ";
-            program_ = cl::Program(context_, srcs, &error);
-            if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-            error = program_.build(build_opts.c_str());
+        std::string build_log;
+        if (!BuildProgram(AllSceneFeatures, program_, &build_log)) {
+            throw std::runtime_error("Cannot create OpenCL renderer! Program build failed:\n" + build_log);
         }
-
-        if (error != CL_SUCCESS) {
-            auto build_log = program_.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device_);
-#if defined(_MSC_VER)
-            __debugbreak();
-#endif
+        if (!CreateKernels()) {
             throw std::runtime_error("Cannot create OpenCL renderer!");
         }
-
-        prim_rays_gen_kernel_ = cl::Kernel(program_, "GeneratePrimaryRays", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        texture_debug_page_kernel_ = cl::Kernel(program_, "TextureDebugPage", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        shade_primary_kernel_ = cl::Kernel(program_, "ShadePrimary", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        shade_secondary_kernel_ = cl::Kernel(program_, "ShadeSecondary", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        trace_primary_rays_kernel_ = cl::Kernel(program_, "TracePrimaryRays", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        compute_ray_hashes_kernel_ = cl::Kernel(program_, "ComputeRayHashes", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        set_head_flags_kernel_ = cl::Kernel(program_, "SetHeadFlags", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        excl_scan_kernel_ = cl::Kernel(program_, "ExclusiveScan", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        incl_scan_kernel_ = cl::Kernel(program_, "InclusiveScan", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        excl_seg_scan_kernel_ = cl::Kernel(program_, "ExclusiveSegScan", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        incl_seg_scan_kernel_ = cl::Kernel(program_, "InclusiveSegScan", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-
-        init_chunk_hash_and_base_kernel_ = cl::Kernel(program_, "InitChunkHashAndBase", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        init_chunk_size_kernel_ = cl::Kernel(program_, "InitChunkSize", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        init_skel_and_head_flags_kernel_ = cl::Kernel(program_, "InitSkeletonAndHeadFlags", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-
-        init_count_table_kernel_ = cl::Kernel(program_, "InitCountTable", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        write_sorted_chunks_kernel_ = cl::Kernel(program_, "WriteSortedChunks", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-
-        add_partial_sums_kernel_ = cl::Kernel(program_, "AddPartialSums", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        add_seg_partial_sums_kernel_ = cl::Kernel(program_, "AddSegPartialSums", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-
-        reorder_rays_kernel_ = cl::Kernel(program_, "ReorderRays", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-
-        trace_secondary_rays_kernel_ = cl::Kernel(program_, "TraceSecondaryRays", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        mix_incremental_kernel_ = cl::Kernel(program_, "MixIncremental", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
-        post_process_kernel_ = cl::Kernel(program_, "PostProcess", &error);
-        if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
+        program_features_ = AllSceneFeatures;
+        programs_[AllSceneFeatures] = program_;
 
 #if !defined(NDEBUG)
+        cl_int error = CL_SUCCESS;
         cl::Kernel types_check = cl::Kernel(program_, "TypesCheck", &error);
         if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
 
         char buf[512];
         int argc = 0;
-        if (types_check.setArg(argc++, sizeof(ray_packet_t), buf) != CL_SUCCESS ||
+        if (types_check.setArg(argc++, sizeof(packed_ray_t), buf) != CL_SUCCESS ||
                 types_check.setArg(argc++, sizeof(ocl::camera_t), buf) != CL_SUCCESS ||
                 types_check.setArg(argc++, sizeof(tri_accel_t), buf) != CL_SUCCESS ||
                 types_check.setArg(argc++, sizeof(hit_data_t), buf) != CL_SUCCESS ||
@@ -228,7 +192,7 @@ ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index)
                 types_check.setArg(argc++, sizeof(texture_t), buf) != CL_SUCCESS ||
                 types_check.setArg(argc++, sizeof(material_t), buf) != CL_SUCCESS ||
                 types_check.setArg(argc++, sizeof(environment_t), buf) != CL_SUCCESS ||
-                types_check.setArg(argc++, sizeof(ray_chunk_t), buf) != CL_SUCCESS) {
+                types_check.setArg(argc++, sizeof(env_cell_t), buf) != CL_SUCCESS) {
 #if defined(_MSC_VER)
             __debugbreak();
 #endif
@@ -262,60 +226,33 @@ ray::ocl::Renderer::Renderer(int w, int h, int platform_index, int device_index)
         error = queue_.enqueueWriteBuffer(color_table_buf_, CL_TRUE, 0, sizeof(pixel_color_t) * color_table.size(), &color_table[0]);
         if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
 
-        halton_seq_buf_ = cl::Buffer(context_, CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY, sizeof(float) * HaltonSeqLen * 2, nullptr, &error);
+        halton_seq_buf_ = cl::Buffer(context_, CL_MEM_READ_ONLY | CL_MEM_HOST_WRITE_ONLY, sizeof(float) * HaltonSeqLen * HaltonDimsCount, nullptr, &error);
         if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
     }
-
-    auto rand_func = std::bind(std::uniform_int_distribution<int>(), std::mt19937(0));
-    permutations_ = ray::ComputeRadicalInversePermutations(g_primes, PrimesCount, rand_func);
 }
 
 void ray::ocl::Renderer::Resize(int w, int h) {
+    if (w <= 0 || h <= 0 || w > MAX_FRAMEBUFFER_SIZE || h > MAX_FRAMEBUFFER_SIZE) {
+        throw std::runtime_error("Framebuffer size is not supported by OpenCL renderer!");
+    }
+
     const int num_pixels = w * h;
 
     cl_int error = CL_SUCCESS;
-    prim_rays_buf_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS, sizeof(ray_packet_t) * num_pixels, nullptr, &error);
-    secondary_rays_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(ray_packet_t) * num_pixels, nullptr, &error);
+    prim_rays_buf_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY | CL_MEM_HOST_NO_ACCESS, sizeof(packed_ray_t) * num_pixels, nullptr, &error);
+    secondary_rays_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(packed_ray_t) * num_pixels, nullptr, &error);
     prim_inters_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(hit_data_t) * num_pixels, nullptr, &error);
     
-    const size_t min_scan_portion = std::min(scan_portion_, seg_scan_portion_);
-    const size_t max_scan_portion = std::max(scan_portion_, seg_scan_portion_);
+    const size_t sort_tiles_count = (num_pixels + sort_portion_ - 1) / sort_portion_;
 
-    const size_t _rem = num_pixels % max_scan_portion;
-    const size_t _num = num_pixels + (_rem == 0 ? 0 : (max_scan_portion - _rem));
-    
-    ray_hashes_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num, nullptr, &error);
-    head_flags_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE, sizeof(uint32_t) * _num, nullptr, &error);
-    scan_values_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE, sizeof(uint32_t) * _num, nullptr, &error);
-
-    chunks_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(ray_chunk_t) * _num, nullptr, &error);
-    chunks2_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(ray_chunk_t) * _num, nullptr, &error);
-    counters_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(ray_chunk_t) * _num, nullptr, &error);
-
-    const size_t _rem1 = (_num / min_scan_portion) % max_scan_portion;
-    const size_t _num1 = _num / min_scan_portion + (_rem1 == 0 ? 0 : (max_scan_portion - _rem1));
-    partial_sums_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num1, nullptr, &error);
-    partial_flags_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num1, nullptr, &error);
-    scan_values2_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num1, nullptr, &error);
-
-    const size_t _rem2 = (_num1 / min_scan_portion) % max_scan_portion;
-    const size_t _num2 = _num1 / min_scan_portion + (_rem2 == 0 ? 0 : (max_scan_portion - _rem2));
-    partial_sums2_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num2, nullptr, &error);
-    partial_flags2_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num2, nullptr, &error);
-    scan_values3_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num2, nullptr, &error);
-
-    const size_t _rem3 = (_num2 / min_scan_portion) % max_scan_portion;
-    const size_t _num3 = _num2 / min_scan_portion + (_rem3 == 0 ? 0 : (max_scan_portion - _rem3));
-    partial_sums3_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num3, nullptr, &error);
-    partial_flags3_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num3, nullptr, &error);
-    scan_values4_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num3, nullptr, &error);
-
-    const size_t _rem4 = (_num3 / min_scan_portion) % max_scan_portion;
-    const size_t _num4 = _num3 / min_scan_portion + (_rem4 == 0 ? 0 : (max_scan_portion - _rem4));
-    partial_sums4_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num4, nullptr, &error);
-    partial_flags4_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num4, nullptr, &error);
-
-    skeleton_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * _num, nullptr, &error);
+    ray_hashes_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * num_pixels, nullptr, &error);
+    ray_hashes2_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * num_pixels, nullptr, &error);
+    ray_indices_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * num_pixels, nullptr, &error);
+    ray_indices2_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * num_pixels, nullptr, &error);
+
+    sort_histogram_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * RadixPasses * RadixSize, nullptr, &error);
+    sort_tile_counters_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * RadixPasses, nullptr, &error);
+    sort_tile_status_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE | CL_MEM_HOST_NO_ACCESS, sizeof(uint32_t) * RadixSize * sort_tiles_count, nullptr, &error);
 
     temp_buf_ = cl::Image2D(context_, CL_MEM_READ_WRITE, cl::ImageFormat { CL_RGBA, CL_FLOAT }, (size_t)w, (size_t)h, 0, nullptr, &error);
     clean_buf_ = cl::Image2D(context_, CL_MEM_READ_WRITE, cl::ImageFormat { CL_RGBA, CL_FLOAT }, (size_t)w, (size_t)h, 0, nullptr, &error);
@@ -326,12 +263,48 @@ void ray::ocl::Renderer::Resize(int w, int h) {
 
     w_ = w;
     h_ = h;
+
+    EnableTraversalCost(traversal_cost_enabled_);
 }
 
 void ray::ocl::Renderer::Clear(const pixel_color_t &c) {
     static_assert(sizeof(pixel_color_t) == sizeof(cl_float4), "!");
     queue_.enqueueFillImage(clean_buf_, *(cl_float4 *)&c, {}, { (size_t)w_, (size_t)h_, 1 });
     queue_.enqueueFillImage(final_buf_, *(cl_float4 *)&c, {}, { (size_t)w_, (size_t)h_, 1 });
+    if (!traversal_cost_.empty()) {
+        queue_.enqueueFillBuffer(traversal_cost_buf_, (cl_uint)0, 0, sizeof(traversal_cost_t) * traversal_cost_.size());
+        std::fill(traversal_cost_.begin(), traversal_cost_.end(), traversal_cost_t{ 0, 0 });
+    }
+}
+
+void ray::ocl::Renderer::EnableTraversalCost(bool enable) {
+    const uint32_t generic_features = AllSceneFeatures | CountTraversalCost;
+    if (enable && programs_.find(generic_features) == programs_.end()) {
+        // built right away, it is used while programs specialized for scene are compiled
+        cl::Program program;
+        if (!BuildProgram(generic_features, program, &program_build_log_)) {
+            enable = false;
+        } else {
+            programs_[generic_features] = program;
+        }
+    }
+
+    traversal_cost_enabled_ = enable;
+
+    // trace kernels always take cost buffer, it has dummy size while traversal cost is not collected
+    const size_t count = enable ? (size_t)w_ * h_ : 1;
+
+    cl_int error = CL_SUCCESS;
+    traversal_cost_buf_ = cl::Buffer(context_, CL_MEM_READ_WRITE, sizeof(traversal_cost_t) * count, nullptr, &error);
+    if (error != CL_SUCCESS) throw std::runtime_error("Cannot create OpenCL renderer!");
+    queue_.enqueueFillBuffer(traversal_cost_buf_, (cl_uint)0, 0, sizeof(traversal_cost_t) * count);
+
+    if (enable) {
+        traversal_cost_.assign(count, { 0, 0 });
+    } else {
+        traversal_cost_.clear();
+        traversal_cost_.shrink_to_fit();
+    }
 }
 
 std::shared_ptr<ray::SceneBase> ray::ocl::Renderer::CreateScene() {
@@ -342,6 +315,11 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
     auto s = std::dynamic_pointer_cast<ocl::Scene>(_s);
     if (!s) return;
 
+    TRACE_SCOPE("RenderScene", region.rect());
+
+    const uint32_t features = s->features() | (traversal_cost_enabled_ ? CountTraversalCost : 0);
+    if (features != program_features_ && !SwitchProgram(features)) return;
+
     uint32_t macro_tree_root = s->macro_nodes_start_;
     bvh_node_t root_node;
     s->nodes_.Get(macro_tree_root, root_node);
@@ -352,14 +330,15 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
 
     region.iteration++;
     if (!region.halton_seq || region.iteration % HaltonSeqLen == 0) {
-        UpdateHaltonSequence(region.iteration, region.halton_seq);
+        region.halton_seq = halton_table_.Get(region.iteration);
     }
 
-    if (region.iteration != loaded_halton_) {
-        if (CL_SUCCESS != queue_.enqueueWriteBuffer(halton_seq_buf_, CL_TRUE, 0, sizeof(float) * HaltonSeqLen * 2, &region.halton_seq[0])) {
+    // points change once per HaltonSeqLen iterations, holding them keeps pointer comparison valid
+    if (region.halton_seq != loaded_halton_) {
+        if (CL_SUCCESS != queue_.enqueueWriteBuffer(halton_seq_buf_, CL_TRUE, 0, sizeof(float) * HaltonSeqLen * HaltonDimsCount, region.halton_seq.get())) {
             return;
         }
-        loaded_halton_ = region.iteration;
+        loaded_halton_ = region.halton_seq;
     }
 
     const auto &cam = s->GetCamera(s->current_cam());
@@ -381,7 +360,7 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
 
     if (!kernel_TracePrimaryRays(prim_rays_buf_, region.rect(), w_,
                                     s->mesh_instances_.buf(), s->mi_indices_.buf(), s->meshes_.buf(), s->transforms_.buf(),
-                                    s->nodes_.buf(), (cl_uint)s->macro_nodes_start_, s->tris_.buf(), s->tri_indices_.buf(), prim_inters_buf_)) return;
+                                    s->nodes_.buf(), (cl_uint)s->macro_nodes_start_, s->tris_.buf(), s->tri_indices_.buf(), prim_inters_buf_, traversal_cost_buf_)) return;
 
     cl_int secondary_rays_count = 0;
     if (queue_.enqueueWriteBuffer(secondary_rays_count_buf_, CL_TRUE, 0, sizeof(cl_int),
@@ -396,7 +375,7 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
                                 s->transforms_.buf(), s->vtx_indices_.buf(), s->vertices_.buf(),
                                 s->nodes_.buf(), (cl_uint)s->macro_nodes_start_,
                                 s->tris_.buf(), s->tri_indices_.buf(),
-                                s->env_, s->materials_.buf(), s->textures_.buf(), s->texture_atlas_.atlas(), temp_buf_,
+                                s->env_, s->env_map_.buf(), s->env_cells_.buf(), s->materials_.buf(), s->textures_.buf(), s->texture_atlas_.atlas(), (cl_int)texture_filter(0), temp_buf_,
                                 secondary_rays_buf_, secondary_rays_count_buf_)) return;
     
     if (queue_.enqueueReadBuffer(secondary_rays_count_buf_, CL_TRUE, 0, sizeof(cl_int),
@@ -409,20 +388,16 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
     for (int depth = 0; depth < MAX_BOUNCES && secondary_rays_count; depth++) {
         auto time_secondary_sort_start = std::chrono::high_resolution_clock::now();
 
-        if (secondary_rays_count > (cl_int)scan_portion_ * 64) {
-            if (!SortRays(secondary_rays_buf_, secondary_rays_count, root_min, cell_size, ray_hashes_buf_, head_flags_buf_,
-                          partial_sums_buf_, partial_sums2_buf_, partial_sums3_buf_, partial_sums4_buf_, partial_flags_buf_,
-                          partial_flags2_buf_, partial_flags3_buf_, partial_flags4_buf_, scan_values_buf_, scan_values2_buf_,
-                          scan_values3_buf_, scan_values4_buf_, chunks_buf_, chunks2_buf_, counters_buf_, skeleton_buf_, prim_rays_buf_)) return;
-            std::swap(prim_rays_buf_, secondary_rays_buf_);
-        }
+        if (!SortRays(secondary_rays_buf_, secondary_rays_count, root_min, cell_size, prim_rays_buf_)) return;
+        std::swap(prim_rays_buf_, secondary_rays_buf_);
 
         queue_.finish();
         auto time_secondary_trace_start = std::chrono::high_resolution_clock::now();
 
-        if (!kernel_TraceSecondaryRays(secondary_rays_buf_, secondary_rays_count,
+        if (!kernel_TraceSecondaryRays(secondary_rays_buf_, secondary_rays_count, w_,
                                         s->mesh_instances_.buf(), s->mi_indices_.buf(), s->meshes_.buf(), s->transforms_.buf(),
-                                        s->nodes_.buf(), (cl_uint)s->macro_nodes_start_, s->tris_.buf(), s->tri_indices_.buf(), prim_inters_buf_)) return;
+                                        s->nodes_.buf(), (cl_uint)s->macro_nodes_start_, s->tris_.buf(), s->tri_indices_.buf(), prim_inters_buf_,
+                                        traversal_cost_buf_)) return;
 
         cl_int new_secondary_rays_count = 0;
         if (queue_.enqueueWriteBuffer(secondary_rays_count_buf_, CL_TRUE, 0, sizeof(cl_int), &new_secondary_rays_count) != CL_SUCCESS) return;
@@ -443,7 +418,7 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
                                     s->transforms_.buf(), s->vtx_indices_.buf(), s->vertices_.buf(),
                                     s->nodes_.buf(), (cl_uint)s->macro_nodes_start_,
                                     s->tris_.buf(), s->tri_indices_.buf(),
-                                    s->env_, s->materials_.buf(), s->textures_.buf(), s->texture_atlas_.atlas(), final_buf_, temp_buf_,
+                                    s->env_, s->env_map_.buf(), s->env_cells_.buf(), s->materials_.buf(), s->textures_.buf(), s->texture_atlas_.atlas(), (cl_int)texture_filter(depth + 1), final_buf_, temp_buf_,
                                     prim_rays_buf_, secondary_rays_count_buf_)) return;
 
         if (queue_.enqueueReadBuffer(secondary_rays_count_buf_, CL_TRUE, 0, sizeof(cl_int),
@@ -469,13 +444,65 @@ void ray::ocl::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
 
     float k = 1.0f / region.iteration;
 
-    if (!kernel_MixIncremental(clean_buf_, temp_buf_, (cl_float)k, final_buf_)) return;
-    std::swap(final_buf_, clean_buf_);
+    // only pixels of rendered region are accumulated and read back (frame can be split between devices)
+    const auto &r = region.rect();
+    const cl::array<size_t, 3> origin = { (size_t)r.x, (size_t)r.y, 0 }, size = { (size_t)r.w, (size_t)r.h, 1 };
+
+    if (!kernel_MixIncremental(clean_buf_, temp_buf_, (cl_float)k, r, final_buf_)) return;
+    if (r.x == 0 && r.y == 0 && r.w == w_ && r.h == h_) {
+        std::swap(final_buf_, clean_buf_);
+    } else {
+        // accumulated pixels of other regions must stay intact
+        if (queue_.enqueueCopyImage(final_buf_, clean_buf_, origin, origin, size) != CL_SUCCESS) return;
+    }
+
+    if (!kernel_Postprocess(clean_buf_, w_, h_, r, final_buf_)) return;
+
+    error = queue_.enqueueReadImage(final_buf_, CL_TRUE, origin, size, sizeof(pixel_color_t) * w_, 0, &frame_pixels_[4 * ((size_t)r.y * w_ + r.x)]);
+
+    if (!traversal_cost_.empty()) {
+        const cl::array<size_t, 3> buf_origin = { sizeof(traversal_cost_t) * r.x, (size_t)r.y, 0 },
+                                   buf_size = { sizeof(traversal_cost_t) * r.w, (size_t)r.h, 1 };
+        error = queue_.enqueueReadBufferRect(traversal_cost_buf_, CL_TRUE, buf_origin, buf_origin, buf_size,
+                                             sizeof(traversal_cost_t) * w_, 0, sizeof(traversal_cost_t) * w_, 0, &traversal_cost_[0]);
+    }
+
+#if defined(ENABLE_TRACING)
+    FlushTracedKernels();
+#endif
+}
+
+cl_int ray::ocl::Renderer::EnqueueKernel(const cl::Kernel &kernel, const cl::NDRange &offset, const cl::NDRange &global, const cl::NDRange &local) {
+#if defined(ENABLE_TRACING)
+    traced_kernel_t k;
+    k.enqueue_ns = trace::Now();
+
+    const cl_int error = queue_.enqueueNDRangeKernel(kernel, offset, global, local, nullptr, &k.event);
+    if (error == CL_SUCCESS) {
+        // names are kept in set, so that events can point to them
+        k.name = kernel_names_.insert(kernel.getInfo<CL_KERNEL_FUNCTION_NAME>()).first->c_str();
+        traced_kernels_.push_back(k);
+    }
+    return error;
+#else
+    return queue_.enqueueNDRangeKernel(kernel, offset, global, local);
+#endif
+}
 
-    if (!kernel_Postprocess(clean_buf_, w_, h_, final_buf_)) return;
+#if defined(ENABLE_TRACING)
+void ray::ocl::Renderer::FlushTracedKernels() {
+    for (const traced_kernel_t &k : traced_kernels_) {
+        cl_ulong queued = 0, start = 0, end = 0;
+        if (k.event.getProfilingInfo(CL_PROFILING_COMMAND_QUEUED, &queued) != CL_SUCCESS ||
+            k.event.getProfilingInfo(CL_PROFILING_COMMAND_START, &start) != CL_SUCCESS ||
+            k.event.getProfilingInfo(CL_PROFILING_COMMAND_END, &end) != CL_SUCCESS) continue;
 
-    error = queue_.enqueueReadImage(final_buf_, CL_TRUE, {}, { (size_t)w_, (size_t)h_, 1 }, 0, 0, &frame_pixels_[0]);
+        // device clock has different origin, it is aligned with host by the moment kernel was enqueued
+        trace::AddTrackEvent(trace_track_, k.name, k.enqueue_ns + (start - queued), k.enqueue_ns + (end - queued));
+    }
+    traced_kernels_.clear();
 }
+#endif
 
 bool ray::ocl::Renderer::kernel_GeneratePrimaryRays(const cl_int iteration, const ray::ocl::camera_t &cam, const ray::rect_t &rect, cl_int w, cl_int h, const cl::Buffer &halton, const cl::Buffer &out_rays) {
     cl_uint argc = 0;
@@ -487,7 +514,7 @@ bool ray::ocl::Renderer::kernel_GeneratePrimaryRays(const cl_int iteration, cons
             prim_rays_gen_kernel_.setArg(argc++, out_rays) != CL_SUCCESS) {
         return false;
     }
-    return CL_SUCCESS == queue_.enqueueNDRangeKernel(prim_rays_gen_kernel_, cl::NDRange{ (size_t)rect.x, (size_t)rect.y }, cl::NDRange{ (size_t)rect.w, (size_t)rect.h });
+    return CL_SUCCESS == EnqueueKernel(prim_rays_gen_kernel_, cl::NDRange{ (size_t)rect.x, (size_t)rect.y }, cl::NDRange{ (size_t)rect.w, (size_t)rect.h });
 }
 
 bool ray::ocl::Renderer::kernel_TextureDebugPage(const cl::Image2DArray &textures, cl_int page, const cl::Image2D &frame_buf) {
@@ -501,7 +528,7 @@ bool ray::ocl::Renderer::kernel_TextureDebugPage(const cl::Image2DArray &texture
     auto w = frame_buf.getImageInfo<CL_IMAGE_WIDTH>(),
          h = frame_buf.getImageInfo<CL_IMAGE_HEIGHT>();
 
-    return CL_SUCCESS == queue_.enqueueNDRangeKernel(texture_debug_page_kernel_, cl::NullRange, cl::NDRange { (size_t)w, (size_t)h });
+    return CL_SUCCESS == EnqueueKernel(texture_debug_page_kernel_, cl::NullRange, cl::NDRange { (size_t)w, (size_t)h });
 }
 
 bool ray::ocl::Renderer::kernel_ShadePrimary(const cl_int iteration, const cl::Buffer &halton,
@@ -511,8 +538,8 @@ bool ray::ocl::Renderer::kernel_ShadePrimary(const cl_int iteration, const cl::B
         const cl::Buffer &transforms, const cl::Buffer &vtx_indices, const cl::Buffer &vertices,
         const cl::Buffer &nodes, cl_uint node_index,
         const cl::Buffer &tris, const cl::Buffer &tri_indices,
-        const environment_t &env, const cl::Buffer &materials,
-        const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, const cl::Image2D &frame_buf,
+        const environment_t &env, const cl::Buffer &env_map, const cl::Buffer &env_cells, const cl::Buffer &materials,
+        const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, cl_int tex_filter, const cl::Image2D &frame_buf,
         const cl::Buffer &secondary_rays, const cl::Buffer &secondary_rays_count) {
     cl_uint argc = 0;
     if (shade_primary_kernel_.setArg(argc++, iteration) != CL_SUCCESS ||
@@ -531,16 +558,19 @@ bool ray::ocl::Renderer::kernel_ShadePrimary(const cl_int iteration, const cl::B
             shade_primary_kernel_.setArg(argc++, tris) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, tri_indices) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, env) != CL_SUCCESS ||
+            shade_primary_kernel_.setArg(argc++, env_map) != CL_SUCCESS ||
+            shade_primary_kernel_.setArg(argc++, env_cells) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, materials) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, textures) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, texture_atlas) != CL_SUCCESS ||
+            shade_primary_kernel_.setArg(argc++, tex_filter) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, frame_buf) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, secondary_rays) != CL_SUCCESS ||
             shade_primary_kernel_.setArg(argc++, secondary_rays_count) != CL_SUCCESS) {
         return false;
     }
 
-    return CL_SUCCESS == queue_.enqueueNDRangeKernel(shade_primary_kernel_, { (size_t)rect.x, (size_t)rect.y }, { (size_t)rect.w, (size_t)rect.h });
+    return CL_SUCCESS == EnqueueKernel(shade_primary_kernel_, { (size_t)rect.x, (size_t)rect.y }, { (size_t)rect.w, (size_t)rect.h });
 }
 
 bool ray::ocl::Renderer::kernel_ShadeSecondary(const cl_int iteration, const cl::Buffer &halton,
@@ -550,8 +580,8 @@ bool ray::ocl::Renderer::kernel_ShadeSecondary(const cl_int iteration, const cl:
         const cl::Buffer &transforms, const cl::Buffer &vtx_indices, const cl::Buffer &vertices,
         const cl::Buffer &nodes, cl_uint node_index,
         const cl::Buffer &tris, const cl::Buffer &tri_indices,
-        const environment_t &env, const cl::Buffer &materials,
-        const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, const cl::Image2D &frame_buf, const cl::Image2D &frame_buf2,
+        const environment_t &env, const cl::Buffer &env_map, const cl::Buffer &env_cells, const cl::Buffer &materials,
+        const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, cl_int tex_filter, const cl::Image2D &frame_buf, const cl::Image2D &frame_buf2,
         const cl::Buffer &secondary_rays, const cl::Buffer &secondary_rays_count) {
     if (rays_count == 0) return true;
 
@@ -571,9 +601,12 @@ bool ray::ocl::Renderer::kernel_ShadeSecondary(const cl_int iteration, const cl:
             shade_secondary_kernel_.setArg(argc++, tris) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, tri_indices) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, env) != CL_SUCCESS ||
+            shade_secondary_kernel_.setArg(argc++, env_map) != CL_SUCCESS ||
+            shade_secondary_kernel_.setArg(argc++, env_cells) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, materials) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, textures) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, texture_atlas) != CL_SUCCESS ||
+            shade_secondary_kernel_.setArg(argc++, tex_filter) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, frame_buf) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, frame_buf2) != CL_SUCCESS ||
             shade_secondary_kernel_.setArg(argc++, secondary_rays) != CL_SUCCESS ||
@@ -589,13 +622,13 @@ bool ray::ocl::Renderer::kernel_ShadeSecondary(const cl_int iteration, const cl:
     cl::NDRange local = { group_size };
 
     if (rays_count - remaining > 0) {
-        if (queue_.enqueueNDRangeKernel(shade_secondary_kernel_, cl::NullRange, global, local) != CL_SUCCESS) {
+        if (EnqueueKernel(shade_secondary_kernel_, cl::NullRange, global, local) != CL_SUCCESS) {
             return false;
         }
     }
 
     if (remaining) {
-        if (queue_.enqueueNDRangeKernel(shade_secondary_kernel_, { (size_t)(rays_count - remaining) }, { (size_t)(remaining) }) != CL_SUCCESS) {
+        if (EnqueueKernel(shade_secondary_kernel_, { (size_t)(rays_count - remaining) }, { (size_t)(remaining) }) != CL_SUCCESS) {
             return false;
         }
     }
@@ -604,7 +637,8 @@ bool ray::ocl::Renderer::kernel_ShadeSecondary(const cl_int iteration, const cl:
 }
 
 bool ray::ocl::Renderer::kernel_TracePrimaryRays(const cl::Buffer &rays, const ray::rect_t &rect, cl_int w, const cl::Buffer &mesh_instances, const cl::Buffer &mi_indices, const cl::Buffer &meshes, const cl::Buffer &transforms,
-        const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections) {
+        const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections,
+        const cl::Buffer &out_cost) {
     cl_uint argc = 0;
     if (trace_primary_rays_kernel_.setArg(argc++, rays) != CL_SUCCESS ||
             trace_primary_rays_kernel_.setArg(argc++, w) != CL_SUCCESS ||
@@ -616,7 +650,8 @@ bool ray::ocl::Renderer::kernel_TracePrimaryRays(const cl::Buffer &rays, const r
             trace_primary_rays_kernel_.setArg(argc++, node_index) != CL_SUCCESS ||
             trace_primary_rays_kernel_.setArg(argc++, tris) != CL_SUCCESS ||
             trace_primary_rays_kernel_.setArg(argc++, tri_indices) != CL_SUCCESS ||
-            trace_primary_rays_kernel_.setArg(argc++, intersections) != CL_SUCCESS) {
+            trace_primary_rays_kernel_.setArg(argc++, intersections) != CL_SUCCESS ||
+            trace_primary_rays_kernel_.setArg(argc++, out_cost) != CL_SUCCESS) {
         return false;
     }
 
@@ -628,19 +663,19 @@ bool ray::ocl::Renderer::kernel_TracePrimaryRays(const cl::Buffer &rays, const r
     cl::NDRange local = { (size_t)8, std::min((size_t)8, max_work_group_size_ / 8) };
 
     if (rect.w - border_x > 0 && rect.h - border_y > 0) {
-        if (queue_.enqueueNDRangeKernel(trace_primary_rays_kernel_, { (size_t)rect.x, (size_t)rect.y }, global, local) != CL_SUCCESS) {
+        if (EnqueueKernel(trace_primary_rays_kernel_, { (size_t)rect.x, (size_t)rect.y }, global, local) != CL_SUCCESS) {
             return false;
         }
     }
 
     if (border_x) {
-        if (queue_.enqueueNDRangeKernel(trace_primary_rays_kernel_, { (size_t)(rect.x + rect.w - border_x), (size_t)rect.y }, { (size_t)(border_x), (size_t)(rect.h - border_y) }) != CL_SUCCESS) {
+        if (EnqueueKernel(trace_primary_rays_kernel_, { (size_t)(rect.x + rect.w - border_x), (size_t)rect.y }, { (size_t)(border_x), (size_t)(rect.h - border_y) }) != CL_SUCCESS) {
             return false;
         }
     }
 
     if (border_y) {
-        if (queue_.enqueueNDRangeKernel(trace_primary_rays_kernel_, { (size_t)rect.x, (size_t)(rect.y + rect.h - border_y) }, { (size_t)(rect.w), (size_t)(border_y) }) != CL_SUCCESS) {
+        if (EnqueueKernel(trace_primary_rays_kernel_, { (size_t)rect.x, (size_t)(rect.y + rect.h - border_y) }, { (size_t)(rect.w), (size_t)(border_y) }) != CL_SUCCESS) {
             return false;
         }
     }
@@ -648,11 +683,13 @@ bool ray::ocl::Renderer::kernel_TracePrimaryRays(const cl::Buffer &rays, const r
     return true;
 }
 
-bool ray::ocl::Renderer::kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_int rays_count,
+bool ray::ocl::Renderer::kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_int rays_count, cl_int w,
         const cl::Buffer &mesh_instances, const cl::Buffer &mi_indices, const cl::Buffer &meshes, const cl::Buffer &transforms,
-        const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections) {
+        const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections,
+        const cl::Buffer &out_cost) {
     cl_uint argc = 0;
     if (trace_secondary_rays_kernel_.setArg(argc++, rays) != CL_SUCCESS ||
+        trace_secondary_rays_kernel_.setArg(argc++, w) != CL_SUCCESS ||
         trace_secondary_rays_kernel_.setArg(argc++, mesh_instances) != CL_SUCCESS ||
         trace_secondary_rays_kernel_.setArg(argc++, mi_indices) != CL_SUCCESS ||
         trace_secondary_rays_kernel_.setArg(argc++, meshes) != CL_SUCCESS ||
@@ -661,7 +698,8 @@ bool ray::ocl::Renderer::kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_in
         trace_secondary_rays_kernel_.setArg(argc++, node_index) != CL_SUCCESS ||
         trace_secondary_rays_kernel_.setArg(argc++, tris) != CL_SUCCESS ||
         trace_secondary_rays_kernel_.setArg(argc++, tri_indices) != CL_SUCCESS ||
-        trace_secondary_rays_kernel_.setArg(argc++, intersections) != CL_SUCCESS) {
+        trace_secondary_rays_kernel_.setArg(argc++, intersections) != CL_SUCCESS ||
+        trace_secondary_rays_kernel_.setArg(argc++, out_cost) != CL_SUCCESS) {
         return false;
     }
 
@@ -673,13 +711,13 @@ bool ray::ocl::Renderer::kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_in
     cl::NDRange local = { (size_t)(group_size) };
 
     if (rays_count - remaining > 0) {
-        if (queue_.enqueueNDRangeKernel(trace_secondary_rays_kernel_, cl::NullRange, global, local) != CL_SUCCESS) {
+        if (EnqueueKernel(trace_secondary_rays_kernel_, cl::NullRange, global, local) != CL_SUCCESS) {
             return false;
         }
     }
 
     if (remaining) {
-        if (queue_.enqueueNDRangeKernel(trace_secondary_rays_kernel_, { (size_t)(rays_count - remaining) }, { (size_t)(remaining) }) != CL_SUCCESS) {
+        if (EnqueueKernel(trace_secondary_rays_kernel_, { (size_t)(rays_count - remaining) }, { (size_t)(remaining) }) != CL_SUCCESS) {
             return false;
         }
     }
@@ -687,223 +725,122 @@ bool ray::ocl::Renderer::kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_in
     return true;
 }
 
-bool ray::ocl::Renderer::kernel_ComputeRayHashes(const cl::Buffer &rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &out_hashes) {
+bool ray::ocl::Renderer::kernel_ComputeRayHashes(const cl::Buffer &rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size,
+                                                 const cl::Buffer &out_hashes, const cl::Buffer &out_indices) {
     cl_uint argc = 0;
     if (compute_ray_hashes_kernel_.setArg(argc++, rays) != CL_SUCCESS ||
         compute_ray_hashes_kernel_.setArg(argc++, root_min) != CL_SUCCESS ||
         compute_ray_hashes_kernel_.setArg(argc++, cell_size) != CL_SUCCESS ||
-        compute_ray_hashes_kernel_.setArg(argc++, out_hashes) != CL_SUCCESS) {
+        compute_ray_hashes_kernel_.setArg(argc++, out_hashes) != CL_SUCCESS ||
+        compute_ray_hashes_kernel_.setArg(argc++, out_indices) != CL_SUCCESS) {
         return false;
     }
 
     cl::NDRange global = { (size_t)(rays_count) };
 
-    return queue_.enqueueNDRangeKernel(compute_ray_hashes_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
-}
-
-bool ray::ocl::Renderer::kernel_SetHeadFlags(const cl::Buffer &hashes, cl_int hashes_count, const cl::Buffer &out_head_flags) {
-    cl_uint argc = 0;
-    if (set_head_flags_kernel_.setArg(argc++, hashes) != CL_SUCCESS ||
-        set_head_flags_kernel_.setArg(argc++, out_head_flags) != CL_SUCCESS) {
-        return false;
-    }
-
-    cl::NDRange global = { (size_t)hashes_count };
-    cl::NDRange local = cl::NullRange;
-
-    return queue_.enqueueNDRangeKernel(set_head_flags_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
-}
-
-bool ray::ocl::Renderer::kernel_ExclusiveScan(const cl::Buffer &values, cl_int count, cl_int offset, cl_int stride,
-                                              const cl::Buffer &out_scan_values, const cl::Buffer &out_partial_sums) {
-    cl_uint argc = 0;
-    if (excl_scan_kernel_.setArg(argc++, values) != CL_SUCCESS ||
-        excl_scan_kernel_.setArg(argc++, offset) != CL_SUCCESS ||
-        excl_scan_kernel_.setArg(argc++, stride) != CL_SUCCESS ||
-        excl_scan_kernel_.setArg(argc++, out_scan_values) != CL_SUCCESS ||
-        excl_scan_kernel_.setArg(argc++, out_partial_sums) != CL_SUCCESS) {
-        return false;
-    }
-
-    cl::NDRange global = { (size_t)(count) };
-    cl::NDRange local = { scan_portion_ };
-
-    return queue_.enqueueNDRangeKernel(excl_scan_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
-}
-
-bool ray::ocl::Renderer::kernel_InclusiveScan(const cl::Buffer &values, cl_int count, const cl::Buffer &out_scan_values, const cl::Buffer &out_partial_sums) {
-    cl_uint argc = 0;
-    if (incl_scan_kernel_.setArg(argc++, values) != CL_SUCCESS ||
-        incl_scan_kernel_.setArg(argc++, out_scan_values) != CL_SUCCESS ||
-        incl_scan_kernel_.setArg(argc++, out_partial_sums) != CL_SUCCESS) {
-        return false;
-    }
-
-    cl::NDRange global = { (size_t)(count) };
-    cl::NDRange local = { scan_portion_ };
-
-    return queue_.enqueueNDRangeKernel(incl_scan_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
+    return EnqueueKernel(compute_ray_hashes_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_ExclusiveSegScan(const cl::Buffer &values, const cl::Buffer &flags, cl_int count, const cl::Buffer &out_scan_values, const cl::Buffer &out_partial_sums) {
+bool ray::ocl::Renderer::kernel_ComputeRadixHistogram(const cl::Buffer &keys, cl_int count, const cl::Buffer &out_histogram) {
     cl_uint argc = 0;
-    if (excl_seg_scan_kernel_.setArg(argc++, values) != CL_SUCCESS ||
-        excl_seg_scan_kernel_.setArg(argc++, flags) != CL_SUCCESS ||
-        excl_seg_scan_kernel_.setArg(argc++, out_scan_values) != CL_SUCCESS ||
-        excl_seg_scan_kernel_.setArg(argc++, out_partial_sums) != CL_SUCCESS) {
+    if (compute_radix_histogram_kernel_.setArg(argc++, keys) != CL_SUCCESS ||
+        compute_radix_histogram_kernel_.setArg(argc++, count) != CL_SUCCESS ||
+        compute_radix_histogram_kernel_.setArg(argc++, out_histogram) != CL_SUCCESS) {
         return false;
     }
 
-    cl::NDRange global = { (size_t)(count) };
-    cl::NDRange local = { seg_scan_portion_ };
+    const size_t tiles_count = (count + sort_portion_ - 1) / sort_portion_;
 
-    return queue_.enqueueNDRangeKernel(excl_seg_scan_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
-}
+    cl::NDRange global = { tiles_count * sort_portion_ };
+    cl::NDRange local = { sort_portion_ };
 
-bool ray::ocl::Renderer::kernel_InclusiveSegScan(const cl::Buffer &values, const cl::Buffer &flags, cl_int count, const cl::Buffer &out_scan_values,
-                                                 const cl::Buffer &out_partial_sums, const cl::Buffer &out_partial_flags) {
-    cl_uint argc = 0;
-    if (incl_seg_scan_kernel_.setArg(argc++, values) != CL_SUCCESS ||
-        incl_seg_scan_kernel_.setArg(argc++, flags) != CL_SUCCESS ||
-        incl_seg_scan_kernel_.setArg(argc++, out_scan_values) != CL_SUCCESS ||
-        incl_seg_scan_kernel_.setArg(argc++, out_partial_sums) != CL_SUCCESS ||
-        incl_seg_scan_kernel_.setArg(argc++, out_partial_flags) != CL_SUCCESS) {
-        return false;
-    }
-
-    cl::NDRange global = { (size_t)(count) };
-    cl::NDRange local = { seg_scan_portion_ };
-
-    return queue_.enqueueNDRangeKernel(incl_seg_scan_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
+    return EnqueueKernel(compute_radix_histogram_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_AddPartialSums(const cl::Buffer &values, cl_int count, const cl::Buffer &partial_sums) {
+bool ray::ocl::Renderer::kernel_ScanRadixHistogram(const cl::Buffer &histogram) {
     cl_uint argc = 0;
-    if (add_partial_sums_kernel_.setArg(argc++, values) != CL_SUCCESS ||
-        add_partial_sums_kernel_.setArg(argc++, partial_sums) != CL_SUCCESS) {
+    if (scan_radix_histogram_kernel_.setArg(argc++, histogram) != CL_SUCCESS) {
         return false;
     }
 
-    cl::NDRange global = { (size_t)(count) };
-    cl::NDRange local = { scan_portion_ };
+    cl::NDRange global = { (size_t)RadixPasses };
 
-    return queue_.enqueueNDRangeKernel(add_partial_sums_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
+    return EnqueueKernel(scan_radix_histogram_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_AddSegPartialSums(const cl::Buffer &flags, const cl::Buffer &values, const cl::Buffer &partial_sums, cl_int count, cl_int _group_size) {
+bool ray::ocl::Renderer::kernel_SortPass(const cl::Buffer &keys, const cl::Buffer &vals, cl_int count, cl_int pass, const cl::Buffer &histogram,
+                                         const cl::Buffer &tile_counters, const cl::Buffer &tile_status, const cl::Buffer &out_keys, const cl::Buffer &out_vals) {
     cl_uint argc = 0;
-    if (add_seg_partial_sums_kernel_.setArg(argc++, flags) != CL_SUCCESS ||
-        add_seg_partial_sums_kernel_.setArg(argc++, values) != CL_SUCCESS ||
-        add_seg_partial_sums_kernel_.setArg(argc++, partial_sums) != CL_SUCCESS ||
-        add_seg_partial_sums_kernel_.setArg(argc++, _group_size) != CL_SUCCESS) {
+    if (sort_pass_kernel_.setArg(argc++, keys) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, vals) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, count) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, pass) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, histogram) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, tile_counters) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, tile_status) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, out_keys) != CL_SUCCESS ||
+        sort_pass_kernel_.setArg(argc++, out_vals) != CL_SUCCESS) {
         return false;
     }
 
-    size_t group_size = std::min((size_t)32, max_work_group_size_);
+    const size_t tiles_count = (count + sort_portion_ - 1) / sort_portion_;
 
-    int remaining = count % group_size;
+    cl::NDRange global = { tiles_count * sort_portion_ };
+    cl::NDRange local = { sort_portion_ };
 
-    cl::NDRange global = { (size_t)(count - remaining) };
-    cl::NDRange local = { (size_t)(group_size) };
-
-    if (count - remaining > 0) {
-        if (queue_.enqueueNDRangeKernel(add_seg_partial_sums_kernel_, cl::NullRange, global, local) != CL_SUCCESS) {
-            return false;
-        }
-    }
-
-    if (remaining) {
-        if (queue_.enqueueNDRangeKernel(add_seg_partial_sums_kernel_, { (size_t)(count - remaining) }, { (size_t)(remaining) }) != CL_SUCCESS) {
-            return false;
-        }
-    }
-
-    return true;
+    return EnqueueKernel(sort_pass_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_InitChunkHashAndBase(const cl::Buffer &chunks, cl_int count, const cl::Buffer &hash_values, const cl::Buffer &head_flags, const cl::Buffer &scan_values) {
+bool ray::ocl::Renderer::kernel_CountTileDigits(const cl::Buffer &keys, cl_int count, cl_int pass, const cl::Buffer &out_tile_counts) {
     cl_uint argc = 0;
-    if (init_chunk_hash_and_base_kernel_.setArg(argc++, chunks) != CL_SUCCESS ||
-        init_chunk_hash_and_base_kernel_.setArg(argc++, hash_values) != CL_SUCCESS ||
-        init_chunk_hash_and_base_kernel_.setArg(argc++, head_flags) != CL_SUCCESS ||
-        init_chunk_hash_and_base_kernel_.setArg(argc++, scan_values) != CL_SUCCESS) {
+    if (count_tile_digits_kernel_.setArg(argc++, keys) != CL_SUCCESS ||
+        count_tile_digits_kernel_.setArg(argc++, count) != CL_SUCCESS ||
+        count_tile_digits_kernel_.setArg(argc++, pass) != CL_SUCCESS ||
+        count_tile_digits_kernel_.setArg(argc++, out_tile_counts) != CL_SUCCESS) {
         return false;
     }
 
-    cl::NDRange global = { (size_t)(count) };
+    const size_t tiles_count = (count + sort_portion_ - 1) / sort_portion_;
 
-    return queue_.enqueueNDRangeKernel(init_chunk_hash_and_base_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
-}
+    cl::NDRange global = { tiles_count * sort_portion_ };
+    cl::NDRange local = { sort_portion_ };
 
-bool ray::ocl::Renderer::kernel_InitChunkSize(const cl::Buffer &chunks, cl_int count, cl_int ray_count) {
-    cl_uint argc = 0;
-    if (init_chunk_size_kernel_.setArg(argc++, chunks) != CL_SUCCESS ||
-        init_chunk_size_kernel_.setArg(argc++, ray_count) != CL_SUCCESS) {
-        return false;
-    }
-
-    cl::NDRange global = { (size_t)count };
-
-    return queue_.enqueueNDRangeKernel(init_chunk_size_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
-}
-
-bool ray::ocl::Renderer::kernel_InitSkeletonAndHeadFlags(const cl::Buffer &scan_values, const cl::Buffer &chunks, cl_int count, const cl::Buffer &skeleton, const cl::Buffer &head_flags) {
-    cl_uint argc = 0;
-    if (init_skel_and_head_flags_kernel_.setArg(argc++, scan_values) != CL_SUCCESS ||
-        init_skel_and_head_flags_kernel_.setArg(argc++, chunks) != CL_SUCCESS ||
-        init_skel_and_head_flags_kernel_.setArg(argc++, skeleton) != CL_SUCCESS ||
-        init_skel_and_head_flags_kernel_.setArg(argc++, head_flags) != CL_SUCCESS) {
-        return false;
-    }
-
-    cl::NDRange global = { (size_t)(count) };
-
-    return queue_.enqueueNDRangeKernel(init_skel_and_head_flags_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
+    return EnqueueKernel(count_tile_digits_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_InitCountTable(const cl::Buffer &chunks, cl_int count, cl_int group_size, cl_int shift, const cl::Buffer &counters) {
+bool ray::ocl::Renderer::kernel_ScanTileDigits(cl_int tiles_count, cl_int pass, const cl::Buffer &histogram, const cl::Buffer &tile_counts) {
     cl_uint argc = 0;
-    if (init_count_table_kernel_.setArg(argc++, chunks) != CL_SUCCESS ||
-        init_count_table_kernel_.setArg(argc++, shift) != CL_SUCCESS ||
-        init_count_table_kernel_.setArg(argc++, counters) != CL_SUCCESS) {
+    if (scan_tile_digits_kernel_.setArg(argc++, tiles_count) != CL_SUCCESS ||
+        scan_tile_digits_kernel_.setArg(argc++, pass) != CL_SUCCESS ||
+        scan_tile_digits_kernel_.setArg(argc++, histogram) != CL_SUCCESS ||
+        scan_tile_digits_kernel_.setArg(argc++, tile_counts) != CL_SUCCESS) {
         return false;
     }
 
-    cl::NDRange global = { (size_t)count };
-    cl::NDRange local = { (size_t)group_size };
+    cl::NDRange global = { (size_t)RadixSize };
 
-    return queue_.enqueueNDRangeKernel(init_count_table_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
+    return EnqueueKernel(scan_tile_digits_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_WriteSortedChunks(const cl::Buffer &chunks_in, const cl::Buffer &offsets, const cl::Buffer &counts, cl_int count, cl_int shift, cl_int _group_size, const cl::Buffer &chunks_out) {
+bool ray::ocl::Renderer::kernel_ScatterTile(const cl::Buffer &keys, const cl::Buffer &vals, cl_int count, cl_int pass, const cl::Buffer &tile_offsets,
+                                            const cl::Buffer &out_keys, const cl::Buffer &out_vals) {
     cl_uint argc = 0;
-    if (write_sorted_chunks_kernel_.setArg(argc++, chunks_in) != CL_SUCCESS ||
-        write_sorted_chunks_kernel_.setArg(argc++, offsets) != CL_SUCCESS ||
-        write_sorted_chunks_kernel_.setArg(argc++, counts) != CL_SUCCESS ||
-        write_sorted_chunks_kernel_.setArg(argc++, shift) != CL_SUCCESS ||
-        write_sorted_chunks_kernel_.setArg(argc++, _group_size) != CL_SUCCESS ||
-        write_sorted_chunks_kernel_.setArg(argc++, count) != CL_SUCCESS ||
-        write_sorted_chunks_kernel_.setArg(argc++, chunks_out) != CL_SUCCESS) {
+    if (scatter_tile_kernel_.setArg(argc++, keys) != CL_SUCCESS ||
+        scatter_tile_kernel_.setArg(argc++, vals) != CL_SUCCESS ||
+        scatter_tile_kernel_.setArg(argc++, count) != CL_SUCCESS ||
+        scatter_tile_kernel_.setArg(argc++, pass) != CL_SUCCESS ||
+        scatter_tile_kernel_.setArg(argc++, tile_offsets) != CL_SUCCESS ||
+        scatter_tile_kernel_.setArg(argc++, out_keys) != CL_SUCCESS ||
+        scatter_tile_kernel_.setArg(argc++, out_vals) != CL_SUCCESS) {
         return false;
     }
 
-    size_t group_size = std::min((size_t)8, max_work_group_size_);
-
-    int remaining = count % group_size;
-
-    if (count - remaining > 0) {
-        if (queue_.enqueueNDRangeKernel(write_sorted_chunks_kernel_, cl::NullRange, { (size_t)(count - remaining) }, { group_size }) != CL_SUCCESS) {
-            return false;
-        }
-    }
+    const size_t tiles_count = (count + sort_portion_ - 1) / sort_portion_;
 
-    if (remaining) {
-        if (queue_.enqueueNDRangeKernel(write_sorted_chunks_kernel_, { (size_t)(count - remaining) }, { (size_t)(remaining) }) != CL_SUCCESS) {
-            return false;
-        }
-    }
+    cl::NDRange global = { tiles_count * sort_portion_ };
+    cl::NDRange local = { sort_portion_ };
 
-    return true;
+    return EnqueueKernel(scatter_tile_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
 }
 
 bool ray::ocl::Renderer::kernel_ReorderRays(const cl::Buffer &in_rays, const cl::Buffer &in_indices, cl_int count, const cl::Buffer &out_rays) {
@@ -916,10 +853,10 @@ bool ray::ocl::Renderer::kernel_ReorderRays(const cl::Buffer &in_rays, const cl:
 
     cl::NDRange global = { (size_t)count };
 
-    return queue_.enqueueNDRangeKernel(reorder_rays_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
+    return EnqueueKernel(reorder_rays_kernel_, cl::NullRange, global, cl::NullRange) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_MixIncremental(const cl::Image2D &fbuf1, const cl::Image2D &fbuf2, cl_float k, const cl::Image2D &res) {
+bool ray::ocl::Renderer::kernel_MixIncremental(const cl::Image2D &fbuf1, const cl::Image2D &fbuf2, cl_float k, const ray::rect_t &rect, const cl::Image2D &res) {
     cl_uint argc = 0;
     if (mix_incremental_kernel_.setArg(argc++, fbuf1) != CL_SUCCESS ||
         mix_incremental_kernel_.setArg(argc++, fbuf2) != CL_SUCCESS ||
@@ -928,16 +865,14 @@ bool ray::ocl::Renderer::kernel_MixIncremental(const cl::Image2D &fbuf1, const c
         return false;
     }
 
-    const auto w = fbuf1.getImageInfo<CL_IMAGE_WIDTH>(),
-               h = fbuf1.getImageInfo<CL_IMAGE_HEIGHT>();
-
-    cl::NDRange global = { (size_t)w, (size_t)h };
+    cl::NDRange offset = { (size_t)rect.x, (size_t)rect.y };
+    cl::NDRange global = { (size_t)rect.w, (size_t)rect.h };
     cl::NDRange local = cl::NullRange;
 
-    return queue_.enqueueNDRangeKernel(mix_incremental_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
+    return EnqueueKernel(mix_incremental_kernel_, offset, global, local) == CL_SUCCESS;
 }
 
-bool ray::ocl::Renderer::kernel_Postprocess(const cl::Image2D &frame_buf, cl_int w, cl_int h, const cl::Image2D &out_pixels) {
+bool ray::ocl::Renderer::kernel_Postprocess(const cl::Image2D &frame_buf, cl_int w, cl_int h, const ray::rect_t &rect, const cl::Image2D &out_pixels) {
     cl_uint argc = 0;
     if (post_process_kernel_.setArg(argc++, frame_buf) != CL_SUCCESS ||
             post_process_kernel_.setArg(argc++, w) != CL_SUCCESS ||
@@ -946,286 +881,317 @@ bool ray::ocl::Renderer::kernel_Postprocess(const cl::Image2D &frame_buf, cl_int
         return false;
     }
 
-    cl::NDRange global = { (size_t)w, (size_t)h };
+    cl::NDRange offset = { (size_t)rect.x, (size_t)rect.y };
+    cl::NDRange global = { (size_t)rect.w, (size_t)rect.h };
     cl::NDRange local = cl::NullRange;//{ (size_t)8, std::min((size_t)8, max_work_group_size_ / 8) };
 
-    return queue_.enqueueNDRangeKernel(post_process_kernel_, cl::NullRange, global, local) == CL_SUCCESS;
+    return EnqueueKernel(post_process_kernel_, offset, global, local) == CL_SUCCESS;
 }
 
-void ray::ocl::Renderer::UpdateHaltonSequence(int iteration, std::unique_ptr<float[]> &seq) {
-    if (!seq) {
-        seq.reset(new float[HaltonSeqLen * 2]);
-    }
+bool ray::ocl::Renderer::BuildProgram(uint32_t features, cl::Program &out_program, std::string *out_build_log) {
+    std::string cl_src_defines;
+    cl_src_defines += "#define TRI_W_BITS " + std::to_string(TRI_W_BITS) + "\n";
+    cl_src_defines += "#define TRI_AXIS_ALIGNED_BIT " + std::to_string(TRI_AXIS_ALIGNED_BIT) + "\n";
+    cl_src_defines += "#define HIT_BIAS " + std::to_string(HIT_BIAS) + "f\n";
+    cl_src_defines += "#define HIT_EPS " + std::to_string(HIT_EPS) + "f\n";
+    cl_src_defines += "#define FLT_EPS " + std::to_string(FLT_EPS) + "f\n";
+    cl_src_defines += "#define PI " + std::to_string(PI) + "f\n";
+    cl_src_defines += "#define HaltonSeqLen " + std::to_string(HaltonSeqLen) + "\n";
+    cl_src_defines += "#define HaltonPixelDims " + std::to_string(HaltonPixelDims) + "\n";
+    cl_src_defines += "#define HaltonDimsPerBounce " + std::to_string(HaltonDimsPerBounce) + "\n";
+    cl_src_defines += "#define HaltonMixPick " + std::to_string(HaltonMixPick) + "\n";
+    cl_src_defines += "#define HaltonLightU " + std::to_string(HaltonLightU) + "\n";
+    cl_src_defines += "#define HaltonLightV " + std::to_string(HaltonLightV) + "\n";
+    cl_src_defines += "#define HaltonBsdfU " + std::to_string(HaltonBsdfU) + "\n";
+    cl_src_defines += "#define HaltonBsdfV " + std::to_string(HaltonBsdfV) + "\n";
+    cl_src_defines += "#define MAX_MIP_LEVEL " + std::to_string(MAX_MIP_LEVEL) + "\n";
+    cl_src_defines += "#define NUM_MIP_LEVELS " + std::to_string(NUM_MIP_LEVELS) + "\n";
+    cl_src_defines += "#define MAX_TEXTURE_SIZE " + std::to_string(MAX_TEXTURE_SIZE) + "\n";
+    cl_src_defines += "#define MAX_MATERIAL_TEXTURES " + std::to_string(MAX_MATERIAL_TEXTURES) + "\n";
+    cl_src_defines += "#define DiffuseMaterial " + std::to_string(DiffuseMaterial) + "\n";
+    cl_src_defines += "#define GlossyMaterial " + std::to_string(GlossyMaterial) + "\n";
+    cl_src_defines += "#define RefractiveMaterial " + std::to_string(RefractiveMaterial) + "\n";
+    cl_src_defines += "#define EmissiveMaterial " + std::to_string(EmissiveMaterial) + "\n";
+    cl_src_defines += "#define MixMaterial " + std::to_string(MixMaterial) + "\n";
+    cl_src_defines += "#define TransparentMaterial " + std::to_string(TransparentMaterial) + "\n";
+    cl_src_defines += "#define MAIN_TEXTURE " + std::to_string(MAIN_TEXTURE) + "\n";
+    cl_src_defines += "#define NORMALS_TEXTURE " + std::to_string(NORMALS_TEXTURE) + "\n";
+    cl_src_defines += "#define MIX_MAT1 " + std::to_string(MIX_MAT1) + "\n";
+    cl_src_defines += "#define MIX_MAT2 " + std::to_string(MIX_MAT2) + "\n";
+    cl_src_defines += "#define TexFilterNearest " + std::to_string(TexFilterNearest) + "\n";
+    cl_src_defines += "#define TexFilterBilinear " + std::to_string(TexFilterBilinear) + "\n";
+    cl_src_defines += "#define TexFilterAnisotropic " + std::to_string(TexFilterAnisotropic) + "\n";
+    cl_src_defines += "#define SORT_PORTION " + std::to_string(sort_portion_) + "\n";
+    cl_src_defines += "#define RADIX_BITS " + std::to_string(RadixBits) + "\n";
+
+    // specialize program for scene features, code for missing ones is compiled out
+    if (!(features & GlossyMaterials)) cl_src_defines += "#define NO_GLOSSY_MATERIALS\n";
+    if (!(features & RefractiveMaterials)) cl_src_defines += "#define NO_REFRACTIVE_MATERIALS\n";
+    if (!(features & EmissiveMaterials)) cl_src_defines += "#define NO_EMISSIVE_MATERIALS\n";
+    if (!(features & MixMaterials)) cl_src_defines += "#define NO_MIX_MATERIALS\n";
+    if (!(features & TransparentMaterials)) cl_src_defines += "#define NO_TRANSPARENT_MATERIALS\n";
+    if (!(features & NormalMaps)) cl_src_defines += "#define NO_NORMAL_MAPS\n";
+    if (!(features & MultipleTexturePages)) cl_src_defines += "#define SINGLE_TEXTURE_PAGE\n";
+    if (!(features & EnvironmentMap)) cl_src_defines += "#define NO_ENVIRONMENT_MAP\n";
+    if (features & CountTraversalCost) cl_src_defines += "#define COUNT_TRAVERSAL_COST\n";
 
-    for (int i = 0; i < HaltonSeqLen; i++) {
-        seq[i * 2 + 0] = ray::ScrambledRadicalInverse<29>(&permutations_[100], (uint64_t)(iteration + i));
-        seq[i * 2 + 1] = ray::ScrambledRadicalInverse<31>(&permutations_[129], (uint64_t)(iteration + i));
+    cl_int error = CL_SUCCESS;
+    cl::Program::Sources srcs = {
+        cl_src_defines,
+        cl_src_types, cl_src_transform, cl_src_primary_ray_gen,
+        cl_src_intersect, cl_src_traverse, cl_src_trace, cl_src_sort,
+        cl_src_texture, cl_src_shade, cl_src_postprocess
+    };
+
+    std::string build_opts = "-Werror -cl-strict-aliasing -cl-mad-enable -cl-no-signed-zeros -cl-fast-relaxed-math ";// = "-cl-opt-disable ";
+
+    struct stat info = { 0 };
+    if (stat("./.dumps", &info) == 0 && info.st_mode & S_IFDIR) {
+        build_opts += "-save-temps=./.dumps/ ";
     }
-}
-
-bool ray::ocl::Renderer::ExclusiveScan_CPU(const cl::Buffer &values, cl_int count, cl_int offset, cl_int stride, const cl::Buffer &out_scan_values) {
-    std::vector<uint32_t> _values((stride/4) * count), _scan_values(count);
-    
-    if (queue_.enqueueReadBuffer(values, CL_TRUE, 0, stride * count, &_values[0]) != CL_SUCCESS) return false;
 
-    uint32_t cur_sum = 0;
-    for (size_t i = 0; i < (size_t)count; i++) {
-        _scan_values[i] = cur_sum;
-        cur_sum += _values[i * (stride / 4) + (offset / 4)];
-    }
-    
-    return queue_.enqueueWriteBuffer(out_scan_values, CL_TRUE, 0, sizeof(uint32_t) * count, &_scan_values[0]) == CL_SUCCESS;
-}
-
-bool ray::ocl::Renderer::ExclusiveScan_GPU(const cl::Buffer &values, cl_int count, cl_int offset, cl_int stride,
-                                           const cl::Buffer &partial_sums, const cl::Buffer &partial_sums2, const cl::Buffer &scan_values2,
-                                           const cl::Buffer &scan_values3, const cl::Buffer &scan_values4, const cl::Buffer &out_scan_values) {
-    size_t _rem = count % scan_portion_;
-    size_t num = count + (_rem == 0 ? 0 : scan_portion_ - _rem);
-
-    if (!kernel_ExclusiveScan(values, (cl_int)num, offset, stride, out_scan_values, partial_sums)) return false;
-
-    size_t new_num = num / scan_portion_;
-    size_t rem = new_num % scan_portion_;
-    size_t _new_num = new_num + (rem == 0 ? 0 : scan_portion_ - rem);
+    // cached binary is only valid for exactly the same device, driver, sources and options
+    uint64_t base_key = 0;
+    if (!program_cache_dir_.empty()) {
+        base_key = HashString(device_.getInfo<CL_DEVICE_NAME>());
+        base_key = HashString(device_.getInfo<CL_DEVICE_VERSION>(), base_key);
+        base_key = HashString(device_.getInfo<CL_DRIVER_VERSION>(), base_key);
+        base_key = HashString(platform_.getInfo<CL_PLATFORM_VERSION>(), base_key);
+        for (const auto &src : srcs) {
+            base_key = HashString(src, base_key);
+        }
 
-    if (new_num != _new_num) {
-        if (queue_.enqueueFillBuffer(partial_sums, (uint32_t)0, sizeof(uint32_t) * new_num, sizeof(uint32_t) * (_new_num - new_num)) != CL_SUCCESS) return false;
+        if (stat(program_cache_dir_.c_str(), &info) != 0) {
+            MakeDir(program_cache_dir_.c_str());
+        }
     }
 
-    if (!kernel_InclusiveScan(partial_sums, (cl_int)_new_num, scan_values2, partial_sums2)) return false;
-
-    if (_new_num > scan_portion_) {
-        size_t new_num1 = _new_num / scan_portion_;
-        size_t rem1 = new_num1 % scan_portion_;
-        size_t new_num2 = new_num1 + (rem1 == 0 ? 0 : scan_portion_ - rem1);
+    auto cache_file_name = [&](const std::string &opts) -> std::string {
+        char key_str[17];
+        snprintf(key_str, sizeof(key_str), "%016llx", (unsigned long long)HashString(opts, base_key));
+        return program_cache_dir_ + "/ray_" + key_str + ".bin";
+    };
 
-        if (new_num1 != new_num2) {
-            if (queue_.enqueueFillBuffer(partial_sums2, (uint32_t)0, sizeof(uint32_t) * new_num1, sizeof(uint32_t) * (new_num2 - new_num1)) != CL_SUCCESS) return false;
-        }
+    if (!program_cache_dir_.empty() && LoadProgramBinary(cache_file_name(build_opts), build_opts, out_program)) return true;
 
-        if (!kernel_InclusiveScan(partial_sums2, (cl_int)new_num2, scan_values3, partial_sums)) return false;
+    cl::Program program = cl::Program(context_, srcs, &error);
+    if (error != CL_SUCCESS) return false;
 
-        if (new_num2 > scan_portion_) {
-            size_t new_num3 = new_num2 / scan_portion_;
-            size_t rem3 = new_num3 % scan_portion_;
-            size_t new_num4 = new_num3 + (rem3 == 0 ? 0 : scan_portion_ - rem3);
+    error = program.build(build_opts.c_str());
+    if (error == CL_INVALID_BUILD_OPTIONS) {
+        // -cl-strict-aliasing not supported sometimes, try to build without it
+        build_opts = "-Werror -cl-mad-enable -cl-no-signed-zeros -cl-fast-relaxed-math ";
 
-            if (new_num4 != scan_portion_) {
-                return false;
-            }
+        // binary built with these options may be cached already
+        if (!program_cache_dir_.empty() && LoadProgramBinary(cache_file_name(build_opts), build_opts, out_program)) return true;
 
-            if (new_num3 != new_num4) {
-                if (queue_.enqueueFillBuffer(partial_sums, (uint32_t)0, sizeof(uint32_t) * new_num3, sizeof(uint32_t) * (new_num4 - new_num3)) != CL_SUCCESS) return false;
-            }
+        program = cl::Program(context_, srcs, &error);
+        if (error != CL_SUCCESS) return false;
+        error = program.build(build_opts.c_str());
+    }
 
-            if (!kernel_InclusiveScan(partial_sums, (cl_int)new_num4, scan_values4, partial_sums2)) return false;
-            if (!kernel_AddPartialSums(scan_values3, (cl_int)new_num2, scan_values4)) return false;
+    if (error != CL_SUCCESS) {
+        if (out_build_log) {
+            (*out_build_log) = program.getBuildInfo<CL_PROGRAM_BUILD_LOG>(device_);
         }
-
-        if (!kernel_AddPartialSums(scan_values2, (cl_int)_new_num, scan_values3)) return false;
+#if defined(_MSC_VER)
+        __debugbreak();
+#endif
+        return false;
     }
 
-    if (!kernel_AddPartialSums(out_scan_values, (cl_int)num, scan_values2)) return false;
+    if (!program_cache_dir_.empty()) {
+        // stored under options program was actually built with, failing to write cache is not critical
+        SaveProgramBinary(program, cache_file_name(build_opts));
+    }
 
+    out_program = program;
     return true;
 }
 
-bool ray::ocl::Renderer::InclusiveSegScan_CPU(const cl::Buffer &flags, const cl::Buffer &values, cl_int count, const cl::Buffer &out_scan_values) {
-    std::vector<uint32_t> _flags(count), _values(count), _scan_values(count);
-
-    if (queue_.enqueueReadBuffer(flags, CL_TRUE, 0, sizeof(uint32_t) * count, &_flags[0]) != CL_SUCCESS) return false;
-    if (queue_.enqueueReadBuffer(values, CL_TRUE, 0, sizeof(uint32_t) * count, &_values[0]) != CL_SUCCESS) return false;
+bool ray::ocl::Renderer::CreateKernels() {
+    cl_int error = CL_SUCCESS;
 
-    uint32_t cur_sum = 0;
-    for (size_t i = 0; i < (size_t)count; i++) {
-        if (_flags[i]) cur_sum = 0;
-        cur_sum += _values[i];
-        _scan_values[i] = cur_sum;
-    }
+    prim_rays_gen_kernel_ = cl::Kernel(program_, "GeneratePrimaryRays", &error);
+    if (error != CL_SUCCESS) return false;
+    texture_debug_page_kernel_ = cl::Kernel(program_, "TextureDebugPage", &error);
+    if (error != CL_SUCCESS) return false;
+    shade_primary_kernel_ = cl::Kernel(program_, "ShadePrimary", &error);
+    if (error != CL_SUCCESS) return false;
+    shade_secondary_kernel_ = cl::Kernel(program_, "ShadeSecondary", &error);
+    if (error != CL_SUCCESS) return false;
+    trace_primary_rays_kernel_ = cl::Kernel(program_, "TracePrimaryRays", &error);
+    if (error != CL_SUCCESS) return false;
+    compute_ray_hashes_kernel_ = cl::Kernel(program_, "ComputeRayHashes", &error);
+    if (error != CL_SUCCESS) return false;
+    compute_radix_histogram_kernel_ = cl::Kernel(program_, "ComputeRadixHistogram", &error);
+    if (error != CL_SUCCESS) return false;
+    scan_radix_histogram_kernel_ = cl::Kernel(program_, "ScanRadixHistogram", &error);
+    if (error != CL_SUCCESS) return false;
+    sort_pass_kernel_ = cl::Kernel(program_, "SortPass", &error);
+    if (error != CL_SUCCESS) return false;
+    count_tile_digits_kernel_ = cl::Kernel(program_, "CountTileDigits", &error);
+    if (error != CL_SUCCESS) return false;
+    scan_tile_digits_kernel_ = cl::Kernel(program_, "ScanTileDigits", &error);
+    if (error != CL_SUCCESS) return false;
+    scatter_tile_kernel_ = cl::Kernel(program_, "ScatterTile", &error);
+    if (error != CL_SUCCESS) return false;
+
+    reorder_rays_kernel_ = cl::Kernel(program_, "ReorderRays", &error);
+    if (error != CL_SUCCESS) return false;
+
+    trace_secondary_rays_kernel_ = cl::Kernel(program_, "TraceSecondaryRays", &error);
+    if (error != CL_SUCCESS) return false;
+    mix_incremental_kernel_ = cl::Kernel(program_, "MixIncremental", &error);
+    if (error != CL_SUCCESS) return false;
+    post_process_kernel_ = cl::Kernel(program_, "PostProcess", &error);
+    if (error != CL_SUCCESS) return false;
 
-    return queue_.enqueueWriteBuffer(out_scan_values, CL_TRUE, 0, sizeof(uint32_t) * count, &_scan_values[0]) == CL_SUCCESS;
+    return true;
 }
 
-bool ray::ocl::Renderer::InclusiveSegScan_GPU(const cl::Buffer &flags, const cl::Buffer &values, cl_int count, const cl::Buffer &partial_sums,
-                                              const cl::Buffer &partial_sums2, const cl::Buffer &partial_sums3, const cl::Buffer &partial_sums4,
-                                              const cl::Buffer &partial_flags, const cl::Buffer &partial_flags2, const cl::Buffer &partial_flags3,
-                                              const cl::Buffer &partial_flags4, const cl::Buffer &scan_values2, const cl::Buffer &scan_values3,
-                                              const cl::Buffer &scan_values4, const cl::Buffer &out_scan_values) {
-    size_t _rem = count % seg_scan_portion_;
-    size_t num = count + (_rem == 0 ? 0 : seg_scan_portion_ - _rem);
-
-    if (!kernel_InclusiveSegScan(values, flags, (cl_int)num, out_scan_values, partial_sums, partial_flags)) return false;
-
-    size_t new_num = num / seg_scan_portion_;
-    size_t rem = new_num % seg_scan_portion_;
-    size_t _new_num = new_num + (rem == 0 ? 0 : seg_scan_portion_ - rem);
-
-    if (new_num != _new_num) {
-        if (queue_.enqueueFillBuffer(partial_sums, (uint32_t)0, sizeof(uint32_t) * new_num, sizeof(uint32_t) * (_new_num - new_num)) != CL_SUCCESS) return false;
-        if (queue_.enqueueFillBuffer(partial_flags, (uint32_t)0, sizeof(uint32_t) * new_num, sizeof(uint32_t) * (_new_num - new_num)) != CL_SUCCESS) return false;
-    }
-
-    if (!kernel_InclusiveSegScan(partial_sums, partial_flags, (cl_int)_new_num, scan_values2, partial_sums2, partial_flags2)) return false;
-
-    if (_new_num > seg_scan_portion_) {
-        size_t new_num1 = _new_num / seg_scan_portion_;
-        size_t rem1 = new_num1 % seg_scan_portion_;
-        size_t new_num2 = new_num1 + (rem1 == 0 ? 0 : seg_scan_portion_ - rem1);
-
-        if (new_num1 != new_num2) {
-            if (queue_.enqueueFillBuffer(partial_sums2, (uint32_t)0, sizeof(uint32_t) * new_num1, sizeof(uint32_t) * (new_num2 - new_num1)) != CL_SUCCESS) return false;
-            if (queue_.enqueueFillBuffer(partial_flags2, (uint32_t)0, sizeof(uint32_t) * new_num1, sizeof(uint32_t) * (new_num2 - new_num1)) != CL_SUCCESS) return false;
+bool ray::ocl::Renderer::SwitchProgram(uint32_t features) {
+    // generic program can render anything, just slower
+    const uint32_t generic_features = AllSceneFeatures | (features & CountTraversalCost);
+
+    auto it = programs_.find(features);
+    if (it == programs_.end()) {
+        auto pending = pending_programs_.find(features);
+        if (pending == pending_programs_.end()) {
+            // compilation takes long, so it must not stall frames
+            pending = pending_programs_.emplace(features, std::async(std::launch::async, [this, features]() {
+                built_program_t ret;
+                ret.built = BuildProgram(features, ret.program, &ret.build_log);
+                return ret;
+            })).first;
         }
 
-        if (!kernel_InclusiveSegScan(partial_sums2, partial_flags2, (cl_int)new_num2, scan_values3, partial_sums3, partial_flags3)) return false;
-
-        if (new_num2 > seg_scan_portion_) {
-            size_t new_num3 = new_num2 / seg_scan_portion_;
-            size_t rem3 = new_num3 % seg_scan_portion_;
-            size_t new_num4 = new_num3 + (rem3 == 0 ? 0 : seg_scan_portion_ - rem3);
-
-            if (new_num4 != seg_scan_portion_) {
-                return false;
-            }
+        if (pending->second.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            built_program_t res = pending->second.get();
+            pending_programs_.erase(pending);
 
-            if (new_num3 != new_num4) {
-                if (queue_.enqueueFillBuffer(partial_sums, (uint32_t)0, sizeof(uint32_t) * new_num3, sizeof(uint32_t) * (new_num4 - new_num3)) != CL_SUCCESS) return false;
-                if (queue_.enqueueFillBuffer(partial_flags, (uint32_t)0, sizeof(uint32_t) * new_num3, sizeof(uint32_t) * (new_num4 - new_num3)) != CL_SUCCESS) return false;
+            if (!res.built) {
+                // failure is reported once, generic program is used for these features from now on
+                program_build_log_ = res.build_log;
+                res.program = programs_[generic_features];
             }
-
-            if (!kernel_InclusiveSegScan(partial_sums, partial_flags, (cl_int)new_num4, scan_values4, partial_sums4, partial_flags4)) return false;
-            if (!kernel_AddSegPartialSums(partial_flags, scan_values3, scan_values4, (cl_int)(new_num2/seg_scan_portion_), (cl_int)seg_scan_portion_)) return false;
+            it = programs_.emplace(features, res.program).first;
+        } else {
+            it = programs_.find(generic_features);
+            if (it == programs_.end()) return false;
         }
-
-        if (!kernel_AddSegPartialSums(partial_flags, scan_values2, scan_values3, (cl_int)(new_num/seg_scan_portion_), (cl_int)seg_scan_portion_)) return false;
     }
 
-    if (!kernel_AddSegPartialSums(flags, out_scan_values, scan_values2, (cl_int)(num/seg_scan_portion_), (cl_int)seg_scan_portion_)) return false;
+    program_features_ = it->first;
+    if (program_() == it->second()) return true;
 
-    return true;
+    program_ = it->second;
+    return CreateKernels();
 }
 
-bool ray::ocl::Renderer::ReorderRays_CPU(const cl::Buffer &scan_values, const cl::Buffer &rays, cl_int count) {
-    std::vector<uint32_t> _scan_values(count);
-    std::vector<ray_packet_t> _rays(count);
+bool ray::ocl::Renderer::LoadProgramBinary(const std::string &file_name, const std::string &build_opts, cl::Program &out_program) {
+    std::ifstream in_file(file_name, std::ios::binary | std::ios::ate);
+    if (!in_file) return false;
 
-    if (queue_.enqueueReadBuffer(scan_values, CL_TRUE, 0, sizeof(uint32_t) * count, &_scan_values[0]) != CL_SUCCESS) return false;
-    if (queue_.enqueueReadBuffer(rays, CL_TRUE, 0, sizeof(ray_packet_t) * count, &_rays[0]) != CL_SUCCESS) return false;
-
-    uint32_t j, k;
-    for (uint32_t i = 0; i < (uint32_t)count; i++) {
-        while (i != (j = _scan_values[i])) {
-            k = _scan_values[j];
-            std::swap(_rays[j], _rays[k]);
-            std::swap(_scan_values[i], _scan_values[j]);
-        }
-    }
+    const auto size = (size_t)in_file.tellg();
+    if (!size) return false;
 
-    return queue_.enqueueWriteBuffer(rays, CL_TRUE, 0, sizeof(ray_packet_t) * count, &_rays[0]) == CL_SUCCESS;
-}
+    cl::Program::Binaries binaries(1);
+    binaries[0].resize(size);
 
-bool ray::ocl::Renderer::PerformRadixSort_CPU(const cl::Buffer &chunks, cl_int count) {
-    std::vector<ray_chunk_t> _chunks(count), _chunks_temp(count);
+    in_file.seekg(0, std::ios::beg);
+    if (!in_file.read((char *)&binaries[0][0], size)) return false;
 
-    if (queue_.enqueueReadBuffer(chunks, CL_TRUE, 0, sizeof(ray_chunk_t) * count, &_chunks[0]) != CL_SUCCESS) return false;
+    cl_int error = CL_SUCCESS;
+    std::vector<int> binary_status;
+    cl::Program program(context_, { device_ }, binaries, &binary_status, &error);
+    if (error != CL_SUCCESS || binary_status[0] != CL_SUCCESS) return false;
 
-    {
-        ray_chunk_t *begin = &_chunks[0];
-        ray_chunk_t *end = &_chunks[0] + count;
-        ray_chunk_t *begin1 = &_chunks_temp[0];
-        ray_chunk_t *end1 = begin1 + (end - begin);
-
-        for (unsigned shift = 0; shift <= 24; shift += 8) {
-            size_t count[0x100] = {};
-            for (ray_chunk_t *p = begin; p != end; p++) {
-                count[(p->hash >> shift) & 0xFF]++;
-            }
-            ray_chunk_t *bucket[0x100], *q = begin1;
-            for (int i = 0; i < 0x100; q += count[i++]) {
-                bucket[i] = q;
-            }
-            for (ray_chunk_t *p = begin; p != end; p++) {
-                *bucket[(p->hash >> shift) & 0xFF]++ = *p;
-            }
-            std::swap(begin, begin1);
-            std::swap(end, end1);
-        }
-    }
+    // binary still has to be 'built', but this is fast since no compilation happens
+    if (program.build({ device_ }, build_opts.c_str()) != CL_SUCCESS) return false;
 
-    return queue_.enqueueWriteBuffer(chunks, CL_TRUE, 0, sizeof(ray_chunk_t) * count, &_chunks[0]) == CL_SUCCESS;
+    out_program = program;
+    return true;
 }
 
-bool ray::ocl::Renderer::PerformRadixSort_GPU(const cl::Buffer &chunks, const cl::Buffer &chunks2, cl_int count, const cl::Buffer &counters,
-                                              const cl::Buffer &partial_sums, const cl::Buffer &partial_sums2, const cl::Buffer &scan_values,
-                                              const cl::Buffer &scan_values2, const cl::Buffer &scan_values3, const cl::Buffer &scan_values4) {
-    size_t group_size = std::min(max_work_group_size_, (size_t)64);
+bool ray::ocl::Renderer::SaveProgramBinary(const cl::Program &program, const std::string &file_name) {
+    cl_int error = CL_SUCCESS;
+    auto devices = program.getInfo<CL_PROGRAM_DEVICES>(&error);
+    if (error != CL_SUCCESS) return false;
 
-    size_t _rem = count % group_size;
-    size_t num = count + (_rem == 0 ? 0 : group_size - _rem);
+    auto sizes = program.getInfo<CL_PROGRAM_BINARY_SIZES>(&error);
+    if (error != CL_SUCCESS || sizes.size() != devices.size()) return false;
 
-    if (_rem) {
-        if (queue_.enqueueFillBuffer(chunks, (uint32_t)0xFFFFFFFF, sizeof(ray_chunk_t) * count, sizeof(ray_chunk_t) * (group_size - _rem)) != CL_SUCCESS) return false;
-        if (queue_.enqueueFillBuffer(chunks2, (uint32_t)0xFFFFFFFF, sizeof(ray_chunk_t) * count, sizeof(ray_chunk_t) * (group_size - _rem)) != CL_SUCCESS) return false;
+    cl::Program::Binaries binaries(sizes.size());
+    for (size_t i = 0; i < sizes.size(); i++) {
+        binaries[i].resize(sizes[i]);
     }
 
-    size_t group_count = num / group_size;
+    if (program.getInfo(CL_PROGRAM_BINARIES, &binaries) != CL_SUCCESS) return false;
 
-    const auto *_chunks1 = &chunks, *_chunks2 = &chunks2;
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (devices[i]() != device_() || binaries[i].empty()) continue;
 
-    for (int shift = 0; shift <= 28; shift += 4) {
-        if (!kernel_InitCountTable(*_chunks1, (cl_int)num, (cl_int)group_size, shift, counters) ||
-            !ExclusiveScan_GPU(counters, (cl_int)group_count * 0x10, 0, 4, partial_sums, partial_sums2, scan_values2, scan_values3, scan_values4, scan_values) ||
-            !kernel_WriteSortedChunks(*_chunks1, scan_values, counters, (cl_int)group_count, shift, (cl_int)group_size, *_chunks2)) return false;
+        // write to temporary file first, so other processes never see partially written binary
+        // (temporary name is unique for process, concurrent writers do not mix their data)
+        const std::string temp_file_name = file_name + "." + std::to_string(ProcessId()) + ".tmp";
 
-        std::swap(_chunks1, _chunks2);
+        bool written;
+        {
+            std::ofstream out_file(temp_file_name, std::ios::binary);
+            written = bool(out_file.write((const char *)&binaries[i][0], binaries[i].size()));
+        }
+
+        if (!written || !RenameOver(temp_file_name.c_str(), file_name.c_str())) {
+            std::remove(temp_file_name.c_str());
+            return false;
+        }
+        return true;
     }
 
-    return true;
+    return false;
 }
 
-bool ray::ocl::Renderer::SortRays(const cl::Buffer &in_rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &ray_hashes,
-                                  const cl::Buffer &head_flags, const cl::Buffer &partial_sums, const cl::Buffer &partial_sums2, const cl::Buffer &partial_sums3, const cl::Buffer &partial_sums4,
-                                  const cl::Buffer &partial_flags, const cl::Buffer &partial_flags2, const cl::Buffer &partial_flags3, const cl::Buffer &partial_flags4,
-                                  const cl::Buffer &scan_values, const cl::Buffer &scan_values2, const cl::Buffer &scan_values3, const cl::Buffer &scan_values4,
-                                  const cl::Buffer &chunks, const cl::Buffer &chunks2, const cl::Buffer &counters, const cl::Buffer &skeleton, const cl::Buffer &out_rays) {
-    if (!kernel_ComputeRayHashes(in_rays, rays_count, root_min, cell_size, ray_hashes)) return false;
+bool ray::ocl::Renderer::PerformRadixSort(const cl::Buffer &keys, const cl::Buffer &vals, cl_int count, const cl::Buffer &keys2, const cl::Buffer &vals2,
+                                          const cl::Buffer &histogram, const cl::Buffer &tile_counters, const cl::Buffer &tile_status) {
+    static_assert(RadixPasses % 2 == 0, "Sorted values are expected to end up in input buffers!");
 
-    if (!kernel_SetHeadFlags(ray_hashes, rays_count, head_flags)) return false;
+    const size_t tiles_count = (count + sort_portion_ - 1) / sort_portion_;
 
-    if (!ExclusiveScan_GPU(head_flags, rays_count, 0, 4, partial_sums, partial_sums2, scan_values2, scan_values3, scan_values4, scan_values)) return false;
+    if (queue_.enqueueFillBuffer(histogram, (uint32_t)0, 0, sizeof(uint32_t) * RadixPasses * RadixSize) != CL_SUCCESS) return false;
+    if (queue_.enqueueFillBuffer(tile_counters, (uint32_t)0, 0, sizeof(uint32_t) * RadixPasses) != CL_SUCCESS) return false;
 
-    uint32_t chunks_count = 0;
+    // digit offsets for all passes are known upfront, so with look-back each pass is a single kernel launch
+    if (!kernel_ComputeRadixHistogram(keys, count, histogram) ||
+        !kernel_ScanRadixHistogram(histogram)) return false;
 
-    {   // get chunks count
-        uint32_t last_scan_value = 0;
-        if (queue_.enqueueReadBuffer(scan_values, CL_FALSE, sizeof(uint32_t) * (rays_count - 1), sizeof(uint32_t), &last_scan_value) != CL_SUCCESS) return false;
+    const cl::Buffer *_keys1 = &keys, *_vals1 = &vals, *_keys2 = &keys2, *_vals2 = &vals2;
 
-        uint32_t last_flag = 0;
-        if (queue_.enqueueReadBuffer(head_flags, CL_TRUE, sizeof(uint32_t) * (rays_count - 1), sizeof(uint32_t), &last_flag) != CL_SUCCESS) return false;
+    for (int pass = 0; pass < RadixPasses; pass++) {
+        if (sort_look_back_) {
+            if (queue_.enqueueFillBuffer(tile_status, (uint32_t)0, 0, sizeof(uint32_t) * RadixSize * tiles_count) != CL_SUCCESS) return false;
+            if (!kernel_SortPass(*_keys1, *_vals1, count, (cl_int)pass, histogram, tile_counters, tile_status, *_keys2, *_vals2)) return false;
+        } else {
+            // tile status holds per tile digit counts, which are scanned into output offsets
+            if (!kernel_CountTileDigits(*_keys1, count, (cl_int)pass, tile_status) ||
+                !kernel_ScanTileDigits((cl_int)tiles_count, (cl_int)pass, histogram, tile_status) ||
+                !kernel_ScatterTile(*_keys1, *_vals1, count, (cl_int)pass, tile_status, *_keys2, *_vals2)) return false;
+        }
 
-        chunks_count = last_scan_value + last_flag;
+        std::swap(_keys1, _keys2);
+        std::swap(_vals1, _vals2);
     }
 
-    if (!kernel_InitChunkHashAndBase(chunks, rays_count, ray_hashes, head_flags, scan_values)) return false;
-    if (!kernel_InitChunkSize(chunks, (cl_int)chunks_count, (cl_int)rays_count)) return false;
-
-    if (!PerformRadixSort_GPU(chunks, chunks2, (cl_int)chunks_count, counters, partial_sums, partial_sums2,
-                              scan_values, scan_values2, scan_values3, scan_values4)) return false;
-
-    if (!ExclusiveScan_GPU(chunks, (cl_int)chunks_count, offsetof(ray_chunk_t, size), sizeof(ray_chunk_t), partial_sums, partial_sums2, scan_values2, scan_values3,
-                           scan_values4, scan_values)) return false;
-
-    if (queue_.enqueueFillBuffer(skeleton, (uint32_t)1, 0, sizeof(uint32_t) * rays_count) != CL_SUCCESS) return false;
-    if (queue_.enqueueFillBuffer(head_flags, (uint32_t)0, 0, sizeof(uint32_t) * rays_count) != CL_SUCCESS) return false;
+    return true;
+}
 
-    if (!kernel_InitSkeletonAndHeadFlags(scan_values, chunks, (cl_int)chunks_count, skeleton, head_flags)) return false;
+bool ray::ocl::Renderer::SortRays(const cl::Buffer &in_rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &out_rays) {
+    if (!kernel_ComputeRayHashes(in_rays, rays_count, root_min, cell_size, ray_hashes_buf_, ray_indices_buf_)) return false;
 
-    if (!InclusiveSegScan_GPU(head_flags, skeleton, (cl_int)rays_count, partial_sums, partial_sums2, partial_sums3, partial_sums4,
-                              partial_flags, partial_flags2, partial_flags3, partial_flags4, scan_values2,
-                              scan_values3, scan_values4, scan_values)) return false;
+    if (!PerformRadixSort(ray_hashes_buf_, ray_indices_buf_, rays_count, ray_hashes2_buf_, ray_indices2_buf_,
+                          sort_histogram_buf_, sort_tile_counters_buf_, sort_tile_status_buf_)) return false;
 
-    if (!kernel_ReorderRays(in_rays, scan_values, (cl_int)rays_count, out_rays)) return false;
+    if (!kernel_ReorderRays(in_rays, ray_indices_buf_, rays_count, out_rays)) return false;
 
     return true;
 }
@@ -1246,7 +1212,7 @@ std::vector<ray::ocl::Platform> ray::ocl::Renderer::QueryPlatforms() {
         out_platforms.back().name = n;
 
         std::vector<cl::Device> devices;
-        platforms[i].getDevices(CL_DEVICE_TYPE_GPU, &devices);
+        platforms[i].getDevices(CL_DEVICE_TYPE_ALL, &devices);
 
         for (size_t j = 0; j < devices.size(); j++) {
             auto n = devices[j].getInfo<CL_DEVICE_NAME>();
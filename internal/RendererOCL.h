@@ -6,6 +6,11 @@
 //#define CL_HPP_ENABLE_EXCEPTIONS
 #include <CL/cl2.hpp>
 
+#include <future>
+#include <map>
+#include <set>
+
+#include "HaltonTable.h"
 #include "../RendererBase.h"
 
 namespace ray {
@@ -23,40 +28,70 @@ protected:
     cl_uint max_compute_units_, max_clock_;
     cl_ulong mem_size_;
     size_t max_work_group_size_;
-    size_t scan_portion_, seg_scan_portion_;
+    size_t sort_portion_;
+    // single pass sort with decoupled look-back (opt-in, see settings_t), otherwise reduce-then-scan
+    bool sort_look_back_;
 
     cl::Context context_;
     cl::Program program_;
 
+    // programs specialized for scene features, generic one is stored with AllSceneFeatures key
+    std::map<uint32_t, cl::Program> programs_;
+    uint32_t program_features_;
+    std::string program_cache_dir_;
+
+    struct built_program_t {
+        bool built;
+        cl::Program program;
+        std::string build_log;
+    };
+    // specialized programs compiled in background, frames are rendered with generic program meanwhile
+    std::map<uint32_t, std::future<built_program_t>> pending_programs_;
+    std::string program_build_log_;
+
     cl::CommandQueue queue_;
 
     cl::Kernel prim_rays_gen_kernel_, texture_debug_page_kernel_,
     shade_primary_kernel_, shade_secondary_kernel_, trace_primary_rays_kernel_,
-    compute_ray_hashes_kernel_, set_head_flags_kernel_, excl_scan_kernel_,
-    incl_scan_kernel_, add_partial_sums_kernel_, init_chunk_hash_and_base_kernel_,
-    init_chunk_size_kernel_, init_skel_and_head_flags_kernel_, init_count_table_kernel_,
-    write_sorted_chunks_kernel_, excl_seg_scan_kernel_, incl_seg_scan_kernel_, add_seg_partial_sums_kernel_,
+    compute_ray_hashes_kernel_, compute_radix_histogram_kernel_, scan_radix_histogram_kernel_, sort_pass_kernel_,
+    count_tile_digits_kernel_, scan_tile_digits_kernel_, scatter_tile_kernel_,
     reorder_rays_kernel_, trace_secondary_rays_kernel_, mix_incremental_kernel_, post_process_kernel_;
 
     cl::Buffer prim_rays_buf_, prim_inters_buf_, color_table_buf_,
-    secondary_rays_buf_, secondary_rays_count_buf_;
+    secondary_rays_buf_, secondary_rays_count_buf_, traversal_cost_buf_;
 
     int w_, h_;
 
-    std::vector<uint16_t> permutations_;
-    int loaded_halton_;
+    HaltonTable halton_table_;
+    std::shared_ptr<const float> loaded_halton_;
 
-    cl::Buffer halton_seq_buf_, ray_hashes_buf_, head_flags_buf_, scan_values_buf_, scan_values2_buf_,
-               scan_values3_buf_, scan_values4_buf_, partial_sums_buf_, partial_sums2_buf_,
-               partial_sums3_buf_, partial_sums4_buf_, chunks_buf_,
-               chunks2_buf_, skeleton_buf_, counters_buf_, partial_flags_buf_, partial_flags2_buf_, partial_flags3_buf_, partial_flags4_buf_;
+    cl::Buffer halton_seq_buf_, ray_hashes_buf_, ray_hashes2_buf_, ray_indices_buf_, ray_indices2_buf_,
+               sort_histogram_buf_, sort_tile_counters_buf_, sort_tile_status_buf_;
 
     cl::Image2D temp_buf_, clean_buf_, final_buf_;
 
     std::vector<float> frame_pixels_;
+    std::vector<traversal_cost_t> traversal_cost_;
 
     stats_t stats_ = { 0 };
 
+#if defined(ENABLE_TRACING)
+    struct traced_kernel_t {
+        cl::Event event;
+        const char *name;
+        uint64_t enqueue_ns;
+    };
+
+    // kernels enqueued during frame, their profiling info is read when frame is finished
+    std::vector<traced_kernel_t> traced_kernels_;
+    std::set<std::string> kernel_names_;
+    int trace_track_;
+
+    void FlushTracedKernels();
+#endif
+
+    cl_int EnqueueKernel(const cl::Kernel &kernel, const cl::NDRange &offset, const cl::NDRange &global, const cl::NDRange &local = cl::NullRange);
+
     bool kernel_GeneratePrimaryRays(cl_int iteration, const ray::ocl::camera_t &cam, const ray::rect_t &rect, cl_int w, cl_int h, const cl::Buffer &halton, const cl::Buffer &out_rays);
     bool kernel_TextureDebugPage(const cl::Image2DArray &textures, cl_int page, const cl::Image2D &frame_buf);
     bool kernel_ShadePrimary(cl_int iteration, const cl::Buffer &halton, const ray::rect_t &rect, cl_int w,
@@ -65,8 +100,8 @@ protected:
                              const cl::Buffer &transforms, const cl::Buffer &vtx_indices, const cl::Buffer &vertices,
                              const cl::Buffer &nodes, cl_uint node_index,
                              const cl::Buffer &tris, const cl::Buffer &tri_indices,
-                             const environment_t &env, const cl::Buffer &materials,
-                             const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, const cl::Image2D &frame_buf,
+                             const environment_t &env, const cl::Buffer &env_map, const cl::Buffer &env_cells, const cl::Buffer &materials,
+                             const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, cl_int tex_filter, const cl::Image2D &frame_buf,
                              const cl::Buffer &secondary_rays, const cl::Buffer &secondary_rays_count);
     bool kernel_ShadeSecondary(cl_int iteration, const cl::Buffer &halton,
                                const cl::Buffer &intersections, const cl::Buffer &rays,
@@ -75,61 +110,43 @@ protected:
                                const cl::Buffer &transforms, const cl::Buffer &vtx_indices, const cl::Buffer &vertices,
                                const cl::Buffer &nodes, cl_uint node_index,
                                const cl::Buffer &tris, const cl::Buffer &tri_indices,
-                               const environment_t &env, const cl::Buffer &materials,
-                               const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, const cl::Image2D &frame_buf, const cl::Image2D &frame_buf2,
+                               const environment_t &env, const cl::Buffer &env_map, const cl::Buffer &env_cells, const cl::Buffer &materials,
+                               const cl::Buffer &textures, const cl::Image2DArray &texture_atlas, cl_int tex_filter, const cl::Image2D &frame_buf, const cl::Image2D &frame_buf2,
                                const cl::Buffer &secondary_rays, const cl::Buffer &secondary_rays_count);
     bool kernel_TracePrimaryRays(const cl::Buffer &rays, const ray::rect_t &rect, cl_int w,
                                  const cl::Buffer &mesh_instances, const cl::Buffer &mi_indices, const cl::Buffer &meshes, const cl::Buffer &transforms,
-                                 const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections);
-    bool kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_int rays_count,
+                                 const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections,
+                                 const cl::Buffer &out_cost);
+    bool kernel_TraceSecondaryRays(const cl::Buffer &rays, cl_int rays_count, cl_int w,
                                    const cl::Buffer &mesh_instances, const cl::Buffer &mi_indices, const cl::Buffer &meshes, const cl::Buffer &transforms,
-                                   const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections);
-    bool kernel_ComputeRayHashes(const cl::Buffer &rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &out_hashes);
-    bool kernel_SetHeadFlags(const cl::Buffer &hashes, cl_int hashes_count, const cl::Buffer &out_head_flags);
-    bool kernel_ExclusiveScan(const cl::Buffer &values, cl_int count, cl_int offset, cl_int stride, const cl::Buffer &out_scan_values, const cl::Buffer &out_partial_sums);
-    bool kernel_InclusiveScan(const cl::Buffer &values, cl_int count, const cl::Buffer &out_scan_values, const cl::Buffer &out_partial_sums);
-    bool kernel_ExclusiveSegScan(const cl::Buffer &values, const cl::Buffer &flags, cl_int count, const cl::Buffer &out_scan_values, const cl::Buffer &out_partial_sums);
-    bool kernel_InclusiveSegScan(const cl::Buffer &values, const cl::Buffer &flags, cl_int count, const cl::Buffer &out_scan_values,
-                                 const cl::Buffer &out_partial_sums, const cl::Buffer &out_partial_flags);
-    bool kernel_AddPartialSums(const cl::Buffer &values, cl_int count, const cl::Buffer &partial_sums);
-    bool kernel_AddSegPartialSums(const cl::Buffer &flags, const cl::Buffer &values, const cl::Buffer &partial_sums, cl_int count, cl_int group_size);
-    bool kernel_InitChunkHashAndBase(const cl::Buffer &chunks, cl_int count, const cl::Buffer &hash_values, const cl::Buffer &head_flags, const cl::Buffer &scan_values);
-    bool kernel_InitChunkSize(const cl::Buffer &chunks, cl_int count, cl_int ray_count);
-    bool kernel_InitSkeletonAndHeadFlags(const cl::Buffer &scan_values, const cl::Buffer &chunks, cl_int count, const cl::Buffer &skeleton, const cl::Buffer &head_flags);
-    bool kernel_InitCountTable(const cl::Buffer &chunks, cl_int count, cl_int group_size, cl_int shift, const cl::Buffer &counters);
-    bool kernel_WriteSortedChunks(const cl::Buffer &chunks_in, const cl::Buffer &offsets, const cl::Buffer &counts, cl_int count, cl_int shift, cl_int group_size, const cl::Buffer &chunks_out);
+                                   const cl::Buffer &nodes, cl_uint node_index, const cl::Buffer &tris, const cl::Buffer &tri_indices, const cl::Buffer &intersections,
+                                   const cl::Buffer &out_cost);
+    bool kernel_ComputeRayHashes(const cl::Buffer &rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &out_hashes, const cl::Buffer &out_indices);
+    bool kernel_ComputeRadixHistogram(const cl::Buffer &keys, cl_int count, const cl::Buffer &out_histogram);
+    bool kernel_ScanRadixHistogram(const cl::Buffer &histogram);
+    bool kernel_SortPass(const cl::Buffer &keys, const cl::Buffer &vals, cl_int count, cl_int pass, const cl::Buffer &histogram,
+                         const cl::Buffer &tile_counters, const cl::Buffer &tile_status, const cl::Buffer &out_keys, const cl::Buffer &out_vals);
+    bool kernel_CountTileDigits(const cl::Buffer &keys, cl_int count, cl_int pass, const cl::Buffer &out_tile_counts);
+    bool kernel_ScanTileDigits(cl_int tiles_count, cl_int pass, const cl::Buffer &histogram, const cl::Buffer &tile_counts);
+    bool kernel_ScatterTile(const cl::Buffer &keys, const cl::Buffer &vals, cl_int count, cl_int pass, const cl::Buffer &tile_offsets,
+                            const cl::Buffer &out_keys, const cl::Buffer &out_vals);
     bool kernel_ReorderRays(const cl::Buffer &in_rays, const cl::Buffer &in_indices, cl_int count, const cl::Buffer &out_rays);
-    bool kernel_MixIncremental(const cl::Image2D &fbuf1, const cl::Image2D &fbuf2, cl_float k, const cl::Image2D &res);
-    bool kernel_Postprocess(const cl::Image2D &frame_buf, cl_int w, cl_int h, const cl::Image2D &out_pixels);
-
-    void UpdateHaltonSequence(int iteration, std::unique_ptr<float[]> &seq);
-
-    bool ExclusiveScan_CPU(const cl::Buffer &values, cl_int count, cl_int offset, cl_int stride, const cl::Buffer &out_scan_values);
-    bool ExclusiveScan_GPU(const cl::Buffer &values, cl_int count, cl_int offset, cl_int stride,
-                           const cl::Buffer &partial_sums, const cl::Buffer &partial_sums2, const cl::Buffer &scan_values2,
-                           const cl::Buffer &scan_values3, const cl::Buffer &scan_values4, const cl::Buffer &out_scan_values);
-
-    bool InclusiveSegScan_CPU(const cl::Buffer &flags, const cl::Buffer &values, cl_int count, const cl::Buffer &out_scan_values);
-    bool InclusiveSegScan_GPU(const cl::Buffer &flags, const cl::Buffer &values, cl_int count, const cl::Buffer &partial_sums, 
-                              const cl::Buffer &partial_sums2, const cl::Buffer &partial_sums3, const cl::Buffer &partial_sums4,
-                              const cl::Buffer &partial_flags, const cl::Buffer &partial_flags2, const cl::Buffer &partial_flags3, 
-                              const cl::Buffer &partial_flags4, const cl::Buffer &scan_values2, const cl::Buffer &scan_values3,
-                              const cl::Buffer &scan_values4, const cl::Buffer &out_scan_values);
-
-    bool ReorderRays_CPU(const cl::Buffer &scan_values, const cl::Buffer &rays, cl_int count);
-
-    bool PerformRadixSort_CPU(const cl::Buffer &chunks, cl_int count);
-    bool PerformRadixSort_GPU(const cl::Buffer &chunks, const cl::Buffer &chunks2, cl_int count, const cl::Buffer &counters,
-                              const cl::Buffer &partial_sums, const cl::Buffer &partial_sums2, const cl::Buffer &scan_values,
-                              const cl::Buffer &scan_values2, const cl::Buffer &scan_values3, const cl::Buffer &scan_values4);
-
-    bool SortRays(const cl::Buffer &in_rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &ray_hashes,
-                  const cl::Buffer &head_flags, const cl::Buffer &partial_sums, const cl::Buffer &partial_sums2, const cl::Buffer &partial_sums3, const cl::Buffer &partial_sums4,
-                  const cl::Buffer &partial_flags, const cl::Buffer &partial_flags2, const cl::Buffer &partial_flags3, const cl::Buffer &partial_flags4,
-                  const cl::Buffer &scan_values, const cl::Buffer &scan_values2, const cl::Buffer &scan_values3, const cl::Buffer &scan_values4,
-                  const cl::Buffer &chunks, const cl::Buffer &chunks2, const cl::Buffer &counters, const cl::Buffer &skeleton, const cl::Buffer &out_rays);
+    bool kernel_MixIncremental(const cl::Image2D &fbuf1, const cl::Image2D &fbuf2, cl_float k, const ray::rect_t &rect, const cl::Image2D &res);
+    bool kernel_Postprocess(const cl::Image2D &frame_buf, cl_int w, cl_int h, const ray::rect_t &rect, const cl::Image2D &out_pixels);
+
+    bool BuildProgram(uint32_t features, cl::Program &out_program, std::string *out_build_log = nullptr);
+    bool CreateKernels();
+    bool SwitchProgram(uint32_t features);
+
+    bool LoadProgramBinary(const std::string &file_name, const std::string &build_opts, cl::Program &out_program);
+    bool SaveProgramBinary(const cl::Program &program, const std::string &file_name);
+
+    bool PerformRadixSort(const cl::Buffer &keys, const cl::Buffer &vals, cl_int count, const cl::Buffer &keys2, const cl::Buffer &vals2,
+                          const cl::Buffer &histogram, const cl::Buffer &tile_counters, const cl::Buffer &tile_status);
+
+    bool SortRays(const cl::Buffer &in_rays, cl_int rays_count, cl_float3 root_min, cl_float3 cell_size, const cl::Buffer &out_rays);
 public:
-    Renderer(int w, int h, int platform_index = -1, int device_index = -1);
+    Renderer(int w, int h, int platform_index = -1, int device_index = -1, const char *program_cache_dir = nullptr, bool sort_look_back = false);
     ~Renderer() override = default;
 
     eRendererType type() const override { return RendererOCL; }
@@ -142,9 +159,21 @@ public:
         return (const pixel_color_t *)&frame_pixels_[0];
     }
 
+    const traversal_cost_t *get_traversal_cost_ref() const override {
+        return traversal_cost_.empty() ? nullptr : &traversal_cost_[0];
+    }
+
     void Resize(int w, int h) override;
     void Clear(const pixel_color_t &c) override;
 
+    /// Traversal cost is not collected if program which counts it fails to build (see program_build_log)
+    void EnableTraversalCost(bool enable) override;
+
+    /// Log of the last failed program build, empty if all programs were built
+    const std::string &program_build_log() const {
+        return program_build_log_;
+    }
+
     std::shared_ptr<SceneBase> CreateScene() override;
     void RenderScene(const std::shared_ptr<SceneBase> &s, RegionContext &region) override;
 
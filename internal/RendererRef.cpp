@@ -1,19 +1,15 @@
 #include "RendererRef.h"
 
 #include <chrono>
-#include <functional>
-#include <random>
 
-#include "Halton.h"
 #include "SceneRef.h"
+#include "Trace.h"
 
-ray::ref::Renderer::Renderer(int w, int h) : clean_buf_(w, h), final_buf_(w, h), temp_buf_(w, h) {
-    auto rand_func = std::bind(std::uniform_int_distribution<int>(), std::mt19937(0));
-    permutations_ = ray::ComputeRadicalInversePermutations(g_primes, PrimesCount, rand_func);
+ray::ref::Renderer::Renderer(int w, int h, eTexCompression tex_compression) : clean_buf_(w, h), final_buf_(w, h), temp_buf_(w, h), tex_compression_(tex_compression) {
 }
 
 std::shared_ptr<ray::SceneBase> ray::ref::Renderer::CreateScene() {
-    return std::make_shared<ref::Scene>();
+    return std::make_shared<ref::Scene>(tex_compression_);
 }
 
 void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, RegionContext &region) {
@@ -70,9 +66,11 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
         rect = { 0, 0, w, h };
     }
 
+    TRACE_SCOPE("RenderScene", rect);
+
     region.iteration++;
     if (!region.halton_seq || region.iteration % HaltonSeqLen == 0) {
-        UpdateHaltonSequence(region.iteration, region.halton_seq);
+        region.halton_seq = halton_table_.Get(region.iteration);
     }
 
     PassData p;
@@ -85,11 +83,24 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
         }
     }
 
+    // shading records mip levels it needs, when scene has streamed textures
+    int8_t *tex_requests = nullptr;
+    if (!s->streamed_textures_.empty()) {
+        p.tex_requests.assign(num_textures, TexNotRequested);
+        tex_requests = &p.tex_requests[0];
+    }
+
+    // debug mode, cost of rays is added to pixels they came from
+    traversal_cost_t *traversal_cost = traversal_cost_.empty() ? nullptr : &traversal_cost_[0];
+
     const auto time_start = std::chrono::high_resolution_clock::now();
+    TRACE_BEGIN("GeneratePrimaryRays");
 
-    GeneratePrimaryRays(region.iteration, cam, rect, w, h, &region.halton_seq[0], p.primary_rays);
+    GeneratePrimaryRays(region.iteration, cam, rect, w, h, region.halton_seq.get(), p.primary_rays);
 
+    TRACE_END("GeneratePrimaryRays");
     const auto time_after_ray_gen = std::chrono::high_resolution_clock::now();
+    TRACE_BEGIN("TracePrimaryRays");
 
     p.intersections.resize(p.primary_rays.size());
 
@@ -99,10 +110,17 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
 
         inter = {};
         inter.id = r.id;
-        Traverse_MacroTree_CPU(r, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+        if (traversal_cost) {
+            Traverse_MacroTree_CPU(r, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter,
+                                   traversal_cost[r.id.y * w + r.id.x]);
+        } else {
+            Traverse_MacroTree_CPU(r, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+        }
     }
 
+    TRACE_END("TracePrimaryRays");
     const auto time_after_prim_trace = std::chrono::high_resolution_clock::now();
+    TRACE_BEGIN("ShadePrimary");
 
     p.secondary_rays.resize(p.intersections.size());
     int secondary_rays_count = 0;
@@ -114,12 +132,13 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
         const int x = inter.id.x;
         const int y = inter.id.y;
         
-        pixel_color_t col = ShadeSurface((y * w + x), region.iteration, &region.halton_seq[0], inter, r, env, mesh_instances, 
+        pixel_color_t col = ShadeSurface((y * w + x), region.iteration, region.halton_seq.get() + HaltonBounceOffset(0), inter, r, env, mesh_instances, 
                                          mi_indices, meshes, transforms, vtx_indices, vertices, nodes, macro_tree_root,
-                                         tris, tri_indices, materials, textures, tex_atlas, &p.secondary_rays[0], &secondary_rays_count);
+                                         tris, tri_indices, materials, textures, tex_atlas, texture_filter(0), tex_requests, &p.secondary_rays[0], &secondary_rays_count);
         temp_buf_.SetPixel(x, y, col);
     }
 
+    TRACE_END("ShadePrimary");
     const auto time_after_prim_shade = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::micro> secondary_sort_time{}, secondary_trace_time{}, secondary_shade_time{};
 
@@ -132,6 +151,7 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
 
     for (int bounce = 0; bounce < MAX_BOUNCES && secondary_rays_count; bounce++) {
         auto time_secondary_sort_start = std::chrono::high_resolution_clock::now();
+        TRACE_BEGIN("SortRays");
 
         SortRays(&p.secondary_rays[0], (size_t)secondary_rays_count, root_min, cell_size,
                  &p.hash_values[0], &p.head_flags[0], &p.scan_values[0], &p.chunks[0], &p.chunks_temp[0], &p.skeleton[0]);
@@ -157,7 +177,9 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
         }
 #endif
 
+        TRACE_END("SortRays");
         auto time_secondary_trace_start = std::chrono::high_resolution_clock::now();
+        TRACE_BEGIN("TraceSecondaryRays");
 
         for (int i = 0; i < secondary_rays_count; i++) {
             const auto &r = p.secondary_rays[i];
@@ -165,10 +187,17 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
 
             inter = {};
             inter.id = r.id;
-            Traverse_MacroTree_CPU(r, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+            if (traversal_cost) {
+                Traverse_MacroTree_CPU(r, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter,
+                                       traversal_cost[r.id.y * w + r.id.x]);
+            } else {
+                Traverse_MacroTree_CPU(r, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+            }
         }
 
+        TRACE_END("TraceSecondaryRays");
         auto time_secondary_shade_start = std::chrono::high_resolution_clock::now();
+        TRACE_BEGIN("ShadeSecondary");
 
         int rays_count = secondary_rays_count;
         secondary_rays_count = 0;
@@ -181,19 +210,24 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
             const int x = inter.id.x;
             const int y = inter.id.y;
 
-            pixel_color_t col = ShadeSurface((y * w + x), region.iteration, &region.halton_seq[0], inter, r, env, mesh_instances,
+            pixel_color_t col = ShadeSurface((y * w + x), region.iteration, region.halton_seq.get() + HaltonBounceOffset(bounce + 1), inter, r, env, mesh_instances,
                                              mi_indices, meshes, transforms, vtx_indices, vertices, nodes, macro_tree_root,
-                                             tris, tri_indices, materials, textures, tex_atlas, &p.secondary_rays[0], &secondary_rays_count);
+                                             tris, tri_indices, materials, textures, tex_atlas, texture_filter(bounce + 1), tex_requests, &p.secondary_rays[0], &secondary_rays_count);
 
             temp_buf_.AddPixel(x, y, col);
         }
 
+        TRACE_END("ShadeSecondary");
         auto time_secondary_shade_end = std::chrono::high_resolution_clock::now();
         secondary_sort_time += std::chrono::duration<double, std::micro>{ time_secondary_trace_start - time_secondary_sort_start };
         secondary_trace_time += std::chrono::duration<double, std::micro>{ time_secondary_shade_start - time_secondary_trace_start };
         secondary_shade_time += std::chrono::duration<double, std::micro>{ time_secondary_shade_end - time_secondary_shade_start };
     }
 
+    if (tex_requests) {
+        s->RequestTextures(tex_requests);
+    }
+
     {
         std::lock_guard<std::mutex> _(pass_cache_mtx_);
         pass_cache_.emplace_back(std::move(p));
@@ -206,6 +240,7 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
         stats_.time_secondary_shade_us += (unsigned long long)secondary_shade_time.count();
     }
 
+    TRACE_BEGIN("MixIncremental");
     clean_buf_.MixIncremental(temp_buf_, rect, 1.0f / region.iteration);
 
     auto clamp_and_gamma_correct = [](const pixel_color_t &p) {
@@ -216,15 +251,5 @@ void ray::ref::Renderer::RenderScene(const std::shared_ptr<SceneBase> &_s, Regio
     };
 
     final_buf_.CopyFrom(clean_buf_, rect, clamp_and_gamma_correct);
-}
-
-void ray::ref::Renderer::UpdateHaltonSequence(int iteration, std::unique_ptr<float[]> &seq) {
-    if (!seq) {
-        seq.reset(new float[HaltonSeqLen * 2]);
-    }
-
-    for (int i = 0; i < HaltonSeqLen; i++) {
-        seq[i * 2 + 0] = ray::ScrambledRadicalInverse<29>(&permutations_[100], (uint64_t)(iteration + i));
-        seq[i * 2 + 1] = ray::ScrambledRadicalInverse<31>(&permutations_[129], (uint64_t)(iteration + i));
-    }
+    TRACE_END("MixIncremental");
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "CoreRef.h"
 #include "FramebufferRef.h"
+#include "HaltonTable.h"
 #include "../RendererBase.h"
 
 namespace ray {
@@ -21,6 +22,8 @@ struct PassData {
     std::vector<ray_chunk_t> chunks, chunks_temp;
     std::vector<uint32_t> skeleton;
 
+    std::vector<int8_t> tex_requests;
+
     PassData() = default;
 
     PassData(const PassData &rhs) = delete;
@@ -32,6 +35,7 @@ struct PassData {
         secondary_rays = std::move(rhs.secondary_rays);
         intersections = std::move(rhs.intersections);
         head_flags = std::move(rhs.head_flags);
+        tex_requests = std::move(rhs.tex_requests);
         return *this;
     }
 };
@@ -44,10 +48,14 @@ class Renderer : public RendererBase {
 
     stats_t stats_ = { 0 };
 
-    std::vector<uint16_t> permutations_;
-    void UpdateHaltonSequence(int iteration, std::unique_ptr<float[]> &seq);
+    eTexCompression tex_compression_;
+
+    HaltonTable halton_table_;
+
+    // allocated only while traversal cost is collected
+    std::vector<traversal_cost_t> traversal_cost_;
 public:
-    Renderer(int w, int h);
+    Renderer(int w, int h, eTexCompression tex_compression = TexCompressionNone);
 
     eRendererType type() const override { return RendererRef; }
 
@@ -59,14 +67,32 @@ public:
         return final_buf_.get_pixels_ref();
     }
 
+    const traversal_cost_t *get_traversal_cost_ref() const override {
+        return traversal_cost_.empty() ? nullptr : &traversal_cost_[0];
+    }
+
     void Resize(int w, int h) override {
         clean_buf_.Resize(w, h);
         final_buf_.Resize(w, h);
         temp_buf_.Resize(w, h);
+        if (traversal_cost_enabled_) {
+            traversal_cost_.assign((size_t)w * h, { 0, 0 });
+        }
     }
 
     void Clear(const pixel_color_t &c) override {
         clean_buf_.Clear(c);
+        std::fill(traversal_cost_.begin(), traversal_cost_.end(), traversal_cost_t{ 0, 0 });
+    }
+
+    void EnableTraversalCost(bool enable) override {
+        traversal_cost_enabled_ = enable;
+        if (enable) {
+            traversal_cost_.assign((size_t)final_buf_.w() * final_buf_.h(), { 0, 0 });
+        } else {
+            traversal_cost_.clear();
+            traversal_cost_.shrink_to_fit();
+        }
     }
 
     std::shared_ptr<SceneBase> CreateScene() override;
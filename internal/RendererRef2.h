@@ -12,7 +12,7 @@ const int RayPacketSize = RayPacketDimX * RayPacketDimY;
 
 class Renderer : public RendererSIMD<RayPacketDimX, RayPacketDimY> {
 public:
-    Renderer(int w, int h) : RendererSIMD(w, h) {}
+    Renderer(int w, int h, eTexCompression tex_compression = TexCompressionNone) : RendererSIMD(w, h, tex_compression) {}
 
     eRendererType type() const override { return RendererRef; }
 };
@@ -1,14 +1,32 @@
 
 #include <chrono>
-#include <functional>
 #include <mutex>
-#include <random>
 
-#include "CoreSIMD.h"
 #include "FramebufferRef.h"
-#include "Halton.h"
+#include "HaltonTable.h"
+#include "SceneRef.h"
+#include "Trace.h"
 #include "../RendererBase.h"
 
+// Shared headers above are compiled for baseline instruction set, only backend code below gets wider target.
+// Otherwise their inline functions could be emitted with AVX instructions and picked by linker for other backends
+#if defined(__clang__)
+#if defined(USE_AVX2)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(USE_AVX)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#endif
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#if defined(USE_AVX2)
+#pragma GCC target ("avx2,fma")
+#elif defined(USE_AVX)
+#pragma GCC target ("avx")
+#endif
+#endif
+
+#include "CoreSIMD.h"
+
 namespace ray {
 namespace NS {
 template <int S>
@@ -25,6 +43,8 @@ struct PassData {
     std::vector<ray_chunk_t> chunks, chunks_temp;
     std::vector<uint32_t> skeleton;
 
+    std::vector<int8_t> tex_requests;
+
     PassData() = default;
 
     PassData(const PassData &rhs) = delete;
@@ -42,10 +62,22 @@ struct PassData {
         chunks = std::move(rhs.chunks);
         chunks_temp = std::move(rhs.chunks_temp);
         skeleton = std::move(rhs.skeleton);
+        tex_requests = std::move(rhs.tex_requests);
         return *this;
     }
 };
 
+/// Adds traversal cost of active rays to pixels they came from
+template <int S>
+void AddTraversalCost(traversal_cost_t *cost, int w, const simd_ivec<S> &xy, const simd_ivec<S> &mask, const traversal_stats_t<S> &st) {
+    for (int j = 0; j < S; j++) {
+        if (!mask[j]) continue;
+        traversal_cost_t &c = cost[(xy[j] & 0x0000FFFF) * w + (xy[j] >> 16)];
+        c.nodes += uint32_t(st.nodes[j]);
+        c.tris += uint32_t(st.tris[j]);
+    }
+}
+
 template <int DimX, int DimY>
 class RendererSIMD : public RendererBase {
     ray::ref::Framebuffer clean_buf_, final_buf_, temp_buf_;
@@ -55,10 +87,14 @@ class RendererSIMD : public RendererBase {
 
     stats_t stats_ = { 0 };
 
-    std::vector<uint16_t> permutations_;
-    void UpdateHaltonSequence(int iteration, std::unique_ptr<float[]> &seq);
+    eTexCompression tex_compression_;
+
+    HaltonTable halton_table_;
+
+    // allocated only while traversal cost is collected
+    std::vector<traversal_cost_t> traversal_cost_;
 public:
-    RendererSIMD(int w, int h);
+    RendererSIMD(int w, int h, eTexCompression tex_compression);
 
     std::pair<int, int> size() const override {
         return std::make_pair(final_buf_.w(), final_buf_.h());
@@ -68,13 +104,31 @@ public:
         return final_buf_.get_pixels_ref();
     }
 
+    const traversal_cost_t *get_traversal_cost_ref() const override {
+        return traversal_cost_.empty() ? nullptr : &traversal_cost_[0];
+    }
+
     void Resize(int w, int h) override {
         clean_buf_.Resize(w, h);
         final_buf_.Resize(w, h);
         temp_buf_.Resize(w, h);
+        if (traversal_cost_enabled_) {
+            traversal_cost_.assign((size_t)w * h, { 0, 0 });
+        }
     }
     void Clear(const pixel_color_t &c) override {
         clean_buf_.Clear(c);
+        std::fill(traversal_cost_.begin(), traversal_cost_.end(), traversal_cost_t{ 0, 0 });
+    }
+
+    void EnableTraversalCost(bool enable) override {
+        traversal_cost_enabled_ = enable;
+        if (enable) {
+            traversal_cost_.assign((size_t)final_buf_.w() * final_buf_.h(), { 0, 0 });
+        } else {
+            traversal_cost_.clear();
+            traversal_cost_.shrink_to_fit();
+        }
     }
 
     std::shared_ptr<SceneBase> CreateScene() override;
@@ -88,17 +142,13 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////////////////
 
-#include "SceneRef.h"
-
 template <int DimX, int DimY>
-ray::NS::RendererSIMD<DimX, DimY>::RendererSIMD(int w, int h) : clean_buf_(w, h), final_buf_(w, h), temp_buf_(w, h) {
-    auto rand_func = std::bind(std::uniform_int_distribution<int>(), std::mt19937(0));
-    permutations_ = ray::ComputeRadicalInversePermutations(g_primes, PrimesCount, rand_func);
+ray::NS::RendererSIMD<DimX, DimY>::RendererSIMD(int w, int h, eTexCompression tex_compression) : clean_buf_(w, h), final_buf_(w, h), temp_buf_(w, h), tex_compression_(tex_compression) {
 }
 
 template <int DimX, int DimY>
 std::shared_ptr<ray::SceneBase> ray::NS::RendererSIMD<DimX, DimY>::CreateScene() {
-    return std::make_shared<ref::Scene>();
+    return std::make_shared<ref::Scene>(tex_compression_);
 }
 
 template <int DimX, int DimY>
@@ -156,6 +206,7 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
     memcpy(&env.sun_col[0], &s->env_.sun_col[0], 3 * sizeof(float));
     memcpy(&env.sky_col[0], &s->env_.sky_col[0], 3 * sizeof(float));
     env.sun_softness = s->env_.sun_softness;
+    env.env_map = s->env_.env_map;
 
     const auto w = final_buf_.w(), h = final_buf_.h();
 
@@ -164,9 +215,11 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
         rect = { 0, 0, w, h };
     }
 
+    TRACE_SCOPE("RenderScene", rect);
+
     region.iteration++;
     if (!region.halton_seq || region.iteration % HaltonSeqLen == 0) {
-        UpdateHaltonSequence(region.iteration, region.halton_seq);
+        region.halton_seq = halton_table_.Get(region.iteration);
     }
 
     PassData<S> p;
@@ -179,11 +232,24 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
         }
     }
 
+    // shading records mip levels it needs, when scene has streamed textures
+    int8_t *tex_requests = nullptr;
+    if (!s->streamed_textures_.empty()) {
+        p.tex_requests.assign(num_textures, TexNotRequested);
+        tex_requests = &p.tex_requests[0];
+    }
+
+    // debug mode, cost of rays is added to pixels they came from
+    traversal_cost_t *traversal_cost = traversal_cost_.empty() ? nullptr : &traversal_cost_[0];
+
     const auto time_start = std::chrono::high_resolution_clock::now();
+    TRACE_BEGIN("GeneratePrimaryRays");
 
-    GeneratePrimaryRays<DimX, DimY>(region.iteration, cam, rect, w, h, &region.halton_seq[0], p.primary_rays);
+    GeneratePrimaryRays<DimX, DimY>(region.iteration, cam, rect, w, h, region.halton_seq.get(), p.primary_rays);
 
+    TRACE_END("GeneratePrimaryRays");
     const auto time_after_ray_gen = std::chrono::high_resolution_clock::now();
+    TRACE_BEGIN("TracePrimaryRays");
 
     p.primary_masks.resize(p.primary_rays.size());
     p.intersections.resize(p.primary_rays.size());
@@ -194,10 +260,18 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
 
         inter = {};
         inter.xy = r.xy;
-        NS::Traverse_MacroTree_CPU(r, { -1 }, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+        if (traversal_cost) {
+            traversal_stats_t<S> st;
+            NS::Traverse_MacroTree_CPU(r, { -1 }, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter, st);
+            AddTraversalCost(traversal_cost, w, r.xy, { -1 }, st);
+        } else {
+            NS::Traverse_MacroTree_CPU(r, { -1 }, nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+        }
     }
 
+    TRACE_END("TracePrimaryRays");
     const auto time_after_prim_trace = std::chrono::high_resolution_clock::now();
+    TRACE_BEGIN("ShadePrimary");
 
     p.secondary_rays.resize(p.intersections.size());
     p.secondary_masks.resize(p.intersections.size());
@@ -215,15 +289,16 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
         p.secondary_masks[i] = { 0 };
 
         simd_fvec<S> out_rgba[4] = { 0.0f };
-        NS::ShadeSurface(index, region.iteration, &region.halton_seq[0], inter, r, env, mesh_instances,
+        NS::ShadeSurface(index, region.iteration, region.halton_seq.get() + HaltonBounceOffset(0), inter, r, env, mesh_instances,
                          mi_indices, meshes, transforms, vtx_indices, vertices, nodes, macro_tree_root,
-                         tris, tri_indices, materials, textures, tex_atlas, out_rgba, &p.secondary_masks[0], &p.secondary_rays[0], &secondary_rays_count);
+                         tris, tri_indices, materials, textures, tex_atlas, texture_filter(0), tex_requests, out_rgba, &p.secondary_masks[0], &p.secondary_rays[0], &secondary_rays_count);
 
         for (int j = 0; j < S; j++) {
             temp_buf_.SetPixel(x[j], y[j], { out_rgba[0][j], out_rgba[1][j], out_rgba[2][j], out_rgba[3][j] });
         }
     }
 
+    TRACE_END("ShadePrimary");
     const auto time_after_prim_shade = std::chrono::high_resolution_clock::now();
     std::chrono::duration<double, std::micro> secondary_sort_time{}, secondary_trace_time{}, secondary_shade_time{};
 
@@ -236,6 +311,7 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
 
     for (int bounce = 0; bounce < MAX_BOUNCES && secondary_rays_count; bounce++) {
         auto time_secondary_sort_start = std::chrono::high_resolution_clock::now();
+        TRACE_BEGIN("SortRays");
 
         SortRays(&p.secondary_rays[0], &p.secondary_masks[0], secondary_rays_count, root_min, cell_size,
                           &p.hash_values[0], &p.head_flags[0], &p.scan_values[0], &p.chunks[0], &p.chunks_temp[0], &p.skeleton[0]);
@@ -276,7 +352,9 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
         }
 #endif
 
+        TRACE_END("SortRays");
         auto time_secondary_trace_start = std::chrono::high_resolution_clock::now();
+        TRACE_BEGIN("TraceSecondaryRays");
 
         for (int i = 0; i < secondary_rays_count; i++) {
             const auto &r = p.secondary_rays[i];
@@ -285,10 +363,18 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
             inter = {};
             inter.xy = r.xy;
 
-            NS::Traverse_MacroTree_CPU(r, p.secondary_masks[i], nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+            if (traversal_cost) {
+                traversal_stats_t<S> st;
+                NS::Traverse_MacroTree_CPU(r, p.secondary_masks[i], nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter, st);
+                AddTraversalCost(traversal_cost, w, r.xy, p.secondary_masks[i], st);
+            } else {
+                NS::Traverse_MacroTree_CPU(r, p.secondary_masks[i], nodes, macro_tree_root, mesh_instances, mi_indices, meshes, transforms, tris, tri_indices, inter);
+            }
         }
 
+        TRACE_END("TraceSecondaryRays");
         auto time_secondary_shade_start = std::chrono::high_resolution_clock::now();
+        TRACE_BEGIN("ShadeSecondary");
 
         int rays_count = secondary_rays_count;
         secondary_rays_count = 0;
@@ -305,9 +391,9 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
             simd_ivec<S> index = { y * w + x };
 
             simd_fvec<S> out_rgba[4] = { 0.0f };
-            NS::ShadeSurface(index, region.iteration, &region.halton_seq[0], inter, r, env, mesh_instances,
+            NS::ShadeSurface(index, region.iteration, region.halton_seq.get() + HaltonBounceOffset(bounce + 1), inter, r, env, mesh_instances,
                              mi_indices, meshes, transforms, vtx_indices, vertices, nodes, macro_tree_root,
-                             tris, tri_indices, materials, textures, tex_atlas, out_rgba, &p.secondary_masks[0], &p.secondary_rays[0], &secondary_rays_count);
+                             tris, tri_indices, materials, textures, tex_atlas, texture_filter(bounce + 1), tex_requests, out_rgba, &p.secondary_masks[0], &p.secondary_rays[0], &secondary_rays_count);
 
             for (int j = 0; j < S; j++) {
                 if (!p.primary_masks[i][j]) continue;
@@ -316,12 +402,17 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
             }
         }
 
+        TRACE_END("ShadeSecondary");
         auto time_secondary_shade_end = std::chrono::high_resolution_clock::now();
         secondary_sort_time += std::chrono::duration<double, std::micro>{ time_secondary_trace_start - time_secondary_sort_start };
         secondary_trace_time += std::chrono::duration<double, std::micro>{ time_secondary_shade_start - time_secondary_trace_start };
         secondary_shade_time += std::chrono::duration<double, std::micro>{ time_secondary_shade_end - time_secondary_shade_start };
     }
 
+    if (tex_requests) {
+        s->RequestTextures(tex_requests);
+    }
+
     {
         std::lock_guard<std::mutex> _(pass_cache_mtx_);
         pass_cache_.emplace_back(std::move(p));
@@ -334,6 +425,7 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
         stats_.time_secondary_shade_us += (unsigned long long)secondary_shade_time.count();
     }
 
+    TRACE_BEGIN("MixIncremental");
     clean_buf_.MixIncremental(temp_buf_, rect, 1.0f / region.iteration);
 
     auto clamp_and_gamma_correct = [](const pixel_color_t &p) {
@@ -344,16 +436,13 @@ void ray::NS::RendererSIMD<DimX, DimY>::RenderScene(const std::shared_ptr<SceneB
     };
 
     final_buf_.CopyFrom(clean_buf_, rect, clamp_and_gamma_correct);
+    TRACE_END("MixIncremental");
 }
 
-template <int DimX, int DimY>
-void ray::NS::RendererSIMD<DimX, DimY>::UpdateHaltonSequence(int iteration, std::unique_ptr<float[]> &seq) {
-    if (!seq) {
-        seq.reset(new float[HaltonSeqLen * 2]);
-    }
-
-    for (int i = 0; i < HaltonSeqLen; i++) {
-        seq[i * 2 + 0] = ray::ScrambledRadicalInverse<29>(&permutations_[100], (uint64_t)(iteration + i));
-        seq[i * 2 + 1] = ray::ScrambledRadicalInverse<31>(&permutations_[129], (uint64_t)(iteration + i));
-    }
-}
+#if defined(__clang__)
+#if defined(USE_AVX2) || defined(USE_AVX)
+#pragma clang attribute pop
+#endif
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
@@ -1,9 +1,11 @@
 #include "SceneOCL.h"
 
+#include <algorithm>
 #include <cassert>
 
 #include "BVHSplit.h"
 #include "TextureUtilsRef.h"
+#include "Trace.h"
 
 ray::ocl::Scene::Scene(const cl::Context &context, const cl::CommandQueue &queue)
     : context_(context), queue_(queue),
@@ -18,12 +20,14 @@ ray::ocl::Scene::Scene(const cl::Context &context, const cl::CommandQueue &queue
       vtx_indices_(context, queue, CL_MEM_READ_ONLY),
       materials_(context, queue, CL_MEM_READ_ONLY),
       textures_(context, queue, CL_MEM_READ_ONLY),
-    texture_atlas_(context_, queue_, MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE) {
+    texture_atlas_(context_, queue_, MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE),
+    env_map_(context, queue, CL_MEM_READ_ONLY),
+    env_cells_(context, queue, CL_MEM_READ_ONLY) {
     SetEnvironment( { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } });
 
     pixel_color8_t default_normalmap = { 127, 127, 255 };
 
-    tex_desc_t t;
+    tex_desc_t t = {};
     t.data = &default_normalmap;
     t.w = 1;
     t.h = 1;
@@ -41,68 +45,149 @@ void ray::ocl::Scene::GetEnvironment(environment_desc_t &env) {
     memcpy(&env.sun_col[0], &env_.sun_col, 3 * sizeof(float));
     memcpy(&env.sky_col[0], &env_.sky_col, 3 * sizeof(float));
     env.sun_softness = env_.sun_softness;
+    env.env_map = env_map_data_.empty() ? nullptr : &env_map_data_[0];
+    env.env_map_w = env_.env_map_res[0];
+    env.env_map_h = env_.env_map_res[1];
 }
 
 void ray::ocl::Scene::SetEnvironment(const environment_desc_t &env) {
+    TRACE_SCOPE("SetEnvironment");
     memcpy(&env_.sun_dir, &env.sun_dir[0], 3 * sizeof(float));
     memcpy(&env_.sun_col, &env.sun_col[0], 3 * sizeof(float));
     memcpy(&env_.sky_col, &env.sky_col[0], 3 * sizeof(float));
     env_.sun_softness = env.sun_softness;
+
+    if (env.env_map && !env_map_data_.empty() && env.env_map == &env_map_data_[0] &&
+        env.env_map_w == env_.env_map_res[0] && env.env_map_h == env_.env_map_res[1]) {
+        // map is not changed
+        return;
+    }
+
+    env_map_data_.clear();
+    env_map_.Clear();
+    env_cells_.Clear();
+    env_.env_map_res[0] = env_.env_map_res[1] = 0;
+    env_.env_cells_res[0] = env_.env_cells_res[1] = 0;
+
+    // resolution is stored as 16-bit values
+    if (!env.env_map || env.env_map_w <= 0 || env.env_map_h <= 0 || env.env_map_w > 0xffff || env.env_map_h > 0xffff) return;
+
+    env_map_data_.assign(env.env_map, env.env_map + size_t(env.env_map_w) * env.env_map_h);
+
+    const int res[2] = { env.env_map_w, env.env_map_h };
+    std::vector<env_cell_t> cells;
+    int cells_res[2];
+    BuildEnvMapCells(&env_map_data_[0], res, cells, cells_res);
+
+    env_map_.Append(reinterpret_cast<const uint32_t *>(&env_map_data_[0]), env_map_data_.size());
+    env_cells_.Append(&cells[0], cells.size());
+
+    env_.env_map_res[0] = (cl_ushort)res[0];
+    env_.env_map_res[1] = (cl_ushort)res[1];
+    env_.env_cells_res[0] = (cl_ushort)cells_res[0];
+    env_.env_cells_res[1] = (cl_ushort)cells_res[1];
 }
 
 uint32_t ray::ocl::Scene::AddTexture(const tex_desc_t &_t) {
+    TRACE_SCOPE("AddTexture");
+    if (!_t.load_func) {
+        // data is uploaded as is, without making a copy first
+        texture_t t;
+        const int res[2] = { _t.w, _t.h };
+        if (!ref::AllocateTextureMips(texture_atlas_, _t.data, res, _t.generate_mipmaps, t)) return 0xffffffff;
+        return StoreTexture(t);
+    }
+
+    // streamed textures are loaded upfront, mip levels are generated from the first one
+    ref::mip_chain_t chain;
+    ref::GenerateMipChain(_t, chain);
+    return AddTexture(chain);
+}
+
+void ray::ocl::Scene::AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) {
+    TRACE_SCOPE("AddTextures");
+    std::vector<ref::mip_chain_t> chains(count);
+    ref::GenerateMipChains(textures, count, count ? &chains[0] : nullptr);
+
+    for (size_t i = 0; i < count; i++) {
+        out_indices[i] = AddTexture(chains[i]);
+    }
+}
+
+uint32_t ray::ocl::Scene::AddTexture(const ref::mip_chain_t &chain) {
+    texture_t t;
+    if (!ref::AllocateTextureMips(texture_atlas_, chain, t)) return 0xffffffff;
+    return StoreTexture(t);
+}
+
+uint32_t ray::ocl::Scene::StoreTexture(const texture_t &t) {
     uint32_t tex_index = (uint32_t)textures_.size();
+    if (!free_textures_.empty()) {
+        tex_index = free_textures_.back();
+        free_textures_.pop_back();
+        textures_.Set(tex_index, t);
+    } else {
+        textures_.PushBack(t);
+    }
+
+    return tex_index;
+}
+
+void ray::ocl::Scene::RemoveTexture(uint32_t i) {
+    TRACE_SCOPE("RemoveTexture");
+    if (i >= textures_.size() || i == default_normals_texture_) return;
 
     texture_t t;
-    t.size[0] = (uint16_t)_t.w;
-    t.size[1] = (uint16_t)_t.h;
-
-    int mip = 0;
-    int res[2] = { _t.w, _t.h };
-
-    std::vector<pixel_color8_t> tex_data(_t.data, _t.data + _t.w * _t.h);
-
-    while (res[0] >= 1 && res[1] >= 1) {
-        int pos[2];
-        int page = texture_atlas_.Allocate(&tex_data[0], res, pos);
-        if (page == -1) {
-            // release allocated mip levels on fail
-            for (int i = mip; i >= 0; i--) {
-                int _pos[2] = { t.pos[i][0], t.pos[i][1] };
-                texture_atlas_.Free(t.page[i], _pos);
-            }
-            return 0xffffffff;
-        }
+    textures_.Get(i, t);
+    if (!t.size[0]) return;
 
-        t.page[mip] = (uint32_t)page;
-        t.pos[mip][0] = (uint16_t)pos[0];
-        t.pos[mip][1] = (uint16_t)pos[1];
+    ref::FreeTextureMips(texture_atlas_, t, 0, NUM_MIP_LEVELS);
 
-        mip++;
+    t.size[0] = t.size[1] = 0;
+    textures_.Set(i, t);
 
-        if (_t.generate_mipmaps) {
-            tex_data = ref::DownsampleTexture(tex_data, res);
+    free_textures_.push_back(i);
+}
 
-            res[0] /= 2;
-            res[1] /= 2;
-        } else {
+bool ray::ocl::Scene::CompactTextures(size_t max_texels) {
+    TRACE_SCOPE("CompactTextures");
+    std::vector<texture_t> textures(textures_.size());
+    if (!textures.empty()) {
+        textures_.Get(&textures[0], 0, textures.size());
+    }
+
+    bool done = true;
+
+    // pages are emptied starting from the last one, moves go only to lower pages, so atlas
+    // is resized once at the end (each resize reallocates and copies the whole image array)
+    for (int page = texture_atlas_.used_pages_count() - 1; page > 0; page--) {
+        bool fits = true;
+        for (size_t i = 0; i < textures.size() && fits && max_texels; i++) {
+            if (!textures[i].size[0]) continue;
+            fits = ref::MoveTextureMips(texture_atlas_, textures[i], 0, NUM_MIP_LEVELS, page, max_texels);
+        }
+
+        if (!fits) break;
+        if (!max_texels) {
+            done = false;
             break;
         }
     }
 
-    // fill remaining mip levels with the last one
-    for (int i = mip; i < NUM_MIP_LEVELS; i++) {
-        t.page[i] = t.page[mip - 1];
-        t.pos[i][0] = t.pos[mip - 1][0];
-        t.pos[i][1] = t.pos[mip - 1][1];
+    if (!textures.empty()) {
+        textures_.Set(&textures[0], 0, textures.size());
     }
 
-    textures_.PushBack(t);
-
-    return tex_index;
+    // drops pages emptied so far, also when compaction is interrupted
+    const int pages_count = std::max(texture_atlas_.used_pages_count(), 1);
+    if (pages_count != texture_atlas_.pages_count()) {
+        texture_atlas_.Resize(pages_count);
+    }
+    return done;
 }
 
 uint32_t ray::ocl::Scene::AddMaterial(const mat_desc_t &m) {
+    TRACE_SCOPE("AddMaterial");
     material_t mat;
 
     mat.type = m.type;
@@ -127,12 +212,22 @@ uint32_t ray::ocl::Scene::AddMaterial(const mat_desc_t &m) {
 
     }
 
+    material_type_counts_[m.type]++;
+
     if (m.normal_map != 0xffffffff) {
         mat.textures[NORMALS_TEXTURE] = m.normal_map;
+        normal_maps_count_++;
     } else {
         mat.textures[NORMALS_TEXTURE] = default_normals_texture_;
     }
 
+    if (!free_materials_.empty()) {
+        const uint32_t mat_index = free_materials_.back();
+        free_materials_.pop_back();
+        materials_.Set(mat_index, mat);
+        return mat_index;
+    }
+
     uint32_t mat_index = (uint32_t)materials_.size();
 
     materials_.PushBack(mat);
@@ -140,7 +235,39 @@ uint32_t ray::ocl::Scene::AddMaterial(const mat_desc_t &m) {
     return mat_index;
 }
 
+void ray::ocl::Scene::RemoveMaterial(uint32_t i) {
+    TRACE_SCOPE("RemoveMaterial");
+    if (i >= materials_.size() || std::find(free_materials_.begin(), free_materials_.end(), i) != free_materials_.end()) return;
+
+    material_t mat;
+    materials_.Get(i, mat);
+
+    // keep scene features up to date, so that program can be specialized again
+    material_type_counts_[mat.type]--;
+    if (mat.textures[NORMALS_TEXTURE] != default_normals_texture_) {
+        normal_maps_count_--;
+    }
+
+    free_materials_.push_back(i);
+}
+
+uint32_t ray::ocl::Scene::features() const {
+    uint32_t features = 0;
+
+    if (material_type_counts_[GlossyMaterial]) features |= GlossyMaterials;
+    if (material_type_counts_[RefractiveMaterial]) features |= RefractiveMaterials;
+    if (material_type_counts_[EmissiveMaterial]) features |= EmissiveMaterials;
+    if (material_type_counts_[MixMaterial]) features |= MixMaterials;
+    if (material_type_counts_[TransparentMaterial]) features |= TransparentMaterials;
+    if (normal_maps_count_) features |= NormalMaps;
+    if (texture_atlas_.used_pages_count() > 1) features |= MultipleTexturePages;
+    if (env_.env_map_res[0]) features |= EnvironmentMap;
+
+    return features;
+}
+
 uint32_t ray::ocl::Scene::AddMesh(const mesh_desc_t &_m) {
+    TRACE_SCOPE("AddMesh");
     std::vector<bvh_node_t> new_nodes;
     std::vector<tri_accel_t> new_tris;
     std::vector<uint32_t> new_tri_indices;
@@ -216,10 +343,12 @@ uint32_t ray::ocl::Scene::AddMesh(const mesh_desc_t &_m) {
 }
 
 void ray::ocl::Scene::RemoveMesh(uint32_t) {
+    TRACE_SCOPE("RemoveMesh");
     // TODO!!!
 }
 
 uint32_t ray::ocl::Scene::AddMeshInstance(uint32_t mesh_index, const float *xform) {
+    TRACE_SCOPE("AddMeshInstance");
     uint32_t mi_index = (uint32_t)mesh_instances_.size();
 
     mesh_instance_t mi;
@@ -240,6 +369,7 @@ uint32_t ray::ocl::Scene::AddMeshInstance(uint32_t mesh_index, const float *xfor
 }
 
 void ray::ocl::Scene::SetMeshInstanceTransform(uint32_t mi_index, const float *xform) {
+    TRACE_SCOPE("SetMeshInstanceTransform");
     transform_t tr;
 
     memcpy(tr.xform, xform, 16 * sizeof(float));
@@ -267,6 +397,7 @@ void ray::ocl::Scene::SetMeshInstanceTransform(uint32_t mi_index, const float *x
 }
 
 void ray::ocl::Scene::RemoveMeshInstance(uint32_t) {
+    TRACE_SCOPE("RemoveMeshInstance");
     // TODO!!
 }
 
@@ -310,6 +441,7 @@ void ray::ocl::Scene::RemoveNodes(uint32_t node_index, uint32_t node_count) {
 }
 
 void ray::ocl::Scene::RebuildMacroBVH() {
+    TRACE_SCOPE("RebuildMacroBVH");
     RemoveNodes(macro_nodes_start_, macro_nodes_count_);
     mi_indices_.Clear();
 
@@ -1,16 +1,19 @@
 #pragma once
 
 #include "TextureAtlasOCL.h"
+#include "TextureUtilsRef.h"
 #include "VectorOCL.h"
 #include "../SceneBase.h"
 
 namespace ray {
 namespace ocl {
 class Renderer;
+class MultiScene;
 
 class Scene : public SceneBase {
 protected:
     friend class ocl::Renderer;
+    friend class ocl::MultiScene;
 
     const cl::Context &context_;
     const cl::CommandQueue &queue_;
@@ -29,12 +32,26 @@ protected:
     ocl::Vector<texture_t> textures_;
     ocl::TextureAtlas texture_atlas_;
 
+    // slots of removed materials and textures (marked with zero size), reused by next additions
+    std::vector<uint32_t> free_materials_, free_textures_;
+
     ocl::environment_t env_;
+    // HDR environment map is kept out of atlas, host copy is returned with environment description
+    std::vector<pixel_color8_t> env_map_data_;
+    ocl::Vector<uint32_t> env_map_;
+    ocl::Vector<env_cell_t> env_cells_;
 
     uint32_t macro_nodes_start_ = 0, macro_nodes_count_ = 0;
 
     uint32_t default_normals_texture_;
 
+    // used to determine scene features
+    uint32_t material_type_counts_[TransparentMaterial + 1] = {};
+    uint32_t normal_maps_count_ = 0;
+
+    uint32_t AddTexture(const ref::mip_chain_t &chain);
+    uint32_t StoreTexture(const texture_t &t);
+
     void RemoveNodes(uint32_t node_index, uint32_t node_count);
     void RebuildMacroBVH();
 public:
@@ -44,10 +61,16 @@ public:
     void SetEnvironment(const environment_desc_t &env) override;
 
     uint32_t AddTexture(const tex_desc_t &t) override;
-    void RemoveTexture(uint32_t) override {}
+    void AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) override;
+    void RemoveTexture(uint32_t i) override;
+    bool CompactTextures(size_t max_texels) override;
+
+    /// Textures are fully resident on device, streaming is not supported
+    void SetTextureCacheSize(size_t) override {}
+    void UpdateTextureResidency() override {}
 
     uint32_t AddMaterial(const mat_desc_t &m) override;
-    void RemoveMaterial(uint32_t) override {}
+    void RemoveMaterial(uint32_t i) override;
 
     uint32_t AddMesh(const mesh_desc_t &m) override;
     void RemoveMesh(uint32_t) override;
@@ -56,6 +79,9 @@ public:
     void SetMeshInstanceTransform(uint32_t mi_index, const float *xform) override;
     void RemoveMeshInstance(uint32_t) override;
 
+    /// Combination of eSceneFeatures flags
+    uint32_t features() const;
+
     uint32_t triangle_count() override {
         return (uint32_t)tris_.size();
     }
@@ -1,14 +1,29 @@
 #include "SceneRef.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
 #include "TextureUtilsRef.h"
+#include "Trace.h"
 
-ray::ref::Scene::Scene() : texture_atlas_(MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE) {
+namespace ray {
+namespace ref {
+// mip levels of streamed texture, that are not larger than this, are always resident
+const int StreamedTailRes = 64;
+const size_t DefaultTexCacheSize = 256 * 1024 * 1024;
+
+bool IsStreamed(const tex_desc_t &t) {
+    return t.load_func && t.generate_mipmaps && std::max(t.w, t.h) > StreamedTailRes;
+}
+}
+}
+
+ray::ref::Scene::Scene(eTexCompression tex_compression)
+    : texture_atlas_(MAX_TEXTURE_SIZE, MAX_TEXTURE_SIZE, 4, tex_compression), tex_cache_size_(DefaultTexCacheSize) {
     pixel_color8_t default_normalmap = { 127, 127, 255 };
 
-    tex_desc_t t;
+    tex_desc_t t = {};
     t.data = &default_normalmap;
     t.w = 1;
     t.h = 1;
@@ -26,68 +41,317 @@ void ray::ref::Scene::GetEnvironment(environment_desc_t &env) {
     memcpy(&env.sun_col[0], &env_.sun_col, 3 * sizeof(float));
     memcpy(&env.sky_col[0], &env_.sky_col, 3 * sizeof(float));
     env.sun_softness = env_.sun_softness;
+    env.env_map = env_.env_map.texels;
+    env.env_map_w = env_.env_map.res[0];
+    env.env_map_h = env_.env_map.res[1];
 }
 
 void ray::ref::Scene::SetEnvironment(const environment_desc_t &env) {
+    TRACE_SCOPE("SetEnvironment");
     memcpy(&env_.sun_dir, &env.sun_dir[0], 3 * sizeof(float));
     memcpy(&env_.sun_col, &env.sun_col[0], 3 * sizeof(float));
     memcpy(&env_.sky_col, &env.sky_col[0], 3 * sizeof(float));
     env_.sun_softness = env.sun_softness;
+
+    if (env.env_map != env_.env_map.texels || env.env_map_w != env_.env_map.res[0] || env.env_map_h != env_.env_map.res[1]) {
+        if (env.env_map && env.env_map_w > 0 && env.env_map_h > 0) {
+            env_map_.assign(env.env_map, env.env_map + size_t(env.env_map_w) * env.env_map_h);
+            env_.env_map.res[0] = env.env_map_w;
+            env_.env_map.res[1] = env.env_map_h;
+            BuildEnvMapCells(&env_map_[0], env_.env_map.res, env_cells_, env_.env_map.cells_res);
+
+            env_.env_map.texels = &env_map_[0];
+            env_.env_map.cells = &env_cells_[0];
+        } else {
+            env_map_.clear();
+            env_cells_.clear();
+            env_.env_map = {};
+        }
+    }
 }
 
 uint32_t ray::ref::Scene::AddTexture(const tex_desc_t &_t) {
-    uint32_t tex_index = (uint32_t)textures_.size();
+    TRACE_SCOPE("AddTexture");
+    if (IsStreamed(_t)) {
+        return AddStreamedTexture(_t);
+    }
+
+    if (!_t.load_func) {
+        // data is written to atlas as is, without making a copy first
+        texture_t t;
+        const int res[2] = { _t.w, _t.h };
+        if (!AllocateTextureMips(texture_atlas_, _t.data, res, _t.generate_mipmaps, t)) return 0xffffffff;
+        return StoreTexture(t);
+    }
 
+    mip_chain_t chain;
+    GenerateMipChain(_t, chain);
+    return AddTexture(chain);
+}
+
+void ray::ref::Scene::AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) {
+    TRACE_SCOPE("AddTextures");
+    std::vector<mip_chain_t> chains(count);
+
+    // mip levels of streamed textures are loaded on demand
+    std::vector<tex_desc_t> to_generate;
+    for (size_t i = 0; i < count; i++) {
+        if (!IsStreamed(textures[i])) to_generate.push_back(textures[i]);
+    }
+    if (!to_generate.empty()) {
+        GenerateMipChains(&to_generate[0], to_generate.size(), &chains[0]);
+    }
+
+    // atlas is filled in order, so that indices are the same as with AddTexture
+    for (size_t i = 0, j = 0; i < count; i++) {
+        out_indices[i] = IsStreamed(textures[i]) ? AddStreamedTexture(textures[i]) : AddTexture(chains[j++]);
+    }
+}
+
+uint32_t ray::ref::Scene::AddTexture(const mip_chain_t &chain) {
     texture_t t;
-    t.size[0] = (uint16_t)_t.w;
-    t.size[1] = (uint16_t)_t.h;
-
-    int mip = 0;
-    int res[2] = { _t.w, _t.h };
-
-    std::vector<pixel_color8_t> tex_data(_t.data, _t.data + _t.w * _t.h);
-
-    while (res[0] >= 1 && res[1] >= 1) {
-        int pos[2];
-        int page = texture_atlas_.Allocate(&tex_data[0], res, pos);
-        if (page == -1) {
-            // release allocated mip levels on fail
-            for (int i = mip; i >= 0; i--) {
-                int _pos[2] = { t.pos[i][0], t.pos[i][1] };
-                texture_atlas_.Free(t.page[i], _pos);
+    if (!AllocateTextureMips(texture_atlas_, chain, t)) return 0xffffffff;
+    return StoreTexture(t);
+}
+
+uint32_t ray::ref::Scene::StoreTexture(const texture_t &t) {
+    if (!free_textures_.empty()) {
+        const uint32_t tex_index = free_textures_.back();
+        free_textures_.pop_back();
+        textures_[tex_index] = t;
+        return tex_index;
+    }
+
+    textures_.push_back(t);
+    return (uint32_t)(textures_.size() - 1);
+}
+
+void ray::ref::Scene::RemoveTexture(uint32_t i) {
+    TRACE_SCOPE("RemoveTexture");
+    if (i >= textures_.size() || i == default_normals_texture_ || !textures_[i].size[0]) return;
+
+    auto it = std::find_if(streamed_textures_.begin(), streamed_textures_.end(),
+                           [i](const streamed_texture_t &t) { return t.index == i; });
+    if (it != streamed_textures_.end()) {
+        while (it->resident_mip < it->mip_count) {
+            EvictMip(*it);
+        }
+        streamed_textures_.erase(it);
+    } else {
+        FreeTextureMips(texture_atlas_, textures_[i], 0, NUM_MIP_LEVELS);
+    }
+
+    textures_[i].size[0] = textures_[i].size[1] = 0;
+    free_textures_.push_back(i);
+}
+
+bool ray::ref::Scene::CompactTextures(size_t max_texels) {
+    TRACE_SCOPE("CompactTextures");
+    std::vector<bool> is_streamed(textures_.size(), false);
+    for (const auto &t : streamed_textures_) {
+        is_streamed[t.index] = true;
+    }
+
+    bool done = true;
+
+    // pages are emptied starting from the last one, moves go only to lower pages, so atlas
+    // is resized once at the end
+    for (int page = texture_atlas_.used_pages_count() - 1; page > 0; page--) {
+        bool fits = true;
+        for (uint32_t i = 0; i < (uint32_t)textures_.size() && fits && max_texels; i++) {
+            if (is_streamed[i] || !textures_[i].size[0]) continue;
+            fits = MoveTextureMips(texture_atlas_, textures_[i], 0, NUM_MIP_LEVELS, page, max_texels);
+        }
+
+        for (auto &t : streamed_textures_) {
+            if (!fits || !max_texels) break;
+            fits = MoveTextureMips(texture_atlas_, t.mips, t.resident_mip, t.mip_count, page, max_texels);
+            UpdateTextureView(t);
+        }
+
+        if (!fits) break;
+        if (!max_texels) {
+            done = false;
+            break;
+        }
+    }
+
+    // drops pages emptied so far, also when compaction is interrupted
+    const int pages_count = std::max(texture_atlas_.used_pages_count(), 1);
+    if (pages_count != texture_atlas_.pages_count()) {
+        texture_atlas_.Resize(pages_count);
+    }
+    return done;
+}
+
+uint32_t ray::ref::Scene::AddStreamedTexture(const tex_desc_t &_t) {
+    streamed_texture_t t;
+    t.load_func = _t.load_func;
+    t.load_userdata = _t.load_userdata;
+    t.mips.size[0] = (uint16_t)_t.w;
+    t.mips.size[1] = (uint16_t)_t.h;
+
+    t.mip_count = 0;
+    t.tail_mip = -1;
+    while ((_t.w >> t.mip_count) >= 1 && (_t.h >> t.mip_count) >= 1 && t.mip_count < NUM_MIP_LEVELS) {
+        if (t.tail_mip == -1 && std::max(_t.w >> t.mip_count, _t.h >> t.mip_count) <= StreamedTailRes) {
+            t.tail_mip = t.mip_count;
+        }
+        t.mip_count++;
+    }
+    if (t.tail_mip == -1) t.tail_mip = t.mip_count - 1;
+
+    // only tail of mip chain is loaded upfront
+    t.resident_mip = t.mip_count;
+    for (int mip = t.mip_count - 1; mip >= t.tail_mip; mip--) {
+        if (!LoadMip(t, mip)) {
+            while (t.resident_mip < t.mip_count) {
+                EvictMip(t);
             }
             return 0xffffffff;
         }
+    }
+    t.wanted_mip = t.resident_mip;
+    t.last_used = residency_frame_;
 
-        t.page[mip] = (uint32_t)page;
-        t.pos[mip][0] = (uint16_t)pos[0];
-        t.pos[mip][1] = (uint16_t)pos[1];
+    t.index = StoreTexture({});
+    streamed_textures_.push_back(t);
+    UpdateTextureView(t);
 
-        mip++;
+    return t.index;
+}
 
-        if (_t.generate_mipmaps) {
-            tex_data = ref::DownsampleTexture(tex_data, res);
+bool ray::ref::Scene::LoadMip(streamed_texture_t &t, int mip) {
+    const int res[2] = { t.mips.size[0] >> mip, t.mips.size[1] >> mip };
 
-            res[0] /= 2;
-            res[1] /= 2;
-        } else {
-            break;
+    std::vector<pixel_color8_t> tex_data(res[0] * res[1]);
+    t.load_func(t.load_userdata, mip, res[0], res[1], &tex_data[0]);
+
+    int pos[2];
+    const int page = texture_atlas_.Allocate(&tex_data[0], res, pos);
+    if (page == -1) return false;
+
+    t.mips.page[mip] = (uint8_t)page;
+    t.mips.pos[mip][0] = (uint16_t)pos[0];
+    t.mips.pos[mip][1] = (uint16_t)pos[1];
+    t.resident_mip = mip;
+
+    if (mip < t.tail_mip) {
+        tex_cache_used_ += tex_data.size() * sizeof(pixel_color8_t);
+    }
+
+    return true;
+}
+
+void ray::ref::Scene::EvictMip(streamed_texture_t &t) {
+    const int mip = t.resident_mip;
+    const int pos[2] = { t.mips.pos[mip][0], t.mips.pos[mip][1] };
+    texture_atlas_.Free(t.mips.page[mip], pos);
+
+    if (mip < t.tail_mip) {
+        tex_cache_used_ -= size_t(t.mips.size[0] >> mip) * (t.mips.size[1] >> mip) * sizeof(pixel_color8_t);
+    }
+
+    t.resident_mip++;
+}
+
+bool ray::ref::Scene::ReserveTextureCache(size_t size) {
+    while (tex_cache_used_ + size > tex_cache_size_) {
+        // least recently used texture, textures used in current frame give up only levels they do not need
+        streamed_texture_t *victim = nullptr;
+        for (auto &t : streamed_textures_) {
+            if (t.resident_mip >= t.tail_mip) continue;
+            if (t.last_used == residency_frame_ && t.resident_mip >= t.wanted_mip) continue;
+
+            if (!victim || t.last_used < victim->last_used) {
+                victim = &t;
+            }
         }
+
+        if (!victim) return false;
+
+        EvictMip(*victim);
+        UpdateTextureView(*victim);
     }
+    return true;
+}
 
-    // fill remaining mip levels with the last one
-    for (int i = mip; i < NUM_MIP_LEVELS; i++) {
-        t.page[i] = t.page[mip - 1];
-        t.pos[i][0] = t.pos[mip - 1][0];
-        t.pos[i][1] = t.pos[mip - 1][1];
+void ray::ref::Scene::UpdateTextureView(const streamed_texture_t &t) {
+    // texture looks like smaller one, which mip chain starts from the finest resident level
+    auto &view = textures_[t.index];
+    view.size[0] = uint16_t(t.mips.size[0] >> t.resident_mip);
+    view.size[1] = uint16_t(t.mips.size[1] >> t.resident_mip);
+
+    for (int i = 0; i < NUM_MIP_LEVELS; i++) {
+        const int mip = std::min(t.resident_mip + i, t.mip_count - 1);
+        view.page[i] = t.mips.page[mip];
+        view.pos[i][0] = t.mips.pos[mip][0];
+        view.pos[i][1] = t.mips.pos[mip][1];
     }
+}
 
-    textures_.push_back(t);
+void ray::ref::Scene::RequestTextures(const int8_t *requests) {
+    std::lock_guard<std::mutex> _(tex_requests_mtx_);
 
-    return tex_index;
+    if (tex_requests_.size() < textures_.size()) {
+        tex_requests_.resize(textures_.size(), TexNotRequested);
+    }
+
+    for (const auto &t : streamed_textures_) {
+        tex_requests_[t.index] = std::min(tex_requests_[t.index], requests[t.index]);
+    }
+}
+
+void ray::ref::Scene::UpdateTextureResidency() {
+    TRACE_SCOPE("UpdateTextureResidency");
+    residency_frame_++;
+
+    std::vector<streamed_texture_t *> pending;
+
+    {
+        std::lock_guard<std::mutex> _(tex_requests_mtx_);
+
+        for (auto &t : streamed_textures_) {
+            if (t.index >= tex_requests_.size() || tex_requests_[t.index] == TexNotRequested) continue;
+
+            t.wanted_mip = std::min(std::max(t.resident_mip + tex_requests_[t.index], 0), t.mip_count - 1);
+            t.last_used = residency_frame_;
+            tex_requests_[t.index] = TexNotRequested;
+
+            if (t.wanted_mip < t.resident_mip) {
+                pending.push_back(&t);
+            }
+        }
+    }
+
+    // cache size could be reduced since last update
+    ReserveTextureCache(0);
+
+    // textures are refined one level at a time, so that coarse levels of all of them go first
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (auto *t : pending) {
+            if (t->resident_mip <= t->wanted_mip) continue;
+
+            const int mip = t->resident_mip - 1;
+            const size_t size = size_t(t->mips.size[0] >> mip) * (t->mips.size[1] >> mip) * sizeof(pixel_color8_t);
+            if (!ReserveTextureCache(size) || !LoadMip(*t, mip)) {
+                t->wanted_mip = t->resident_mip;
+                continue;
+            }
+
+            progress = true;
+        }
+    }
+
+    for (auto *t : pending) {
+        UpdateTextureView(*t);
+    }
 }
 
 uint32_t ray::ref::Scene::AddMaterial(const mat_desc_t &m) {
+    TRACE_SCOPE("AddMaterial");
     material_t mat;
 
     mat.type = m.type;
@@ -118,6 +382,13 @@ uint32_t ray::ref::Scene::AddMaterial(const mat_desc_t &m) {
         mat.textures[NORMALS_TEXTURE] = default_normals_texture_;
     }
 
+    if (!free_materials_.empty()) {
+        const uint32_t mat_index = free_materials_.back();
+        free_materials_.pop_back();
+        materials_[mat_index] = mat;
+        return mat_index;
+    }
+
     uint32_t mat_index = (uint32_t)materials_.size();
 
     materials_.push_back(mat);
@@ -125,7 +396,14 @@ uint32_t ray::ref::Scene::AddMaterial(const mat_desc_t &m) {
     return mat_index;
 }
 
+void ray::ref::Scene::RemoveMaterial(uint32_t i) {
+    TRACE_SCOPE("RemoveMaterial");
+    if (i >= materials_.size() || std::find(free_materials_.begin(), free_materials_.end(), i) != free_materials_.end()) return;
+    free_materials_.push_back(i);
+}
+
 uint32_t ray::ref::Scene::AddMesh(const mesh_desc_t &_m) {
+    TRACE_SCOPE("AddMesh");
     meshes_.emplace_back();
     auto &m = meshes_.back();
     m.node_index = (uint32_t)nodes_.size();
@@ -168,6 +446,7 @@ uint32_t ray::ref::Scene::AddMesh(const mesh_desc_t &_m) {
 }
 
 void ray::ref::Scene::RemoveMesh(uint32_t i) {
+    TRACE_SCOPE("RemoveMesh");
     const auto &m = meshes_[i];
 
     uint32_t node_index = m.node_index,
@@ -204,6 +483,7 @@ void ray::ref::Scene::RemoveMesh(uint32_t i) {
 }
 
 uint32_t ray::ref::Scene::AddMeshInstance(uint32_t mesh_index, const float *xform) {
+    TRACE_SCOPE("AddMeshInstance");
     uint32_t mi_index = (uint32_t)mesh_instances_.size();
 
     mesh_instances_.emplace_back();
@@ -218,6 +498,7 @@ uint32_t ray::ref::Scene::AddMeshInstance(uint32_t mesh_index, const float *xfor
 }
 
 void ray::ref::Scene::SetMeshInstanceTransform(uint32_t mi_index, const float *xform) {
+    TRACE_SCOPE("SetMeshInstanceTransform");
     auto &mi = mesh_instances_[mi_index];
     auto &tr = transforms_[mi.tr_index];
 
@@ -237,6 +518,7 @@ void ray::ref::Scene::SetMeshInstanceTransform(uint32_t mi_index, const float *x
 }
 
 void ray::ref::Scene::RemoveMeshInstance(uint32_t i) {
+    TRACE_SCOPE("RemoveMeshInstance");
     mesh_instances_.erase(mesh_instances_.begin() + i);
 
     RebuildMacroBVH();
@@ -273,6 +555,7 @@ void ray::ref::Scene::RemoveNodes(uint32_t node_index, uint32_t node_count) {
 }
 
 void ray::ref::Scene::RebuildMacroBVH() {
+    TRACE_SCOPE("RebuildMacroBVH");
     RemoveNodes(macro_nodes_start_, macro_nodes_count_);
     mi_indices_.clear();
 
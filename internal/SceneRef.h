@@ -1,10 +1,12 @@
 #pragma once
 
+#include <mutex>
 #include <vector>
 
 #include "BVHSplit.h"
 #include "CoreRef.h"
 #include "TextureAtlasRef.h"
+#include "TextureUtilsRef.h"
 #include "../SceneBase.h"
 
 namespace ray {
@@ -20,6 +22,14 @@ namespace avx {
 template <int DimX, int DimY>
 class RendererSIMD;
 }
+namespace avx2 {
+template <int DimX, int DimY>
+class RendererSIMD;
+}
+namespace avx16 {
+template <int DimX, int DimY>
+class RendererSIMD;
+}
 
 namespace neon {
 template <int DimX, int DimY>
@@ -38,6 +48,10 @@ protected:
     friend class sse::RendererSIMD;
     template <int DimX, int DimY>
     friend class avx::RendererSIMD;
+    template <int DimX, int DimY>
+    friend class avx2::RendererSIMD;
+    template <int DimX, int DimY>
+    friend class avx16::RendererSIMD;
 	template <int DimX, int DimY>
     friend class neon::RendererSIMD;
 
@@ -55,7 +69,32 @@ protected:
     std::vector<texture_t> textures_;
     TextureAtlas texture_atlas_;
 
+    // slots of removed materials and textures (marked with zero size), reused by next additions
+    std::vector<uint32_t> free_materials_, free_textures_;
+
+    // texture, which mip levels are loaded on demand, only a tail of the mip chain is resident at any time
+    struct streamed_texture_t {
+        uint32_t index;                 // index in textures_, entry there starts from the finest resident level
+        tex_load_func_t load_func;
+        void *load_userdata;
+        texture_t mips;                 // placement of all levels, valid starting from resident_mip
+        int mip_count, tail_mip;        // levels starting from tail_mip are never evicted
+        int resident_mip, wanted_mip;
+        uint64_t last_used;
+    };
+
+    std::vector<streamed_texture_t> streamed_textures_;
+    size_t tex_cache_size_, tex_cache_used_ = 0;
+    uint64_t residency_frame_ = 0;
+
+    // requests recorded during rendering, relative to the finest resident level
+    std::vector<int8_t> tex_requests_;
+    std::mutex tex_requests_mtx_;
+
     environment_t env_;
+    // HDR environment map is kept out of atlas, its pages can be block compressed
+    std::vector<pixel_color8_t> env_map_;
+    std::vector<env_cell_t> env_cells_;
 
     uint32_t macro_nodes_start_ = 0, macro_nodes_count_ = 0;
 
@@ -63,17 +102,34 @@ protected:
 
     void RemoveNodes(uint32_t node_index, uint32_t node_count);
     void RebuildMacroBVH();
+
+    uint32_t AddTexture(const mip_chain_t &chain);
+    uint32_t StoreTexture(const texture_t &t);
+
+    uint32_t AddStreamedTexture(const tex_desc_t &t);
+    bool LoadMip(streamed_texture_t &t, int mip);
+    void EvictMip(streamed_texture_t &t);
+    bool ReserveTextureCache(size_t size);
+    void UpdateTextureView(const streamed_texture_t &t);
+
+    /// Merges mip levels requested by render pass, called concurrently from render threads
+    void RequestTextures(const int8_t *requests);
 public:
-    Scene();
+    explicit Scene(eTexCompression tex_compression = TexCompressionNone);
 
     void GetEnvironment(environment_desc_t &env) override;
     void SetEnvironment(const environment_desc_t &env) override;
 
     uint32_t AddTexture(const tex_desc_t &t) override;
-    void RemoveTexture(uint32_t) override {}
+    void AddTextures(const tex_desc_t *textures, size_t count, uint32_t *out_indices) override;
+    void RemoveTexture(uint32_t i) override;
+    bool CompactTextures(size_t max_texels) override;
+
+    void SetTextureCacheSize(size_t size) override { tex_cache_size_ = size; }
+    void UpdateTextureResidency() override;
 
     uint32_t AddMaterial(const mat_desc_t &m) override;
-    void RemoveMaterial(uint32_t) override {}
+    void RemoveMaterial(uint32_t i) override;
 
     uint32_t AddMesh(const mesh_desc_t &m) override;
     void RemoveMesh(uint32_t) override;
@@ -1,5 +1,7 @@
 #include "TextureAtlasOCL.h"
 
+#include <algorithm>
+
 ray::ocl::TextureAtlas::TextureAtlas(const cl::Context &context, const cl::CommandQueue &queue,
                                      int resx, int resy, int pages_count)
     : context_(context), queue_(queue), res_{ resx, resy }, pages_count_(0) {
@@ -21,31 +23,30 @@ int ray::ocl::TextureAtlas::Allocate(const pixel_color8_t *data, const int _res[
             if (error != CL_SUCCESS) return -1;
 
             {
-                // add 1px border
+                // add 1px border, that wraps around
                 error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0] + 1, (size_t)pos[1], (size_t)page }, { (size_t)_res[0], 1, 1 }, 0, 0, &data[(_res[1] - 1) * _res[0]]);
                 if (error != CL_SUCCESS) return -1;
 
                 error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0] + 1, (size_t)pos[1] + res[1] - 1, (size_t)page }, { (size_t)_res[0], 1, 1 }, 0, 0, &data[0]);
                 if (error != CL_SUCCESS) return -1;
-                
-                std::vector<pixel_color8_t> vertical_border(res[1]);
-                vertical_border[0] = data[(_res[1] - 1) * _res[0] + _res[1] - 1];
-                for (int i = 0; i < _res[1]; i++) {
-                    vertical_border[i + 1] = data[i * _res[0] + _res[1] - 1];
-                }
-                vertical_border[res[1] - 1] = data[0 * _res[0] + _res[1] - 1];
 
-                error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0], (size_t)pos[1], (size_t)page }, { 1, (size_t)res[1], 1 }, 0, 0, &vertical_border[0]);
+                // columns are read directly from data using its row pitch
+                const size_t row_pitch = sizeof(pixel_color8_t) * _res[0];
+
+                error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0], (size_t)pos[1] + 1, (size_t)page }, { 1, (size_t)_res[1], 1 }, row_pitch, 0, &data[_res[0] - 1]);
                 if (error != CL_SUCCESS) return -1;
-                
-                vertical_border[0] = data[(_res[1] - 1) * _res[0]];
-                for (int i = 0; i < _res[1]; i++) {
-                    vertical_border[i + 1] = data[i * _res[0]];
-                }
-                vertical_border[res[1] - 1] = data[0];
 
-                error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0] + res[0] - 1, (size_t)pos[1], (size_t)page }, { 1, (size_t)res[1], 1 }, 0, 0, &vertical_border[0]);
+                error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0] + res[0] - 1, (size_t)pos[1] + 1, (size_t)page }, { 1, (size_t)_res[1], 1 }, row_pitch, 0, &data[0]);
                 if (error != CL_SUCCESS) return -1;
+
+                const pixel_color8_t *corners[2][2] = { { &data[_res[1] * _res[0] - 1], &data[(_res[1] - 1) * _res[0]] },
+                                                        { &data[_res[0] - 1], &data[0] } };
+                for (int y = 0; y < 2; y++) {
+                    for (int x = 0; x < 2; x++) {
+                        error = queue_.enqueueWriteImage(atlas_, CL_TRUE, { (size_t)pos[0] + x * (res[0] - 1), (size_t)pos[1] + y * (res[1] - 1), (size_t)page }, { 1, 1, 1 }, 0, 0, corners[y][x]);
+                        if (error != CL_SUCCESS) return -1;
+                    }
+                }
             }
 
             return page;
@@ -57,11 +58,35 @@ int ray::ocl::TextureAtlas::Allocate(const pixel_color8_t *data, const int _res[
 }
 
 bool ray::ocl::TextureAtlas::Free(int page, const int pos[2]) {
-    if (page < 0 || page > pages_count_) return false;
+    if (page < 0 || page >= pages_count_) return false;
     // TODO: fill with black in debug
     return splitters_[page].Free(pos);
 }
 
+int ray::ocl::TextureAtlas::Move(int page, const int pos[2], int max_page, int new_pos[2]) {
+    if (page < 0 || page >= pages_count_) return -1;
+
+    int size[2];
+    const int index = splitters_[page].FindNode(pos, size);
+    if (index == -1) return -1;
+
+    for (int new_page = 0; new_page < std::min(max_page, pages_count_); new_page++) {
+        if (splitters_[new_page].Allocate(size, new_pos) != -1) {
+            cl_int error = queue_.enqueueCopyImage(atlas_, atlas_, { (size_t)pos[0], (size_t)pos[1], (size_t)page },
+                                                   { (size_t)new_pos[0], (size_t)new_pos[1], (size_t)new_page }, { (size_t)size[0], (size_t)size[1], 1 });
+            if (error != CL_SUCCESS) {
+                splitters_[new_page].Free(new_pos);
+                return -1;
+            }
+
+            splitters_[page].Free(index);
+            return new_page;
+        }
+    }
+
+    return -1;
+}
+
 bool ray::ocl::TextureAtlas::Resize(int pages_count) {
     // if we shrink atlas, all redundant pages required to be empty
     for (int i = pages_count; i < pages_count_; i++) {
@@ -74,13 +99,13 @@ bool ray::ocl::TextureAtlas::Resize(int pages_count) {
     if (error != CL_SUCCESS) return false;
 
     if (pages_count_) {
-        error = queue_.enqueueCopyImage(atlas_, new_atlas, {}, {}, { (size_t)res_[0], (size_t)res_[1], (size_t)pages_count_ });
+        error = queue_.enqueueCopyImage(atlas_, new_atlas, {}, {}, { (size_t)res_[0], (size_t)res_[1], (size_t)std::min(pages_count_, pages_count) });
         if (error != CL_SUCCESS) return false;
     }
 
     atlas_ = std::move(new_atlas);
 
-	splitters_.resize(pages_count, TextureSplitter{ res_ });
+	splitters_.resize(pages_count, TexturePacker{ res_ });
     pages_count_ = pages_count;
 
     return true;
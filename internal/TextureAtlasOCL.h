@@ -1,7 +1,7 @@
 #pragma once
 
 #include "CoreOCL.h"
-#include "TextureSplitter.h"
+#include "TexturePacker.h"
 
 namespace ray {
 namespace ocl {
@@ -14,7 +14,7 @@ class TextureAtlas {
     const int res_[2];
     int pages_count_;
 
-    std::vector<TextureSplitter> splitters_;
+    std::vector<TexturePacker> splitters_;
 public:
     TextureAtlas(const cl::Context &context, const cl::CommandQueue &queue,
                  int resx, int resy, int pages_count = 4);
@@ -23,9 +23,22 @@ public:
         return atlas_;
     }
 
+    int pages_count() const { return pages_count_; }
+
+    int used_pages_count() const {
+        int count = pages_count_;
+        while (count && splitters_[count - 1].empty()) count--;
+        return count;
+    }
+
     int Allocate(const pixel_color8_t *data, const int res[2], int pos[2]);
     bool Free(int page, const int pos[2]);
 
+    /** Moves allocated region to one of pages [0, max_page), copy is done on device.
+        Returns new page or -1 if region does not fit
+    */
+    int Move(int page, const int pos[2], int max_page, int new_pos[2]);
+
     bool Resize(int pages_count);
 };
 }
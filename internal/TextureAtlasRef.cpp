@@ -1,50 +1,291 @@
 #include "TextureAtlasRef.h"
 
-ray::ref::TextureAtlas::TextureAtlas(int resx, int resy, int pages_count) : res_{ resx, resy }, res_f_{ (float)resx, (float)resy }, pages_count_(0) {
+#include <algorithm>
+#include <cstdlib>
+
+namespace ray {
+namespace ref {
+uint16_t EncodeColor565(const int rgb[3]) {
+    const int r = (rgb[0] * 31 + 127) / 255,
+              g = (rgb[1] * 63 + 127) / 255,
+              b = (rgb[2] * 31 + 127) / 255;
+    return uint16_t((r << 11) | (g << 5) | b);
+}
+
+void EncodeBC3AlphaBlock(const pixel_color8_t src[16], uint8_t out_block[8]) {
+    int min_a = 255, max_a = 0;
+    for (int i = 0; i < 16; i++) {
+        min_a = std::min(min_a, (int)src[i].a);
+        max_a = std::max(max_a, (int)src[i].a);
+    }
+
+    out_block[0] = uint8_t(max_a);
+    out_block[1] = uint8_t(min_a);
+
+    uint64_t indices = 0;
+    if (max_a != min_a) {
+        uint8_t palette[8];
+        DecodeBC3AlphaPalette(out_block, palette);
+
+        for (int i = 0; i < 16; i++) {
+            int best_index = 0, best_dist = 256;
+            for (int j = 0; j < 8; j++) {
+                const int dist = std::abs((int)src[i].a - (int)palette[j]);
+                if (dist < best_dist) {
+                    best_index = j;
+                    best_dist = dist;
+                }
+            }
+            indices |= uint64_t(best_index) << (3 * i);
+        }
+    }
+
+    for (int i = 0; i < 6; i++) {
+        out_block[2 + i] = uint8_t((indices >> (8 * i)) & 0xff);
+    }
+}
+}
+}
+
+void ray::ref::EncodeBC1Block(const pixel_color8_t src[16], uint8_t out_block[8]) {
+    // bounding box of block colors, slightly inset to reduce error from outliers
+    int min_col[3] = { 255, 255, 255 }, max_col[3] = { 0, 0, 0 };
+    for (int i = 0; i < 16; i++) {
+        const uint8_t rgb[3] = { src[i].r, src[i].g, src[i].b };
+        for (int j = 0; j < 3; j++) {
+            min_col[j] = std::min(min_col[j], (int)rgb[j]);
+            max_col[j] = std::max(max_col[j], (int)rgb[j]);
+        }
+    }
+
+    for (int j = 0; j < 3; j++) {
+        const int inset = (max_col[j] - min_col[j]) / 16;
+        min_col[j] += inset;
+        max_col[j] -= inset;
+    }
+
+    {   // pick box diagonal, channels that correlate negatively with the widest one are flipped
+        int axis = 0;
+        for (int j = 1; j < 3; j++) {
+            if (max_col[j] - min_col[j] > max_col[axis] - min_col[axis]) axis = j;
+        }
+
+        int mean[3] = {};
+        for (int i = 0; i < 16; i++) {
+            mean[0] += src[i].r;
+            mean[1] += src[i].g;
+            mean[2] += src[i].b;
+        }
+
+        int cov[3] = {};
+        for (int i = 0; i < 16; i++) {
+            const int d[3] = { 16 * src[i].r - mean[0], 16 * src[i].g - mean[1], 16 * src[i].b - mean[2] };
+            for (int j = 0; j < 3; j++) {
+                cov[j] += d[axis] * d[j];
+            }
+        }
+
+        for (int j = 0; j < 3; j++) {
+            if (cov[j] < 0) std::swap(min_col[j], max_col[j]);
+        }
+    }
+
+    uint16_t c0 = EncodeColor565(max_col), c1 = EncodeColor565(min_col);
+    // c0 > c1 selects opaque 4-color mode
+    if (c0 < c1) std::swap(c0, c1);
+
+    out_block[0] = uint8_t(c0 & 0xff);
+    out_block[1] = uint8_t(c0 >> 8);
+    out_block[2] = uint8_t(c1 & 0xff);
+    out_block[3] = uint8_t(c1 >> 8);
+
+    uint32_t indices = 0;
+    if (c0 != c1) {
+        pixel_color8_t palette[4];
+        DecodeBC1Palette(out_block, palette);
+
+        for (int i = 0; i < 16; i++) {
+            int best_index = 0, best_dist = 0x7fffffff;
+            for (int j = 0; j < 4; j++) {
+                const int dr = (int)src[i].r - palette[j].r,
+                          dg = (int)src[i].g - palette[j].g,
+                          db = (int)src[i].b - palette[j].b;
+                const int dist = dr * dr + dg * dg + db * db;
+                if (dist < best_dist) {
+                    best_index = j;
+                    best_dist = dist;
+                }
+            }
+            indices |= uint32_t(best_index) << (2 * i);
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        out_block[4 + i] = uint8_t((indices >> (8 * i)) & 0xff);
+    }
+}
+
+void ray::ref::EncodeBC3Block(const pixel_color8_t src[16], uint8_t out_block[16]) {
+    EncodeBC3AlphaBlock(src, out_block);
+    EncodeBC1Block(src, out_block + 8);
+}
+
+ray::ref::TextureAtlas::TextureAtlas(int resx, int resy, int pages_count, eTexCompression compression)
+    : res_{ resx, resy }, res_f_{ (float)resx, (float)resy }, compression_(compression),
+      block_size_(compression == TexCompressionBC1 ? 8 : (compression == TexCompressionBC3 ? 16 : 16 * (int)sizeof(pixel_color8_t))), pages_count_(0) {
+    if (resx % 4 || resy % 4) {
+        throw std::runtime_error("TextureAtlas resolution should be multiple of 4!");
+    }
     if (!Resize(pages_count)) {
         throw std::runtime_error("TextureAtlas cannot be resized!");
     }
 }
 
-int ray::ref::TextureAtlas::Allocate(const pixel_color8_t *data, const int _res[2], int pos[2]) {
-    int res[2] = { _res[0] + 2, _res[1] + 2 };
+void ray::ref::TextureAtlas::WriteRegion(Page &page, int posx, int posy, int sizex, int sizey, const pixel_color8_t *data) {
+    if (compression_ == TexCompressionNone) {
+        for (int y = 0; y < sizey; y++) {
+            const int py = posy + y;
+            for (int x = 0; x < sizex;) {
+                const int px = posx + x;
+                // row of texels is contiguous only inside of one tile
+                const int count = std::min(4 - (px % 4), sizex - x);
 
-    if (res[0] > res_[0] || res[1] > res_[1]) return -1;
+                uint8_t *out_tile = &page[block_offset(px, py)];
+                memcpy(out_tile + sizeof(pixel_color8_t) * (4 * (py % 4) + (px % 4)), &data[y * sizex + x], count * sizeof(pixel_color8_t));
 
-    auto write_page = [_res, &res, this](std::vector<pixel_color8_t> &page, int posx, int posy, int sizex, int sizey, const pixel_color8_t *data) {
-        for (int y = 0; y < sizey; y++) {
-            memcpy(&page[(posy + y) * res_[0] + posx], &data[y * sizex], sizex * sizeof(pixel_color8_t));
+                x += count;
+            }
         }
-    };
+    } else {
+        // region is expected to be block aligned
+        for (int y = 0; y < sizey; y += 4) {
+            for (int x = 0; x < sizex; x += 4) {
+                pixel_color8_t block[16];
+                for (int j = 0; j < 4; j++) {
+                    memcpy(&block[j * 4], &data[(y + j) * sizex + x], 4 * sizeof(pixel_color8_t));
+                }
 
-    for (int page_index = 0; page_index < pages_count_; page_index++) {
-        int index = splitters_[page_index].Allocate(&res[0], &pos[0]);
-        if (index != -1) {
-            auto &page = pages_[page_index];
+                uint8_t *out_block = &page[block_offset(posx + x, posy + y)];
+                if (compression_ == TexCompressionBC1) {
+                    EncodeBC1Block(block, out_block);
+                } else {
+                    EncodeBC3Block(block, out_block);
+                }
+            }
+        }
+    }
+}
 
-            write_page(page, pos[0] + 1, pos[1] + 1, _res[0], _res[1], &data[0]);
+void ray::ref::TextureAtlas::WriteTexture(Page &page, const int pos[2], const int size[2], const pixel_color8_t *data, const int res[2]) {
+    const int offset = interior_offset();
 
-            // add 1px border
-            write_page(page, pos[0] + 1, pos[1], _res[0], 1, &data[(_res[1] - 1) * _res[0]]);
+    // border wraps around, padding (if any) repeats border texels
+    std::vector<int> src_x(size[0]);
+    for (int x = 0; x < size[0]; x++) {
+        src_x[x] = (std::min(std::max(x - offset, -1), res[0]) + res[0]) % res[0];
+    }
 
-            write_page(page, pos[0] + 1, pos[1] + res[1] - 1, _res[0], 1, &data[0]);
+    auto src_y = [offset, res](int y) { return (std::min(std::max(y - offset, -1), res[1]) + res[1]) % res[1]; };
 
-            std::vector<pixel_color8_t> vertical_border(res[1]);
-            vertical_border[0] = data[(_res[1] - 1) * _res[0] + _res[1] - 1];
-            for (int i = 0; i < _res[1]; i++) {
-                vertical_border[i + 1] = data[i * _res[0] + _res[1] - 1];
+    if (compression_ == TexCompressionNone) {
+        for (int y = 0; y < size[1]; y++) {
+            const pixel_color8_t *src_row = &data[size_t(src_y(y)) * res[0]];
+            const int py = pos[1] + y;
+            for (int x = 0; x < size[0];) {
+                const int px = pos[0] + x;
+                // row of texels is contiguous only inside of one tile
+                const int count = std::min(4 - (px % 4), size[0] - x);
+
+                auto *out_texels = reinterpret_cast<pixel_color8_t *>(&page[block_offset(px, py)]) + 4 * (py % 4) + (px % 4);
+
+                bool contiguous = true;
+                for (int i = 1; i < count; i++) {
+                    contiguous &= (src_x[x + i] == src_x[x] + i);
+                }
+
+                if (contiguous) {
+                    memcpy(out_texels, &src_row[src_x[x]], count * sizeof(pixel_color8_t));
+                } else {
+                    for (int i = 0; i < count; i++) {
+                        out_texels[i] = src_row[src_x[x + i]];
+                    }
+                }
+
+                x += count;
+            }
+        }
+    } else {
+        // region is block aligned
+        for (int y = 0; y < size[1]; y += 4) {
+            const pixel_color8_t *src_rows[4];
+            for (int j = 0; j < 4; j++) {
+                src_rows[j] = &data[size_t(src_y(y + j)) * res[0]];
             }
-            vertical_border[res[1] - 1] = data[0 * _res[0] + _res[1] - 1];
 
-            write_page(page, pos[0], pos[1], 1, res[1], &vertical_border[0]);
+            for (int x = 0; x < size[0]; x += 4) {
+                pixel_color8_t block[16];
+                for (int j = 0; j < 4; j++) {
+                    for (int i = 0; i < 4; i++) {
+                        block[j * 4 + i] = src_rows[j][src_x[x + i]];
+                    }
+                }
 
-            vertical_border[0] = data[(_res[1] - 1) * _res[0]];
-            for (int i = 0; i < _res[1]; i++) {
-                vertical_border[i + 1] = data[i * _res[0]];
+                uint8_t *out_block = &page[block_offset(pos[0] + x, pos[1] + y)];
+                if (compression_ == TexCompressionBC1) {
+                    EncodeBC1Block(block, out_block);
+                } else {
+                    EncodeBC3Block(block, out_block);
+                }
             }
-            vertical_border[res[1] - 1] = data[0];
+        }
+    }
+}
 
-            write_page(page, pos[0] + res[0] - 1, pos[1], 1, res[1], &vertical_border[0]);
+void ray::ref::TextureAtlas::CopyRegion(int src_page, const int src_pos[2], int dst_page, const int dst_pos[2], const int size[2]) {
+    const uint8_t *src = &pages_[src_page][0];
+    uint8_t *dst = &pages_[dst_page][0];
+
+    if (compression_ == TexCompressionNone) {
+        for (int y = 0; y < size[1]; y++) {
+            for (int x = 0; x < size[0]; x++) {
+                const int sx = src_pos[0] + x, sy = src_pos[1] + y,
+                          dx = dst_pos[0] + x, dy = dst_pos[1] + y;
+                memcpy(dst + block_offset(dx, dy) + sizeof(pixel_color8_t) * (4 * (dy % 4) + (dx % 4)),
+                       src + block_offset(sx, sy) + sizeof(pixel_color8_t) * (4 * (sy % 4) + (sx % 4)), sizeof(pixel_color8_t));
+            }
+        }
+    } else {
+        // regions are block aligned
+        for (int y = 0; y < size[1]; y += 4) {
+            for (int x = 0; x < size[0]; x += 4) {
+                memcpy(dst + block_offset(dst_pos[0] + x, dst_pos[1] + y), src + block_offset(src_pos[0] + x, src_pos[1] + y), block_size_);
+            }
+        }
+    }
+}
+
+int ray::ref::TextureAtlas::Allocate(const pixel_color8_t *data, const int _res[2], int pos[2]) {
+    // 1px border is added on each side
+    int res[2] = { _res[0] + 2, _res[1] + 2 };
+    const int offset = interior_offset();
+
+    if (compression_ != TexCompressionNone) {
+        // keep interior block aligned, so that wrapped border texels never share block with it
+        res[0] = ((_res[0] + 3) & ~3) + 2 * offset;
+        res[1] = ((_res[1] + 3) & ~3) + 2 * offset;
+    }
+
+    if (res[0] > res_[0] || res[1] > res_[1]) return -1;
+
+    for (int page_index = 0; page_index < pages_count_; page_index++) {
+        int index = splitters_[page_index].Allocate(&res[0], &pos[0]);
+        if (index != -1) {
+            // no intermediate copy, so data can point to memory mapped file
+            WriteTexture(pages_[page_index], pos, res, data, _res);
+
+            // returned position points to border texel
+            pos[0] += offset - 1;
+            pos[1] += offset - 1;
 
             return page_index;
         }
@@ -54,15 +295,16 @@ int ray::ref::TextureAtlas::Allocate(const pixel_color8_t *data, const int _res[
     return Allocate(data, _res, pos);
 }
 
-bool ray::ref::TextureAtlas::Free(int page, const int pos[2]) {
-    if (page < 0 || page > pages_count_) return false;
+bool ray::ref::TextureAtlas::Free(int page, const int _pos[2]) {
+    if (page < 0 || page >= pages_count_) return false;
+
+    const int pos[2] = { _pos[0] - (interior_offset() - 1), _pos[1] - (interior_offset() - 1) };
 #ifndef NDEBUG
     int size[2];
     int index = splitters_[page].FindNode(&pos[0], &size[0]);
     if (index != -1) {
-        for (int j = pos[1]; j < pos[1] + size[1]; j++) {
-            memset(&pages_[page][j * res_[0] + pos[0]], 0, size[0] * sizeof(pixel_color8_t));
-        }
+        std::vector<pixel_color8_t> zeroes(size[0] * size[1], { 0, 0, 0, 0 });
+        WriteRegion(pages_[page], pos[0], pos[1], size[0], size[1], &zeroes[0]);
         return splitters_[page].Free(index);
     } else {
         return false;
@@ -72,18 +314,44 @@ bool ray::ref::TextureAtlas::Free(int page, const int pos[2]) {
 #endif
 }
 
+int ray::ref::TextureAtlas::Move(int page, const int _pos[2], int max_page, int new_pos[2]) {
+    if (page < 0 || page >= pages_count_) return -1;
+
+    const int pos[2] = { _pos[0] - (interior_offset() - 1), _pos[1] - (interior_offset() - 1) };
+
+    int size[2];
+    const int index = splitters_[page].FindNode(&pos[0], &size[0]);
+    if (index == -1) return -1;
+
+    for (int new_page = 0; new_page < std::min(max_page, pages_count_); new_page++) {
+        if (splitters_[new_page].Allocate(&size[0], &new_pos[0]) != -1) {
+            CopyRegion(page, pos, new_page, new_pos, size);
+            splitters_[page].Free(index);
+
+            new_pos[0] += interior_offset() - 1;
+            new_pos[1] += interior_offset() - 1;
+
+            return new_page;
+        }
+    }
+
+    return -1;
+}
+
 bool ray::ref::TextureAtlas::Resize(int pages_count) {
     // if we shrink atlas, all redundant pages required to be empty
     for (int i = pages_count; i < pages_count_; i++) {
         if (!splitters_[i].empty()) return false;
     }
 
+    const size_t page_size = size_t(block_size_) * (res_[0] / 4) * (res_[1] / 4);
+
     pages_.resize(pages_count);
     for (auto &p : pages_) {
-        p.resize(res_[0] * res_[1], { 0, 0, 0, 0 });
+        p.resize(page_size, 0);
     }
 
-    splitters_.resize(pages_count, TextureSplitter{ &res_[0] });
+    splitters_.resize(pages_count, TexturePacker{ &res_[0] });
 
     pages_count_ = pages_count;
 
@@ -1,36 +1,194 @@
 #pragma once
 
 #include "Core.h"
-#include "TextureSplitter.h"
+#include "TexturePacker.h"
 
 namespace ray {
 namespace ref {
+force_inline void DecodeColor565(uint16_t c, uint8_t out_rgb[3]) {
+    const int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+    out_rgb[0] = uint8_t((r << 3) | (r >> 2));
+    out_rgb[1] = uint8_t((g << 2) | (g >> 4));
+    out_rgb[2] = uint8_t((b << 3) | (b >> 2));
+}
+
+/// Decodes 4-entry color palette of BC1 block
+force_inline void DecodeBC1Palette(const uint8_t *block, pixel_color8_t out_palette[4]) {
+    const uint16_t c0 = uint16_t(block[0] | (block[1] << 8)),
+                   c1 = uint16_t(block[2] | (block[3] << 8));
+
+    uint8_t rgb0[3], rgb1[3];
+    DecodeColor565(c0, rgb0);
+    DecodeColor565(c1, rgb1);
+
+    out_palette[0] = { rgb0[0], rgb0[1], rgb0[2], 255 };
+    out_palette[1] = { rgb1[0], rgb1[1], rgb1[2], 255 };
+
+    if (c0 > c1) {
+        out_palette[2] = { uint8_t((2 * rgb0[0] + rgb1[0]) / 3), uint8_t((2 * rgb0[1] + rgb1[1]) / 3), uint8_t((2 * rgb0[2] + rgb1[2]) / 3), 255 };
+        out_palette[3] = { uint8_t((rgb0[0] + 2 * rgb1[0]) / 3), uint8_t((rgb0[1] + 2 * rgb1[1]) / 3), uint8_t((rgb0[2] + 2 * rgb1[2]) / 3), 255 };
+    } else {
+        out_palette[2] = { uint8_t((rgb0[0] + rgb1[0]) / 2), uint8_t((rgb0[1] + rgb1[1]) / 2), uint8_t((rgb0[2] + rgb1[2]) / 2), 255 };
+        out_palette[3] = { 0, 0, 0, 0 };
+    }
+}
+
+force_inline int BC1Index(const uint8_t *block, int i) {
+    return (block[4 + i / 4] >> (2 * (i % 4))) & 0x3;
+}
+
+/// Decodes 8-entry alpha palette of BC3 block
+force_inline void DecodeBC3AlphaPalette(const uint8_t *block, uint8_t out_palette[8]) {
+    const int a0 = block[0], a1 = block[1];
+    out_palette[0] = uint8_t(a0);
+    out_palette[1] = uint8_t(a1);
+    if (a0 > a1) {
+        for (int i = 1; i < 7; i++) {
+            out_palette[i + 1] = uint8_t(((7 - i) * a0 + i * a1) / 7);
+        }
+    } else {
+        for (int i = 1; i < 5; i++) {
+            out_palette[i + 1] = uint8_t(((5 - i) * a0 + i * a1) / 5);
+        }
+        out_palette[6] = 0;
+        out_palette[7] = 255;
+    }
+}
+
+force_inline int BC3AlphaIndex(const uint8_t *block, int i) {
+    const int bit = 3 * i;
+    const uint32_t bits = uint32_t(block[2 + bit / 8]) | (uint32_t(block[2 + bit / 8 + 1]) << 8);
+    return (bits >> (bit % 8)) & 0x7;
+}
+
+force_inline pixel_color8_t DecodeBC1Texel(const uint8_t *block, int i) {
+    pixel_color8_t palette[4];
+    DecodeBC1Palette(block, palette);
+    return palette[BC1Index(block, i)];
+}
+
+force_inline pixel_color8_t DecodeBC3Texel(const uint8_t *block, int i) {
+    pixel_color8_t palette[4];
+    DecodeBC1Palette(block + 8, palette);
+    uint8_t alpha_palette[8];
+    DecodeBC3AlphaPalette(block, alpha_palette);
+
+    pixel_color8_t ret = palette[BC1Index(block + 8, i)];
+    ret.a = alpha_palette[BC3AlphaIndex(block, i)];
+    return ret;
+}
+
+void EncodeBC1Block(const pixel_color8_t src[16], uint8_t out_block[8]);
+void EncodeBC3Block(const pixel_color8_t src[16], uint8_t out_block[16]);
+
 class TextureAtlas {
     const int res_[2];
     const float res_f_[2];
+    const eTexCompression compression_;
+    const int block_size_;
     int pages_count_;
 
-    using Page = std::vector<pixel_color8_t>;
+    // 4x4 tiles of RGBA8 texels (64 bytes each) or 4x4 compressed blocks, depending on compression
+    using Page = std::vector<uint8_t>;
 
-    std::vector<TextureSplitter> splitters_;
+    std::vector<TexturePacker> splitters_;
     std::vector<Page> pages_;
+
+    force_inline size_t block_offset(int x, int y) const {
+        return size_t(block_size_) * ((y / 4) * (res_[0] / 4) + (x / 4));
+    }
+
+    force_inline const uint8_t *block_ptr(int page, int x, int y) const {
+        return &pages_[page][block_offset(x, y)];
+    }
+
+    // distance from allocated region origin to the first texel of texture
+    int interior_offset() const { return compression_ == TexCompressionNone ? 1 : 4; }
+
+    void WriteRegion(Page &page, int posx, int posy, int sizex, int sizey, const pixel_color8_t *data);
+    /// Writes texture of resolution res to allocated region together with its border, texels are read directly from data
+    void WriteTexture(Page &page, const int pos[2], const int size[2], const pixel_color8_t *data, const int res[2]);
+    void CopyRegion(int src_page, const int src_pos[2], int dst_page, const int dst_pos[2], const int size[2]);
 public:
-    TextureAtlas(int resx, int resy, int pages_count = 4);
+    TextureAtlas(int resx, int resy, int pages_count = 4, eTexCompression compression = TexCompressionNone);
 
     force_inline float size_x() const { return res_f_[0]; }
     force_inline float size_y() const { return res_f_[1]; }
 
+    eTexCompression compression() const { return compression_; }
+
+    int pages_count() const { return pages_count_; }
+
+    int used_pages_count() const {
+        int count = pages_count_;
+        while (count && splitters_[count - 1].empty()) count--;
+        return count;
+    }
+
+    /// Raw page storage, uncompressed page keeps 4x4 tiles of texels in row-major order
+    force_inline const uint8_t *page_data(int page) const { return &pages_[page][0]; }
+
     force_inline pixel_color8_t Get(int page, int x, int y) const {
-        return pages_[page][res_[0] * y + x];
+        if (compression_ == TexCompressionNone) {
+            return reinterpret_cast<const pixel_color8_t *>(block_ptr(page, x, y))[4 * (y % 4) + (x % 4)];
+        } else if (compression_ == TexCompressionBC1) {
+            return DecodeBC1Texel(block_ptr(page, x, y), 4 * (y % 4) + (x % 4));
+        } else {
+            return DecodeBC3Texel(block_ptr(page, x, y), 4 * (y % 4) + (x % 4));
+        }
     }
 
     force_inline pixel_color8_t Get(int page, float x, float y) const {
         return Get(page, int(x * res_[0] - 0.5f), int(y * res_[1] - 0.5f));
     }
 
+    /// Fetches 2x2 footprint for bilinear filtering, { (x, y), (x + 1, y), (x, y + 1), (x + 1, y + 1) }
+    force_inline void Get2x2(int page, int x, int y, pixel_color8_t out[4]) const {
+        if ((x % 4) != 3 && (y % 4) != 3) {
+            // whole footprint is inside of one tile, palette is decoded once
+            const uint8_t *block = block_ptr(page, x, y);
+            const int i = 4 * (y % 4) + (x % 4);
+
+            pixel_color8_t palette[4];
+            if (compression_ == TexCompressionNone) {
+                const auto *texels = reinterpret_cast<const pixel_color8_t *>(block);
+                out[0] = texels[i];
+                out[1] = texels[i + 1];
+                out[2] = texels[i + 4];
+                out[3] = texels[i + 5];
+            } else if (compression_ == TexCompressionBC1) {
+                DecodeBC1Palette(block, palette);
+                out[0] = palette[BC1Index(block, i)];
+                out[1] = palette[BC1Index(block, i + 1)];
+                out[2] = palette[BC1Index(block, i + 4)];
+                out[3] = palette[BC1Index(block, i + 5)];
+            } else {
+                DecodeBC1Palette(block + 8, palette);
+                uint8_t alpha_palette[8];
+                DecodeBC3AlphaPalette(block, alpha_palette);
+
+                const int offsets[] = { 0, 1, 4, 5 };
+                for (int j = 0; j < 4; j++) {
+                    out[j] = palette[BC1Index(block + 8, i + offsets[j])];
+                    out[j].a = alpha_palette[BC3AlphaIndex(block, i + offsets[j])];
+                }
+            }
+        } else {
+            out[0] = Get(page, x, y);
+            out[1] = Get(page, x + 1, y);
+            out[2] = Get(page, x, y + 1);
+            out[3] = Get(page, x + 1, y + 1);
+        }
+    }
+
     int Allocate(const pixel_color8_t *data, const int res[2], int pos[2]);
     bool Free(int page, const int pos[2]);
 
+    /** Moves allocated region to one of pages [0, max_page), texel data is copied as is.
+        Returns new page or -1 if region does not fit
+    */
+    int Move(int page, const int pos[2], int max_page, int new_pos[2]);
+
     bool Resize(int pages_count);
 };
 }
@@ -0,0 +1,191 @@
+#include "TexturePacker.h"
+
+#include <algorithm>
+#include <climits>
+
+ray::TexturePacker::TexturePacker(const int res[2]) {
+    const int root = NewNode(-1, 0, 0, res[0], res[1]);
+    AddFreeLeaf(root);
+}
+
+int ray::TexturePacker::Allocate(const int res[2], int pos[2]) {
+    bool truncated = false;
+    int i = FindBestLeaf(res, MaxLeavesScanned, truncated);
+    if (i == -1 && truncated) {
+        // bounded scan could skip a fitting leaf, all of them are checked before page is reported full
+        i = FindBestLeaf(res, INT_MAX, truncated);
+    }
+    if (i == -1) return -1;
+
+    RemoveFreeLeaf(i);
+
+    // split until leaf matches requested size, remainders go to free lists
+    while (nodes_[i].size[0] != res[0] || nodes_[i].size[1] != res[1]) {
+        const node_t n = nodes_[i];
+
+        const int dw = n.size[0] - res[0], dh = n.size[1] - res[1];
+
+        int ch0, ch1;
+        if (dw > dh) {
+            ch0 = NewNode(i, n.pos[0], n.pos[1], res[0], n.size[1]);
+            ch1 = NewNode(i, n.pos[0] + res[0], n.pos[1], dw, n.size[1]);
+        } else {
+            ch0 = NewNode(i, n.pos[0], n.pos[1], n.size[0], res[1]);
+            ch1 = NewNode(i, n.pos[0], n.pos[1] + res[1], n.size[0], dh);
+        }
+
+        nodes_[i].child[0] = ch0;
+        nodes_[i].child[1] = ch1;
+
+        AddFreeLeaf(ch1);
+        i = ch0;
+    }
+
+    nodes_[i].is_free = false;
+    allocated_[PosKey(nodes_[i].pos)] = i;
+
+    pos[0] = nodes_[i].pos[0];
+    pos[1] = nodes_[i].pos[1];
+
+    return i;
+}
+
+bool ray::TexturePacker::Free(const int pos[2]) {
+    auto it = allocated_.find(PosKey(pos));
+    if (it == allocated_.end()) return false;
+    return Free(it->second);
+}
+
+bool ray::TexturePacker::Free(int i) {
+    if (i < 0 || i >= (int)nodes_.size() || nodes_[i].is_free || nodes_[i].has_children()) return false;
+
+    allocated_.erase(PosKey(nodes_[i].pos));
+    nodes_[i].is_free = true;
+
+    // merge free leaves back into their parent
+    int par = nodes_[i].parent;
+    while (par != -1) {
+        const int ch0 = nodes_[par].child[0], ch1 = nodes_[par].child[1];
+        const int other = (ch0 == i) ? ch1 : ch0;
+
+        if (nodes_[other].has_children() || !nodes_[other].is_free) break;
+
+        RemoveFreeLeaf(other);
+        unused_nodes_.push_back(ch0);
+        unused_nodes_.push_back(ch1);
+
+        nodes_[par].child[0] = nodes_[par].child[1] = -1;
+
+        i = par;
+        par = nodes_[par].parent;
+    }
+
+    AddFreeLeaf(i);
+
+    return true;
+}
+
+int ray::TexturePacker::FindNode(const int pos[2], int size[2]) const {
+    auto it = allocated_.find(PosKey(pos));
+    if (it == allocated_.end()) return -1;
+
+    const node_t &n = nodes_[it->second];
+    size[0] = n.size[0];
+    size[1] = n.size[1];
+
+    return it->second;
+}
+
+int ray::TexturePacker::SizeClass(int size) {
+    int c = 0;
+    while (size > 1 && c < SizeClassesCount - 1) {
+        size >>= 1;
+        c++;
+    }
+    return c;
+}
+
+int ray::TexturePacker::NewNode(int parent, int posx, int posy, int sizex, int sizey) {
+    int i;
+    if (!unused_nodes_.empty()) {
+        i = unused_nodes_.back();
+        unused_nodes_.pop_back();
+        nodes_[i] = {};
+    } else {
+        i = (int)nodes_.size();
+        nodes_.emplace_back();
+    }
+
+    node_t &n = nodes_[i];
+    n.parent = parent;
+    n.pos[0] = posx;
+    n.pos[1] = posy;
+    n.size[0] = sizex;
+    n.size[1] = sizey;
+
+    return i;
+}
+
+void ray::TexturePacker::AddFreeLeaf(int i) {
+    auto &list = free_leaves_[SizeClass(nodes_[i].size[1])][SizeClass(nodes_[i].size[0])];
+    nodes_[i].list_index = (int)list.size();
+    list.push_back(i);
+}
+
+void ray::TexturePacker::RemoveFreeLeaf(int i) {
+    auto &list = free_leaves_[SizeClass(nodes_[i].size[1])][SizeClass(nodes_[i].size[0])];
+
+    const int last = list.back();
+    list[nodes_[i].list_index] = last;
+    nodes_[last].list_index = nodes_[i].list_index;
+    list.pop_back();
+
+    nodes_[i].list_index = -1;
+}
+
+int ray::TexturePacker::FindBestLeaf(const int res[2], int max_scanned, bool &truncated) const {
+    const int cx = SizeClass(res[0]), cy = SizeClass(res[1]);
+
+    // classes are visited by increasing area, search stops at the first one that gives a fit
+    for (int sum = cx + cy; sum <= 2 * (SizeClassesCount - 1); sum++) {
+        int best = -1;
+        long long best_area = 0;
+
+        for (int y = std::max(cy, sum - (SizeClassesCount - 1)); y <= std::min(sum - cx, SizeClassesCount - 1); y++) {
+            const int x = sum - y;
+            const auto &list = free_leaves_[y][x];
+            if (list.empty()) continue;
+
+            if (x > cx && y > cy) {
+                // every leaf of larger class fits
+                const int i = list.back();
+                const long long area = (long long)nodes_[i].size[0] * nodes_[i].size[1];
+                if (best == -1 || area < best_area) {
+                    best = i;
+                    best_area = area;
+                }
+                continue;
+            }
+
+            // leaves of the same class may be too small, only the most recent ones are checked to keep lookup bounded
+            const int scan_end = std::max((int)list.size() - max_scanned, 0);
+            if (scan_end > 0) truncated = true;
+
+            for (int j = (int)list.size() - 1; j >= scan_end; j--) {
+                const int i = list[j];
+                const node_t &n = nodes_[i];
+                if (n.size[0] < res[0] || n.size[1] < res[1]) continue;
+
+                const long long area = (long long)n.size[0] * n.size[1];
+                if (best == -1 || area < best_area) {
+                    best = i;
+                    best_area = area;
+                }
+            }
+        }
+
+        if (best != -1) return best;
+    }
+
+    return -1;
+}
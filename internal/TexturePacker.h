@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+
+#include <map>
+#include <vector>
+
+namespace ray {
+/** Guillotine packer with the same interface as TextureSplitter.
+    Free leaves are kept in lists by power-of-two size class, so allocation does not walk the tree,
+    allocated regions are looked up by position in O(log n)
+*/
+class TexturePacker {
+    static const int SizeClassesCount = 16;
+    static const int MaxLeavesScanned = 32;
+
+    struct node_t {
+        int parent = -1;
+        int child[2] = { -1, -1 };
+        int pos[2], size[2];
+        bool is_free = true;
+        int list_index = -1;    // position in free list of its size class (only for free leaves)
+
+        bool has_children() const {
+            return child[0] != -1;
+        }
+    };
+
+    std::vector<node_t> nodes_;
+    std::vector<int> unused_nodes_;
+
+    std::vector<int> free_leaves_[SizeClassesCount][SizeClassesCount];
+    std::map<uint32_t, int> allocated_;
+
+    static int SizeClass(int size);
+    static uint32_t PosKey(const int pos[2]) {
+        return (uint32_t(pos[1]) << 16) | uint32_t(pos[0]);
+    }
+
+    int NewNode(int parent, int posx, int posy, int sizex, int sizey);
+    void AddFreeLeaf(int i);
+    void RemoveFreeLeaf(int i);
+    int FindBestLeaf(const int res[2], int max_scanned, bool &truncated) const;
+public:
+    explicit TexturePacker(const int res[2]);
+
+    bool empty() const {
+        return allocated_.empty();
+    }
+
+    int Allocate(const int res[2], int pos[2]);
+    bool Free(const int pos[2]);
+    bool Free(int i);
+
+    int FindNode(const int pos[2], int size[2]) const;
+};
+}
@@ -19,21 +19,23 @@ bool ray::TextureSplitter::Free(int i) {
 
     nodes_[i].is_free = true;
 
+    // merge free leaves back into their parent
     int par = nodes_[i].parent;
     while (par != -1) {
         int ch0 = nodes_[par].child[0], ch1 = nodes_[par].child[1];
 
-        if (nodes_[ch0].has_children() && nodes_[ch0].is_free &&
-                nodes_[ch1].has_children() && nodes_[ch1].is_free) {
+        if (nodes_[ch0].has_children() || !nodes_[ch0].is_free ||
+                nodes_[ch1].has_children() || !nodes_[ch1].is_free) {
+            break;
+        }
 
-            SafeErase(ch0, &par, 1);
-            ch1 = nodes_[par].child[1];
-            SafeErase(ch1, &par, 1);
+        SafeErase(ch0, &par, 1);
+        ch1 = nodes_[par].child[1];
+        SafeErase(ch1, &par, 1);
 
-            nodes_[par].child[0] = nodes_[par].child[1] = -1;
+        nodes_[par].child[0] = nodes_[par].child[1] = -1;
 
-            par = nodes_[par].parent;
-        }
+        par = nodes_[par].parent;
     }
 
     return true;
@@ -99,9 +101,8 @@ int ray::TextureSplitter::Insert_Recursive(int i, const int res[2]) {
 }
 
 int ray::TextureSplitter::Find_Recursive(int i, const int pos[2]) const {
-    if (nodes_[i].is_free ||
-            pos[0] < nodes_[i].pos[0] || pos[0] > (nodes_[i].pos[0] + nodes_[i].size[0]) ||
-            pos[1] < nodes_[i].pos[1] || pos[1] > (nodes_[i].pos[1] + nodes_[i].size[1])) {
+    if (pos[0] < nodes_[i].pos[0] || pos[0] >= (nodes_[i].pos[0] + nodes_[i].size[0]) ||
+            pos[1] < nodes_[i].pos[1] || pos[1] >= (nodes_[i].pos[1] + nodes_[i].size[1])) {
         return -1;
     }
 
@@ -112,7 +113,8 @@ int ray::TextureSplitter::Find_Recursive(int i, const int pos[2]) const {
         if (i != -1) return i;
         return Find_Recursive(ch1, pos);
     } else {
-        if (pos[0] == nodes_[i].pos[0] && pos[1] == nodes_[i].pos[1]) {
+        // only allocated leaves can be found, inner nodes are never marked as used
+        if (!nodes_[i].is_free && pos[0] == nodes_[i].pos[0] && pos[1] == nodes_[i].pos[1]) {
             return i;
         } else {
             return -1;
@@ -11,7 +11,7 @@ class TextureSplitter {
         bool is_free = true;
 
         bool has_children() const {
-            return child[0] != 0 || child[1] != 0;
+            return child[0] != -1;
         }
     };
 
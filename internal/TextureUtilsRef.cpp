@@ -3,36 +3,140 @@
 #include "CoreRef.h"
 
 #include <cmath>
+#include <cstring>
 
 #include <array>
+#include <atomic>
+#include <thread>
 
-std::vector<ray::pixel_color8_t> ray::ref::DownsampleTexture(const std::vector<pixel_color8_t> &_tex, const int res[2]) {
-    if (res[0] == 1 || res[1] == 1) return _tex;
-    
-    const pixel_color8_t *tex = &_tex[0];
-
-    // TODO: properly downsample non-power-of-2 textures
-
-    std::vector<pixel_color8_t> ret;
-    for (int j = 0; j < res[1]; j += 2) {
-        for (int i = 0; i < res[0]; i += 2) {
-            int r = tex[(j + 0) * res[0] + i].r + tex[(j + 0) * res[0] + i + 1].r +
-                    tex[(j + 1) * res[0] + i].r + tex[(j + 1) * res[0] + i + 1].r;
-            int g = tex[(j + 0) * res[0] + i].g + tex[(j + 0) * res[0] + i + 1].g +
-                    tex[(j + 1) * res[0] + i].g + tex[(j + 1) * res[0] + i + 1].g;
-            int b = tex[(j + 0) * res[0] + i].b + tex[(j + 0) * res[0] + i + 1].b +
-                    tex[(j + 1) * res[0] + i].b + tex[(j + 1) * res[0] + i + 1].b;
-            int a = tex[(j + 0) * res[0] + i].a + tex[(j + 0) * res[0] + i + 1].a +
-                    tex[(j + 1) * res[0] + i].a + tex[(j + 1) * res[0] + i + 1].a;
-
-            ret.push_back({ (uint8_t)std::round(r * 0.25f), (uint8_t)std::round(g * 0.25f),
-                (uint8_t)std::round(b * 0.25f), (uint8_t)std::round(a * 0.25f)
-            });
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace ray {
+namespace ref {
+// Averages 2x2 texel quads of two rows, (sum + 2) / 4 matches rounding of scalar version
+void DownsampleRows(const pixel_color8_t *row0, const pixel_color8_t *row1, int out_w, pixel_color8_t *out_row) {
+    int i = 0;
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    const __m128i zero = _mm_setzero_si128(), two = _mm_set1_epi16(2);
+    for (; i + 4 <= out_w; i += 4) {
+        __m128i sum[2];
+        for (int j = 0; j < 2; j++) {
+            const __m128i in0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&row0[2 * i + 4 * j])),
+                          in1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&row1[2 * i + 4 * j]));
+            // { t0 t1 } and { t2 t3 } with 16-bit channels
+            const __m128i a = _mm_add_epi16(_mm_unpacklo_epi8(in0, zero), _mm_unpacklo_epi8(in1, zero));
+            const __m128i b = _mm_add_epi16(_mm_unpackhi_epi8(in0, zero), _mm_unpackhi_epi8(in1, zero));
+            sum[j] = _mm_add_epi16(_mm_unpacklo_epi64(a, b), _mm_unpackhi_epi64(a, b));
+            sum[j] = _mm_srli_epi16(_mm_add_epi16(sum[j], two), 2);
         }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(&out_row[i]), _mm_packus_epi16(sum[0], sum[1]));
     }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+    for (; i + 4 <= out_w; i += 4) {
+        // even and odd texels are separated on load
+        const uint32x4x2_t in0 = vld2q_u32(reinterpret_cast<const uint32_t *>(&row0[2 * i])),
+                           in1 = vld2q_u32(reinterpret_cast<const uint32_t *>(&row1[2 * i]));
+        const uint8x16_t e0 = vreinterpretq_u8_u32(in0.val[0]), o0 = vreinterpretq_u8_u32(in0.val[1]),
+                         e1 = vreinterpretq_u8_u32(in1.val[0]), o1 = vreinterpretq_u8_u32(in1.val[1]);
+
+        uint16x8_t lo = vaddl_u8(vget_low_u8(e0), vget_low_u8(o0));
+        lo = vaddw_u8(vaddw_u8(lo, vget_low_u8(e1)), vget_low_u8(o1));
+        uint16x8_t hi = vaddl_u8(vget_high_u8(e0), vget_high_u8(o0));
+        hi = vaddw_u8(vaddw_u8(hi, vget_high_u8(e1)), vget_high_u8(o1));
+
+        // rounding shift gives (sum + 2) / 4
+        vst1q_u8(reinterpret_cast<uint8_t *>(&out_row[i]), vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2)));
+    }
+#endif
+    for (; i < out_w; i++) {
+        const pixel_color8_t *t00 = &row0[2 * i], *t01 = &row0[2 * i + 1],
+                             *t10 = &row1[2 * i], *t11 = &row1[2 * i + 1];
+        out_row[i] = { uint8_t((t00->r + t01->r + t10->r + t11->r + 2) / 4), uint8_t((t00->g + t01->g + t10->g + t11->g + 2) / 4),
+                       uint8_t((t00->b + t01->b + t10->b + t11->b + 2) / 4), uint8_t((t00->a + t01->a + t10->a + t11->a + 2) / 4) };
+    }
+}
+}
+}
+
+void ray::ref::DownsampleTexture(const pixel_color8_t *tex, const int res[2], pixel_color8_t *out_tex) {
+    // last column and row of odd sized texture are skipped
+    const int out_res[2] = { res[0] / 2, res[1] / 2 };
+    for (int j = 0; j < out_res[1]; j++) {
+        DownsampleRows(&tex[(2 * j) * res[0]], &tex[(2 * j + 1) * res[0]], out_res[0], &out_tex[j * out_res[0]]);
+    }
+}
+
+std::vector<ray::pixel_color8_t> ray::ref::DownsampleTexture(const std::vector<pixel_color8_t> &tex, const int res[2]) {
+    if (res[0] == 1 || res[1] == 1) return tex;
+
+    std::vector<pixel_color8_t> ret((res[0] / 2) * (res[1] / 2));
+    DownsampleTexture(&tex[0], res, &ret[0]);
     return ret;
 }
 
+void ray::ref::GenerateMipChain(const tex_desc_t &t, mip_chain_t &out_chain) {
+    out_chain.count = 1;
+    out_chain.res[0][0] = t.w;
+    out_chain.res[0][1] = t.h;
+    out_chain.offset[0] = 0;
+
+    size_t total_size = size_t(t.w) * t.h;
+    if (t.generate_mipmaps) {
+        while (out_chain.count < NUM_MIP_LEVELS) {
+            const int *prev_res = out_chain.res[out_chain.count - 1];
+            if (prev_res[0] < 2 || prev_res[1] < 2) break;
+
+            out_chain.res[out_chain.count][0] = prev_res[0] / 2;
+            out_chain.res[out_chain.count][1] = prev_res[1] / 2;
+            out_chain.offset[out_chain.count] = total_size;
+
+            total_size += size_t(prev_res[0] / 2) * (prev_res[1] / 2);
+            out_chain.count++;
+        }
+    }
+
+    out_chain.data.resize(total_size);
+    if (t.load_func) {
+        t.load_func(t.load_userdata, 0, t.w, t.h, &out_chain.data[0]);
+    } else {
+        memcpy(&out_chain.data[0], t.data, sizeof(pixel_color8_t) * t.w * t.h);
+    }
+
+    for (int mip = 1; mip < out_chain.count; mip++) {
+        DownsampleTexture(&out_chain.data[out_chain.offset[mip - 1]], out_chain.res[mip - 1], &out_chain.data[out_chain.offset[mip]]);
+    }
+}
+
+void ray::ref::GenerateMipChains(const tex_desc_t *textures, size_t count, mip_chain_t *out_chains) {
+    const size_t threads_count = std::min<size_t>(count, std::max(std::thread::hardware_concurrency(), 1u));
+    if (threads_count <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            GenerateMipChain(textures[i], out_chains[i]);
+        }
+        return;
+    }
+
+    // textures differ in size a lot, so they are picked one by one instead of splitting in equal ranges
+    std::atomic_size_t next_texture(0);
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < threads_count; i++) {
+        threads.emplace_back([textures, count, out_chains, &next_texture]() {
+            for (size_t j = next_texture++; j < count; j = next_texture++) {
+                GenerateMipChain(textures[j], out_chains[j]);
+            }
+        });
+    }
+
+    for (auto &t : threads) {
+        t.join();
+    }
+}
+
 void ray::ref::ComputeTextureBasis(size_t vtx_offset, std::vector<vertex_t> &vertices, std::vector<uint32_t> &new_vtx_indices,
                                    const uint32_t *indices, size_t indices_count) {
 
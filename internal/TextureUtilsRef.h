@@ -1,13 +1,153 @@
 #pragma once
 
+#include <algorithm>
 #include <vector>
 
 #include "Core.h"
-#include "../Types.h"
+#include "../SceneBase.h"
 
 namespace ray {
 namespace ref {
-     std::vector<pixel_color8_t> DownsampleTexture(const std::vector<pixel_color8_t> &_tex, const int res[2]);
+     /// Box-filters texture to half resolution, out_tex should have space for (res[0] / 2) * (res[1] / 2) texels
+     void DownsampleTexture(const pixel_color8_t *tex, const int res[2], pixel_color8_t *out_tex);
+     std::vector<pixel_color8_t> DownsampleTexture(const std::vector<pixel_color8_t> &tex, const int res[2]);
+
+     /// Texture data with its mip levels stored one after another
+     struct mip_chain_t {
+         std::vector<pixel_color8_t> data;
+         int res[NUM_MIP_LEVELS][2];
+         size_t offset[NUM_MIP_LEVELS];
+         int count;
+     };
+
+     /// Loads (or copies) texture data and generates its mip levels if requested
+     void GenerateMipChain(const tex_desc_t &t, mip_chain_t &out_chain);
+
+     /// Same as above for batch of textures, which are processed in parallel
+     void GenerateMipChains(const tex_desc_t *textures, size_t count, mip_chain_t *out_chains);
+
+     /// Releases atlas regions of texture mip levels in range [first_mip, last_mip)
+     template <typename Atlas>
+     void FreeTextureMips(Atlas &atlas, const texture_t &t, int first_mip, int last_mip) {
+         for (int mip = first_mip; mip < last_mip; mip++) {
+             // remaining levels repeat the last one
+             if (mip > first_mip && t.page[mip] == t.page[mip - 1] &&
+                     t.pos[mip][0] == t.pos[mip - 1][0] && t.pos[mip][1] == t.pos[mip - 1][1]) continue;
+
+             const int pos[2] = { t.pos[mip][0], t.pos[mip][1] };
+             atlas.Free(t.page[mip], pos);
+         }
+     }
+
+     /// Makes levels after the first count ones repeat the last allocated level, sets texture size
+     inline void FinishTextureMips(texture_t &t, int count, const int res[2]) {
+         for (int mip = count; mip < NUM_MIP_LEVELS; mip++) {
+             t.page[mip] = t.page[count - 1];
+             t.pos[mip][0] = t.pos[count - 1][0];
+             t.pos[mip][1] = t.pos[count - 1][1];
+         }
+
+         t.size[0] = (uint16_t)res[0];
+         t.size[1] = (uint16_t)res[1];
+     }
+
+     /// Places all levels of mip chain in atlas, on fail nothing is left allocated
+     template <typename Atlas>
+     bool AllocateTextureMips(Atlas &atlas, const mip_chain_t &chain, texture_t &out_t) {
+         for (int mip = 0; mip < chain.count; mip++) {
+             int pos[2];
+             const int page = atlas.Allocate(&chain.data[chain.offset[mip]], chain.res[mip], pos);
+             if (page == -1) {
+                 FreeTextureMips(atlas, out_t, 0, mip);
+                 return false;
+             }
+
+             out_t.page[mip] = (uint8_t)page;
+             out_t.pos[mip][0] = (uint16_t)pos[0];
+             out_t.pos[mip][1] = (uint16_t)pos[1];
+         }
+
+         FinishTextureMips(out_t, chain.count, chain.res[0]);
+         return true;
+     }
+
+     /** Places texture data and its generated mip levels in atlas without copying the data first
+         (it can point to memory mapped file). Only two coarser levels are kept in temporary storage at a time.
+         On fail nothing is left allocated
+     */
+     template <typename Atlas>
+     bool AllocateTextureMips(Atlas &atlas, const pixel_color8_t *data, const int _res[2], bool generate_mipmaps, texture_t &out_t) {
+         std::vector<pixel_color8_t> temp[2];
+
+         int res[2] = { _res[0], _res[1] }, count = 0;
+         while (true) {
+             int pos[2];
+             const int page = atlas.Allocate(data, res, pos);
+             if (page == -1) {
+                 FreeTextureMips(atlas, out_t, 0, count);
+                 return false;
+             }
+
+             out_t.page[count] = (uint8_t)page;
+             out_t.pos[count][0] = (uint16_t)pos[0];
+             out_t.pos[count][1] = (uint16_t)pos[1];
+             count++;
+
+             if (!generate_mipmaps || count == NUM_MIP_LEVELS || res[0] < 2 || res[1] < 2) break;
+
+             // level is written over the one before previous
+             auto &next = temp[count % 2];
+             next.resize(size_t(res[0] / 2) * (res[1] / 2));
+             DownsampleTexture(data, res, &next[0]);
+
+             data = &next[0];
+             res[0] /= 2;
+             res[1] /= 2;
+         }
+
+         FinishTextureMips(out_t, count, _res);
+         return true;
+     }
+
+     /** Moves texture mip levels in range [first_mip, last_mip) from page to lower pages of atlas.
+         Returns false if one of levels does not fit there, stops with max_texels set to zero when budget is spent.
+     */
+     template <typename Atlas>
+     bool MoveTextureMips(Atlas &atlas, texture_t &t, int first_mip, int last_mip, int page, size_t &max_texels) {
+         int prev_page = -1, prev_pos[2] = { -1, -1 };
+         for (int mip = first_mip; mip < last_mip; mip++) {
+             if (t.page[mip] == prev_page && t.pos[mip][0] == prev_pos[0] && t.pos[mip][1] == prev_pos[1]) {
+                 // level repeats previous one, which could be moved already
+                 t.page[mip] = t.page[mip - 1];
+                 t.pos[mip][0] = t.pos[mip - 1][0];
+                 t.pos[mip][1] = t.pos[mip - 1][1];
+                 continue;
+             }
+
+             prev_page = t.page[mip];
+             prev_pos[0] = t.pos[mip][0];
+             prev_pos[1] = t.pos[mip][1];
+
+             if (t.page[mip] != page) continue;
+
+             const size_t texels = size_t(std::max(t.size[0] >> mip, 1)) * std::max(t.size[1] >> mip, 1);
+             if (texels > max_texels) {
+                 max_texels = 0;
+                 return true;
+             }
+
+             int new_pos[2];
+             const int new_page = atlas.Move(page, prev_pos, page, new_pos);
+             if (new_page == -1) return false;
+
+             t.page[mip] = (uint8_t)new_page;
+             t.pos[mip][0] = (uint16_t)new_pos[0];
+             t.pos[mip][1] = (uint16_t)new_pos[1];
+
+             max_texels -= texels;
+         }
+         return true;
+     }
 
      void ComputeTextureBasis(size_t vtx_offset, std::vector<vertex_t> &vertices, std::vector<uint32_t> &new_vtx_indices,
                               const uint32_t *indices, size_t indices_count);
@@ -0,0 +1,226 @@
+#include "Trace.h"
+
+#include "../Trace.h"
+
+#if defined(ENABLE_TRACING)
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ray {
+namespace trace {
+// tracks are shown as separate threads, their ids start after ids of real threads
+const int TrackIdStart = 1000;
+
+struct event_t {
+    const char *name;
+    uint64_t ts, dur;
+    rect_t region;
+    int track;          // -1 for events of thread itself
+    char type;          // 'B', 'E' or 'X' (complete event of track)
+    bool has_region;
+};
+
+struct thread_buf_t {
+    int id;
+    bool in_use;
+    uint64_t count;     // total number of written events, ring buffer keeps the last TraceBufferSize
+    std::vector<event_t> events;
+};
+
+struct registry_t {
+    std::mutex mtx;
+    std::vector<std::unique_ptr<thread_buf_t>> threads;
+    std::vector<std::string> tracks;
+};
+
+registry_t &registry() {
+    static registry_t r;
+    return r;
+}
+
+// buffer of exited thread is reused by the next one, renderers start new threads every frame
+struct thread_buf_holder_t {
+    thread_buf_t *buf = nullptr;
+
+    ~thread_buf_holder_t() {
+        if (buf) {
+            std::lock_guard<std::mutex> _(registry().mtx);
+            buf->in_use = false;
+        }
+    }
+};
+
+thread_local thread_buf_holder_t tls_buf;
+
+thread_buf_t *GetThreadBuf() {
+    if (!tls_buf.buf) {
+        registry_t &r = registry();
+        std::lock_guard<std::mutex> _(r.mtx);
+
+        for (auto &t : r.threads) {
+            if (!t->in_use) {
+                tls_buf.buf = t.get();
+                break;
+            }
+        }
+
+        if (!tls_buf.buf) {
+            r.threads.emplace_back(new thread_buf_t);
+            tls_buf.buf = r.threads.back().get();
+            tls_buf.buf->id = int(r.threads.size());
+            tls_buf.buf->count = 0;
+            tls_buf.buf->events.resize(TraceBufferSize);
+        }
+        tls_buf.buf->in_use = true;
+    }
+    return tls_buf.buf;
+}
+
+inline event_t &NextEvent() {
+    thread_buf_t *t = GetThreadBuf();
+    return t->events[(t->count++) % TraceBufferSize];
+}
+
+void WriteString(std::ostream &out, const char *str) {
+    out << '"';
+    for (const char *c = str; *c; c++) {
+        if (*c == '"' || *c == '\\') out << '\\';
+        out << *c;
+    }
+    out << '"';
+}
+
+void WriteTime(std::ostream &out, uint64_t ns) {
+    // trace_event timestamps are in microseconds
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%llu.%03u", (unsigned long long)(ns / 1000), (unsigned)(ns % 1000));
+    out << buf;
+}
+}
+}
+
+uint64_t ray::trace::Now() {
+    static const auto epoch = std::chrono::steady_clock::now();
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+void ray::trace::Begin(const char *name) {
+    event_t &e = NextEvent();
+    e.name = name;
+    e.ts = Now();
+    e.track = -1;
+    e.type = 'B';
+    e.has_region = false;
+}
+
+void ray::trace::Begin(const char *name, const rect_t &region) {
+    event_t &e = NextEvent();
+    e.name = name;
+    e.ts = Now();
+    e.region = region;
+    e.track = -1;
+    e.type = 'B';
+    e.has_region = true;
+}
+
+void ray::trace::End(const char *name) {
+    event_t &e = NextEvent();
+    e.name = name;
+    e.ts = Now();
+    e.track = -1;
+    e.type = 'E';
+    e.has_region = false;
+}
+
+void ray::trace::AddTrackEvent(int track, const char *name, uint64_t begin_ns, uint64_t end_ns) {
+    event_t &e = NextEvent();
+    e.name = name;
+    e.ts = begin_ns;
+    e.dur = end_ns > begin_ns ? end_ns - begin_ns : 0;
+    e.track = track;
+    e.type = 'X';
+    e.has_region = false;
+}
+
+int ray::trace::RegisterTrack(const char *name) {
+    registry_t &r = registry();
+    std::lock_guard<std::mutex> _(r.mtx);
+    r.tracks.emplace_back(name);
+    return int(r.tracks.size() - 1);
+}
+
+bool ray::TracingSupported() {
+    return true;
+}
+
+void ray::ClearTrace() {
+    using namespace trace;
+
+    registry_t &r = registry();
+    std::lock_guard<std::mutex> _(r.mtx);
+    for (auto &t : r.threads) {
+        t->count = 0;
+    }
+}
+
+bool ray::DumpTrace(std::ostream &out) {
+    using namespace trace;
+
+    registry_t &r = registry();
+    std::lock_guard<std::mutex> _(r.mtx);
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"ray\"}}";
+
+    for (const auto &t : r.threads) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t->id
+            << ",\"args\":{\"name\":\"thread " << t->id << "\"}}";
+    }
+
+    for (size_t i = 0; i < r.tracks.size(); i++) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << (TrackIdStart + i) << ",\"args\":{\"name\":";
+        WriteString(out, r.tracks[i].c_str());
+        out << "}}";
+    }
+
+    for (const auto &t : r.threads) {
+        const uint64_t count = std::min(t->count, (uint64_t)TraceBufferSize);
+        for (uint64_t i = t->count - count; i < t->count; i++) {
+            const event_t &e = t->events[i % TraceBufferSize];
+
+            out << ",\n{\"name\":";
+            WriteString(out, e.name);
+            out << ",\"cat\":\"ray\",\"ph\":\"" << e.type << "\",\"pid\":0,\"tid\":"
+                << (e.track == -1 ? t->id : TrackIdStart + e.track) << ",\"ts\":";
+            WriteTime(out, e.ts);
+            if (e.type == 'X') {
+                out << ",\"dur\":";
+                WriteTime(out, e.dur);
+            }
+            if (e.has_region) {
+                out << ",\"args\":{\"x\":" << e.region.x << ",\"y\":" << e.region.y
+                    << ",\"w\":" << e.region.w << ",\"h\":" << e.region.h << "}";
+            }
+            out << "}";
+        }
+    }
+
+    out << "\n]}\n";
+    return bool(out);
+}
+#else
+bool ray::TracingSupported() {
+    return false;
+}
+
+void ray::ClearTrace() {}
+
+bool ray::DumpTrace(std::ostream &) {
+    return false;
+}
+#endif
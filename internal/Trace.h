@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+
+#include "../Types.h"
+
+/*  Timeline tracing of render stages, compiled out unless ENABLE_TRACING is defined.
+    Each thread writes begin/end events into its own ring buffer, so recording needs no locks,
+    only the last TraceBufferSize events of each thread are kept. Names must be string literals.
+*/
+
+#if defined(ENABLE_TRACING)
+namespace ray {
+namespace trace {
+const int TraceBufferSize = 64 * 1024;
+
+/// Current time in nanoseconds, all events use this clock
+uint64_t Now();
+
+void Begin(const char *name);
+void Begin(const char *name, const rect_t &region);
+void End(const char *name);
+
+/** @brief Adds event which happened on other timeline (e.g. OpenCL device)
+    @param track index of track returned by RegisterTrack
+    @param begin_ns,end_ns time of event in Now() clock
+*/
+void AddTrackEvent(int track, const char *name, uint64_t begin_ns, uint64_t end_ns);
+
+/// Creates named track for events not bound to threads, name is copied
+int RegisterTrack(const char *name);
+
+class Scope {
+    const char *name_;
+public:
+    explicit Scope(const char *name) : name_(name) { Begin(name); }
+    Scope(const char *name, const rect_t &region) : name_(name) { Begin(name, region); }
+    ~Scope() { End(name_); }
+
+    Scope(const Scope &rhs) = delete;
+    Scope &operator=(const Scope &rhs) = delete;
+};
+}
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+#define TRACE_SCOPE(...) ray::trace::Scope TRACE_CONCAT(_trace_scope_, __LINE__)(__VA_ARGS__)
+#define TRACE_BEGIN(...) ray::trace::Begin(__VA_ARGS__)
+#define TRACE_END(name) ray::trace::End(name)
+#else
+#define TRACE_SCOPE(...)
+#define TRACE_BEGIN(...)
+#define TRACE_END(name)
+#endif
@@ -15,31 +15,35 @@ float3 get_cam_dir(const float x, const float y, const camera_t *cam, int w, int
 }
 
 __kernel
-void GeneratePrimaryRays(const int iteration, camera_t cam, int w, int h, __global const float *halton, __global ray_packet_t *out_rays) {
+void GeneratePrimaryRays(const int iteration, camera_t cam, int w, int h, __global const float *halton, __global packed_ray_t *out_rays) {
     const int i = get_global_id(0);
     const int j = get_global_id(1);
 
     const int index = j * w + i;
     const int hi = (hash(index) + iteration) & (HaltonSeqLen - 1);
 
-    const float x = (float)i + halton[hi * 2];
-    const float y = (float)j + halton[hi * 2 + 1];
+    const float x = (float)i + halton[0 * HaltonSeqLen + hi];
+    const float y = (float)j + halton[1 * HaltonSeqLen + hi];
 
     float3 d = get_cam_dir(x, y, &cam, w, h);
 
-    __global ray_packet_t *r = &out_rays[index];
+    ray_packet_t r;
 
-    r->o = (float4)(cam.origin, x);
-    r->d = (float4)(d, y);
-    r->c = (float4)(1.0f, 1.0f, 1.0f, 1.0f);
+    r.o = (float4)(cam.origin, x);
+    r.d = (float4)(d, y);
+    r.c = (float4)(1.0f, 1.0f, 1.0f, 1.0f);
 
-    r->do_dx = r->do_dy = (float3)(0, 0, 0);
+    r.do_dx = r.do_dy = (float3)(0, 0, 0);
 
     float3 _dx = get_cam_dir(x + 1, y, &cam, w, h),
            _dy = get_cam_dir(x, y + 1, &cam, w, h);
 
-    r->dd_dx = _dx - d;
-    r->dd_dy = _dy - d;
+    r.dd_dx = _dx - d;
+    r.dd_dy = _dy - d;
+    r.depth = 0;
+    r.pdf = 0;
+
+    out_rays[index] = PackRay(&r);
 }
 
 )"
\ No newline at end of file
@@ -31,24 +31,108 @@ float3 heat_map(float val) {
     return (heatmap_colors[i2] - heatmap_colors[i1]) * fract + heatmap_colors[i1];
 }
 
+#if !defined(NO_ENVIRONMENT_MAP)
+float3 DecodeRGBE(uint t) {
+    const int e = (int)(t >> 24);
+    const float f = e ? ldexp(1.0f, e - (128 + 8)) : 0.0f;
+    return (float3)((float)(t & 0xff), (float)((t >> 8) & 0xff), (float)((t >> 16) & 0xff)) * f;
+}
+
+// lat-long mapping, y axis points up
+float2 EnvMapDirToUV(const float3 dir) {
+    return (float2)(0.5f + atan2(dir.z, dir.x) / (2 * PI), acos(clamp(dir.y, -1.0f, 1.0f)) / PI);
+}
+
+float3 EvalEnvMap(const environment_t *env, __global const uint *env_map, const float3 dir) {
+    const int w = env->env_map_res[0], h = env->env_map_res[1];
+
+    const float2 uv = EnvMapDirToUV(dir);
+    const float2 f = uv * (float2)(w, h) - 0.5f;
+    const float2 _f0 = floor(f), k = f - _f0;
+
+    // wraps around horizontally, clamps at poles
+    const int x0 = ((int)_f0.x + w) % w, x1 = (x0 + 1) % w;
+    const int y0 = max((int)_f0.y, 0), y1 = min((int)_f0.y + 1, h - 1);
+
+    const float3 c0 = mix(DecodeRGBE(env_map[y0 * w + x0]), DecodeRGBE(env_map[y0 * w + x1]), k.x),
+                 c1 = mix(DecodeRGBE(env_map[y1 * w + x0]), DecodeRGBE(env_map[y1 * w + x1]), k.x);
+    return mix(c0, c1, k.y);
+}
+
+float EnvMapPdf(const environment_t *env, __global const env_cell_t *env_cells, const float3 dir) {
+    const float sin_theta = native_sqrt(fmax(1.0f - dir.y * dir.y, 0.0f));
+    if (sin_theta <= 0.0f) return 0.0f;
+
+    const int cw = env->env_cells_res[0], ch = env->env_cells_res[1];
+
+    const float2 uv = EnvMapDirToUV(dir);
+    const int x = min((int)(uv.x * cw), cw - 1), y = min((int)(uv.y * ch), ch - 1);
+
+    return env_cells[y * cw + x].pdf * (cw * ch) / (2 * PI * PI * sin_theta);
+}
+
+float SampleEnvMap(const environment_t *env, __global const env_cell_t *env_cells, const float r1, const float r2, float3 *out_dir) {
+    const int cw = env->env_cells_res[0], ch = env->env_cells_res[1];
+    const int count = cw * ch;
+
+    // fractional part is reused to pick between cell and its alias, then as position inside of cell
+    const float f = r1 * count;
+    int i = min((int)f, count - 1);
+    float k = fmin(f - i, 0.99999994f);
+
+    const env_cell_t c = env_cells[i];
+    if (k < c.q) {
+        k = k / c.q;
+    } else {
+        k = (k - c.q) / (1.0f - c.q);
+        i = (int)c.alias;
+    }
+
+    const float u = (i % cw + k) / cw,
+                v = (i / cw + r2) / ch;
+
+    const float theta = v * PI, phi = (u - 0.5f) * 2 * PI;
+    float cos_theta, cos_phi;
+    const float sin_theta = sincos(theta, &cos_theta);
+    const float sin_phi = sincos(phi, &cos_phi);
+
+    (*out_dir) = (float3)(sin_theta * cos_phi, cos_theta, sin_theta * sin_phi);
+
+    if (sin_theta <= 0.0f) return 0.0f;
+    return env_cells[i].pdf * count / (2 * PI * PI * sin_theta);
+}
+
+float PowerHeuristic(const float a, const float b) {
+    const float t = a * a;
+    return t / (b * b + t);
+}
+#endif
+
 float4 ShadeSurface(const int index, const int iteration, __global const float *halton,
-                    __global const hit_data_t *prim_inters, __global const ray_packet_t *prim_rays,
+                    __global const hit_data_t *prim_inters, __global const packed_ray_t *prim_rays,
                     __global const mesh_instance_t *mesh_instances, __global const uint *mi_indices,
                     __global const mesh_t *meshes, __global const transform_t *transforms,
                     __global const uint *vtx_indices, __global const vertex_t *vertices,
                     __global const bvh_node_t *nodes, uint node_index, 
                     __global const tri_accel_t *tris, __global const uint *tri_indices, 
-                    const environment_t env, __global const material_t *materials, __global const texture_t *textures, __read_only image2d_array_t texture_atlas,
-                    __global ray_packet_t *out_secondary_rays, __global int *out_secondary_rays_count) {
+                    const environment_t env, __global const uint *env_map, __global const env_cell_t *env_cells, __global const material_t *materials, __global const texture_t *textures, __read_only image2d_array_t texture_atlas,
+                    const int tex_filter, __global packed_ray_t *out_secondary_rays, __global int *out_secondary_rays_count) {
 
-    __global const ray_packet_t *orig_ray = &prim_rays[index];
+    const ray_packet_t _orig_ray = UnpackRay(prim_rays[index]);
+    const ray_packet_t *orig_ray = &_orig_ray;
     __global const hit_data_t *inter = &prim_inters[index];
 
     const int x = (int)(orig_ray->o.w),
               y = (int)(orig_ray->d.w);
 
     if (!inter->mask) {
-        // TODO: sample environment map or spherical garm.
+#if !defined(NO_ENVIRONMENT_MAP)
+        if (env.env_map_res[0]) {
+            // diffuse bounces can also be produced by light sampling, contributions are combined with power heuristic
+            const float weight = orig_ray->pdf > 0.0f ? PowerHeuristic(orig_ray->pdf, EnvMapPdf(&env, env_cells, orig_ray->d.xyz)) : 1.0f;
+            return (float4)(orig_ray->c.xyz * EvalEnvMap(&env, env_map, orig_ray->d.xyz) * weight, 1);
+        }
+#endif
         return (float4)(orig_ray->c.xyz * env.sky_col, 1);
     }
 
@@ -145,10 +229,14 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
     const int hi = (hash(index) + iteration) & (HaltonSeqLen - 1);
 
+    // each bounce takes its own dimensions of Halton points
+    halton += (HaltonPixelDims + HaltonDimsPerBounce * orig_ray->depth) * HaltonSeqLen;
+
+#if !defined(NO_MIX_MATERIALS)
     // resolve mix material
     while (mat->type == MixMaterial) {
         const float4 mix = SampleTextureBilinear(texture_atlas, &textures[mat->textures[MAIN_TEXTURE]], uvs, 0) * mat->strength;
-        const float r = halton[hi * 2];
+        const float r = halton[HaltonMixPick * HaltonSeqLen + hi];
 
         // shlick fresnel
         float RR = mat->fresnel + (1.0f - mat->fresnel) * native_powr(1.0f + dot(I, N), 5.0f);
@@ -156,6 +244,7 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         mat = (r * RR < mix.x) ? &materials[mat->textures[MIX_MAT1]] : &materials[mat->textures[MIX_MAT2]];
     }
+#endif
 
     // Derivative for normal
 
@@ -178,11 +267,13 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
     float3 B = b1 * _w + b2 * inter->u + b3 * inter->v;
     float3 T = cross(B, N);
 
+#if !defined(NO_NORMAL_MAPS)
     float4 normals = SampleTextureBilinear(texture_atlas, &textures[mat->textures[NORMALS_TEXTURE]], uvs, 0);
 
     normals = 2.0f * normals - 1.0f;
 
     N = normals.x * B + normals.z * N + normals.y * T;
+#endif
     
     //////////////////////////////////////////
 
@@ -194,11 +285,22 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
     //////////////////////////////////////////
 
-    float4 albedo = SampleTextureAnisotropic(texture_atlas, &textures[mat->textures[MAIN_TEXTURE]], uvs, duv_dx, duv_dy);
+    __global const texture_t *albedo_tex = &textures[mat->textures[MAIN_TEXTURE]];
+
+    float4 albedo;
+    if (tex_filter == TexFilterAnisotropic) {
+        albedo = SampleTextureAnisotropic(texture_atlas, albedo_tex, uvs, duv_dx, duv_dy);
+    } else {
+        // single tap filters take level from the longer axis of footprint, so growing differentials of deep bounces only make it coarser
+        const float lod = IsotropicTextureLod(albedo_tex, duv_dx, duv_dy);
+        const int _lod = lod > 0.0f ? (int)fmin(lod + 0.5f, (float)MAX_MIP_LEVEL) : 0;
+        albedo = (tex_filter == TexFilterBilinear) ? SampleTextureBilinear(texture_atlas, albedo_tex, uvs, _lod) :
+                                                     SampleTextureNearest(texture_atlas, albedo_tex, uvs, _lod);
+    }
     albedo.xyz *= mat->main_color;
     albedo = native_powr(albedo, 2.2f);
 
-    float3 col;
+    float3 col = (float3)(0, 0, 0);
 
     // Generate secondary ray
     if (mat->type == DiffuseMaterial) { 
@@ -206,10 +308,10 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         float v = 1;
         if (k > 0) {
-            const float z = 1.0f - halton[hi * 2] * env.sun_softness;
+            const float z = 1.0f - halton[HaltonLightU * HaltonSeqLen + hi] * env.sun_softness;
             const float temp = native_sqrt(1.0f - z * z);
 
-            const float phi = halton[hi * 2 + 1] * 2 * PI;
+            const float phi = halton[HaltonLightV * HaltonSeqLen + hi] * 2 * PI;
             float cos_phi;
             const float sin_phi = sincos(phi, &cos_phi);
 
@@ -227,10 +329,31 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         col = albedo.xyz * env.sun_col * v * k;
 
-        const float z = halton[hi * 2];
+#if !defined(NO_ENVIRONMENT_MAP)
+        if (env.env_map_res[0]) {
+            // light sampling of environment map
+            float3 L;
+            const float pdf = SampleEnvMap(&env, env_cells, halton[HaltonLightU * HaltonSeqLen + hi], halton[HaltonLightV * HaltonSeqLen + hi], &L);
+            const float k = dot(N, L);
+            const float3 env_col = EvalEnvMap(&env, env_map, L);
+
+            if (pdf > 0.0f && k > 0.0f && (env_col.x + env_col.y + env_col.z) > 0.0f) {
+                ray_packet_t r;
+                r.o = (float4)(P + HIT_BIAS * N, 0);
+                r.d = (float4)(L, 0);
+
+                // diffuse bounce picks directions uniformly over hemisphere
+                const float bsdf_pdf = 1.0f / (2 * PI);
+                col += albedo.xyz * env_col * (k * bsdf_pdf / pdf) * PowerHeuristic(pdf, bsdf_pdf) *
+                       TraceShadowRay(&r, mesh_instances, mi_indices, meshes, transforms, nodes, node_index, tris, tri_indices);
+            }
+        }
+#endif
+
+        const float z = halton[HaltonBsdfU * HaltonSeqLen + hi];
         const float temp = native_sqrt(1.0f - z * z);
 
-        const float phi = halton[((hash(hi) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
+        const float phi = halton[HaltonBsdfV * HaltonSeqLen + hi] * 2 * PI;
         float cos_phi;
         const float sin_phi = sincos(phi, &cos_phi);
 
@@ -241,6 +364,8 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
         r.d = (float4)(V, (float)y);
         r.c = orig_ray->c;
         r.c.xyz *= z * albedo.xyz;
+        r.depth = orig_ray->depth + 1;
+        r.pdf = 1.0f / (2 * PI);
         r.do_dx = do_dx;
         r.do_dy = do_dy;
         r.dd_dx = dd_dx - 2 * (dot(I, plane_N) * dndx + ddn_dx * plane_N);
@@ -248,17 +373,18 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         if (dot(r.c.xyz, r.c.xyz) > 0.005f) {
             const int index = atomic_inc(out_secondary_rays_count);
-            out_secondary_rays[index] = r;
+            out_secondary_rays[index] = PackRay(&r);
         }
+#if !defined(NO_GLOSSY_MATERIALS)
     } else if (mat->type == GlossyMaterial) {
         col = (float3)(0, 0, 0);
 
         float3 V = reflect(I, dot(I, N) > 0 ? N : -N);
 
-        const float z = 1.0f - halton[hi * 2] * mat->roughness;
+        const float z = 1.0f - halton[HaltonBsdfU * HaltonSeqLen + hi] * mat->roughness;
         const float temp = native_sqrt(1.0f - z * z);
 
-        const float phi = halton[((hash(hi) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
+        const float phi = halton[HaltonBsdfV * HaltonSeqLen + hi] * 2 * PI;
         float cos_phi;
         const float sin_phi = sincos(phi, &cos_phi);
 
@@ -271,6 +397,8 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
         r.d = (float4)(V, (float)y);
         r.c = orig_ray->c;
         r.c.xyz *= z;
+        r.depth = orig_ray->depth + 1;
+        r.pdf = 0;
         r.do_dx = do_dx;
         r.do_dy = do_dy;
         r.dd_dx = dd_dx - 2 * (dot(I, plane_N) * dndx + ddn_dx * plane_N);
@@ -278,8 +406,10 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         if (dot(r.c.xyz, r.c.xyz) > 0.005f) {
             const int index = atomic_inc(out_secondary_rays_count);
-            out_secondary_rays[index] = r;
+            out_secondary_rays[index] = PackRay(&r);
         }
+#endif
+#if !defined(NO_REFRACTIVE_MATERIALS)
     } else if (mat->type == RefractiveMaterial) {
         col = (float3)(0, 0, 0);
 
@@ -291,10 +421,10 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
         float m = eta * cosi - sqrt(cost2);
         float3 V = eta * I + m * _N;
 
-        const float z = 1.0f - halton[hi * 2] * mat->roughness;
+        const float z = 1.0f - halton[HaltonBsdfU * HaltonSeqLen + hi] * mat->roughness;
         const float temp = native_sqrt(1.0f - z * z);
 
-        const float phi = halton[((hash(hi) + iteration) & (HaltonSeqLen - 1)) * 2 + 0] * 2 * PI;
+        const float phi = halton[HaltonBsdfV * HaltonSeqLen + hi] * 2 * PI;
         float cos_phi;
         const float sin_phi = sincos(phi, &cos_phi);
 
@@ -313,6 +443,8 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
         r.d = (float4)(V, (float)y);
         r.c.xyz = orig_ray->c.xyz * z;
         r.c.w = mat->ior;
+        r.depth = orig_ray->depth + 1;
+        r.pdf = 0;
         r.do_dx = do_dx;
         r.do_dy = do_dy;
         r.dd_dx = eta * dd_dx - (m * dndx + dmdx * plane_N);
@@ -320,10 +452,14 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         if (cost2 >= 0 && dot(r.c.xyz, r.c.xyz) > 0.005f) {
             const int index = atomic_inc(out_secondary_rays_count);
-            out_secondary_rays[index] = r;
+            out_secondary_rays[index] = PackRay(&r);
         }
+#endif
+#if !defined(NO_EMISSIVE_MATERIALS)
     } else if (mat->type == EmissiveMaterial) {
-        col = mat->strength * orig_ray->c.xyz * albedo.xyz;
+        col = mat->strength * albedo.xyz;
+#endif
+#if !defined(NO_TRANSPARENT_MATERIALS)
     } else if (mat->type == TransparentMaterial) {
         col = (float3)(0, 0, 0);
 
@@ -331,6 +467,8 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
         r.o = (float4)(P + HIT_BIAS * I, (float)x);
         r.d = orig_ray->d;
         r.c = orig_ray->c;
+        r.depth = orig_ray->depth + 1;
+        r.pdf = 0;
         r.do_dx = do_dx;
         r.do_dy = do_dy;
         r.dd_dx = dd_dx;
@@ -338,8 +476,9 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
         if (dot(r.c.xyz, r.c.xyz) > 0.005f) {
             const int index = atomic_inc(out_secondary_rays_count);
-            out_secondary_rays[index] = r;
+            out_secondary_rays[index] = PackRay(&r);
         }
+#endif
     }
 
     //////////////////////////////////////////
@@ -349,14 +488,14 @@ float4 ShadeSurface(const int index, const int iteration, __global const float *
 
 __kernel
 void ShadePrimary(const int iteration, __global const float *halton, int w,
-                  __global const hit_data_t *prim_inters, __global const ray_packet_t *prim_rays,
+                  __global const hit_data_t *prim_inters, __global const packed_ray_t *prim_rays,
                   __global const mesh_instance_t *mesh_instances, __global const uint *mi_indices,
                   __global const mesh_t *meshes, __global const transform_t *transforms,
                   __global const uint *vtx_indices, __global const vertex_t *vertices,
                   __global const bvh_node_t *nodes, uint node_index, 
                   __global const tri_accel_t *tris, __global const uint *tri_indices, 
-                  const environment_t env, __global const material_t *materials, __global const texture_t *textures, __read_only image2d_array_t texture_atlas, __write_only image2d_t frame_buf,
-                  __global ray_packet_t *out_secondary_rays, __global int *out_secondary_rays_count) {
+                  const environment_t env, __global const uint *env_map, __global const env_cell_t *env_cells, __global const material_t *materials, __global const texture_t *textures, __read_only image2d_array_t texture_atlas, const int tex_filter, __write_only image2d_t frame_buf,
+                  __global packed_ray_t *out_secondary_rays, __global int *out_secondary_rays_count) {
     const int i = get_global_id(0);
     const int j = get_global_id(1);
 
@@ -369,29 +508,29 @@ void ShadePrimary(const int iteration, __global const float *halton, int w,
                   vtx_indices, vertices,
                   nodes, node_index, 
                   tris, tri_indices, 
-                  env, materials, textures, texture_atlas,
-                  out_secondary_rays, out_secondary_rays_count);
+                  env, env_map, env_cells, materials, textures, texture_atlas,
+                  tex_filter, out_secondary_rays, out_secondary_rays_count);
 
     write_imagef(frame_buf, (int2)(i, j), res);
 }
 
 __kernel
 void ShadeSecondary(const int iteration, __global const float *halton,
-                    __global const hit_data_t *prim_inters, __global const ray_packet_t *prim_rays,
+                    __global const hit_data_t *prim_inters, __global const packed_ray_t *prim_rays,
                     __global const mesh_instance_t *mesh_instances, __global const uint *mi_indices,
                     __global const mesh_t *meshes, __global const transform_t *transforms,
                     __global const uint *vtx_indices, __global const vertex_t *vertices,
                     __global const bvh_node_t *nodes, uint node_index, 
                     __global const tri_accel_t *tris, __global const uint *tri_indices, 
-                    const environment_t env, __global const material_t *materials, __global const texture_t *textures, __read_only image2d_array_t texture_atlas,
-                    __write_only image2d_t frame_buf, __read_only image2d_t frame_buf2,
-                    __global ray_packet_t *out_secondary_rays, __global int *out_secondary_rays_count) {
+                    const environment_t env, __global const uint *env_map, __global const env_cell_t *env_cells, __global const material_t *materials, __global const texture_t *textures, __read_only image2d_array_t texture_atlas,
+                    const int tex_filter, __write_only image2d_t frame_buf, __read_only image2d_t frame_buf2,
+                    __global packed_ray_t *out_secondary_rays, __global int *out_secondary_rays_count) {
     const int index = get_global_id(0);
 
-    __global const ray_packet_t *orig_ray = &prim_rays[index];
+    const uint ray_id = prim_rays[index].id;
 
-    const int x = (int)orig_ray->o.w,
-              y = (int)orig_ray->d.w;
+    const int x = (int)(ray_id & 0x3fff),
+              y = (int)((ray_id >> 14) & 0x3fff);
 
     float4 col = read_imagef(frame_buf2, FBUF_SAMPLER, (int2)(x, y));
 
@@ -402,8 +541,8 @@ void ShadeSecondary(const int iteration, __global const float *halton,
                   vtx_indices, vertices,
                   nodes, node_index, 
                   tris, tri_indices, 
-                  env, materials, textures, texture_atlas,
-                  out_secondary_rays, out_secondary_rays_count);
+                  env, env_map, env_cells, materials, textures, texture_atlas,
+                  tex_filter, out_secondary_rays, out_secondary_rays_count);
 
     write_imagef(frame_buf, (int2)(x, y), col + res);
 }
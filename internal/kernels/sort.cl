@@ -51,18 +51,20 @@ int g_phi_table[][17] = { { 2,  2,  2,  2,  2,  3,  3,  3,  4,  4,  4,  4,  5,
                           { 14, 14, 13, 13, 13, 13, 12, 12, 12, 11, 11, 10, 10, 10, 10, 10, 9  },
                           { 14, 13, 13, 13, 13, 12, 12, 12, 12, 11, 11, 11, 10, 10, 10, 10, 10 } };
 
-uint get_ray_hash(__global ray_packet_t *r, const float3 root_min, const float3 cell_size) {
-	int x = (int)((r->o.x - root_min.x) / cell_size.x),
-		y = (int)((r->o.y - root_min.y) / cell_size.y),
-		z = (int)((r->o.z - root_min.z) / cell_size.z);
+uint get_ray_hash(__global const packed_ray_t *r, const float3 root_min, const float3 cell_size) {
+	int x = (int)((r->o[0] - root_min.x) / cell_size.x),
+		y = (int)((r->o[1] - root_min.y) / cell_size.y),
+		z = (int)((r->o[2] - root_min.z) / cell_size.z);
+
+    const float3 d = DecodeOctahedral(r->d);
 
     x = g_morton_table_256[x];
     y = g_morton_table_256[y];
     z = g_morton_table_256[z];
 
-    int oi = (int)((1.0f + r->d.z) / g_omega_step);
-    int pi = (int)((1.0f + r->d.y) / g_phi_step),
-        pj = (int)((1.0f + r->d.x) / g_phi_step);
+    int oi = (int)((1.0f + d.z) / g_omega_step);
+    int pi = (int)((1.0f + d.y) / g_phi_step),
+        pj = (int)((1.0f + d.x) / g_phi_step);
 
 	int o = g_morton_table_16[g_omega_table[oi]];
 	int p = g_morton_table_16[g_phi_table[pi][pj]];
@@ -70,249 +72,264 @@ uint get_ray_hash(__global ray_packet_t *r, const float3 root_min, const float3
     return (o << 25) | (p << 24) | (y << 2) | (z << 1) | (x << 0);
 }
 
-__kernel
-void ComputeRayHashes(__global ray_packet_t *rays, float3 root_min, float3 cell_size, __global uint *out_hashes) {
-    const int i = get_global_id(0);
-    out_hashes[i] = get_ray_hash(&rays[i], root_min, cell_size);
-}
+#define RADIX_SIZE (1 << RADIX_BITS)
+#define RADIX_MASK (RADIX_SIZE - 1)
+#define RADIX_PASSES (32 / RADIX_BITS)
+
+// tile status used for decoupled look-back, upper two bits hold flag, the rest is a counter
+#define STATUS_NOT_READY    0u
+#define STATUS_AGGREGATE    (1u << 30)
+#define STATUS_PREFIX       (2u << 30)
+#define STATUS_FLAG_MASK    (3u << 30)
+#define STATUS_VALUE_MASK   (~STATUS_FLAG_MASK)
 
 __kernel
-void SetHeadFlags(__global uint *hashes, __global uint *out_head_flags) {
+void ComputeRayHashes(__global const packed_ray_t *rays, float3 root_min, float3 cell_size, __global uint *out_hashes, __global uint *out_indices) {
     const int i = get_global_id(0);
-    if (i == 0) {
-        out_head_flags[i] = 1;
-    } else {
-        out_head_flags[i] = hashes[i] != hashes[i - 1];
-    }
+    out_hashes[i] = get_ray_hash(&rays[i], root_min, cell_size);
+    out_indices[i] = (uint)i;
 }
 
-__kernel
-void ExclusiveScan(__global uint *in_values, int bytes_offset, int bytes_stride, __global uint *out_scan_values, __global uint *partial_sums) {
-    const int gi = get_global_id(0);
+uint LocalExclusiveScan(uint val, __local uint *temp, uint *out_total) {
     const int li = get_local_id(0);
+    const int ls = get_local_size(0);
 
-    __local uint temp[2][SCAN_PORTION];
-
-    int pout = 0, pin = 1;
-
-    temp[pout][li] = (li == 0) ? 0 : in_values[(bytes_stride/4) * (gi - 1) + (bytes_offset/4)];
-    temp[pin][li] = 0;
+    temp[li] = val;
     barrier(CLK_LOCAL_MEM_FENCE);
-    
-    for (int offset = 1; offset < SCAN_PORTION; offset *= 2) {
-        pout = 1 - pout;
-        pin = 1 - pout;
-
-        if (li >= offset) {
-            temp[pout][li] = temp[pin][li] + temp[pin][li - offset];
-        } else {
-            temp[pout][li] = temp[pin][li];
-        }
 
+    for (int offset = 1; offset < ls; offset *= 2) {
+        const uint v = (li >= offset) ? temp[li - offset] : 0;
+        barrier(CLK_LOCAL_MEM_FENCE);
+        temp[li] += v;
         barrier(CLK_LOCAL_MEM_FENCE);
     }
 
-    out_scan_values[gi] = temp[pout][li];
-    if (li == get_local_size(0) - 1) {
-        partial_sums[get_group_id(0)] = temp[pout][li] + in_values[(bytes_stride/4) * gi + (bytes_offset/4)];
-    }
+    const uint res = temp[li] - val;
+    (*out_total) = temp[ls - 1];
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    return res;
 }
 
 __kernel
-void InclusiveScan(__global uint *in_values, __global uint *out_scan_values, __global uint *partial_sums) {
+void ComputeRadixHistogram(__global const uint *keys, int count, __global uint *out_histogram) {
     const int gi = get_global_id(0);
     const int li = get_local_id(0);
 
-    __local uint temp[2][SCAN_PORTION];
+    __local uint local_histogram[RADIX_PASSES * RADIX_SIZE];
 
-    int pout = 0, pin = 1;
-
-    temp[pout][li] = in_values[gi];
-    temp[pin][li] = 0;
+    for (int i = li; i < RADIX_PASSES * RADIX_SIZE; i += get_local_size(0)) {
+        local_histogram[i] = 0;
+    }
     barrier(CLK_LOCAL_MEM_FENCE);
-    
-    for (int offset = 1; offset < SCAN_PORTION; offset *= 2) {
-        pout = 1 - pout;
-        pin = 1 - pout;
 
-        if (li >= offset) {
-            temp[pout][li] = temp[pin][li] + temp[pin][li - offset];
-        } else {
-            temp[pout][li] = temp[pin][li];
+    if (gi < count) {
+        const uint key = keys[gi];
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            atomic_inc(&local_histogram[pass * RADIX_SIZE + ((key >> (pass * RADIX_BITS)) & RADIX_MASK)]);
         }
-
-        barrier(CLK_LOCAL_MEM_FENCE);
     }
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-    out_scan_values[gi] = temp[pout][li];
-    if (li == get_local_size(0) - 1) {
-        partial_sums[get_group_id(0)] = temp[pout][li];
+    for (int i = li; i < RADIX_PASSES * RADIX_SIZE; i += get_local_size(0)) {
+        if (local_histogram[i]) {
+            atomic_add(&out_histogram[i], local_histogram[i]);
+        }
     }
 }
 
 __kernel
-void AddPartialSums(__global uint *in_values, __global uint *partial_sums) {
-    const int global_index = get_global_id(0);
-    const int group_index = get_group_id(0);
-    if (group_index != 0) {
-        in_values[global_index] += partial_sums[group_index - 1];
+void ScanRadixHistogram(__global uint *histogram) {
+    const int pass = get_global_id(0);
+
+    uint sum = 0;
+    for (int i = 0; i < RADIX_SIZE; i++) {
+        const uint val = histogram[pass * RADIX_SIZE + i];
+        histogram[pass * RADIX_SIZE + i] = sum;
+        sum += val;
     }
 }
 
-__kernel
-void InitChunkHashAndBase(__global ray_chunk_t *chunks, __global uint *hash_values, __global uint *head_flags, __global uint *scan_values) {
-    const int i = get_global_id(0);
+// loads tile of keys and sorts it locally by current digit (stable), invalid keys end up at the tail
+void LoadSortedTile(__global const uint *keys, __global const uint *vals, int count, int tile, int shift,
+                    __local uint *temp, __local uint *local_keys, __local uint *local_vals,
+                    __local uint *digit_counts, __local uint *digit_starts, uint *out_key, uint *out_val) {
+    const int li = get_local_id(0);
+    const int ls = get_local_size(0);
 
-    if (head_flags[i]) {
-        chunks[scan_values[i]].hash = hash_values[i];
-        chunks[scan_values[i]].base = (uint)i;
+    for (int i = li; i < RADIX_SIZE; i += ls) {
+        digit_counts[i] = 0;
     }
-}
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-__kernel
-void InitChunkSize(__global ray_chunk_t *chunks, int ray_count) {
-    const int i = get_global_id(0);
-    
-    if (i == get_global_size(0) - 1) {
-        chunks[i].size = (uint)ray_count - chunks[i].base;
-    } else {
-        chunks[i].size = chunks[i + 1].base - chunks[i].base;
+    const int gi = tile * ls + li;
+
+    uint key = 0xffffffff, val = 0;
+    if (gi < count) {
+        key = keys[gi];
+        val = vals[gi];
+        atomic_inc(&digit_counts[(key >> shift) & RADIX_MASK]);
     }
-}
 
-__kernel
-void InitSkeletonAndHeadFlags(__global uint *scan_values, __global ray_chunk_t *chunks, __global uint *skeleton, __global uint *head_flags) {
-    const int i = get_global_id(0);
+    // one bit at a time
+    for (int bit = 0; bit < RADIX_BITS; bit++) {
+        const uint b = (key >> (shift + bit)) & 1;
 
-    skeleton[scan_values[i]] = chunks[i].base;
-    head_flags[scan_values[i]] = 1;
-}
+        uint zeros_total;
+        const uint zeros_before = LocalExclusiveScan(1 - b, temp, &zeros_total);
+        const uint pos = b ? (zeros_total + li - zeros_before) : zeros_before;
 
-__kernel
-void InitCountTable(__global ray_chunk_t *chunks, int shift, __global uint *counters) {
-    const int gi = get_global_id(0);
-    const int li = get_local_id(0);
+        local_keys[pos] = key;
+        local_vals[pos] = val;
+        barrier(CLK_LOCAL_MEM_FENCE);
 
-    __local uint local_counters[0x10];
-    
-    for (int i = li; i < 0x10; i += get_local_size(0)) {
-        local_counters[i] = 0;
+        key = local_keys[li];
+        val = local_vals[li];
+        barrier(CLK_LOCAL_MEM_FENCE);
     }
-    barrier(CLK_LOCAL_MEM_FENCE);
 
-    atomic_inc(&local_counters[(chunks[gi].hash >> shift) & 0xF]);
-    barrier(CLK_LOCAL_MEM_FENCE);
-
-    for (int i = li; i < 0x10; i += get_local_size(0)) {
-        counters[i * get_num_groups(0) + get_group_id(0)] = local_counters[i];
+    if (li == 0) {
+        uint sum = 0;
+        for (int i = 0; i < RADIX_SIZE; i++) {
+            digit_starts[i] = sum;
+            sum += digit_counts[i];
+        }
     }
+
+    (*out_key) = key;
+    (*out_val) = val;
 }
 
+/*  Onesweep pass, relies on forward progress of work-groups that are already running (look-back spins on them),
+    OpenCL does not guarantee it, so it is used only when explicitly enabled (see settings_t::sort_look_back)
+*/
 __kernel
-void WriteSortedChunks(__global ray_chunk_t *chunks, __global uint *offsets, __global uint *counts, int shift, int group_size, int global_size, __global ray_chunk_t *chunks_out) {
-    const int gi = get_global_id(0);
-
-    uint local_offsets[0x10];
-    for (int i = 0; i < 0x10; i++) {
-        local_offsets[i] = offsets[i * global_size + gi];
-    }
+void SortPass(__global const uint *keys, __global const uint *vals, int count, int pass, __global const uint *histogram,
+              __global uint *tile_counters, __global uint *tile_status, __global uint *out_keys, __global uint *out_vals) {
+    const int li = get_local_id(0);
+    const int ls = get_local_size(0);
 
-    for (int i = 0; i < group_size; i++) {
-        uint index = (chunks[gi * group_size + i].hash >> shift) & 0xF;
-        uint local_index = local_offsets[index]++;
+    __local uint tile_index;
+    __local uint temp[SORT_PORTION], local_keys[SORT_PORTION], local_vals[SORT_PORTION];
+    __local uint digit_counts[RADIX_SIZE], digit_starts[RADIX_SIZE], digit_offsets[RADIX_SIZE];
 
-        chunks_out[local_index] = chunks[gi * group_size + i];
+    // tiles are taken in launch order, so look-back only waits for groups that are already running
+    if (li == 0) {
+        tile_index = atomic_inc(&tile_counters[pass]);
     }
-}
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-__kernel
-void ExclusiveSegScan(__global uint *in_values, __global uint *in_flags, __global uint *out_scan_values, __global uint *partial_sums) {
-    const int gi = get_global_id(0);
-    const int li = get_local_id(0);
+    const int tile = (int)tile_index;
+    const int shift = pass * RADIX_BITS;
+    const int tile_count = min(ls, count - tile * ls);
 
-    __local uint temp[2][SEG_SCAN_PORTION];
-    __local uint temp_flags[2][SEG_SCAN_PORTION];
+    uint key, val;
+    LoadSortedTile(keys, vals, count, tile, shift, temp, local_keys, local_vals, digit_counts, digit_starts, &key, &val);
 
-    int pout = 0, pin = 1;
+    // decoupled look-back, publish tile aggregate first, then accumulate predecessors until inclusive prefix is found
+    for (int d = li; d < RADIX_SIZE; d += ls) {
+        const uint digit_count = digit_counts[d];
+        uint prefix = 0;
 
-    temp[pout][li] = (li == 0) ? 0 : in_values[gi - 1];
-    temp_flags[pout][li] = in_flags[gi];
-    temp[pin][li] = 0;
-    temp_flags[pin][li] = 0;
-    barrier(CLK_LOCAL_MEM_FENCE);
-    
-    for (int offset = 1; offset < SEG_SCAN_PORTION; offset *= 2) {
-        pout = 1 - pout;
-        pin = 1 - pout;
-
-        if (li >= offset) {
-            temp_flags[pout][li] = temp_flags[pin][li] | temp_flags[pin][li - offset];
-            temp[pout][li] = temp_flags[pin][li] ? temp[pin][li] : (temp[pin][li] + temp[pin][li - offset]);
+        if (tile == 0) {
+            atomic_xchg(&tile_status[d], STATUS_PREFIX | digit_count);
         } else {
-            temp[pout][li] = temp[pin][li];
-            temp_flags[pout][li] = temp_flags[pin][li];
+            atomic_xchg(&tile_status[tile * RADIX_SIZE + d], STATUS_AGGREGATE | digit_count);
+
+            int prev_tile = tile - 1;
+            while (true) {
+                const uint status = atomic_or(&tile_status[prev_tile * RADIX_SIZE + d], 0);
+                const uint flag = status & STATUS_FLAG_MASK;
+                if (flag == STATUS_NOT_READY) continue;
+
+                prefix += (status & STATUS_VALUE_MASK);
+                if (flag == STATUS_PREFIX) break;
+
+                prev_tile--;
+            }
+
+            atomic_xchg(&tile_status[tile * RADIX_SIZE + d], STATUS_PREFIX | (prefix + digit_count));
         }
 
-        barrier(CLK_LOCAL_MEM_FENCE);
+        digit_offsets[d] = histogram[pass * RADIX_SIZE + d] + prefix;
     }
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (li < tile_count) {
+        const uint d = (key >> shift) & RADIX_MASK;
+        const uint dst = digit_offsets[d] + (li - digit_starts[d]);
 
-    out_scan_values[gi] = temp[pout][li];
-    if (li == get_local_size(0) - 1) {
-        partial_sums[get_group_id(0)] = temp[pout][li] + in_values[gi];
+        out_keys[dst] = key;
+        out_vals[dst] = val;
     }
 }
 
+// reduce-then-scan pass (used where look-back is not safe), no work-group waits for another one
+
 __kernel
-void InclusiveSegScan(__global uint *in_values, __global uint *in_flags, __global uint *out_scan_values, __global uint *partial_sums, __global uint *partial_flags) {
-    const int gi = get_global_id(0);
+void CountTileDigits(__global const uint *keys, int count, int pass, __global uint *out_tile_counts) {
     const int li = get_local_id(0);
+    const int gi = get_global_id(0);
+    const int tile = get_group_id(0);
 
-    __local uint temp[2][SEG_SCAN_PORTION];
-    __local uint temp_flags[2][SEG_SCAN_PORTION];
+    __local uint digit_counts[RADIX_SIZE];
 
-    int pout = 0, pin = 1;
+    for (int i = li; i < RADIX_SIZE; i += get_local_size(0)) {
+        digit_counts[i] = 0;
+    }
+    barrier(CLK_LOCAL_MEM_FENCE);
 
-    temp[pout][li] = in_values[gi];
-    temp_flags[pout][li] = in_flags[gi];
-    temp[pin][li] = 0;
-    temp_flags[pin][li] = 0;
+    if (gi < count) {
+        atomic_inc(&digit_counts[(keys[gi] >> (pass * RADIX_BITS)) & RADIX_MASK]);
+    }
     barrier(CLK_LOCAL_MEM_FENCE);
-    
-    for (int offset = 1; offset < SEG_SCAN_PORTION; offset *= 2) {
-        pout = 1 - pout;
-        pin = 1 - pout;
-
-        if (li >= offset) {
-            temp_flags[pout][li] = temp_flags[pin][li] | temp_flags[pin][li - offset];
-            temp[pout][li] = temp_flags[pin][li] ? temp[pin][li] : (temp[pin][li] + temp[pin][li - offset]);
-        } else {
-            temp_flags[pout][li] = temp_flags[pin][li];
-            temp[pout][li] = temp[pin][li];
-        }
 
-        barrier(CLK_LOCAL_MEM_FENCE);
+    for (int i = li; i < RADIX_SIZE; i += get_local_size(0)) {
+        out_tile_counts[tile * RADIX_SIZE + i] = digit_counts[i];
     }
+}
 
-    out_scan_values[gi] = temp[pout][li];
-    if (li == get_local_size(0) - 1) {
-        partial_sums[get_group_id(0)] = temp[pout][li];
-        partial_flags[get_group_id(0)] = temp_flags[pout][li];
+__kernel
+void ScanTileDigits(int tiles_count, int pass, __global const uint *histogram, __global uint *tile_counts) {
+    const int d = get_global_id(0);
+
+    // counts of tiles become output offsets
+    uint sum = histogram[pass * RADIX_SIZE + d];
+    for (int tile = 0; tile < tiles_count; tile++) {
+        const uint val = tile_counts[tile * RADIX_SIZE + d];
+        tile_counts[tile * RADIX_SIZE + d] = sum;
+        sum += val;
     }
 }
 
 __kernel
-void AddSegPartialSums(__global uint *flags, __global uint *in_values, __global uint *partial_sums, int group_size) {
-    const int gi = get_global_id(0);    
+void ScatterTile(__global const uint *keys, __global const uint *vals, int count, int pass,
+                 __global const uint *tile_offsets, __global uint *out_keys, __global uint *out_vals) {
+    const int li = get_local_id(0);
+    const int ls = get_local_size(0);
+    const int tile = get_group_id(0);
+
+    __local uint temp[SORT_PORTION], local_keys[SORT_PORTION], local_vals[SORT_PORTION];
+    __local uint digit_counts[RADIX_SIZE], digit_starts[RADIX_SIZE];
+
+    const int shift = pass * RADIX_BITS;
+    const int tile_count = min(ls, count - tile * ls);
+
+    uint key, val;
+    LoadSortedTile(keys, vals, count, tile, shift, temp, local_keys, local_vals, digit_counts, digit_starts, &key, &val);
+    barrier(CLK_LOCAL_MEM_FENCE);
+
+    if (li < tile_count) {
+        const uint d = (key >> shift) & RADIX_MASK;
+        const uint dst = tile_offsets[tile * RADIX_SIZE + d] + (li - digit_starts[d]);
 
-    uint flag = 0;
-    for (int i = 0; i < group_size && gi; i++) {
-        flag = flag | flags[gi * group_size + i];
-        in_values[gi * group_size + i] = flag ? in_values[gi * group_size + i] : (in_values[gi * group_size + i] + partial_sums[gi - 1]);
+        out_keys[dst] = key;
+        out_vals[dst] = val;
     }
 }
 
 __kernel
-void ReorderRays(__global ray_packet_t *in_rays, __global uint *in_indices, __global ray_packet_t *out_rays) {
+void ReorderRays(__global const packed_ray_t *in_rays, __global uint *in_indices, __global packed_ray_t *out_rays) {
     const int gi = get_global_id(0);
     out_rays[gi] = in_rays[in_indices[gi]];
 }
@@ -1,6 +1,31 @@
 R"(
 
 __constant sampler_t TEX_SAMPLER = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP | CLK_FILTER_LINEAR;
+__constant sampler_t TEX_SAMPLER_NEAREST = CLK_NORMALIZED_COORDS_TRUE | CLK_ADDRESS_CLAMP | CLK_FILTER_NEAREST;
+
+#if defined(SINGLE_TEXTURE_PAGE)
+#define TEXTURE_PAGE(t, lod) 0
+#else
+#define TEXTURE_PAGE(t, lod) (t)->page[lod]
+#endif
+
+// Mip level for single tap filtering, pixel footprint is approximated by its longer axis
+float IsotropicTextureLod(__global const texture_t *texture, const float2 duv_dx, const float2 duv_dy) {
+    const float2 sz = (float2)(texture->size[0], texture->size[1]);
+    const float2 dx = duv_dx * sz, dy = duv_dy * sz;
+    return 0.5f * native_log2(fmax(dot(dx, dx), dot(dy, dy)));
+}
+
+float4 SampleTextureNearest(__read_only image2d_array_t texture_atlas, __global const texture_t *texture,
+                            const float2 uvs, int lod) {
+    const float2 tex_atlas_size = (float2)(get_image_width(texture_atlas), get_image_height(texture_atlas));
+
+    const float2 uvs1 = TransformUVs(uvs, tex_atlas_size, texture, lod);
+
+    float4 coord1 = (float4)(uvs1, (float)TEXTURE_PAGE(texture, lod), 0);
+
+    return read_imagef(texture_atlas, TEX_SAMPLER_NEAREST, coord1);
+}
 
 float4 SampleTextureBilinear(__read_only image2d_array_t texture_atlas, __global const texture_t *texture,
                               const float2 uvs, int lod) {
@@ -8,7 +33,7 @@ float4 SampleTextureBilinear(__read_only image2d_array_t texture_atlas, __global
     
     const float2 uvs1 = TransformUVs(uvs, tex_atlas_size, texture, lod);
 
-    float4 coord1 = (float4)(uvs1, (float)texture->page[lod], 0);
+    float4 coord1 = (float4)(uvs1, (float)TEXTURE_PAGE(texture, lod), 0);
 
     return read_imagef(texture_atlas, TEX_SAMPLER, coord1);
 }
@@ -23,8 +48,8 @@ float4 SampleTextureTrilinear(__read_only image2d_array_t texture_atlas, __globa
     int page1 = (int)min(floor(lod), (float)MAX_MIP_LEVEL);
     int page2 = (int)min(ceil(lod), (float)MAX_MIP_LEVEL);
 
-    float4 coord1 = (float4)(uvs1, (float)texture->page[page1], 0);
-    float4 coord2 = (float4)(uvs2, (float)texture->page[page2], 0);
+    float4 coord1 = (float4)(uvs1, (float)TEXTURE_PAGE(texture, page1), 0);
+    float4 coord2 = (float4)(uvs2, (float)TEXTURE_PAGE(texture, page2), 0);
 
     float4 tex_col1 = read_imagef(texture_atlas, TEX_SAMPLER, coord1);
     float4 tex_col2 = read_imagef(texture_atlas, TEX_SAMPLER, coord2);
@@ -68,8 +93,8 @@ float4 SampleTextureAnisotropic(__read_only image2d_array_t texture_atlas, __glo
     int lod1 = (int)floor(lod);
     int lod2 = (int)ceil(lod);
 
-    int page1 = texture->page[lod1];
-    int page2 = texture->page[lod2];
+    int page1 = TEXTURE_PAGE(texture, lod1);
+    int page2 = TEXTURE_PAGE(texture, lod2);
 
     float2 pos1 = (float2)((float)texture->pos[lod1][0] + 0.5f, (float)texture->pos[lod1][1] + 0.5f);
     float2 size1 = (float2)((float)(texture->size[0] >> lod1), (float)(texture->size[1] >> lod1));
@@ -13,18 +13,27 @@ float TraceShadowRay(const ray_packet_t *orig_r,
                                      meshes, transforms, nodes, node_index, tris, tri_indices);
 }
 
+#if defined(COUNT_TRAVERSAL_COST)
+void AddTraversalCost(const ray_packet_t *r, int w, uint2 cost, __global uint *out_cost) {
+    // secondary rays of the same pixel can be traced simultaneously
+    const int i = (int)(r->d.w) * w + (int)(r->o.w);
+    atomic_add(&out_cost[2 * i + 0], cost.x);
+    atomic_add(&out_cost[2 * i + 1], cost.y);
+}
+#endif
+
 __kernel
-void TracePrimaryRays(__global const ray_packet_t *rays, int w, 
+void TracePrimaryRays(__global const packed_ray_t *rays, int w, 
                       __global const mesh_instance_t *mesh_instances,
                       __global const uint *mi_indices, 
                       __global const mesh_t *meshes, __global const transform_t *transforms,
                       __global const bvh_node_t *nodes, uint node_index,
                       __global const tri_accel_t *tris, __global const uint *tri_indices, 
-                      __global hit_data_t *out_prim_inters) {
+                      __global hit_data_t *out_prim_inters, __global uint *out_cost) {
 
     const int index = get_global_id(1) * w + get_global_id(0);
 
-    const ray_packet_t orig_r = rays[index];
+    const ray_packet_t orig_r = UnpackRay(rays[index]);
     const float3 orig_inv_d = safe_invert(orig_r.d.xyz);
     const float *orig_rinv_d = (const float *)&orig_inv_d;
 
@@ -33,24 +42,28 @@ void TracePrimaryRays(__global const ray_packet_t *rays, int w,
     inter.t = FLT_MAX;
     inter.ray_id = (float2)(orig_r.o.w, orig_r.d.w);
 
+    uint2 cost = (uint2)(0, 0);
     Traverse_MacroTree(&orig_r, orig_rinv_d, mesh_instances, mi_indices, meshes, transforms,
-                       nodes, node_index, tris, tri_indices, &inter);
+                       nodes, node_index, tris, tri_indices, &inter, &cost);
 
     out_prim_inters[index] = inter;
+#if defined(COUNT_TRAVERSAL_COST)
+    AddTraversalCost(&orig_r, w, cost, out_cost);
+#endif
 }
 
 __kernel
-void TraceSecondaryRays(__global const ray_packet_t *rays,
+void TraceSecondaryRays(__global const packed_ray_t *rays, int w,
                       __global const mesh_instance_t *mesh_instances,
                       __global const uint *mi_indices, 
                       __global const mesh_t *meshes, __global const transform_t *transforms,
                       __global const bvh_node_t *nodes, uint node_index,
                       __global const tri_accel_t *tris, __global const uint *tri_indices, 
-                      __global hit_data_t *out_prim_inters) {
+                      __global hit_data_t *out_prim_inters, __global uint *out_cost) {
 
     const int index = get_global_id(0);
 
-    const ray_packet_t orig_r = rays[index];
+    const ray_packet_t orig_r = UnpackRay(rays[index]);
     const float3 orig_inv_d = safe_invert(orig_r.d.xyz);
     const float *orig_rinv_d = (const float *)&orig_inv_d;
 
@@ -59,10 +72,14 @@ void TraceSecondaryRays(__global const ray_packet_t *rays,
     inter.t = FLT_MAX;
     inter.ray_id = (float2)(orig_r.o.w, orig_r.d.w);
 
+    uint2 cost = (uint2)(0, 0);
     Traverse_MacroTree(&orig_r, orig_rinv_d, mesh_instances, mi_indices, meshes, transforms,
-                       nodes, node_index, tris, tri_indices, &inter);
+                       nodes, node_index, tris, tri_indices, &inter, &cost);
 
     out_prim_inters[index] = inter;
+#if defined(COUNT_TRAVERSAL_COST)
+    AddTraversalCost(&orig_r, w, cost, out_cost);
+#endif
 }
 
 )"
\ No newline at end of file
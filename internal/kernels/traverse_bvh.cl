@@ -53,10 +53,18 @@ float3 safe_invert(const float3 v) {
 #define far_child(rd, n)    \
     (rd)[(n)->space_axis] < 0 ? (n)->left_child : (n)->right_child
 
+// debug variant of program counts tested nodes (x) and triangles (y) of each ray
+#if defined(COUNT_TRAVERSAL_COST)
+#define add_traversal_cost(cost, nodes_count, tris_count) \
+    { (cost)->x += (nodes_count); (cost)->y += (tris_count); }
+#else
+#define add_traversal_cost(cost, nodes_count, tris_count)
+#endif
+
 void Traverse_MicroTree(const ray_packet_t *r, const float *inv_d, uint obj_index,
                         __global const bvh_node_t *nodes, uint node_index,
                         __global const tri_accel_t *tris, __global const uint *tri_indices, 
-                        hit_data_t *inter) {
+                        hit_data_t *inter, uint2 *cost) {
 
     const float *ro = (const float *)&r->o;
     const float *rd = (const float *)&r->d;
@@ -72,6 +80,7 @@ void Traverse_MicroTree(const ray_packet_t *r, const float *inv_d, uint obj_inde
         __global const bvh_node_t *n = &nodes[cur];
         
         if (n->tri_count) {
+            add_traversal_cost(cost, 0, n->tri_count);
             IntersectTris(r, tris, tri_indices, n->tri_index, n->tri_count, obj_index, inter);
             last = cur; cur = n->parent;
             continue;
@@ -86,6 +95,7 @@ void Traverse_MicroTree(const ray_packet_t *r, const float *inv_d, uint obj_inde
         }
 
         uint try_child = (last == n->parent) ? near : far;
+        add_traversal_cost(cost, 1, 0);
         if (bbox_test(ro, inv_d, inter->t, &nodes[try_child])) {
             last = cur; cur = try_child;
         } else {
@@ -151,7 +161,7 @@ void Traverse_MacroTree(const ray_packet_t *orig_r, const float *orig_rinv_d,
                         __global const mesh_t *meshes, __global const transform_t *transforms, 
                         __global const bvh_node_t *nodes, uint node_index, 
                         __global const tri_accel_t *tris, __global const uint *tri_indices,
-                        hit_data_t *inter) {
+                        hit_data_t *inter, uint2 *cost) {
 
     const float *orig_ro = (const float *)&orig_r->o;
     const float *orig_rd = (const float *)&orig_r->d;
@@ -172,6 +182,7 @@ void Traverse_MacroTree(const ray_packet_t *orig_r, const float *orig_rinv_d,
                 __global const mesh_t *m = &meshes[mi->mesh_index];
                 __global const transform_t *tr = &transforms[mi->tr_index];
 
+                add_traversal_cost(cost, 1, 0);
                 if (!_bbox_test(orig_ro, orig_rinv_d, inter->t, mi->bbox_min, mi->bbox_max)) continue;
 
                 const ray_packet_t r = TransformRay(orig_r, &tr->inv_xform);
@@ -179,7 +190,7 @@ void Traverse_MacroTree(const ray_packet_t *orig_r, const float *orig_rinv_d,
 
                 const float *rinv_d = (const float *)&inv_d;
                 
-                Traverse_MicroTree(&r, rinv_d, mi_indices[i], nodes, m->node_index, tris, tri_indices, inter);
+                Traverse_MicroTree(&r, rinv_d, mi_indices[i], nodes, m->node_index, tris, tri_indices, inter, cost);
             }
 
             last = cur; cur = n->parent;
@@ -195,6 +206,7 @@ void Traverse_MacroTree(const ray_packet_t *orig_r, const float *orig_rinv_d,
         }
 
         uint try_child = (last == n->parent) ? near : far;
+        add_traversal_cost(cost, 1, 0);
         if (bbox_test(orig_ro, orig_rinv_d, inter->t, &nodes[try_child])) {
             last = cur; cur = try_child;
         } else {
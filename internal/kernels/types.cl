@@ -6,8 +6,20 @@ typedef struct _ray_packet_t {
     float4 o, d;
     float4 c;
     float3 do_dx, dd_dx, do_dy, dd_dy;
+    int depth;
+    float pdf;
 } ray_packet_t;
 
+// compact ray representation used in ray buffers, ray_packet_t is used only for computations
+typedef struct _packed_ray_t {
+    float o[3];
+    uint id;        // pixel coordinates (14 bits each) and bounce depth (4 bits)
+    uint d;         // octahedral encoded direction (2 x 16-bit snorm)
+    ushort c[4];    // color and ior as half floats
+    ushort do_dx[4], dd_dx[4], do_dy[4], dd_dy[4]; // derivatives as half floats (w is unused)
+    float pdf;      // pdf of diffuse bounce direction
+} packed_ray_t;
+
 typedef struct _camera_t {
     float3 origin, fwd, side, up;
 } camera_t;
@@ -80,15 +92,65 @@ typedef struct _environment_t {
     float3 sun_col;
     float3 sky_col;
     float sun_softness;
-    float pad[3];
+    ushort env_map_res[2], env_cells_res[2];
+    float pad;
 } environment_t;
 
-typedef struct _ray_chunk_t {
-    uint hash, base, size;
-} ray_chunk_t;
+typedef struct _env_cell_t {
+    float q, pdf;
+    uint alias, pad;
+} env_cell_t;
 
-__kernel void TypesCheck(ray_packet_t r, camera_t c, tri_accel_t t, hit_data_t i,
+__kernel void TypesCheck(packed_ray_t r, camera_t c, tri_accel_t t, hit_data_t i,
                          bvh_node_t b, vertex_t v, mesh_t m, mesh_instance_t mi, transform_t tr,
-                         texture_t tex, material_t mat, environment_t env, ray_chunk_t ch) {}
+                         texture_t tex, material_t mat, environment_t env, env_cell_t cell) {}
+
+uint EncodeOctahedral(float3 n) {
+    n /= (fabs(n.x) + fabs(n.y) + fabs(n.z));
+    float2 p = n.xy;
+    if (n.z < 0.0f) {
+        p = (1.0f - fabs(n.yx)) * copysign((float2)(1.0f, 1.0f), n.xy);
+    }
+    return as_uint(convert_short2_rte(clamp(p, -1.0f, 1.0f) * 32767.0f));
+}
+
+float3 DecodeOctahedral(uint e) {
+    const float2 p = convert_float2(as_short2(e)) * (1.0f / 32767.0f);
+    float3 n = (float3)(p, 1.0f - fabs(p.x) - fabs(p.y));
+    const float t = fmax(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+packed_ray_t PackRay(const ray_packet_t *r) {
+    packed_ray_t pr;
+    pr.o[0] = r->o.x;
+    pr.o[1] = r->o.y;
+    pr.o[2] = r->o.z;
+    pr.id = ((uint)r->o.w & 0x3fff) | (((uint)r->d.w & 0x3fff) << 14) | ((uint)r->depth << 28);
+    pr.d = EncodeOctahedral(r->d.xyz);
+    vstore_half4(r->c, 0, (half *)pr.c);
+    vstore_half3(r->do_dx, 0, (half *)pr.do_dx);
+    vstore_half3(r->dd_dx, 0, (half *)pr.dd_dx);
+    vstore_half3(r->do_dy, 0, (half *)pr.do_dy);
+    vstore_half3(r->dd_dy, 0, (half *)pr.dd_dy);
+    pr.pdf = r->pdf;
+    return pr;
+}
+
+ray_packet_t UnpackRay(const packed_ray_t pr) {
+    ray_packet_t r;
+    r.o = (float4)(pr.o[0], pr.o[1], pr.o[2], (float)(pr.id & 0x3fff));
+    r.d = (float4)(DecodeOctahedral(pr.d), (float)((pr.id >> 14) & 0x3fff));
+    r.c = vload_half4(0, (const half *)pr.c);
+    r.do_dx = vload_half3(0, (const half *)pr.do_dx);
+    r.dd_dx = vload_half3(0, (const half *)pr.dd_dx);
+    r.do_dy = vload_half3(0, (const half *)pr.do_dy);
+    r.dd_dy = vload_half3(0, (const half *)pr.dd_dy);
+    r.depth = (int)(pr.id >> 28);
+    r.pdf = pr.pdf;
+    return r;
+}
 
 )"
\ No newline at end of file
@@ -9,8 +9,14 @@
 inline void cpuid(int info[4], int InfoType) {
     __cpuid_count(InfoType, 0, info[0], info[1], info[2], info[3]);
 }
+inline unsigned long long xgetbv(unsigned int index) {
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((unsigned long long)edx << 32) | eax;
+}
 #else
 #define cpuid(info, x)    __cpuidex(info, x, 0)
+#define xgetbv(index)     _xgetbv(index)
 #endif
 
 #else
@@ -21,13 +27,18 @@ inline void cpuid(int info[4], int InfoType) {
 inline void cpuid(int info[4], int InfoType) {
     __cpuid_count(InfoType, 0, info[0], info[1], info[2], info[3]);
 }
+inline unsigned long long xgetbv(unsigned int index) {
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(index));
+    return ((unsigned long long)edx << 32) | eax;
+}
 #endif
 
 #endif
 
 namespace ray {
     struct CpuFeatures {
-        bool sse2_supported, avx_supported;
+        bool sse2_supported, avx_supported, avx2_supported, fma_supported;
     };
 
     inline CpuFeatures GetCpuFeatures() {
@@ -35,6 +46,8 @@ namespace ray {
 
         ret.sse2_supported = false;
         ret.avx_supported = false;
+        ret.avx2_supported = false;
+        ret.fma_supported = false;
 #if !defined(__ANDROID__)
         int info[4];
         cpuid(info, 0);
@@ -48,6 +61,18 @@ namespace ray {
             cpuid(info, 0x00000001);
             ret.sse2_supported = (info[3] & ((int)1 << 26)) != 0;
             ret.avx_supported = (info[2] & ((int)1 << 28)) != 0;
+            ret.fma_supported = (info[2] & ((int)1 << 12)) != 0;
+
+            // AVX registers are usable only if OS saves them on context switch (OSXSAVE is set and XCR0 has XMM and YMM state bits)
+            const bool os_saves_ymm = (info[2] & ((int)1 << 27)) != 0 && (xgetbv(0) & 0x6) == 0x6;
+            if (!os_saves_ymm) {
+                ret.avx_supported = false;
+                ret.fma_supported = false;
+            }
+        }
+        if (nIds >= 0x00000007) {
+            cpuid(info, 0x00000007);
+            ret.avx2_supported = ret.avx_supported && (info[1] & ((int)1 << 5)) != 0;
         }
 #elif defined(__i386__) || defined(__x86_64__)
         ret.sse2_supported = true;
@@ -57,4 +82,5 @@ namespace ray {
     }
 }
 
-#undef cpuid
\ No newline at end of file
+#undef cpuid
+#undef xgetbv
\ No newline at end of file
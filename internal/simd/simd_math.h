@@ -0,0 +1,265 @@
+//#pragma once
+// Included from simd_vec.h with NS defined. Functions are composed of simd_vec operations only,
+// so each backend gets them in its native width
+
+#include <limits>
+
+namespace ray {
+namespace NS {
+namespace simd_math {
+const float LOG2E = 1.44269504088896341f;
+const float LN2 = 0.693147180559945309f, LN2_HI = 0.693359375f, LN2_LO = -2.12194440e-4f;
+const float SQRT2 = 1.41421356237309505f;
+const float PI = 3.14159265358979323846f, PI_2 = 1.57079632679489661923f;
+// pi / 4 split into three parts, so that argument reduction is exact for moderate arguments
+const float FOPI = 1.27323954473516f, DP1 = 0.78515625f, DP2 = 2.4187564849853515625e-4f, DP3 = 3.77489497744594108e-8f;
+
+template <typename T, int S>
+force_inline const simd_vec<T, S> &as(const simd_vec<typename std::conditional<std::is_same<T, int>::value, float, int>::type, S> &v) {
+    return reinterpret_cast<const simd_vec<T, S>&>(v);
+}
+
+/// e^r for r in [-ln(2) / 2, ln(2) / 2] (cephes expf polynomial)
+template <int S>
+force_inline simd_fvec<S> exp_poly(const simd_fvec<S> &r) {
+    simd_fvec<S> p = fmadd(r, 1.9875691500e-4f, simd_fvec<S>{ 1.3981999507e-3f });
+    p = fmadd(p, r, simd_fvec<S>{ 8.3334519073e-3f });
+    p = fmadd(p, r, simd_fvec<S>{ 4.1665795894e-2f });
+    p = fmadd(p, r, simd_fvec<S>{ 1.6666665459e-1f });
+    p = fmadd(p, r, simd_fvec<S>{ 5.0000001201e-1f });
+    return fmadd(p, r * r, r + 1.0f);
+}
+
+/// 2^n for integral n in [-126, 127]
+template <int S>
+force_inline simd_fvec<S> pow2i(const simd_fvec<S> &n) {
+    const simd_ivec<S> bits = ((simd_ivec<S>)n + simd_ivec<S>{ 127 }) << 23;
+    return as<float>(bits);
+}
+
+/// Splits positive normal x into exponent e and mantissa m in [sqrt(0.5), sqrt(2)), returns ln(m)
+template <int S>
+force_inline simd_fvec<S> log_mantissa(const simd_fvec<S> &x, simd_fvec<S> &out_e) {
+    const simd_ivec<S> &bits = as<int>(x);
+
+    out_e = (simd_fvec<S>)((bits >> 23) - simd_ivec<S>{ 127 });
+    simd_ivec<S> mbits = (bits & simd_ivec<S>{ 0x007fffff }) | simd_ivec<S>{ 0x3f800000 };
+    simd_fvec<S> m = as<float>(mbits);
+
+    const simd_fvec<S> big = m > SQRT2;
+    where(big, m) = m * 0.5f;
+    where(big, out_e) = out_e + 1.0f;
+
+    // ln(m) = 2 * atanh(s), series converges quickly as |s| < 0.172
+    const simd_fvec<S> s = (m - 1.0f) / (m + 1.0f), s2 = s * s;
+    simd_fvec<S> p = fmadd(s2, 1.0f / 9, simd_fvec<S>{ 1.0f / 7 });
+    p = fmadd(p, s2, simd_fvec<S>{ 1.0f / 5 });
+    p = fmadd(p, s2, simd_fvec<S>{ 1.0f / 3 });
+    return fmadd(p * s2, 2.0f * s, 2.0f * s);
+}
+
+/// Restores results of log for zero, negative and infinite arguments
+template <int S>
+force_inline void log_special_cases(const simd_fvec<S> &x, simd_fvec<S> &ret) {
+    where(x <= 0.0f, ret) = -std::numeric_limits<float>::infinity();
+    where(x < 0.0f, ret) = std::numeric_limits<float>::quiet_NaN();
+    where(x > std::numeric_limits<float>::max(), ret) = std::numeric_limits<float>::infinity();
+}
+
+/// Restores results of exp for arguments outside of normal range
+template <int S>
+force_inline void exp_special_cases(const simd_fvec<S> &x, float min_x, float max_x, simd_fvec<S> &ret) {
+    where(x < min_x, ret) = 0.0f;
+    where(x > max_x, ret) = std::numeric_limits<float>::infinity();
+}
+
+/// sin or cos polynomial for r in [-pi/4, pi/4] is selected by quadrant, sign_bits are applied to result
+template <int S>
+force_inline simd_fvec<S> sincos_poly(const simd_fvec<S> &r, const simd_ivec<S> &use_cos, const simd_ivec<S> &sign_bits) {
+    const simd_fvec<S> z = r * r;
+
+    simd_fvec<S> ps = fmadd(z, -1.9515295891e-4f, simd_fvec<S>{ 8.3321608736e-3f });
+    ps = fmadd(ps, z, simd_fvec<S>{ -1.6666654611e-1f });
+    ps = fmadd(ps * z, r, r);
+
+    simd_fvec<S> pc = fmadd(z, 2.443315711809948e-5f, simd_fvec<S>{ -1.388731625493765e-3f });
+    pc = fmadd(pc, z, simd_fvec<S>{ 4.166664568298827e-2f });
+    pc = fmadd(pc * z, z, fmadd(z, -0.5f, simd_fvec<S>{ 1.0f }));
+
+    where(as<float>(use_cos), ps) = pc;
+    return as<float>(as<int>(ps) ^ sign_bits);
+}
+
+/// Reduces |x| to [-pi/4, pi/4], returns octant (always even)
+template <int S>
+force_inline simd_ivec<S> reduce_pi4(const simd_fvec<S> &ax, simd_fvec<S> &out_r) {
+    simd_ivec<S> j = (simd_ivec<S>)floor(ax * FOPI);
+    j = (j + simd_ivec<S>{ 1 }) & simd_ivec<S>{ ~1 };
+
+    const simd_fvec<S> y = (simd_fvec<S>)j;
+    out_r = fmadd(y, -DP3, fmadd(y, -DP2, fmadd(y, -DP1, ax)));
+    return j;
+}
+
+/// asin(x) for x in [0, 0.5] (cephes asinf polynomial)
+template <int S>
+force_inline simd_fvec<S> asin_poly(const simd_fvec<S> &x, const simd_fvec<S> &z) {
+    simd_fvec<S> p = fmadd(z, 4.2163199048e-2f, simd_fvec<S>{ 2.4181311049e-2f });
+    p = fmadd(p, z, simd_fvec<S>{ 4.5470025998e-2f });
+    p = fmadd(p, z, simd_fvec<S>{ 7.4953002686e-2f });
+    p = fmadd(p, z, simd_fvec<S>{ 1.6666752422e-1f });
+    return fmadd(p * z, x, x);
+}
+
+/// atan(x) for x in [0, 1] (cephes atanf polynomial with reduction around tan(pi/8))
+template <int S>
+force_inline simd_fvec<S> atan_poly(const simd_fvec<S> &x) {
+    const simd_fvec<S> mid = x > 0.4142135623730950f;
+
+    simd_fvec<S> xr = x, offset = { 0.0f };
+    where(mid, xr) = (x - 1.0f) / (x + 1.0f);
+    where(mid, offset) = 0.25f * PI;
+
+    const simd_fvec<S> z = xr * xr;
+    simd_fvec<S> p = fmadd(z, 8.05374449538e-2f, simd_fvec<S>{ -1.38776856032e-1f });
+    p = fmadd(p, z, simd_fvec<S>{ 1.99777106478e-1f });
+    p = fmadd(p, z, simd_fvec<S>{ -3.33329491539e-1f });
+    return fmadd(p * z, xr, xr) + offset;
+}
+}
+
+/** Polynomial approximations of math functions. Results are within few ULP of libm (see test_simd)
+    for normal arguments; denormal results are flushed to zero. pow error grows with |y * log2(x)|,
+    sin/cos expect |x| < 8192
+*/
+
+template <int S>
+force_inline simd_fvec<S> exp2(const simd_fvec<S> &x) {
+    using namespace simd_math;
+    const simd_fvec<S> _x = min(max(x, simd_fvec<S>{ -126.0f }), simd_fvec<S>{ 127.0f });
+    const simd_fvec<S> n = floor(_x + 0.5f);
+
+    simd_fvec<S> ret = exp_poly((_x - n) * LN2) * pow2i(n);
+    exp_special_cases(x, -126.0f, 127.0f, ret);
+    return ret;
+}
+
+template <int S>
+force_inline simd_fvec<S> exp(const simd_fvec<S> &x) {
+    using namespace simd_math;
+    const float MinX = -87.3f, MaxX = 88.0f;
+
+    const simd_fvec<S> _x = min(max(x, simd_fvec<S>{ MinX }), simd_fvec<S>{ MaxX });
+    const simd_fvec<S> n = floor(fmadd(_x, LOG2E, simd_fvec<S>{ 0.5f }));
+    const simd_fvec<S> r = fmadd(n, -LN2_LO, fmadd(n, -LN2_HI, _x));
+
+    simd_fvec<S> ret = exp_poly(r) * pow2i(n);
+    exp_special_cases(x, MinX, MaxX, ret);
+    return ret;
+}
+
+template <int S>
+force_inline simd_fvec<S> log2(const simd_fvec<S> &x) {
+    using namespace simd_math;
+    simd_fvec<S> e;
+    const simd_fvec<S> lm = log_mantissa(x, e);
+
+    simd_fvec<S> ret = fmadd(lm, LOG2E, e);
+    log_special_cases(x, ret);
+    return ret;
+}
+
+template <int S>
+force_inline simd_fvec<S> log(const simd_fvec<S> &x) {
+    using namespace simd_math;
+    simd_fvec<S> e;
+    const simd_fvec<S> lm = log_mantissa(x, e);
+
+    simd_fvec<S> ret = fmadd(e, LN2_HI, fmadd(e, LN2_LO, lm));
+    log_special_cases(x, ret);
+    return ret;
+}
+
+/// x^y for non-negative x
+template <int S>
+force_inline simd_fvec<S> pow(const simd_fvec<S> &x, const simd_fvec<S> &y) {
+    simd_fvec<S> ret = exp2(y * log2(x));
+    // 0^0 is 1, as in libm
+    where((x <= 0.0f) & (y > 0.0f), ret) = 0.0f;
+    where((y <= 0.0f) & (y >= 0.0f), ret) = 1.0f;
+    return ret;
+}
+
+template <int S>
+force_inline simd_fvec<S> pow(const simd_fvec<S> &x, float y) {
+    return pow(x, simd_fvec<S>{ y });
+}
+
+template <int S>
+force_inline void sincos(const simd_fvec<S> &x, simd_fvec<S> &out_sin, simd_fvec<S> &out_cos) {
+    using namespace simd_math;
+    const simd_ivec<S> sign_mask = { int(0x80000000) };
+
+    simd_fvec<S> r;
+    const simd_ivec<S> j = reduce_pi4(abs(x), r);
+    const simd_ivec<S> use_cos = (j & simd_ivec<S>{ 2 }) == 2;
+
+    // octants 4, 6 negate sine (and input sign is restored), octants 2, 4 negate cosine
+    out_sin = sincos_poly(r, use_cos, ((j & simd_ivec<S>{ 4 }) << 29) ^ (as<int>(x) & sign_mask));
+    out_cos = sincos_poly(r, use_cos ^ simd_ivec<S>{ -1 }, ((j + simd_ivec<S>{ 2 }) & simd_ivec<S>{ 4 }) << 29);
+}
+
+template <int S>
+force_inline simd_fvec<S> sin(const simd_fvec<S> &x) {
+    using namespace simd_math;
+    const simd_ivec<S> sign_mask = { int(0x80000000) };
+
+    simd_fvec<S> r;
+    const simd_ivec<S> j = reduce_pi4(abs(x), r);
+    return sincos_poly(r, (j & simd_ivec<S>{ 2 }) == 2, ((j & simd_ivec<S>{ 4 }) << 29) ^ (as<int>(x) & sign_mask));
+}
+
+template <int S>
+force_inline simd_fvec<S> cos(const simd_fvec<S> &x) {
+    using namespace simd_math;
+
+    simd_fvec<S> r;
+    const simd_ivec<S> j = reduce_pi4(abs(x), r);
+    return sincos_poly(r, (j & simd_ivec<S>{ 2 }) == 0, ((j + simd_ivec<S>{ 2 }) & simd_ivec<S>{ 4 }) << 29);
+}
+
+template <int S>
+force_inline simd_fvec<S> acos(const simd_fvec<S> &x) {
+    using namespace simd_math;
+    const simd_fvec<S> ax = abs(x);
+    const simd_fvec<S> big = ax > 0.5f;
+
+    // acos(|x|) = 2 * asin(sqrt((1 - |x|) / 2)) close to 1, pi/2 - asin(|x|) otherwise
+    simd_fvec<S> z = ax * ax, xx = ax;
+    where(big, z) = 0.5f - 0.5f * ax;
+    where(big, xx) = sqrt(z);
+
+    const simd_fvec<S> p = asin_poly(xx, z);
+
+    simd_fvec<S> ret = PI_2 - p;
+    where(big, ret) = 2.0f * p;
+    where(x < 0.0f, ret) = PI - ret;
+    return ret;
+}
+
+template <int S>
+force_inline simd_fvec<S> atan2(const simd_fvec<S> &y, const simd_fvec<S> &x) {
+    using namespace simd_math;
+    const simd_fvec<S> ax = abs(x), ay = abs(y);
+    const simd_fvec<S> num = min(ax, ay), den = max(ax, ay);
+
+    simd_fvec<S> ret = atan_poly(num / den);
+    where(den <= 0.0f, ret) = 0.0f;
+
+    where(ay > ax, ret) = PI_2 - ret;
+    where(x < 0.0f, ret) = PI - ret;
+    where(y < 0.0f, ret) = -ret;
+    return ret;
+}
+}
+}
@@ -314,6 +314,24 @@ public:
         return temp;
     }
 
+    force_inline static simd_vec<T, S> fmadd(const simd_vec<T, S> &a, const simd_vec<T, S> &b, const simd_vec<T, S> &c) {
+        simd_vec<T, S> ret;
+        ITERATE(S, { ret.comp_[i] = a.comp_[i] * b.comp_[i] + c.comp_[i]; })
+        return ret;
+    }
+
+    force_inline static simd_vec<T, S> fmsub(const simd_vec<T, S> &a, const simd_vec<T, S> &b, const simd_vec<T, S> &c) {
+        simd_vec<T, S> ret;
+        ITERATE(S, { ret.comp_[i] = a.comp_[i] * b.comp_[i] - c.comp_[i]; })
+        return ret;
+    }
+
+    force_inline static simd_vec<T, S> gather(const T *base, const simd_vec<int, S> &index) {
+        simd_vec<T, S> ret;
+        ITERATE(S, { ret.comp_[i] = base[index[i]]; })
+        return ret;
+    }
+
     force_inline static simd_vec<T, S> and_not(const simd_vec<T, S> &v1, const simd_vec<T, S> &v2) {
         const auto *src1 = reinterpret_cast<const uint8_t*>(&v1.comp_[0]);
         const auto *src2 = reinterpret_cast<const uint8_t*>(&v2.comp_[0]);
@@ -492,12 +510,6 @@ public:
         return ret;
     }
 
-    friend force_inline simd_vec<T, S> pow(const simd_vec<T, S> &v1, const simd_vec<T, S> &v2) {
-        simd_vec<T, S> ret;
-        ITERATE(S, { ret.comp_[i] = std::pow(v1.comp_[i], v2.comp_[i]); })
-        return ret;
-    }
-
     friend force_inline simd_vec<T, S> normalize(const simd_vec<T, S> &v1) {
         return v1 / v1.length();
     }
@@ -531,10 +543,28 @@ force_inline simd_vec<T, S> min(const simd_vec<T, S> &v1, const simd_vec<T, S> &
 template <typename T, int S>
 force_inline simd_vec<T, S> max(const simd_vec<T, S> &v1, const simd_vec<T, S> &v2) { return simd_vec<T, S>::max(v1, v2); }
 
-template <typename T, int S>
-force_inline simd_vec<T, S> abs(const simd_vec<T, S> &v) {
-    // TODO: find faster implementation
-    return max(v, -v);
+/// a * b + c, fused into single instruction where it is available (results can differ in last bit)
+template <typename T, int S>
+force_inline simd_vec<T, S> fmadd(const simd_vec<T, S> &a, const simd_vec<T, S> &b, const simd_vec<T, S> &c) { return simd_vec<T, S>::fmadd(a, b, c); }
+
+template <typename T, int S>
+force_inline simd_vec<T, S> fmadd(const simd_vec<T, S> &a, T b, const simd_vec<T, S> &c) { return simd_vec<T, S>::fmadd(a, simd_vec<T, S>{ b }, c); }
+
+/// a * b - c
+template <typename T, int S>
+force_inline simd_vec<T, S> fmsub(const simd_vec<T, S> &a, const simd_vec<T, S> &b, const simd_vec<T, S> &c) { return simd_vec<T, S>::fmsub(a, b, c); }
+
+template <typename T, int S>
+force_inline simd_vec<T, S> fmsub(const simd_vec<T, S> &a, T b, const simd_vec<T, S> &c) { return simd_vec<T, S>::fmsub(a, simd_vec<T, S>{ b }, c); }
+
+/// Loads base[index[i]] into each component, all indices must be valid
+template <typename T, int S>
+force_inline simd_vec<T, S> gather(const T *base, const simd_vec<int, S> &index) { return simd_vec<T, S>::gather(base, index); }
+
+template <typename T, int S>
+force_inline simd_vec<T, S> abs(const simd_vec<T, S> &v) {
+    // TODO: find faster implementation
+    return max(v, -v);
 }
 
 template <typename T, int S>
@@ -596,6 +626,8 @@ using native_simd_ivec = simd_ivec<1>;
 }
 #endif
 
+#include "simd_math.h"
+
 #ifdef __GNUC__
 #pragma GCC diagnostic pop
 #endif
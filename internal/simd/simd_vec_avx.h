@@ -4,10 +4,20 @@
 
 #include <immintrin.h>
 
-#ifdef __GNUC__
+#if defined(__clang__)
+#if defined(USE_AVX2)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#endif
+#elif defined(__GNUC__)
 #pragma GCC push_options
+#if defined(USE_AVX2)
+#pragma GCC target ("avx2,fma")
+#else
 #pragma GCC target ("avx")
 #endif
+#endif
 
 #if defined(__GNUC__)
 #define _mm256_test_all_zeros(mask, val) \
@@ -20,8 +30,76 @@
 namespace ray {
 namespace NS {
 
+#if defined(USE_AVX2)
+force_inline __m256i i256_add(__m256i a, __m256i b) { return _mm256_add_epi32(a, b); }
+force_inline __m256i i256_sub(__m256i a, __m256i b) { return _mm256_sub_epi32(a, b); }
+force_inline __m256i i256_mullo(__m256i a, __m256i b) { return _mm256_mullo_epi32(a, b); }
+force_inline __m256i i256_cmpeq(__m256i a, __m256i b) { return _mm256_cmpeq_epi32(a, b); }
+force_inline __m256i i256_cmpgt(__m256i a, __m256i b) { return _mm256_cmpgt_epi32(a, b); }
+force_inline __m256i i256_min(__m256i a, __m256i b) { return _mm256_min_epi32(a, b); }
+force_inline __m256i i256_max(__m256i a, __m256i b) { return _mm256_max_epi32(a, b); }
+force_inline __m256i i256_and(__m256i a, __m256i b) { return _mm256_and_si256(a, b); }
+force_inline __m256i i256_or(__m256i a, __m256i b) { return _mm256_or_si256(a, b); }
+force_inline __m256i i256_xor(__m256i a, __m256i b) { return _mm256_xor_si256(a, b); }
+force_inline __m256i i256_andnot(__m256i a, __m256i b) { return _mm256_andnot_si256(a, b); }
+force_inline __m256i i256_blendv(__m256i a, __m256i b, __m256i mask) { return _mm256_blendv_epi8(a, b, mask); }
+force_inline __m256i i256_srli(__m256i a, int n) { return _mm256_srli_epi32(a, n); }
+force_inline __m256i i256_slli(__m256i a, int n) { return _mm256_slli_epi32(a, n); }
+force_inline __m256i i256_srlv(__m256i a, __m256i n) { return _mm256_srlv_epi32(a, n); }
+force_inline __m256i i256_sllv(__m256i a, __m256i n) { return _mm256_sllv_epi32(a, n); }
+#else
+// AVX has no 256-bit integer instructions, they are emulated with 128-bit halves or floating point bit operations
+
+#define I256_SPLIT(op, a, b) \
+    _mm256_insertf128_si256(_mm256_castsi128_si256(op(_mm256_castsi256_si128(a), _mm256_castsi256_si128(b))), \
+                            op(_mm256_extractf128_si256(a, 1), _mm256_extractf128_si256(b, 1)), 1)
+#define I256_BITS(op, a, b) _mm256_castps_si256(op(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b)))
+
+force_inline __m256i i256_add(__m256i a, __m256i b) { return I256_SPLIT(_mm_add_epi32, a, b); }
+force_inline __m256i i256_sub(__m256i a, __m256i b) { return I256_SPLIT(_mm_sub_epi32, a, b); }
+force_inline __m256i i256_mullo(__m256i a, __m256i b) { return I256_SPLIT(_mm_mullo_epi32, a, b); }
+force_inline __m256i i256_cmpeq(__m256i a, __m256i b) { return I256_SPLIT(_mm_cmpeq_epi32, a, b); }
+force_inline __m256i i256_cmpgt(__m256i a, __m256i b) { return I256_SPLIT(_mm_cmpgt_epi32, a, b); }
+force_inline __m256i i256_min(__m256i a, __m256i b) { return I256_SPLIT(_mm_min_epi32, a, b); }
+force_inline __m256i i256_max(__m256i a, __m256i b) { return I256_SPLIT(_mm_max_epi32, a, b); }
+force_inline __m256i i256_and(__m256i a, __m256i b) { return I256_BITS(_mm256_and_ps, a, b); }
+force_inline __m256i i256_or(__m256i a, __m256i b) { return I256_BITS(_mm256_or_ps, a, b); }
+force_inline __m256i i256_xor(__m256i a, __m256i b) { return I256_BITS(_mm256_xor_ps, a, b); }
+force_inline __m256i i256_andnot(__m256i a, __m256i b) { return I256_BITS(_mm256_andnot_ps, a, b); }
+force_inline __m256i i256_blendv(__m256i a, __m256i b, __m256i mask) {
+    // masks are made of whole lanes, so sign bit is enough
+    return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _mm256_castsi256_ps(mask)));
+}
+force_inline __m256i i256_srli(__m256i a, int n) {
+    const __m128i _n = _mm_cvtsi32_si128(n);
+    return _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_srl_epi32(_mm256_castsi256_si128(a), _n)), _mm_srl_epi32(_mm256_extractf128_si256(a, 1), _n), 1);
+}
+force_inline __m256i i256_slli(__m256i a, int n) {
+    const __m128i _n = _mm_cvtsi32_si128(n);
+    return _mm256_insertf128_si256(_mm256_castsi128_si256(_mm_sll_epi32(_mm256_castsi256_si128(a), _n)), _mm_sll_epi32(_mm256_extractf128_si256(a, 1), _n), 1);
+}
+force_inline __m256i i256_srlv(__m256i a, __m256i n) {
+    alignas(32) uint32_t _a[8], _n[8];
+    _mm256_store_si256((__m256i *)_a, a);
+    _mm256_store_si256((__m256i *)_n, n);
+    ITERATE_8({ _a[i] >>= _n[i]; })
+    return _mm256_load_si256((const __m256i *)_a);
+}
+force_inline __m256i i256_sllv(__m256i a, __m256i n) {
+    alignas(32) uint32_t _a[8], _n[8];
+    _mm256_store_si256((__m256i *)_a, a);
+    _mm256_store_si256((__m256i *)_n, n);
+    ITERATE_8({ _a[i] <<= _n[i]; })
+    return _mm256_load_si256((const __m256i *)_a);
+}
+
+#undef I256_BITS
+#undef I256_SPLIT
+#endif
+
+// alignment is explicit, __m256 gets only 16 bytes when AVX is enabled with target pragma rather than compiler flag
 template <int S>
-class simd_vec<typename std::enable_if<S == 8, float>::type, S> {
+class alignas(32) simd_vec<typename std::enable_if<S == 8, float>::type, S> {
     public:
     union {
         __m256 vec_;
@@ -150,6 +228,36 @@ public:
         return temp;
     }
 
+    force_inline static simd_vec<float, S> fmadd(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+#if defined(USE_AVX2)
+        temp.vec_ = _mm256_fmadd_ps(a.vec_, b.vec_, c.vec_);
+#else
+        temp.vec_ = _mm256_add_ps(_mm256_mul_ps(a.vec_, b.vec_), c.vec_);
+#endif
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> fmsub(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+#if defined(USE_AVX2)
+        temp.vec_ = _mm256_fmsub_ps(a.vec_, b.vec_, c.vec_);
+#else
+        temp.vec_ = _mm256_sub_ps(_mm256_mul_ps(a.vec_, b.vec_), c.vec_);
+#endif
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> gather(const float *base, const simd_vec<int, S> &index) {
+        simd_vec<float, S> temp;
+#if defined(USE_AVX2)
+        temp.vec_ = _mm256_i32gather_ps(base, index.vec_, sizeof(float));
+#else
+        ITERATE_8({ temp.comp_[i] = base[index.comp_[i]]; })
+#endif
+        return temp;
+    }
+
     friend force_inline simd_vec<float, S> operator&(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
         simd_vec<float, S> temp;
         temp.vec_ = _mm256_and_ps(v1.vec_, v2.vec_);
@@ -294,12 +402,6 @@ public:
         return ret;
     }
 
-    friend force_inline simd_vec<float, S> pow(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
-        simd_vec<float, S> ret;
-        ITERATE_8({ ret.comp_[i] = std::pow(v1.comp_[i], v2.comp_[i]); })
-        return ret;
-    }
-
     friend force_inline simd_vec<float, S> normalize(const simd_vec<float, S> &v1) {
         return v1 / v1.length();
     }
@@ -313,7 +415,7 @@ public:
 };
 
 template <int S>
-class simd_vec<typename std::enable_if<S == 8, int>::type, S> {
+class alignas(32) simd_vec<typename std::enable_if<S == 8, int>::type, S> {
     union {
         __m256i vec_;
         int comp_[8];
@@ -339,32 +441,32 @@ public:
     force_inline int operator[](int i) const { return comp_[i]; }
 
     force_inline simd_vec<int, S> &operator+=(const simd_vec<int, S> &rhs) {
-        vec_ = _mm256_add_epi32(vec_, rhs.vec_);
+        vec_ = i256_add(vec_, rhs.vec_);
         return *this;
     }
 
     force_inline simd_vec<int, S> &operator+=(int rhs) {
-        vec_ = _mm256_add_epi32(vec_, _mm256_set1_epi32(rhs));
+        vec_ = i256_add(vec_, _mm256_set1_epi32(rhs));
         return *this;
     }
 
     force_inline simd_vec<int, S> &operator-=(const simd_vec<int, S> &rhs) {
-        vec_ = _mm256_sub_epi32(vec_, rhs.vec_);
+        vec_ = i256_sub(vec_, rhs.vec_);
         return *this;
     }
 
     force_inline simd_vec<int, S> &operator-=(int rhs) {
-        vec_ = _mm256_sub_epi32(vec_, _mm256_set1_epi32(rhs));
+        vec_ = i256_sub(vec_, _mm256_set1_epi32(rhs));
         return *this;
     }
 
     force_inline simd_vec<int, S> &operator*=(const simd_vec<int, S> &rhs) {
-        ITERATE_8({ comp_[i] = comp_[i] * rhs.comp_[i]; })
+        vec_ = i256_mullo(vec_, rhs.vec_);
         return *this;
     }
 
     force_inline simd_vec<int, S> &operator*=(int rhs) {
-        ITERATE_8({ comp_[i] = comp_[i] * rhs; })
+        vec_ = i256_mullo(vec_, _mm256_set1_epi32(rhs));
         return *this;
     }
 
@@ -380,25 +482,25 @@ public:
 
     force_inline simd_vec<int, S> operator==(int rhs) const {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_cmpeq_epi32(vec_, _mm256_set1_epi32(rhs));
+        ret.vec_ = i256_cmpeq(vec_, _mm256_set1_epi32(rhs));
         return ret;
     }
 
     force_inline simd_vec<int, S> operator==(const simd_vec<int, S> &rhs) const {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_cmpeq_epi32(vec_, rhs.vec_);
+        ret.vec_ = i256_cmpeq(vec_, rhs.vec_);
         return ret;
     }
 
     force_inline simd_vec<int, S> operator!=(int rhs) const {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_andnot_si256(_mm256_cmpeq_epi32(vec_, _mm256_set1_epi32(rhs)), _mm256_set1_epi32(~0));
+        ret.vec_ = i256_andnot(i256_cmpeq(vec_, _mm256_set1_epi32(rhs)), _mm256_set1_epi32(~0));
         return ret;
     }
 
     force_inline simd_vec<int, S> operator!=(const simd_vec<int, S> &rhs) const {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_andnot_si256(_mm256_cmpeq_epi32(vec_, rhs.vec_), _mm256_set1_epi32(~0));
+        ret.vec_ = i256_andnot(i256_cmpeq(vec_, rhs.vec_), _mm256_set1_epi32(~0));
         return ret;
     }
 
@@ -417,7 +519,7 @@ public:
     }
 
     force_inline void blend_to(const simd_vec<int, S> &mask, const simd_vec<int, S> &v1) {
-        vec_ = _mm256_blendv_epi8(vec_, v1.vec_, mask.vec_);
+        vec_ = i256_blendv(vec_, v1.vec_, mask.vec_);
     }
 
     force_inline bool all_zeros() const {
@@ -435,55 +537,65 @@ public:
 
     force_inline static simd_vec<int, S> min(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_min_epi32(v1.vec_, v2.vec_);
+        temp.vec_ = i256_min(v1.vec_, v2.vec_);
         return temp;
     }
 
     force_inline static simd_vec<int, S> max(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_max_epi32(v1.vec_, v2.vec_);
+        temp.vec_ = i256_max(v1.vec_, v2.vec_);
+        return temp;
+    }
+
+    force_inline static simd_vec<int, S> gather(const int *base, const simd_vec<int, S> &index) {
+        simd_vec<int, S> temp;
+#if defined(USE_AVX2)
+        temp.vec_ = _mm256_i32gather_epi32(base, index.vec_, sizeof(int));
+#else
+        ITERATE_8({ temp.comp_[i] = base[index.comp_[i]]; })
+#endif
         return temp;
     }
 
     force_inline static simd_vec<int, S> and_not(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_andnot_si256(v1.vec_, v2.vec_);
+        temp.vec_ = i256_andnot(v1.vec_, v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator&(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_and_si256(v1.vec_, v2.vec_);
+        temp.vec_ = i256_and(v1.vec_, v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator|(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_or_si256(v1.vec_, v2.vec_);
+        temp.vec_ = i256_or(v1.vec_, v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator^(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_xor_si256(v1.vec_, v2.vec_);
+        temp.vec_ = i256_xor(v1.vec_, v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator+(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_add_epi32(v1.vec_, v2.vec_);
+        temp.vec_ = i256_add(v1.vec_, v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator-(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_sub_epi32(v1.vec_, v2.vec_);
+        temp.vec_ = i256_sub(v1.vec_, v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator*(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        ITERATE_8({ temp.comp_[i] = v1.comp_[i] * v2.comp_[i]; })
+        temp.vec_ = i256_mullo(v1.vec_, v2.vec_);
         return temp;
     }
 
@@ -495,19 +607,19 @@ public:
 
     friend force_inline simd_vec<int, S> operator+(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_add_epi32(v1.vec_, _mm256_set1_epi32(v2));
+        temp.vec_ = i256_add(v1.vec_, _mm256_set1_epi32(v2));
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator-(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_sub_epi32(v1.vec_, _mm256_set1_epi32(v2));
+        temp.vec_ = i256_sub(v1.vec_, _mm256_set1_epi32(v2));
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator*(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> temp;
-        ITERATE_8({ temp.comp_[i] = v1.comp_[i] * v2; })
+        temp.vec_ = i256_mullo(v1.vec_, _mm256_set1_epi32(v2));
         return temp;
     }
 
@@ -519,19 +631,19 @@ public:
 
     friend force_inline simd_vec<int, S> operator+(int v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_add_epi32(_mm256_set1_epi32(v1), v2.vec_);
+        temp.vec_ = i256_add(_mm256_set1_epi32(v1), v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator-(int v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_sub_epi32(_mm256_set1_epi32(v1), v2.vec_);
+        temp.vec_ = i256_sub(_mm256_set1_epi32(v1), v2.vec_);
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator*(int v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        ITERATE_8({ temp.comp_[i] = v1 * v2.comp_[i]; })
+        temp.vec_ = i256_mullo(_mm256_set1_epi32(v1), v2.vec_);
         return temp;
     }
 
@@ -543,49 +655,724 @@ public:
 
     friend force_inline simd_vec<int, S> operator<(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_cmplt_epi32(v1.vec_, v2.vec_);
+        ret.vec_ = i256_cmpgt(v2.vec_, v1.vec_);
+        return ret;
+    }
+
+    friend force_inline simd_vec<int, S> operator>(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> ret;
+        ret.vec_ = i256_cmpgt(v1.vec_, v2.vec_);
+        return ret;
+    }
+
+    friend force_inline simd_vec<int, S> operator<(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> ret;
+        ret.vec_ = i256_cmpgt(_mm256_set1_epi32(v2), v1.vec_);
+        return ret;
+    }
+
+    friend force_inline simd_vec<int, S> operator>(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> ret;
+        ret.vec_ = i256_cmpgt(v1.vec_, _mm256_set1_epi32(v2));
+        return ret;
+    }
+
+    friend force_inline simd_vec<int, S> operator>>(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_ = i256_srlv(v1.vec_, v2.vec_);
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator>>(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> temp;
+        temp.vec_ = i256_srli(v1.vec_, v2);
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator<<(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_ = i256_sllv(v1.vec_, v2.vec_);
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator<<(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> temp;
+        temp.vec_ = i256_slli(v1.vec_, v2);
+        return temp;
+    }
+
+    static int size() { return S; }
+    static bool is_native() { return true; }
+};
+
+// 16-wide vectors are pairs of 8-wide ones, wider packets amortize per-node work of coherent rays
+
+template <int S>
+class alignas(32) simd_vec<typename std::enable_if<S == 16, float>::type, S> {
+    simd_vec<float, S / 2> vec_[2];
+
+    friend class simd_vec<int, S>;
+public:
+    force_inline simd_vec() = default;
+    force_inline simd_vec(float f) {
+        vec_[0] = vec_[1] = simd_vec<float, S / 2>{ f };
+    }
+    force_inline simd_vec(float f1, float f2, float f3, float f4, float f5, float f6, float f7, float f8,
+                          float f9, float f10, float f11, float f12, float f13, float f14, float f15, float f16) {
+        vec_[0] = { f1, f2, f3, f4, f5, f6, f7, f8 };
+        vec_[1] = { f9, f10, f11, f12, f13, f14, f15, f16 };
+    }
+    force_inline simd_vec(const float *f) {
+        vec_[0] = simd_vec<float, S / 2>{ f };
+        vec_[1] = simd_vec<float, S / 2>{ f + 8 };
+    }
+    force_inline simd_vec(const float *f, simd_mem_aligned_tag) {
+        vec_[0] = simd_vec<float, S / 2>{ f, simd_mem_aligned };
+        vec_[1] = simd_vec<float, S / 2>{ f + 8, simd_mem_aligned };
+    }
+
+    force_inline float &operator[](int i) { return vec_[i / 8][i % 8]; }
+    force_inline float operator[](int i) const { return vec_[i / 8][i % 8]; }
+
+    force_inline simd_vec<float, S> &operator+=(const simd_vec<float, S> &rhs) {
+        vec_[0] += rhs.vec_[0];
+        vec_[1] += rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator+=(float rhs) {
+        vec_[0] += rhs;
+        vec_[1] += rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator-=(const simd_vec<float, S> &rhs) {
+        vec_[0] -= rhs.vec_[0];
+        vec_[1] -= rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator-=(float rhs) {
+        vec_[0] -= rhs;
+        vec_[1] -= rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator*=(const simd_vec<float, S> &rhs) {
+        vec_[0] *= rhs.vec_[0];
+        vec_[1] *= rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator*=(float rhs) {
+        vec_[0] *= rhs;
+        vec_[1] *= rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator/=(const simd_vec<float, S> &rhs) {
+        vec_[0] /= rhs.vec_[0];
+        vec_[1] /= rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> &operator/=(float rhs) {
+        vec_[0] /= rhs;
+        vec_[1] /= rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<float, S> operator-() const {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = -vec_[0];
+        temp.vec_[1] = -vec_[1];
+        return temp;
+    }
+
+    force_inline operator simd_vec<int, S>() const {
+        simd_vec<int, S> ret;
+        ret.vec_[0] = (simd_vec<int, S / 2>)vec_[0];
+        ret.vec_[1] = (simd_vec<int, S / 2>)vec_[1];
+        return ret;
+    }
+
+    force_inline simd_vec<float, S> sqrt() const {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = vec_[0].sqrt();
+        temp.vec_[1] = vec_[1].sqrt();
+        return temp;
+    }
+
+    force_inline void copy_to(float *f) const {
+        vec_[0].copy_to(f);
+        vec_[1].copy_to(f + 8);
+    }
+
+    force_inline void copy_to(float *f, simd_mem_aligned_tag) const {
+        vec_[0].copy_to(f, simd_mem_aligned);
+        vec_[1].copy_to(f + 8, simd_mem_aligned);
+    }
+
+    force_inline void blend_to(const simd_vec<float, S> &mask, const simd_vec<float, S> &v1) {
+        vec_[0].blend_to(mask.vec_[0], v1.vec_[0]);
+        vec_[1].blend_to(mask.vec_[1], v1.vec_[1]);
+    }
+
+    force_inline static simd_vec<float, S> min(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::min(v1.vec_[0], v2.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::min(v1.vec_[1], v2.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> max(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::max(v1.vec_[0], v2.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::max(v1.vec_[1], v2.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> and_not(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::and_not(v1.vec_[0], v2.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::and_not(v1.vec_[1], v2.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> floor(const simd_vec<float, S> &v1) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::floor(v1.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::floor(v1.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> ceil(const simd_vec<float, S> &v1) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::ceil(v1.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::ceil(v1.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> fmadd(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::fmadd(a.vec_[0], b.vec_[0], c.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::fmadd(a.vec_[1], b.vec_[1], c.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> fmsub(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::fmsub(a.vec_[0], b.vec_[0], c.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::fmsub(a.vec_[1], b.vec_[1], c.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> gather(const float *base, const simd_vec<int, S> &index) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = simd_vec<float, S / 2>::gather(base, index.vec_[0]);
+        temp.vec_[1] = simd_vec<float, S / 2>::gather(base, index.vec_[1]);
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator&(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] & v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] & v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator|(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] | v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] | v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator^(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] ^ v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] ^ v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator+(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] + v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] + v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator-(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] - v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] - v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator*(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] * v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] * v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator/(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] / v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] / v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator+(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] + v2;
+        temp.vec_[1] = v1.vec_[1] + v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator-(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] - v2;
+        temp.vec_[1] = v1.vec_[1] - v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator*(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] * v2;
+        temp.vec_[1] = v1.vec_[1] * v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator/(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1.vec_[0] / v2;
+        temp.vec_[1] = v1.vec_[1] / v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator+(float v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1 + v2.vec_[0];
+        temp.vec_[1] = v1 + v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator-(float v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1 - v2.vec_[0];
+        temp.vec_[1] = v1 - v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator*(float v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1 * v2.vec_[0];
+        temp.vec_[1] = v1 * v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator/(float v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> temp;
+        temp.vec_[0] = v1 / v2.vec_[0];
+        temp.vec_[1] = v1 / v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<float, S> operator<(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] < v2.vec_[0];
+        ret.vec_[1] = v1.vec_[1] < v2.vec_[1];
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator<=(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] <= v2.vec_[0];
+        ret.vec_[1] = v1.vec_[1] <= v2.vec_[1];
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator>(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] > v2.vec_[0];
+        ret.vec_[1] = v1.vec_[1] > v2.vec_[1];
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator>=(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] >= v2.vec_[0];
+        ret.vec_[1] = v1.vec_[1] >= v2.vec_[1];
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator<(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] < v2;
+        ret.vec_[1] = v1.vec_[1] < v2;
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator<=(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] <= v2;
+        ret.vec_[1] = v1.vec_[1] <= v2;
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator>(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] > v2;
+        ret.vec_[1] = v1.vec_[1] > v2;
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> operator>=(const simd_vec<float, S> &v1, float v2) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = v1.vec_[0] >= v2;
+        ret.vec_[1] = v1.vec_[1] >= v2;
+        return ret;
+    }
+
+    friend force_inline simd_vec<float, S> clamp(const simd_vec<float, S> &v1, float min, float max) {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = clamp(v1.vec_[0], min, max);
+        ret.vec_[1] = clamp(v1.vec_[1], min, max);
+        return ret;
+    }
+
+    friend force_inline const float *value_ptr(const simd_vec<float, S> &v1) {
+        return value_ptr(v1.vec_[0]);
+    }
+
+    static int size() { return S; }
+    static bool is_native() { return true; }
+};
+
+template <int S>
+class alignas(32) simd_vec<typename std::enable_if<S == 16, int>::type, S> {
+    simd_vec<int, S / 2> vec_[2];
+
+    friend class simd_vec<float, S>;
+public:
+    force_inline simd_vec() = default;
+    force_inline simd_vec(int f) {
+        vec_[0] = vec_[1] = simd_vec<int, S / 2>{ f };
+    }
+    force_inline simd_vec(int i1, int i2, int i3, int i4, int i5, int i6, int i7, int i8,
+                          int i9, int i10, int i11, int i12, int i13, int i14, int i15, int i16) {
+        vec_[0] = { i1, i2, i3, i4, i5, i6, i7, i8 };
+        vec_[1] = { i9, i10, i11, i12, i13, i14, i15, i16 };
+    }
+    force_inline simd_vec(const int *f) {
+        vec_[0] = simd_vec<int, S / 2>{ f };
+        vec_[1] = simd_vec<int, S / 2>{ f + 8 };
+    }
+    force_inline simd_vec(const int *f, simd_mem_aligned_tag) {
+        vec_[0] = simd_vec<int, S / 2>{ f, simd_mem_aligned };
+        vec_[1] = simd_vec<int, S / 2>{ f + 8, simd_mem_aligned };
+    }
+
+    force_inline int &operator[](int i) { return vec_[i / 8][i % 8]; }
+    force_inline int operator[](int i) const { return vec_[i / 8][i % 8]; }
+
+    force_inline simd_vec<int, S> &operator+=(const simd_vec<int, S> &rhs) {
+        vec_[0] += rhs.vec_[0];
+        vec_[1] += rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator+=(int rhs) {
+        vec_[0] += rhs;
+        vec_[1] += rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator-=(const simd_vec<int, S> &rhs) {
+        vec_[0] -= rhs.vec_[0];
+        vec_[1] -= rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator-=(int rhs) {
+        vec_[0] -= rhs;
+        vec_[1] -= rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator*=(const simd_vec<int, S> &rhs) {
+        vec_[0] *= rhs.vec_[0];
+        vec_[1] *= rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator*=(int rhs) {
+        vec_[0] *= rhs;
+        vec_[1] *= rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator/=(const simd_vec<int, S> &rhs) {
+        vec_[0] /= rhs.vec_[0];
+        vec_[1] /= rhs.vec_[1];
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> &operator/=(int rhs) {
+        vec_[0] /= rhs;
+        vec_[1] /= rhs;
+        return *this;
+    }
+
+    force_inline simd_vec<int, S> operator==(int rhs) const {
+        simd_vec<int, S> ret;
+        ret.vec_[0] = vec_[0] == rhs;
+        ret.vec_[1] = vec_[1] == rhs;
+        return ret;
+    }
+
+    force_inline simd_vec<int, S> operator==(const simd_vec<int, S> &rhs) const {
+        simd_vec<int, S> ret;
+        ret.vec_[0] = vec_[0] == rhs.vec_[0];
+        ret.vec_[1] = vec_[1] == rhs.vec_[1];
+        return ret;
+    }
+
+    force_inline simd_vec<int, S> operator!=(int rhs) const {
+        simd_vec<int, S> ret;
+        ret.vec_[0] = vec_[0] != rhs;
+        ret.vec_[1] = vec_[1] != rhs;
+        return ret;
+    }
+
+    force_inline simd_vec<int, S> operator!=(const simd_vec<int, S> &rhs) const {
+        simd_vec<int, S> ret;
+        ret.vec_[0] = vec_[0] != rhs.vec_[0];
+        ret.vec_[1] = vec_[1] != rhs.vec_[1];
+        return ret;
+    }
+
+    force_inline operator simd_vec<float, S>() const {
+        simd_vec<float, S> ret;
+        ret.vec_[0] = (simd_vec<float, S / 2>)vec_[0];
+        ret.vec_[1] = (simd_vec<float, S / 2>)vec_[1];
+        return ret;
+    }
+
+    force_inline void copy_to(int *f) const {
+        vec_[0].copy_to(f);
+        vec_[1].copy_to(f + 8);
+    }
+
+    force_inline void copy_to(int *f, simd_mem_aligned_tag) const {
+        vec_[0].copy_to(f, simd_mem_aligned);
+        vec_[1].copy_to(f + 8, simd_mem_aligned);
+    }
+
+    force_inline void blend_to(const simd_vec<int, S> &mask, const simd_vec<int, S> &v1) {
+        vec_[0].blend_to(mask.vec_[0], v1.vec_[0]);
+        vec_[1].blend_to(mask.vec_[1], v1.vec_[1]);
+    }
+
+    force_inline bool all_zeros() const {
+        return (vec_[0] | vec_[1]).all_zeros();
+    }
+
+    force_inline bool all_zeros(const simd_vec<int, S> &mask) const {
+        return ((vec_[0] & mask.vec_[0]) | (vec_[1] & mask.vec_[1])).all_zeros();
+    }
+
+    force_inline bool not_all_zeros() const {
+        return (vec_[0] | vec_[1]).not_all_zeros();
+    }
+
+    force_inline static simd_vec<int, S> min(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = simd_vec<int, S / 2>::min(v1.vec_[0], v2.vec_[0]);
+        temp.vec_[1] = simd_vec<int, S / 2>::min(v1.vec_[1], v2.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<int, S> max(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = simd_vec<int, S / 2>::max(v1.vec_[0], v2.vec_[0]);
+        temp.vec_[1] = simd_vec<int, S / 2>::max(v1.vec_[1], v2.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<int, S> gather(const int *base, const simd_vec<int, S> &index) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = simd_vec<int, S / 2>::gather(base, index.vec_[0]);
+        temp.vec_[1] = simd_vec<int, S / 2>::gather(base, index.vec_[1]);
+        return temp;
+    }
+
+    force_inline static simd_vec<int, S> and_not(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = simd_vec<int, S / 2>::and_not(v1.vec_[0], v2.vec_[0]);
+        temp.vec_[1] = simd_vec<int, S / 2>::and_not(v1.vec_[1], v2.vec_[1]);
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator&(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] & v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] & v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator|(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] | v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] | v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator^(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] ^ v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] ^ v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator+(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] + v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] + v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator-(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] - v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] - v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator*(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] * v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] * v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator/(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] / v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] / v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator+(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] + v2;
+        temp.vec_[1] = v1.vec_[1] + v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator-(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] - v2;
+        temp.vec_[1] = v1.vec_[1] - v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator*(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] * v2;
+        temp.vec_[1] = v1.vec_[1] * v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator/(const simd_vec<int, S> &v1, int v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1.vec_[0] / v2;
+        temp.vec_[1] = v1.vec_[1] / v2;
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator+(int v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1 + v2.vec_[0];
+        temp.vec_[1] = v1 + v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator-(int v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1 - v2.vec_[0];
+        temp.vec_[1] = v1 - v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator*(int v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1 * v2.vec_[0];
+        temp.vec_[1] = v1 * v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator/(int v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> temp;
+        temp.vec_[0] = v1 / v2.vec_[0];
+        temp.vec_[1] = v1 / v2.vec_[1];
+        return temp;
+    }
+
+    friend force_inline simd_vec<int, S> operator<(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
+        simd_vec<int, S> ret;
+        ret.vec_[0] = v1.vec_[0] < v2.vec_[0];
+        ret.vec_[1] = v1.vec_[1] < v2.vec_[1];
         return ret;
     }
 
     friend force_inline simd_vec<int, S> operator>(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_cmpgt_epi32(v1.vec_, v2.vec_);
+        ret.vec_[0] = v1.vec_[0] > v2.vec_[0];
+        ret.vec_[1] = v1.vec_[1] > v2.vec_[1];
         return ret;
     }
 
     friend force_inline simd_vec<int, S> operator<(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_cmpgt_epi32(_mm256_set1_epi32(v2), v1.vec_);
+        ret.vec_[0] = v1.vec_[0] < v2;
+        ret.vec_[1] = v1.vec_[1] < v2;
         return ret;
     }
 
     friend force_inline simd_vec<int, S> operator>(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> ret;
-        ret.vec_ = _mm256_cmpgt_epi32(v1.vec_, _mm256_set1_epi32(v2));
+        ret.vec_[0] = v1.vec_[0] > v2;
+        ret.vec_[1] = v1.vec_[1] > v2;
         return ret;
     }
 
     friend force_inline simd_vec<int, S> operator>>(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_srlv_epi32(v1.vec_, v2.vec_);
+        temp.vec_[0] = v1.vec_[0] >> v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] >> v2.vec_[1];
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator>>(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_srli_epi32(v1.vec_, v2);
+        temp.vec_[0] = v1.vec_[0] >> v2;
+        temp.vec_[1] = v1.vec_[1] >> v2;
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator<<(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_sllv_epi32(v1.vec_, v2.vec_);
+        temp.vec_[0] = v1.vec_[0] << v2.vec_[0];
+        temp.vec_[1] = v1.vec_[1] << v2.vec_[1];
         return temp;
     }
 
     friend force_inline simd_vec<int, S> operator<<(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm256_slli_epi32(v1.vec_, v2);
+        temp.vec_[0] = v1.vec_[0] << v2;
+        temp.vec_[1] = v1.vec_[1] << v2;
         return temp;
     }
 
@@ -603,6 +1390,8 @@ using native_simd_ivec = simd_ivec<8>;
 
 #pragma warning(pop)
 
-#ifdef __GNUC__
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
 #pragma GCC pop_options
 #endif
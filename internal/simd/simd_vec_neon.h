@@ -232,6 +232,24 @@ public:
         return temp;
     }
 
+    force_inline static simd_vec<float, S> fmadd(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+        temp.vec_ = vmlaq_f32(c.vec_, a.vec_, b.vec_);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> fmsub(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+        temp.vec_ = vsubq_f32(vmulq_f32(a.vec_, b.vec_), c.vec_);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> gather(const float *base, const simd_vec<int, S> &index) {
+        simd_vec<float, S> temp;
+        ITERATE_4({ temp.comp_[i] = base[index.comp_[i]]; })
+        return temp;
+    }
+
     friend force_inline simd_vec<float, S> operator&(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
         simd_vec<float, S> temp;
         temp.vec_ = vreinterpretq_f32_s32(vandq_s32(vreinterpretq_s32_f32(v1.vec_), vreinterpretq_s32_f32(v2.vec_)));
@@ -333,12 +351,6 @@ public:
         return ret;
     }
 
-    friend force_inline simd_vec<float, S> pow(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
-        simd_vec<float, S> ret;
-        ITERATE_4({ ret.comp_[i] = std::pow(v1.comp_[i], v2.comp_[i]); })
-        return ret;
-    }
-
     friend force_inline simd_vec<float, S> normalize(const simd_vec<float, S> &v1) {
         return v1 / v1.length();
     }
@@ -547,6 +559,12 @@ public:
         return temp;
     }
 
+    force_inline static simd_vec<int, S> gather(const int *base, const simd_vec<int, S> &index) {
+        simd_vec<int, S> temp;
+        ITERATE_4({ temp.comp_[i] = base[index.comp_[i]]; })
+        return temp;
+    }
+
     force_inline static simd_vec<int, S> and_not(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
         temp.vec_ = vbicq_s32(v2.vec_, v1.vec_);
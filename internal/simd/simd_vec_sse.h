@@ -203,6 +203,24 @@ public:
         return temp;
     }
 
+    force_inline static simd_vec<float, S> fmadd(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+        temp.vec_ = _mm_add_ps(_mm_mul_ps(a.vec_, b.vec_), c.vec_);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> fmsub(const simd_vec<float, S> &a, const simd_vec<float, S> &b, const simd_vec<float, S> &c) {
+        simd_vec<float, S> temp;
+        temp.vec_ = _mm_sub_ps(_mm_mul_ps(a.vec_, b.vec_), c.vec_);
+        return temp;
+    }
+
+    force_inline static simd_vec<float, S> gather(const float *base, const simd_vec<int, S> &index) {
+        simd_vec<float, S> temp;
+        temp.vec_ = _mm_setr_ps(base[index.comp_[0]], base[index.comp_[1]], base[index.comp_[2]], base[index.comp_[3]]);
+        return temp;
+    }
+
     friend force_inline simd_vec<float, S> operator&(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
         simd_vec<float, S> temp;
         temp.vec_ = _mm_and_ps(v1.vec_, v2.vec_);
@@ -307,12 +325,6 @@ public:
         return ret;
     }
 
-    friend force_inline simd_vec<float, S> pow(const simd_vec<float, S> &v1, const simd_vec<float, S> &v2) {
-        simd_vec<float, S> ret;
-        ITERATE_4({ ret.comp_[i] = std::pow(v1.comp_[i], v2.comp_[i]); })
-        return ret;
-    }
-
     friend force_inline simd_vec<float, S> normalize(const simd_vec<float, S> &v1) {
         return v1 / v1.length();
     }
@@ -333,6 +345,17 @@ class simd_vec<typename std::enable_if<S == 4, int>::type, S> {
     };
 
     friend class simd_vec<float, S>;
+
+    // low 32 bits of products are the same for signed and unsigned numbers
+    force_inline static __m128i mullo(__m128i v1, __m128i v2) {
+#if 0 // requires sse4.1
+        return _mm_mullo_epi32(v1, v2);
+#else
+        __m128i even = _mm_mul_epu32(v1, v2),
+                odd = _mm_mul_epu32(_mm_srli_si128(v1, 4), _mm_srli_si128(v2, 4));
+        return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+    }
 public:
     force_inline simd_vec() = default;
     force_inline simd_vec(int f) {
@@ -372,12 +395,12 @@ public:
     }
 
     force_inline simd_vec<int, S> &operator*=(const simd_vec<int, S> &rhs) {
-        ITERATE_4({ comp_[i] = comp_[i] * rhs.comp_[i]; })
+        vec_ = mullo(vec_, rhs.vec_);
         return *this;
     }
 
     force_inline simd_vec<int, S> &operator*=(int rhs) {
-        ITERATE_4({ comp_[i] = comp_[i] * rhs; })
+        vec_ = mullo(vec_, _mm_set1_epi32(rhs));
         return *this;
     }
 
@@ -511,13 +534,29 @@ public:
 
     force_inline static simd_vec<int, S> min(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
-        temp.vec_ = _mm_min_si128(v1.vec_, v2.vec_);
+#if 0 // requires sse4.1
+        temp.vec_ = _mm_min_epi32(v1.vec_, v2.vec_);
+#else
+        __m128i mask = _mm_cmplt_epi32(v1.vec_, v2.vec_);
+        temp.vec_ = _mm_or_si128(_mm_and_si128(mask, v1.vec_), _mm_andnot_si128(mask, v2.vec_));
+#endif
         return temp;
     }
 
     force_inline static simd_vec<int, S> max(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> temp;
+#if 0 // requires sse4.1
         temp.vec_ = _mm_max_epi32(v1.vec_, v2.vec_);
+#else
+        __m128i mask = _mm_cmpgt_epi32(v1.vec_, v2.vec_);
+        temp.vec_ = _mm_or_si128(_mm_and_si128(mask, v1.vec_), _mm_andnot_si128(mask, v2.vec_));
+#endif
+        return temp;
+    }
+
+    force_inline static simd_vec<int, S> gather(const int *base, const simd_vec<int, S> &index) {
+        simd_vec<int, S> temp;
+        temp.vec_ = _mm_setr_epi32(base[index.comp_[0]], base[index.comp_[1]], base[index.comp_[2]], base[index.comp_[3]]);
         return temp;
     }
 
@@ -559,7 +598,7 @@ public:
 
     friend force_inline simd_vec<int, S> operator*(const simd_vec<int, S> &v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> ret;
-        ITERATE_4({ ret.comp_[i] = v1.comp_[i] * v2.comp_[i]; })
+        ret.vec_ = mullo(v1.vec_, v2.vec_);
         return ret;
     }
 
@@ -583,13 +622,13 @@ public:
 
     friend force_inline simd_vec<int, S> operator*(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> ret;
-        ITERATE_4({ ret.comp_[i] = v1.comp_[i] * v2; })
+        ret.vec_ = mullo(v1.vec_, _mm_set1_epi32(v2));
         return ret;
     }
 
     friend force_inline simd_vec<int, S> operator/(const simd_vec<int, S> &v1, int v2) {
         simd_vec<int, S> ret;
-        ITERATE_4({ ret.vec_ = v1.comp_[i] / v2; })
+        ITERATE_4({ ret.comp_[i] = v1.comp_[i] / v2; })
         return ret;
     }
 
@@ -605,7 +644,7 @@ public:
 
     friend force_inline simd_vec<int, S> operator*(int v1, const simd_vec<int, S> &v2) {
         simd_vec<int, S> ret;
-        ITERATE_4({ ret.comp_[i] = v1 * v2.comp_[i]; })
+        ret.vec_ = mullo(_mm_set1_epi32(v1), v2.vec_);
         return ret;
     }
 
@@ -3,10 +3,32 @@
 
 void test_simd();
 void test_primary_ray_gen();
+void test_tex_atlas();
+void test_tex_streaming();
+void test_tex_compaction();
+void test_tex_mips();
+void test_env_map();
+void test_backends();
+void test_traverse();
+void test_halton();
+void test_sort();
+void test_trace();
+void test_render();
 
 int main() {
     test_simd();
     test_primary_ray_gen();
+    test_tex_atlas();
+    test_tex_streaming();
+    test_tex_compaction();
+    test_tex_mips();
+    test_env_map();
+    test_backends();
+    test_traverse();
+    test_halton();
+    test_sort();
+    test_trace();
+    test_render();
 
     puts("OK");
 }
@@ -0,0 +1,210 @@
+#include "test_common.h"
+
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "../RendererFactory.h"
+#include "../internal/simd/detect.h"
+
+namespace {
+const int W = 32, H = 32;
+
+/// Renders textured quad lit by sky, optionally collects traversal cost of pixels
+void RenderQuad(ray::RendererBase &r, std::vector<ray::pixel_color_t> &out_pixels,
+                std::vector<ray::traversal_cost_t> *out_cost = nullptr) {
+    using namespace ray;
+
+    auto scene = r.CreateScene();
+
+    environment_desc_t env = {};
+    env.sun_dir[0] = 0.0f; env.sun_dir[1] = 0.0f; env.sun_dir[2] = -1.0f;
+    env.sun_col[0] = env.sun_col[1] = env.sun_col[2] = 0.0f;
+    env.sky_col[0] = 0.5f; env.sky_col[1] = 0.6f; env.sky_col[2] = 0.7f;
+    env.sun_softness = 0.0f;
+    scene->SetEnvironment(env);
+
+    // checker texture, so that texture sampling of backend is covered too
+    std::vector<pixel_color8_t> texels(8 * 8);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            const uint8_t c = ((x + y) % 2) ? 255 : 64;
+            texels[y * 8 + x] = { c, c, c, 255 };
+        }
+    }
+
+    tex_desc_t tex_desc = {};
+    tex_desc.data = &texels[0];
+    tex_desc.w = tex_desc.h = 8;
+    tex_desc.generate_mipmaps = true;
+
+    mat_desc_t mat_desc;
+    mat_desc.type = DiffuseMaterial;
+    mat_desc.main_texture = scene->AddTexture(tex_desc);
+
+    // quad is slightly tilted, ray sorting expects scene bounds to have volume
+    const float attrs[] = { -1.0f, -1.0f, -0.25f,    0.0f, -0.124f, 0.992f,    0.0f, 0.0f,
+                             1.0f, -1.0f, -0.25f,    0.0f, -0.124f, 0.992f,    1.0f, 0.0f,
+                             1.0f,  1.0f,  0.25f,    0.0f, -0.124f, 0.992f,    1.0f, 1.0f,
+                            -1.0f,  1.0f,  0.25f,    0.0f, -0.124f, 0.992f,    0.0f, 1.0f };
+    const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    mesh_desc_t mesh_desc;
+    mesh_desc.prim_type = TriangleList;
+    mesh_desc.layout = PxyzNxyzTuv;
+    mesh_desc.vtx_attrs = &attrs[0];
+    mesh_desc.vtx_attrs_count = 4;
+    mesh_desc.vtx_indices = &indices[0];
+    mesh_desc.vtx_indices_count = 6;
+    mesh_desc.shapes.push_back({ scene->AddMaterial(mat_desc), 0, 6 });
+
+    const float xform[16] = { 1, 0, 0, 0,
+                              0, 1, 0, 0,
+                              0, 0, 1, 0,
+                              0, 0, 0, 1 };
+    scene->AddMeshInstance(scene->AddMesh(mesh_desc), xform);
+
+    // quad covers middle of image, sky is visible around it
+    const float origin[3] = { 0, 0, 3 }, fwd[3] = { 0, 0, -1 };
+    scene->set_current_cam(scene->AddCamera(Persp, origin, fwd, 45.0f));
+
+    r.Resize(W, H);
+    r.EnableTraversalCost(out_cost != nullptr);
+    r.Clear();
+
+    RegionContext region({ 0, 0, W, H });
+    for (int i = 0; i < 16; i++) {
+        r.RenderScene(scene, region);
+    }
+
+    const pixel_color_t *pixels = r.get_pixels_ref();
+    out_pixels.assign(pixels, pixels + W * H);
+
+    if (out_cost) {
+        const traversal_cost_t *cost = r.get_traversal_cost_ref();
+        require(cost != nullptr);
+        out_cost->assign(cost, cost + W * H);
+    }
+}
+}
+
+void test_backends() {
+    using namespace ray;
+
+    const auto features = GetCpuFeatures();
+
+    struct backend_t {
+        eRendererType type;
+        const char *name;
+        bool supported;
+    } backends[] = {
+        { RendererRef, "Ref", true },
+#if !defined(__ANDROID__)
+        { RendererSSE, "SSE", features.sse2_supported },
+        { RendererAVX, "AVX", features.avx_supported },
+        { RendererAVX2, "AVX2", features.avx2_supported && features.fma_supported },
+        { RendererAVX16, "AVX16", features.avx2_supported && features.fma_supported },
+#endif
+    };
+
+    settings_t s;
+    s.w = W;
+    s.h = H;
+
+    float ref_avg[3] = { 0.0f, 0.0f, 0.0f };
+    eRendererType widest = RendererRef;
+
+    for (const auto &b : backends) {
+        if (!b.supported) {
+            std::cout << "Cannot test " << b.name << " backend" << std::endl;
+
+            // backend is never created on hardware that lacks required instructions
+            std::stringstream log;
+            auto r = CreateRenderer(s, b.type | RendererRef, log);
+            require(r->type() == RendererRef);
+            continue;
+        }
+
+        if (b.type & default_renderer_flags) {
+            widest = b.type;
+        }
+
+        std::stringstream log;
+        auto r = CreateRenderer(s, b.type, log);
+        require(r->type() == b.type);
+
+        std::vector<pixel_color_t> pixels;
+        RenderQuad(*r, pixels);
+
+        float avg[3] = { 0.0f, 0.0f, 0.0f };
+        for (const pixel_color_t &p : pixels) {
+            avg[0] += p.r / (W * H);
+            avg[1] += p.g / (W * H);
+            avg[2] += p.b / (W * H);
+        }
+
+        if (b.type == RendererRef) {
+            ref_avg[0] = avg[0];
+            ref_avg[1] = avg[1];
+            ref_avg[2] = avg[2];
+        } else {
+            // backends are not bit exact (FMA, packet order of sampling), only average color is compared
+            require(avg[0] == Approx(ref_avg[0], 0.02));
+            require(avg[1] == Approx(ref_avg[1], 0.02));
+            require(avg[2] == Approx(ref_avg[2], 0.02));
+        }
+
+        // quad is visible in the middle of image, sky in the corner
+        const pixel_color_t &center = pixels[(H / 2) * W + W / 2], &corner = pixels[0];
+        require(std::abs(center.r - corner.r) > 0.05f);
+
+        {   // collecting traversal cost does not change image
+            std::vector<pixel_color_t> pixels2;
+            std::vector<traversal_cost_t> cost;
+            RenderQuad(*r, pixels2, &cost);
+
+            for (int i = 0; i < W * H; i++) {
+                require(pixels2[i].r == pixels[i].r && pixels2[i].g == pixels[i].g && pixels2[i].b == pixels[i].b);
+            }
+
+            // rays hitting the quad test its triangles, sky rays are rejected at scene bounds
+            const traversal_cost_t &center_cost = cost[(H / 2) * W + W / 2], &corner_cost = cost[0];
+            require(center_cost.tris > 0);
+            require(center_cost.nodes > corner_cost.nodes);
+            require(corner_cost.tris == 0);
+
+            r->EnableTraversalCost(false);
+            require(r->get_traversal_cost_ref() == nullptr);
+        }
+
+        {   // filter is chosen per bounce depth, only primary rays can hit the quad
+            require(r->texture_filter(0) == TexFilterAnisotropic);
+            r->SetTextureFilter(1, TexFilterNearest);
+            require(r->texture_filter(0) == TexFilterAnisotropic);
+            require(r->texture_filter(1) == TexFilterNearest && r->texture_filter(100) == TexFilterNearest);
+
+            std::vector<pixel_color_t> pixels2;
+            RenderQuad(*r, pixels2);
+
+            for (int i = 0; i < W * H; i++) {
+                require(pixels2[i].r == pixels[i].r && pixels2[i].g == pixels[i].g && pixels2[i].b == pixels[i].b);
+            }
+
+            r->SetTextureFilter(0, TexFilterNearest);
+            require(r->texture_filter(0) == TexFilterNearest);
+            RenderQuad(*r, pixels2);
+
+            int changed = 0;
+            for (int i = 0; i < W * H; i++) {
+                if (std::abs(pixels2[i].r - pixels[i].r) > 0.001f) changed++;
+            }
+            require(changed > 0);
+        }
+    }
+
+    {   // default flags without OpenCL pick the widest supported backend
+        std::stringstream log;
+        auto r = CreateRenderer(s, default_renderer_flags & ~RendererOCL, log);
+        require(r->type() == widest);
+    }
+}
@@ -1,3 +1,4 @@
+#include <cstdint>
 
 #include <vector>
 
@@ -18,4 +19,396 @@ std::vector<float> primary_ray_gen_test_data = {
     196609, 0.000000f, 0.000000f, 4.000000f, -0.235702f, -0.235702f, -0.942809f,
     196610, 0.000000f, 0.000000f, 4.000000f, -0.000000f, -0.242536f, -0.970143f,
     196611, 0.000000f, 0.000000f, 4.000000f, 0.235702f, -0.235702f, -0.942809f,
-};
\ No newline at end of file
+};
+std::vector<uint8_t> render_diffuse_ref = {
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 178, 166, 177, 192, 142, 147, 195, 136, 139,
+    200, 133, 135, 196, 143, 148, 181, 169, 181, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 173, 170, 183, 193, 110, 106, 207,  79,  54, 212,  81,  55, 216,  83,  56,
+    218,  83,  57, 219,  84,  57, 220,  84,  57, 210, 112, 105, 179, 171, 184, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 171, 156, 167, 190,  83,  68, 200,  77,  52, 207,  79,  54, 212,  81,  55, 215,  82,  56,
+    217,  83,  56, 218,  83,  57, 220,  84,  57, 219,  84,  57, 215,  91,  72, 185, 159, 169, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 165, 171, 185, 179,  76,  61, 190,  73,  50, 198,  76,  52, 204,  78,  53, 209,  80,  54, 212,  81,  55,
+    214,  82,  56, 216,  83,  56, 217,  83,  56, 217,  83,  56, 216,  82,  56, 211,  87,  67, 176, 172, 185, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 162, 103, 103, 177,  68,  47, 187,  72,  49, 195,  75,  51, 200,  77,  52, 204,  78,  53, 208,  80,  54,
+    210,  80,  55, 212,  81,  55, 213,  81,  55, 214,  82,  55, 213,  81,  55, 210,  80,  54, 197, 109, 104, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    162, 170, 184, 157,  61,  42, 173,  67,  46, 183,  70,  48, 190,  73,  50, 194,  75,  51, 199,  76,  52, 201,  77,  52,
+    205,  79,  53, 207,  79,  54, 208,  79,  54, 209,  80,  54, 209,  80,  54, 206,  79,  53, 201,  77,  52, 172, 173, 186,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    153, 163, 172, 150, 157, 164, 147, 154, 161, 147, 154, 161, 146, 153, 160, 149, 156, 163, 148, 155, 162, 147, 153, 160,
+    140, 120, 123, 151,  59,  41, 167,  64,  44, 177,  68,  47, 184,  71,  49, 189,  73,  49, 194,  74,  51, 196,  75,  51,
+    199,  76,  52, 202,  77,  53, 203,  78,  53, 203,  77,  53, 203,  78,  53, 201,  77,  52, 195,  75,  51, 168, 124, 125,
+    148, 155, 162, 148, 155, 162, 146, 153, 160, 148, 155, 162, 147, 154, 161, 149, 157, 164, 147, 154, 161, 154, 164, 173,
+    141, 143, 146, 140, 142, 145, 141, 144, 147, 141, 143, 146, 142, 145, 148, 140, 143, 146, 143, 146, 149, 141, 144, 147,
+    126, 100,  99, 143,  56,  38, 158,  61,  42, 168,  65,  44, 176,  68,  46, 183,  70,  48, 186,  71,  49, 190,  73,  50,
+    193,  74,  50, 194,  74,  50, 196,  75,  51, 197,  75,  51, 196,  75,  51, 193,  74,  50, 189,  72,  49, 165, 105, 100,
+    141, 144, 147, 140, 143, 145, 141, 144, 146, 140, 143, 146, 142, 145, 148, 139, 142, 144, 143, 146, 149, 139, 141, 144,
+    143, 146, 148, 138, 140, 143, 146, 148, 151, 138, 141, 143, 143, 146, 149, 142, 145, 148, 140, 143, 145, 143, 146, 149,
+    115,  91,  90, 130,  51,  35, 147,  57,  39, 161,  62,  43, 167,  64,  44, 173,  67,  45, 178,  69,  47, 182,  70,  48,
+    185,  71,  48, 187,  72,  49, 188,  72,  49, 189,  72,  49, 188,  72,  49, 186,  71,  48, 181,  69,  47, 159, 102,  97,
+    139, 141, 144, 143, 146, 148, 141, 143, 146, 139, 142, 145, 144, 146, 149, 137, 140, 142, 146, 149, 152, 139, 142, 144,
+    138, 141, 144, 147, 150, 152, 137, 139, 141, 143, 145, 148, 142, 145, 147, 139, 142, 145, 144, 147, 149, 138, 141, 144,
+    121, 110, 111, 113,  45,  32, 133,  52,  36, 148,  57,  39, 155,  60,  41, 164,  63,  43, 166,  64,  44, 173,  67,  45,
+    176,  67,  46, 176,  67,  46, 179,  68,  47, 179,  68,  47, 179,  69,  47, 175,  67,  45, 170,  65,  45, 150, 115, 113,
+    143, 146, 148, 138, 141, 143, 145, 148, 150, 141, 143, 146, 139, 142, 144, 147, 150, 153, 138, 140, 143, 145, 148, 151,
+    145, 148, 150, 141, 144, 146, 138, 140, 143, 144, 146, 149, 142, 145, 147, 138, 141, 144, 144, 146, 149, 138, 140, 142,
+    129, 127, 129,  93,  37,  27, 116,  46,  32, 133,  52,  36, 141,  55,  37, 150,  58,  40, 157,  60,  41, 161,  62,  42,
+    166,  64,  44, 167,  64,  44, 169,  65,  44, 168,  64,  44, 168,  64,  44, 163,  63,  43, 152,  58,  40, 143, 132, 133,
+    141, 143, 145, 139, 141, 144, 143, 145, 148, 143, 145, 148, 139, 142, 144, 145, 147, 150, 143, 145, 148, 139, 141, 144,
+    146, 149, 151, 133, 135, 138, 145, 148, 150, 145, 147, 150, 134, 137, 139, 148, 150, 153, 141, 143, 146, 136, 139, 141,
+    133, 136, 139,  82,  49,  48,  92,  37,  26, 111,  44,  30, 125,  49,  34, 135,  52,  36, 142,  55,  38, 148,  57,  39,
+    151,  58,  40, 154,  59,  40, 155,  59,  41, 154,  59,  40, 151,  58,  40, 144,  55,  38, 129,  75,  69, 133, 136, 138,
+    147, 150, 152, 143, 145, 147, 137, 140, 142, 150, 153, 155, 140, 142, 145, 137, 140, 142, 151, 154, 156, 138, 141, 143,
+    145, 147, 150, 152, 155, 158, 130, 133, 135, 144, 147, 149, 153, 155, 158, 129, 132, 134, 139, 141, 144, 144, 146, 149,
+     56,  61,  66,  59,  51,  54,  87,  37,  28,  92,  37,  26, 100,  40,  28, 115,  45,  31, 122,  48,  33, 129,  50,  35,
+    134,  52,  36, 137,  53,  36, 138,  53,  37, 136,  52,  36, 132,  51,  35, 120,  50,  38, 139, 135, 136, 152, 155, 157,
+    127, 129, 131, 142, 144, 147, 155, 158, 161, 130, 132, 134, 139, 141, 143, 155, 158, 161, 133, 136, 138, 138, 141, 143,
+    127, 129, 131, 147, 150, 152, 155, 158, 161, 128, 131, 133, 136, 138, 140, 158, 161, 164, 135, 137, 140,  95,  97, 100,
+     63,  69,  75,  53,  58,  63,  61,  52,  55,  85,  35,  26,  86,  35,  25,  90,  36,  25,  95,  38,  26, 101,  40,  28,
+    111,  43,  30, 112,  44,  30, 111,  43,  30, 108,  42,  29, 101,  53,  46, 134, 130, 132, 131, 132, 134, 129, 131, 133,
+    151, 154, 156, 150, 152, 154, 126, 128, 130, 144, 146, 149, 157, 160, 163, 130, 132, 135, 138, 140, 143, 157, 160, 163,
+    148, 151, 153, 131, 133, 135, 144, 147, 150, 150, 153, 155, 138, 140, 143, 134, 136, 138, 146, 148, 150, 129, 132, 134,
+     55,  59,  64,  50,  55,  60,  52,  58,  63,  56,  51,  54,  78,  42,  39,  88,  35,  24,  82,  32,  23,  83,  33,  23,
+     83,  33,  23,  84,  33,  23,  87,  34,  24,  82,  38,  33,  69,  61,  61, 131, 132, 134, 150, 151, 153, 143, 145, 146,
+    128, 130, 132, 146, 147, 149, 157, 159, 162, 147, 149, 152, 129, 131, 133, 143, 146, 149, 157, 160, 163, 137, 139, 141,
+    151, 154, 157, 145, 148, 151, 136, 138, 140, 128, 130, 132, 151, 154, 157, 150, 152, 155, 135, 137, 139, 132, 134, 136,
+     97, 100, 104,  54,  59,  64,  49,  53,  58,  43,  47,  51,  37,  41,  44,  53,  44,  46,  64,  33,  30,  64,  27,  22,
+     67,  33,  29,  59,  36,  35,  46,  30,  30,  45,  46,  48, 135, 136, 138, 145, 146, 148, 134, 136, 137, 129, 131, 133,
+    154, 155, 157, 146, 148, 150, 128, 129, 131, 136, 138, 140, 162, 164, 167, 146, 148, 151, 126, 129, 131, 135, 138, 140,
+    123, 125, 128, 150, 152, 155, 157, 159, 162, 134, 136, 139, 126, 128, 130, 152, 154, 156, 152, 154, 156, 133, 135, 137,
+    131, 132, 134, 128, 130, 132,  90,  92,  95,  59,  63,  67,  42,  46,  50,  45,  48,  52,  43,  45,  49,  39,  41,  44,
+     35,  37,  40,  44,  48,  51, 101, 101, 103, 133, 134, 136, 146, 148, 150, 136, 138, 139, 133, 134, 136, 144, 145, 147,
+    148, 150, 153, 133, 134, 136, 139, 141, 143, 153, 154, 156, 145, 147, 149, 128, 130, 132, 144, 146, 148, 155, 158, 161,
+    128, 130, 133, 111, 112, 114, 153, 156, 158, 171, 174, 177, 129, 131, 133, 113, 114, 116, 152, 155, 157, 168, 170, 173,
+    127, 129, 130, 114, 115, 117, 150, 151, 152, 161, 163, 165, 119, 120, 122, 106, 107, 109, 116, 118, 119, 127, 129, 131,
+    114, 115, 116, 116, 116, 117, 151, 152, 154, 156, 158, 159, 123, 124, 126, 121, 123, 124, 154, 156, 158, 159, 162, 164,
+    124, 125, 127, 125, 126, 128, 158, 160, 163, 158, 160, 162, 124, 126, 127, 129, 131, 133, 157, 160, 163, 154, 156, 158,
+    181, 184, 188, 132, 134, 137,  96,  97,  99, 142, 145, 147, 184, 187, 190, 145, 147, 149,  98,  99, 101, 129, 131, 133,
+    178, 180, 183, 156, 158, 160, 103, 104, 105, 116, 117, 118, 169, 170, 172, 167, 168, 171, 111, 112, 113, 104, 105, 106,
+    159, 161, 163, 174, 175, 177, 122, 124, 126,  99, 100, 101, 148, 150, 152, 181, 183, 185, 135, 137, 139,  96,  97,  98,
+    139, 141, 143, 183, 185, 188, 148, 150, 152,  99, 100, 102, 127, 129, 131, 180, 182, 185, 160, 162, 164, 106, 107, 109,
+    143, 146, 148, 169, 172, 175, 146, 148, 151, 116, 118, 120, 127, 130, 132, 160, 163, 165, 162, 164, 166, 126, 128, 130,
+    114, 115, 117, 143, 145, 147, 170, 172, 175, 145, 147, 149, 111, 112, 113, 124, 125, 127, 159, 161, 163, 162, 164, 167,
+    125, 127, 129, 111, 112, 113, 145, 147, 149, 171, 172, 174, 142, 144, 146, 110, 112, 113, 125, 127, 129, 166, 168, 171,
+    162, 164, 167, 121, 123, 125, 113, 115, 116, 151, 153, 156, 176, 178, 181, 139, 141, 143, 105, 107, 108, 133, 134, 136,
+    147, 150, 153, 167, 170, 173, 141, 144, 146, 120, 121, 123, 131, 133, 136, 158, 160, 163, 157, 160, 162, 129, 131, 134,
+    121, 123, 125, 143, 144, 147, 162, 164, 166, 143, 145, 147, 122, 124, 126, 129, 131, 132, 154, 156, 158, 153, 155, 157,
+    130, 132, 135, 122, 124, 125, 142, 144, 146, 159, 161, 163, 141, 143, 145, 124, 126, 128, 133, 135, 137, 154, 156, 159,
+    151, 153, 156, 130, 132, 135, 128, 129, 131, 144, 146, 149, 160, 162, 165, 140, 143, 145, 123, 125, 127, 137, 139, 141,
+     90,  91,  93, 129, 131, 134, 182, 185, 188, 175, 177, 181, 119, 121, 123,  91,  92,  94, 140, 142, 144, 187, 190, 193,
+    165, 167, 170, 108, 109, 111,  97,  98, 100, 150, 151, 154, 190, 192, 195, 153, 155, 157,  99, 100, 101, 104, 106, 107,
+    161, 162, 164, 188, 192, 195, 141, 143, 145,  90,  91,  93, 115, 116, 118, 173, 175, 177, 183, 186, 189, 129, 131, 133,
+     88,  89,  90, 130, 132, 134, 184, 187, 190, 174, 176, 180, 115, 117, 119,  92,  93,  94, 144, 146, 148, 192, 194, 198,
+    133, 135, 137, 136, 138, 141, 147, 149, 152, 146, 149, 151, 140, 142, 145, 134, 136, 139, 137, 140, 142, 145, 147, 149,
+    143, 146, 148, 139, 141, 143, 136, 139, 141, 139, 141, 143, 143, 145, 147, 140, 142, 145, 138, 140, 143, 139, 141, 143,
+    140, 142, 144, 141, 142, 144, 137, 139, 141, 140, 142, 144, 142, 144, 146, 142, 145, 147, 138, 140, 142, 136, 138, 140,
+    140, 142, 144, 145, 148, 150, 144, 146, 148, 138, 140, 142, 135, 137, 140, 140, 142, 145, 148, 150, 153, 145, 148, 151,
+    146, 149, 152,  93,  95,  96, 102, 104, 106, 158, 161, 164, 196, 199, 202, 157, 160, 163, 101, 102, 104,  93,  94,  95,
+    147, 149, 151, 194, 197, 201, 166, 169, 172, 109, 111, 113,  86,  88,  89, 138, 140, 142, 189, 192, 195, 175, 178, 181,
+    118, 120, 122,  84,  85,  86, 129, 132, 134, 184, 187, 191, 183, 186, 189, 129, 131, 133,  83,  84,  85, 121, 123, 125,
+    178, 181, 184, 189, 191, 195, 136, 138, 141,  85,  86,  87, 113, 115, 117, 171, 173, 176, 194, 198, 201, 144, 147, 149
+};
+
+std::vector<uint8_t> render_materials_ref = {
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 167, 185, 201, 167, 185, 201, 166, 184, 200, 168, 185, 201,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 178, 188, 201,
+    255, 220, 188, 255, 246, 174, 255, 240, 178, 255, 220, 188, 178, 188, 201, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    157, 172, 186, 157, 172, 186, 161, 178, 193, 166, 183, 199, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200,
+    167, 184, 200, 160, 176, 191, 156, 172, 186, 157, 172, 186, 157, 173, 187, 154, 169, 183, 140, 155, 168, 118, 131, 142,
+    121, 131, 142, 140, 155, 169, 156, 171, 185, 157, 172, 186, 156, 171, 185, 157, 172, 187, 239, 196, 184, 255, 255, 156,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 159, 209, 188, 188, 157, 172, 186, 161, 177, 192,
+    112, 116, 120, 110, 114, 117, 156, 172, 186, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200,
+    166, 184, 200, 160, 177, 192, 112, 116, 120, 110, 113, 117, 103, 105, 108, 101,  93,  91,  88,  88,  90, 105, 106, 108,
+    114, 110, 110, 112, 106, 106,  73,  73,  75, 100, 103, 106, 111, 114, 118, 179, 138, 120, 255, 255, 141, 255, 255, 144,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 140, 156, 129, 119, 109, 112, 116,
+    111, 115, 118, 130, 139, 148, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200,
+    164, 179, 194, 164, 181, 197, 134, 145, 154, 108, 111, 115, 121, 113, 111, 127, 121, 120, 143, 136, 136, 119, 121, 124,
+    104, 105, 107,  96,  94,  95, 114, 111, 112,  77,  81,  85, 106, 108, 111, 255, 229, 133, 255, 255, 144, 255, 255, 144,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 201, 128, 113, 117, 120,
+    110, 113, 116, 143, 156, 167, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200, 166, 184, 200, 161, 176, 190,
+    177, 151, 144, 255, 196, 152, 129, 137, 145, 107, 103, 103, 116, 112, 112, 121, 116, 116, 120, 118, 120, 112, 114, 117,
+    110, 112, 114, 112, 110, 112, 112, 112, 114, 110, 112, 114, 100, 101, 104, 255, 253, 137, 255, 255, 144, 255, 255, 144,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 236, 134, 112, 116, 119,
+    114, 117, 120, 126, 135, 143, 157, 173, 187, 164, 180, 195, 163, 180, 195, 164, 181, 197, 161, 178, 193, 196, 181, 183,
+    242, 194, 179, 255, 223, 160, 113, 112, 115, 111,  98,  95, 117, 114, 114, 116, 114, 115, 122, 116, 115, 120, 116, 116,
+    114, 114, 116, 112, 112, 113, 113, 113, 114, 113, 113, 115,  95,  98, 101, 255, 253, 136, 255, 255, 144, 255, 255, 144,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 240, 137, 115, 115, 117,
+    109, 112, 116, 111, 115, 119, 126, 133, 140, 129, 137, 144, 129, 138, 146, 124, 132, 139, 123, 130, 138, 110, 115, 120,
+    207, 166, 154, 205, 150, 127, 103, 103, 105, 133, 114, 109, 117, 114, 115, 116, 113, 114, 117, 115, 116, 117, 115, 116,
+    113, 114, 116, 113, 115, 118, 111, 113, 116, 111, 114, 116, 103, 104, 107, 255, 220, 123, 255, 255, 144, 255, 255, 144,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 208, 130, 122, 120, 121,
+    111, 115, 118, 114, 118, 122, 104, 107, 111, 107, 109, 112, 114, 113, 115, 109, 112, 115, 111, 112, 114, 103, 107, 110,
+     67,  72,  77,  69,  72,  77, 115, 117, 120, 121, 127, 134, 118, 116, 118, 118, 114, 115, 118, 115, 115, 115, 114, 116,
+    115, 114, 116, 110, 112, 115, 110, 112, 115, 109, 112, 116, 122, 129, 137, 192, 123,  80, 255, 255, 140, 255, 255, 144,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 138, 140, 120, 114, 127, 120, 119,
+    104, 108, 111,  96, 100, 104,  69,  75,  81,  88,  92,  96, 111, 113, 116, 103, 103, 105, 116, 119, 121, 102, 104, 106,
+     90,  93,  96,  69,  69,  71, 106, 107, 109, 139, 151, 163, 143, 154, 165, 114, 119, 124, 114, 115, 117, 111, 114, 117,
+    110, 113, 117, 111, 114, 117, 116, 122, 127, 143, 156, 167, 143, 149, 159, 128,  89,  69, 245, 150,  83, 255, 255, 133,
+    255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 144, 255, 255, 136, 215, 147, 108, 145, 126, 120, 142, 129, 125,
+    124, 128, 132,  89,  92,  95,  57,  61,  66,  62,  68,  74,  55,  60,  65,  59,  63,  66,  50,  53,  56,  54,  51,  52,
+     77,  70,  69,  77,  78,  80,  78,  76,  78,  82,  90,  98, 160, 177, 192, 168, 185, 201, 158, 174, 188, 153, 166, 179,
+    151, 166, 179, 159, 175, 190, 168, 186, 202, 159, 176, 191, 112,  99,  96, 127,  93,  76, 167, 111,  80, 170, 107,  67,
+    255, 177,  90, 255, 221, 111, 255, 226, 115, 255, 166,  89, 137, 107,  94, 175, 140, 125, 173, 141, 127, 116, 105, 102,
+    120, 124, 128, 130, 134, 138,  98, 101, 103,  77,  80,  82, 101, 105, 108, 103, 107, 110,  78,  81,  83,  82,  85,  87,
+    118, 121, 124, 127, 130, 134,  66,  72,  76,  49,  55,  59,  94, 102, 111, 148, 164, 178, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 152, 167, 181, 114, 110, 112, 148, 133, 129, 150, 131, 125, 125, 103,  95, 134, 104,  91,
+    179, 135, 114, 174, 129, 107, 134,  98,  80, 135, 109,  99, 196, 152, 133, 171, 139, 125, 118, 101,  95, 123, 110, 106,
+     84,  87,  89, 117, 119, 122, 139, 142, 146, 111, 114, 117,  81,  83,  85,  96,  98, 101, 133, 136, 140, 129, 132, 136,
+     92,  94,  96,  89,  92,  94, 110, 114, 119,  82,  89,  96,  51,  56,  61,  49,  54,  58, 101, 112, 121, 127, 140, 152,
+    120, 133, 144,  79,  86,  93, 101,  91,  90, 151, 143, 143, 119, 111, 110,  99,  90,  87, 146, 127, 120, 168, 150, 145,
+    135, 117, 111, 117,  97,  89, 152, 127, 118, 179, 151, 141, 144, 122, 114, 109,  92,  86, 133, 117, 111, 165, 149, 144,
+    120, 120, 123,  91,  91,  92,  95,  94,  95, 138, 134, 135, 145, 144, 146, 102, 103, 105,  80,  82,  84, 115, 115, 116,
+    142, 146, 150, 118, 121, 124,  82,  85,  87,  95,  97, 100, 122, 127, 132, 103, 109, 114,  67,  71,  75,  61,  65,  68,
+     99, 103, 107, 132, 134, 138, 115, 111, 111,  85,  81,  81, 123, 115, 113, 159, 151, 150, 150, 133, 128,  96,  88,  86,
+    113, 101,  97, 169, 148, 141, 162, 145, 141, 117, 101,  95,  97,  88,  86, 145, 130, 126, 155, 145, 143, 122, 114, 113,
+    129, 129, 131, 129, 129, 131, 108, 107, 109, 103, 100, 101, 116, 116, 118, 136, 135, 138, 125, 123, 124,  96,  99, 102,
+    102, 103, 105, 119, 123, 127, 133, 137, 142, 110, 113, 117,  92,  95,  98, 104, 107, 110, 129, 132, 135, 130, 133, 137,
+    102, 104, 107,  96,  95,  96, 117, 117, 119, 143, 143, 146, 130, 126, 127, 104,  99,  98, 102,  98,  99, 144, 131, 127,
+    153, 145, 144, 120, 115, 116,  99,  91,  89, 114, 109, 108, 155, 143, 140, 146, 138, 137, 114, 104, 101,  97,  92,  92,
+    135, 134, 136, 131, 129, 130, 107, 107, 110, 100,  99, 101, 122, 117, 117, 129, 132, 135, 120, 121, 124, 102, 105, 108,
+    100, 103, 106, 116, 120, 123, 124, 128, 132, 111, 115, 118, 104, 106, 109, 108, 110, 113, 122, 125, 128, 123, 125, 127,
+    109, 109, 111, 105, 107, 109, 119, 117, 119, 129, 127, 128, 121, 119, 120, 112, 108, 108, 112, 112, 113, 129, 122, 122,
+    130, 126, 126, 125, 115, 113, 114, 108, 107, 124, 118, 117, 127, 124, 125, 127, 121, 121, 119, 111, 109, 116, 111, 110,
+     91,  90,  92, 135, 135, 138, 161, 157, 157, 115, 118, 121,  76,  77,  78,  87,  90,  93, 130, 134, 138, 154, 155, 158,
+    115, 119, 122,  75,  77,  79,  87,  88,  90, 128, 132, 136, 149, 154, 159, 116, 120, 124,  75,  78,  80,  87,  88,  90,
+    133, 132, 134, 154, 156, 160, 120, 121, 123,  76,  78,  81,  86,  87,  90, 130, 131, 134, 161, 157, 158, 116, 119, 122,
+     80,  79,  80,  88,  88,  89, 141, 134, 133, 153, 156, 159, 116, 120, 123,  84,  81,  81,  85,  87,  89, 130, 130, 133,
+    107, 108, 110, 103, 104, 107, 112, 113, 115, 127, 127, 129, 121, 124, 128, 111, 112, 114, 102, 103, 105, 104, 107, 110,
+    116, 119, 123, 124, 128, 132, 113, 117, 120, 103, 105, 108, 102, 103, 106, 111, 115, 119, 125, 127, 131, 123, 124, 127,
+    109, 109, 112,  98, 101, 103, 107, 110, 113, 123, 125, 127, 130, 130, 133, 118, 116, 118,  98, 101, 104, 100, 104, 107,
+    118, 120, 122, 137, 134, 136, 119, 120, 122, 103, 104, 106, 101, 100, 101, 122, 118, 118, 140, 136, 137, 122, 126, 129,
+     82,  84,  87,  75,  77,  79, 111, 115, 118, 153, 153, 156, 139, 143, 148, 105, 105, 106,  70,  72,  74,  94,  97, 100,
+    131, 136, 140, 148, 153, 158, 118, 122, 125,  81,  84,  86,  78,  80,  83, 118, 119, 121, 152, 153, 156, 136, 139, 142,
+     99, 101, 103,  72,  73,  74, 100, 102, 104, 143, 141, 143, 155, 153, 154, 113, 117, 120,  79,  81,  84,  83,  85,  88,
+    119, 123, 126, 155, 155, 157, 139, 135, 136,  94,  96,  99,  74,  76,  78, 109, 109, 111, 140, 145, 150, 148, 148, 151,
+    126, 129, 133, 112, 115, 119,  99, 102, 105,  98, 102, 105, 110, 114, 117, 124, 128, 132, 123, 127, 131, 109, 112, 116,
+     96,  99, 102,  99, 102, 105, 114, 116, 119, 130, 132, 136, 123, 126, 130, 111, 111, 113,  96,  98, 101, 102, 104, 107,
+    118, 121, 124, 129, 133, 137, 122, 124, 127, 104, 106, 109,  92,  95,  98, 104, 106, 109, 122, 125, 128, 136, 136, 139,
+    118, 120, 123,  99, 101, 104,  92,  95,  98, 108, 111, 115, 129, 130, 133, 134, 135, 138, 114, 115, 118,  93,  96,  99,
+    145, 149, 153, 104, 107, 111,  66,  68,  70,  80,  83,  85, 118, 122, 125, 153, 158, 163, 143, 146, 150, 101, 104, 107,
+     66,  68,  70,  83,  85,  87, 122, 126, 130, 159, 160, 164, 139, 142, 146, 100, 102, 104,  64,  65,  67,  87,  88,  91,
+    125, 129, 133, 157, 160, 165, 134, 137, 141,  94,  98, 101,  67,  67,  69,  93,  95,  97, 128, 132, 136, 159, 161, 165,
+    133, 134, 136,  93,  94,  96,  65,  67,  69,  98,  99, 102, 141, 140, 142, 155, 158, 163, 128, 129, 131,  92,  91,  92,
+    112, 115, 119, 114, 118, 121, 110, 114, 117, 107, 111, 114, 109, 112, 115, 111, 115, 118, 113, 116, 119, 112, 115, 119,
+    111, 114, 118, 110, 113, 116, 109, 112, 115, 109, 113, 117, 111, 115, 118, 113, 116, 119, 112, 116, 119, 115, 115, 118,
+    109, 112, 116, 111, 113, 116, 110, 112, 116, 112, 114, 117, 114, 117, 121, 118, 119, 122, 114, 115, 118, 113, 113, 116,
+    109, 110, 113, 112, 113, 116, 113, 117, 121, 115, 119, 122, 115, 116, 119, 110, 112, 115, 109, 109, 111, 109, 111, 115
+};
+
+std::vector<uint8_t> render_instances_ref = {
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202, 168, 186, 202,
+    143, 147, 151, 147, 151, 155, 142, 146, 150, 144, 148, 151, 141, 145, 149, 144, 147, 151, 144, 148, 152, 143, 146, 150,
+    146, 150, 154, 143, 147, 151, 143, 147, 151, 143, 147, 150, 144, 148, 152, 145, 148, 152, 142, 146, 149, 145, 149, 152,
+    140, 144, 147, 145, 149, 153, 143, 147, 151, 143, 147, 150, 145, 149, 152, 143, 147, 151, 144, 148, 151, 142, 146, 150,
+    145, 149, 153, 141, 145, 148, 144, 149, 153, 146, 150, 154, 141, 145, 148, 148, 152, 156, 141, 145, 148, 145, 149, 154,
+    142, 145, 148, 142, 145, 147, 142, 145, 148, 142, 145, 148, 145, 148, 151, 140, 142, 145, 140, 143, 146, 147, 150, 153,
+    137, 140, 143, 145, 148, 150, 143, 145, 148, 139, 142, 144, 147, 149, 152, 141, 144, 147, 140, 143, 146, 148, 151, 154,
+    137, 139, 142, 145, 148, 151, 145, 148, 151, 138, 141, 143, 147, 150, 153, 141, 144, 147, 140, 142, 145, 150, 153, 156,
+    136, 139, 141, 143, 146, 149, 145, 147, 150, 140, 143, 146, 145, 148, 151, 143, 146, 149, 141, 144, 147, 142, 144, 147,
+    146, 149, 152, 143, 145, 148, 138, 141, 143, 147, 149, 152, 139, 142, 145, 142, 145, 148, 147, 150, 153, 138, 141, 144,
+    146, 149, 152, 147, 150, 153, 140, 143, 145, 144, 147, 149, 145, 148, 150, 141, 144, 146, 143, 146, 149, 145, 148, 151,
+    144, 147, 150, 140, 143, 146, 144, 147, 150, 143, 146, 149, 141, 144, 146, 147, 150, 153, 141, 144, 147, 142, 145, 148,
+    146, 149, 151, 139, 142, 144, 145, 147, 150, 147, 150, 153, 137, 139, 142, 148, 151, 153, 144, 147, 150, 138, 140, 143,
+    131, 133, 136, 146, 149, 151, 149, 152, 154, 131, 133, 136, 149, 152, 155, 149, 151, 154, 129, 132, 134, 150, 153, 156,
+    147, 150, 152, 129, 131, 134, 152, 155, 158, 145, 148, 151, 128, 131, 133, 154, 157, 160, 141, 144, 146, 129, 131, 134,
+    155, 158, 161, 140, 143, 146, 131, 133, 135, 157, 160, 163, 138, 141, 143, 132, 135, 137, 157, 160, 163, 136, 139, 142,
+    134, 136, 139, 156, 159, 162, 135, 138, 140, 136, 138, 141, 155, 158, 161, 135, 137, 140, 140, 143, 145, 153, 156, 159,
+    152, 155, 157, 139, 142, 145, 141, 144, 146, 151, 154, 157, 139, 142, 145, 142, 145, 148, 153, 156, 159, 139, 141, 144,
+    146, 148, 151, 146, 149, 152, 139, 142, 144, 146, 149, 152, 143, 145, 148, 144, 147, 150, 144, 147, 150, 143, 145, 148,
+    142, 145, 147, 151, 154, 157, 137, 140, 142, 140, 143, 145, 156, 159, 162, 144, 147, 150, 132, 134, 137, 145, 148, 151,
+    150, 152, 155, 136, 139, 142, 144, 147, 150, 152, 155, 157, 136, 139, 141, 147, 149, 152, 150, 153, 156, 134, 137, 139,
+    132, 134, 137, 146, 149, 152, 153, 156, 159, 133, 136, 138, 134, 136, 139, 150, 152, 155, 121, 131, 167, 105, 128, 200,
+    121, 135, 183, 151, 154, 157, 126, 129, 131, 143, 146, 151, 101, 118, 172,  98, 123, 197, 132, 140, 165, 161, 164, 166,
+    132, 134, 137, 118, 123, 141,  86, 110, 182, 105, 124, 183, 124, 128, 135, 159, 162, 165, 148, 150, 153, 106, 117, 153,
+     89, 114, 188, 123, 134, 172, 136, 139, 141, 145, 148, 151, 153, 156, 159, 137, 139, 142, 139, 142, 145, 157, 160, 163,
+    158, 161, 164, 128, 130, 133, 124, 126, 129, 163, 167, 170, 146, 148, 151, 117, 119, 122,  54,  98, 196,  52, 106, 217,
+     50, 102, 208, 129, 135, 152, 165, 168, 172, 116, 124, 150,  48,  99, 203,  53, 107, 219,  74, 105, 187, 117, 119, 121,
+    155, 158, 161,  89, 108, 169,  50, 102, 209,  53, 107, 219, 132, 143, 183, 124, 127, 129, 101, 105, 119,  42,  86, 179,
+     51, 103, 211,  56, 107, 216, 164, 167, 171, 150, 153, 156, 116, 118, 121, 147, 150, 153, 157, 160, 164, 128, 130, 132,
+    130, 132, 135, 170, 174, 177, 138, 141, 143, 114, 116, 118, 156, 159, 162, 158, 161, 165,  42,  78, 157,  45,  91, 186,
+     43,  88, 180,  96, 103, 129, 116, 117, 119, 106, 113, 135,  39,  81, 166,  44,  91, 186,  73,  98, 169, 167, 170, 173,
+    115, 117, 119,  30,  59, 121,  41,  84, 172,  44,  91, 185,  89, 101, 141, 140, 143, 146,  72,  78,  94,  32,  67, 140,
+     43,  87, 178,  53,  95, 187, 130, 134, 143, 113, 115, 117, 162, 165, 169, 158, 161, 164, 111, 113, 115, 141, 144, 147,
+    123, 126, 128, 122, 125, 127, 168, 171, 175, 152, 154, 157, 113, 115, 117, 133, 137, 144,  44,  69, 127,  27,  56, 118,
+     43,  58, 100, 149, 151, 153, 152, 154, 157,  75,  77,  82,  31,  62, 128,  32,  64, 133,  91,  95, 108, 112, 114, 115,
+    125, 128, 131,  38,  45,  61,  26,  55, 114,  65,  85, 144, 167, 170, 175, 130, 132, 135,  43,  46,  51,  24,  39,  77,
+     30,  57, 116,  71,  88, 139, 120, 125, 138, 174, 177, 181, 145, 148, 151, 106, 108, 110, 152, 155, 158, 171, 174, 177,
+    170, 173, 177, 133, 136, 138, 120, 122, 124, 157, 160, 164, 149, 154, 170,  57, 102, 202,  53, 107, 219,  54,  99, 198,
+    132, 134, 142, 112, 113, 115, 137, 139, 142,  92, 112, 175,  51, 105, 214,  52, 105, 215, 131, 140, 174, 164, 166, 169,
+    122, 124, 126,  95, 102, 127,  47,  97, 198,  52, 107, 219,  81, 110, 191, 130, 131, 134, 167, 170, 173, 120, 122, 127,
+     52,  86, 168,  50, 103, 210,  62, 109, 214, 111, 119, 146, 115, 117, 119, 165, 169, 172, 163, 166, 169, 112, 114, 116,
+    146, 148, 151, 158, 161, 164, 139, 142, 145, 130, 132, 135, 108, 119, 157,  49, 101, 206,  52, 105, 214,  48,  98, 201,
+    108, 119, 159, 155, 157, 161, 130, 132, 136,  42,  86, 179,  51, 103, 211,  51, 105, 213,  72,  99, 173, 126, 127, 129,
+    141, 143, 146,  69,  86, 140,  47,  95, 197,  52, 106, 216,  50, 101, 207, 138, 142, 155, 124, 126, 128,  77,  83, 105,
+     40,  82, 170,  49, 100, 204,  52, 106, 216, 109, 126, 178, 162, 165, 168, 145, 148, 151, 117, 119, 121, 140, 143, 146,
+    133, 135, 138, 161, 164, 167, 145, 148, 150, 124, 126, 128, 102, 108, 130,  40,  82, 169,  43,  88, 181,  41,  84, 171,
+    110, 115, 133, 153, 156, 159, 117, 119, 125,  33,  66, 136,  41,  85, 175,  44,  89, 183,  88, 103, 152, 129, 131, 134,
+    113, 115, 118,  40,  56, 100,  37,  75, 156,  43,  88, 181,  51,  88, 172, 141, 143, 146,  94,  96,  99,  38,  46,  65,
+     29,  61, 128,  41,  83, 170,  44,  90, 184, 125, 134, 163, 151, 154, 157, 135, 137, 140, 133, 135, 138, 148, 151, 154,
+    110, 112, 114, 114, 116, 118, 170, 174, 177, 168, 171, 175, 105, 107, 108,  36,  45,  74,  28,  52, 104,  62,  68,  92,
+    107, 108, 110, 110, 111, 113, 139, 141, 145,  60,  67,  82,  29,  50, 100,  54,  67, 106, 149, 151, 153, 168, 170, 174,
+    113, 115, 117,  58,  61,  65,  21,  37,  73,  50,  64, 107,  98, 101, 111, 106, 108, 109, 137, 139, 142,  89,  93,  99,
+     30,  38,  60,  34,  53, 101, 126, 131, 150, 171, 173, 177, 124, 126, 128, 109, 111, 113, 158, 161, 164, 174, 178, 181,
+    177, 181, 184, 135, 137, 140, 103, 105, 107, 111, 120, 153,  92, 116, 188,  84, 108, 180,  85,  93, 121, 127, 128, 130,
+    171, 173, 177, 154, 156, 159, 105, 108, 119,  85, 105, 168,  73, 104, 185, 125, 134, 169, 114, 115, 117, 108, 110, 112,
+    158, 160, 163, 169, 172, 174, 101, 110, 145,  67,  98, 179,  96, 117, 183, 170, 173, 183, 134, 136, 139,  96,  97,  99,
+    131, 133, 135, 163, 166, 174,  88, 108, 170,  76, 105, 184, 117, 128, 165, 182, 185, 189, 157, 160, 163, 104, 105, 107,
+    152, 155, 158, 142, 145, 147, 117, 123, 144,  48,  98, 201,  53, 108, 220,  52, 107, 217,  48,  92, 186, 123, 126, 136,
+    143, 145, 148, 143, 145, 148,  87, 106, 166,  50, 102, 209,  53, 108, 220,  52, 105, 215, 113, 120, 148, 136, 138, 141,
+    140, 142, 144, 125, 128, 137,  44,  90, 187,  51, 105, 214,  53, 108, 221, 102, 125, 194, 135, 137, 140, 139, 141, 144,
+    127, 130, 135,  66,  89, 156,  47,  97, 198,  52, 106, 217,  56, 108, 218, 135, 142, 163, 135, 137, 140, 136, 138, 141,
+    135, 137, 139, 187, 190, 194, 133, 141, 168,  49, 101, 207,  53, 107, 219,  52, 106, 217,  44,  91, 187,  92, 100, 128,
+     92,  93,  95, 136, 138, 141,  57,  88, 167,  50, 102, 209,  52, 107, 218,  50, 103, 210, 124, 136, 180, 171, 174, 178,
+    112, 114, 117,  26,  48,  99,  44,  90, 186,  50, 103, 210,  53, 107, 218,  48,  97, 197, 123, 126, 130, 132, 136, 141,
+     51,  59,  82,  32,  67, 142,  45,  92, 190,  51, 104, 212,  53, 107, 218,  99, 114, 162,  93,  94,  96, 137, 140, 143,
+    127, 129, 131, 124, 126, 129, 118, 124, 144,  41,  84, 172,  46,  94, 192,  45,  92, 188,  38,  76, 158, 140, 142, 146,
+    153, 155, 157, 120, 122, 125,  30,  59, 120,  43,  88, 182,  46,  93, 192,  43,  88, 181,  92, 101, 133, 121, 122, 124,
+    118, 120, 124,  54,  62,  82,  38,  74, 153,  43,  88, 183,  46,  94, 191,  95, 116, 181, 155, 157, 160,  97,  99, 102,
+     35,  40,  47,  24,  51, 110,  38,  78, 161,  44,  91, 186,  47,  95, 194, 108, 117, 148, 160, 163, 166, 166, 170, 173,
+    104, 105, 107, 111, 112, 114, 155, 158, 161,  72,  82, 110,  35,  66, 132,  34,  59, 117,  95, 100, 117, 168, 170, 173,
+    166, 169, 173, 117, 119, 121,  62,  65,  72,  29,  55, 113,  32,  64, 130,  91, 100, 132, 107, 108, 109, 110, 111, 113,
+    152, 154, 156,  89,  94,  99,  34,  45,  80,  28,  58, 121,  67,  84, 136, 154, 157, 168, 163, 166, 169, 119, 121, 123,
+     73,  75,  77,  28,  36,  55,  26,  50, 102,  52,  73, 130,  92, 101, 134, 114, 115, 117, 158, 161, 164, 176, 179, 183,
+    168, 171, 174, 140, 143, 145, 111, 113, 115, 121, 123, 124, 146, 149, 152, 157, 159, 162, 131, 133, 135, 109, 111, 113,
+    126, 128, 130, 160, 163, 166, 159, 161, 164, 119, 120, 122,  97,  97,  99, 128, 130, 132, 163, 166, 169, 159, 161, 165,
+    125, 127, 130, 106, 107, 108, 126, 128, 130, 155, 157, 160, 153, 155, 157, 118, 120, 122, 107, 109, 110, 141, 143, 145,
+    172, 175, 178, 141, 143, 146, 102, 103, 104, 103, 104, 105, 147, 149, 152, 177, 180, 183, 146, 148, 151, 107, 109, 110,
+    179, 182, 186, 124, 129, 144,  62,  82, 141,  99, 111, 152, 165, 168, 177, 172, 175, 178, 129, 130, 133,  96,  97,  99,
+    127, 129, 131, 170, 173, 176, 155, 160, 178,  91, 106, 157,  76,  88, 130, 130, 131, 133, 172, 175, 178, 165, 168, 171,
+    120, 122, 124, 100, 101, 102, 133, 135, 137, 153, 159, 181, 127, 138, 179, 101, 109, 139, 102, 103, 105, 138, 140, 143,
+    175, 178, 181, 158, 161, 164, 116, 118, 119,  94,  97, 106, 112, 122, 159, 140, 152, 192, 142, 147, 165, 116, 118, 120,
+    112, 121, 152,  47,  97, 198,  50, 103, 211,  49, 101, 207,  57,  95, 184, 115, 119, 132, 150, 152, 155, 159, 162, 165,
+    136, 138, 141, 104, 113, 146,  49,  95, 194,  50, 102, 209,  50, 101, 207,  97, 115, 173, 116, 118, 121, 120, 122, 124,
+    145, 147, 150, 143, 146, 151,  78,  93, 142,  45,  92, 190,  50, 103, 210,  50, 101, 207, 140, 149, 180, 147, 149, 152,
+    119, 120, 122,  98, 100, 103, 102, 105, 113,  41,  68, 134,  44,  91, 187,  49, 101, 207,  53, 104, 210, 120, 132, 175,
+     50,  95, 191,  52, 106, 216,  53, 108, 220,  52, 107, 218,  48,  99, 203,  91, 104, 148, 177, 180, 184, 181, 184, 188,
+    129, 131, 135,  47,  85, 171,  50, 102, 209,  53, 108, 219,  53, 108, 219,  48,  98, 201,  76,  82, 108, 103, 105, 106,
+    150, 153, 156,  77,  86, 102,  38,  78, 162,  48,  99, 202,  52, 106, 217,  53, 108, 220,  91, 123, 211, 157, 160, 166,
+     97,  99, 102,  34,  37,  41,  25,  42,  86,  36,  76, 160,  46,  95, 195,  51, 104, 212,  53, 107, 219,  69, 113, 215,
+     47,  97, 198,  52, 107, 217,  53, 109, 222,  52, 107, 218,  46,  94, 191,  77,  93, 144, 133, 135, 137, 136, 137, 140,
+    122, 124, 130,  42,  86, 179,  51, 103, 211,  53, 108, 220,  53, 108, 221,  48,  99, 201, 120, 127, 151, 140, 142, 145,
+    114, 117, 119,  37,  47,  78,  37,  77, 160,  48,  99, 202,  52, 106, 216,  53, 109, 221,  50, 102, 208, 120, 125, 141,
+    120, 123, 126,  53,  59,  66,  32,  44,  79,  35,  72, 152,  45,  92, 189,  50, 103, 210,  53, 107, 219,  52, 107, 217,
+     51,  88, 173,  49, 100, 205,  49, 100, 204,  48,  97, 198,  42,  85, 174, 100, 103, 115,  79,  80,  81, 111, 113, 115,
+    130, 134, 141,  34,  71, 148,  47,  97, 199,  50, 102, 207,  49, 100, 205,  67,  98, 179, 180, 183, 193, 174, 177, 181,
+    115, 117, 119,  31,  33,  42,  31,  63, 131,  44,  89, 183,  49,  99, 203,  49, 100, 205,  46,  93, 191,  88,  89,  90,
+    140, 142, 145,  87,  94, 102,  53,  61,  75,  29,  60, 127,  40,  81, 168,  47,  97, 198,  50, 101, 206,  57, 100, 198,
+     90, 100, 132,  58,  90, 167,  42,  86, 176,  40,  76, 153,  92, 100, 130, 123, 124, 126, 106, 107, 109, 126, 128, 130,
+    152, 154, 158, 101, 106, 124,  40,  78, 158,  41,  83, 170,  61,  92, 170, 130, 134, 145, 161, 163, 166, 154, 156, 158,
+    129, 131, 133,  95,  97, 100,  60,  67,  91,  36,  68, 138,  41,  85, 173,  65,  95, 172, 104, 112, 140, 114, 115, 117,
+    135, 137, 139, 144, 147, 149,  89,  92,  96,  35,  47,  77,  30,  62, 130,  39,  81, 166,  53,  89, 171, 122, 133, 170,
+    162, 165, 168, 142, 144, 149, 104, 107, 118, 106, 108, 111, 131, 133, 135, 155, 158, 161, 160, 163, 166, 140, 142, 144,
+    118, 120, 122, 114, 115, 117, 127, 129, 133, 150, 152, 156, 154, 156, 159, 133, 134, 137, 113, 115, 116, 120, 122, 123,
+    144, 147, 150, 163, 166, 169, 151, 153, 155, 111, 112, 114,  90,  93, 102, 123, 125, 126, 150, 153, 155, 167, 170, 173,
+    146, 149, 152, 120, 122, 124, 107, 108, 110, 121, 123, 125, 150, 152, 156, 160, 162, 166, 138, 140, 143, 112, 114, 116,
+    194, 197, 201, 140, 143, 146,  87,  88,  89,  84,  85,  87, 138, 140, 143, 191, 195, 199, 190, 193, 198, 136, 138, 141,
+     84,  85,  86,  91,  92,  93, 144, 146, 148, 192, 195, 199, 182, 185, 189, 127, 129, 132,  79,  80,  82,  99, 100, 102,
+    153, 156, 159, 199, 203, 206, 175, 178, 181, 120, 122, 125,  74,  74,  75, 105, 107, 109, 161, 164, 167, 201, 205, 210,
+    166, 168, 172, 111, 113, 115,  74,  74,  75, 117, 118, 121, 171, 174, 178, 198, 201, 205, 154, 156, 159, 101, 102, 104,
+    156, 159, 163, 135, 138, 140, 116, 118, 120, 122, 125, 127, 141, 143, 145, 161, 164, 167, 155, 158, 161, 135, 137, 140,
+    118, 120, 122, 123, 125, 127, 142, 144, 147, 159, 162, 165, 152, 155, 158, 134, 136, 139, 117, 119, 121, 125, 127, 129,
+    142, 145, 148, 158, 161, 164, 150, 152, 155, 133, 136, 138, 119, 121, 124, 128, 130, 133, 142, 144, 147, 159, 162, 165,
+    149, 152, 156, 132, 134, 136, 121, 123, 125, 129, 132, 134, 145, 147, 150, 158, 161, 164, 146, 149, 152, 132, 134, 137,
+    132, 134, 136, 153, 156, 160, 166, 169, 172, 147, 150, 153, 127, 130, 132, 113, 115, 117, 128, 130, 133, 149, 152, 155,
+    165, 168, 172, 152, 154, 157, 130, 132, 134, 112, 114, 116, 123, 126, 128, 146, 149, 152, 164, 166, 170, 157, 160, 163,
+    133, 135, 138, 113, 115, 117, 121, 123, 125, 143, 146, 149, 166, 169, 172, 162, 165, 168, 136, 139, 141, 113, 115, 118,
+    116, 118, 121, 140, 143, 146, 166, 169, 173, 163, 166, 169, 138, 141, 143, 113, 114, 117, 114, 116, 118, 141, 144, 147
+};
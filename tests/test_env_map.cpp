@@ -0,0 +1,157 @@
+#include "test_common.h"
+
+#include <vector>
+
+#include "../internal/Core.h"
+#include "../internal/RendererSSE.h"
+
+void test_env_map() {
+    using namespace ray;
+
+    {   // RGBE round trip keeps 8 bits of mantissa of the largest channel
+        const float col[3] = { 1234.5f, 0.75f, 0.0f };
+
+        pixel_color8_t t;
+        EncodeRGBE(col, t);
+
+        float col2[3];
+        DecodeRGBE(t, col2);
+
+        require(std::abs(col2[0] - col[0]) < col[0] / 128);
+        require(std::abs(col2[1] - col[1]) < col[0] / 128);
+        require(col2[2] == 0.0f);
+    }
+
+    const int W = 64, H = 32;
+
+    // dim sky with bright spot
+    std::vector<pixel_color8_t> texels(W * H);
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            const bool spot = x >= 40 && x < 44 && y >= 8 && y < 12;
+            const float col[3] = { spot ? 100.0f : 0.1f, spot ? 90.0f : 0.2f, spot ? 80.0f : 0.3f };
+            EncodeRGBE(col, texels[y * W + x]);
+        }
+    }
+
+    const int res[2] = { W, H };
+
+    std::vector<env_cell_t> cells;
+    env_map_t env;
+    env.texels = &texels[0];
+    env.res[0] = W;
+    env.res[1] = H;
+    BuildEnvMapCells(&texels[0], res, cells, env.cells_res);
+    env.cells = &cells[0];
+
+    require(env.cells_res[0] == W && env.cells_res[1] == H);
+
+    {   // alias table reproduces cell probabilities
+        const int count = W * H;
+
+        std::vector<double> prob(count, 0.0);
+        double pdf_sum = 0.0;
+        for (int i = 0; i < count; i++) {
+            prob[i] += cells[i].q;
+            prob[cells[i].alias] += 1.0 - cells[i].q;
+            pdf_sum += cells[i].pdf;
+        }
+
+        require(std::abs(pdf_sum - 1.0) < 0.0001);
+        for (int i = 0; i < count; i++) {
+            require(std::abs(prob[i] / count - cells[i].pdf) < 0.00001);
+        }
+    }
+
+    {   // samples follow radiance and agree with pdf evaluation
+        const int SamplesCount = 65536;
+
+        int spot_hits = 0, pdf_mismatches = 0;
+
+        uint32_t rnd = 12345;
+        for (int i = 0; i < SamplesCount; i++) {
+            rnd = rnd * 1664525u + 1013904223u;
+            const float r1 = float(rnd >> 8) / (1 << 24);
+            rnd = rnd * 1664525u + 1013904223u;
+            const float r2 = float(rnd >> 8) / (1 << 24);
+
+            float dir[3];
+            const float pdf = SampleEnvMap(env, r1, r2, dir);
+            require(pdf > 0.0f);
+
+            const float pdf2 = EnvMapPdf(env, dir);
+            if (std::abs(pdf - pdf2) > 0.001f * pdf) pdf_mismatches++;
+
+            float col[3];
+            EvalEnvMap(env, dir, col);
+            if (col[0] > 10.0f) spot_hits++;
+        }
+
+        // only samples that land exactly on cell boundaries can disagree
+        require(pdf_mismatches < SamplesCount / 100);
+        // spot holds most of energy
+        require(spot_hits > SamplesCount / 2);
+    }
+
+    {   // packet versions used by SIMD backends agree with scalar ones
+        const int PacketsCount = 1024;
+
+        int mismatches = 0;
+
+        uint32_t rnd = 54321;
+        for (int i = 0; i < PacketsCount; i++) {
+            sse::simd_fvec4 r1, r2;
+            for (int j = 0; j < 4; j++) {
+                rnd = rnd * 1664525u + 1013904223u;
+                r1[j] = float(rnd >> 8) / (1 << 24);
+                rnd = rnd * 1664525u + 1013904223u;
+                r2[j] = float(rnd >> 8) / (1 << 24);
+            }
+
+            sse::simd_fvec4 dir[3], col[3];
+            const sse::simd_fvec4 pdf = sse::SampleEnvMap(env, r1, r2, dir), pdf2 = sse::EnvMapPdf(env, dir);
+            sse::EvalEnvMap(env, dir, col);
+
+            for (int j = 0; j < 4; j++) {
+                float _dir[3];
+                const float _pdf = SampleEnvMap(env, r1[j], r2[j], _dir);
+
+                require(std::abs(dir[0][j] - _dir[0]) < 0.0001f && std::abs(dir[1][j] - _dir[1]) < 0.0001f && std::abs(dir[2][j] - _dir[2]) < 0.0001f);
+                require(std::abs(pdf[j] - _pdf) < 0.001f * _pdf);
+
+                const float d[3] = { dir[0][j], dir[1][j], dir[2][j] };
+
+                float _col[3];
+                EvalEnvMap(env, d, _col);
+
+                for (int k = 0; k < 3; k++) {
+                    require(std::abs(col[k][j] - _col[k]) < 0.001f * std::max(_col[k], 1.0f));
+                }
+
+                // lookups of directions close to cell boundaries can round differently
+                if (std::abs(pdf2[j] - EnvMapPdf(env, d)) > 0.001f * pdf2[j]) mismatches++;
+            }
+        }
+
+        require(mismatches < PacketsCount * 4 / 100);
+    }
+
+    {   // pdf integrates to one over sphere
+        const int N = 512;
+
+        double sum = 0.0;
+        for (int j = 0; j < N; j++) {
+            for (int i = 0; i < N; i++) {
+                // uniform sphere directions
+                const float z = 1.0f - 2.0f * (j + 0.5f) / N, phi = 2 * PI * (i + 0.5f) / N;
+                const float r = std::sqrt(1.0f - z * z);
+                const float dir[3] = { r * std::cos(phi), z, r * std::sin(phi) };
+
+                sum += EnvMapPdf(env, dir);
+            }
+        }
+
+        const double integral = sum * 4 * PI / (N * N);
+        require(std::abs(integral - 1.0) < 0.02);
+    }
+}
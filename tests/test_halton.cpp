@@ -0,0 +1,84 @@
+#include "test_common.h"
+
+#include <cmath>
+#include <vector>
+
+#include "../internal/Core.h"
+#include "../internal/HaltonTable.h"
+
+namespace {
+/// Scalar scrambled radical inverse with runtime base, same as ray::ScrambledRadicalInverse
+double ScrambledRadicalInverse(int base, const int *perm, int a) {
+    const double inv_base = 1.0 / base;
+    double res = 0.0, inv_base_n = 1.0;
+    while (a) {
+        const int next = a / base, digit = a - next * base;
+        inv_base_n *= inv_base;
+        res += perm[digit] * inv_base_n;
+        a = next;
+    }
+    return res + inv_base_n * perm[0] / (base - 1);
+}
+}
+
+void test_halton() {
+    using namespace ray;
+
+    HaltonTable table;
+    const int *perms = table.permutations();
+
+    {   // batched points match scalar computation, index range covers many digits of each base
+        for (const int first_index : { 0, 1, 12345, 9999936 }) {
+            const int count = 64;
+
+            std::vector<float> points(HaltonDimsCount * count);
+            ComputeHaltonPoints(perms, first_index, count, &points[0]);
+
+            for (int d = 0; d < HaltonDimsCount; d++) {
+                for (int i = 0; i < count; i++) {
+                    const float p = points[d * count + i];
+                    require(p >= 0.0f && p < 1.0f);
+                    require(std::abs(p - ScrambledRadicalInverse(g_primes[d], &perms[g_prime_sums[d]], first_index + i)) < 0.000001);
+                }
+            }
+        }
+    }
+
+    {   // every dimension is stratified, aligned block of base^k points puts one point into each interval of 1/base^k
+        for (int d = 0; d < HaltonDimsCount; d++) {
+            const int base = g_primes[d];
+
+            int block = base;
+            while (block * base <= 1024) block *= base;
+
+            const int count = (block + 3) & ~3, first_index = 7 * block;
+
+            std::vector<float> points(HaltonDimsCount * count);
+            ComputeHaltonPoints(perms, first_index, count, &points[0]);
+
+            std::vector<int> hits(block, 0);
+            for (int i = 0; i < block; i++) {
+                hits[int(points[d * count + i] * block)]++;
+            }
+
+            for (int i = 0; i < block; i++) {
+                require(hits[i] == 1);
+            }
+        }
+    }
+
+    {   // regions share points while they stay within the same block of iterations
+        auto points1 = table.Get(1), points2 = table.Get(1);
+        require(points1 == points2);
+
+        auto points3 = table.Get(1 + HaltonSeqLen);
+        require(points3 != points1);
+
+        // previous points stay valid for regions that still use them
+        std::vector<float> expected(HaltonDimsCount * HaltonSeqLen);
+        ComputeHaltonPoints(perms, 1, HaltonSeqLen, &expected[0]);
+        for (int i = 0; i < HaltonDimsCount * HaltonSeqLen; i++) {
+            require(points1.get()[i] == expected[i]);
+        }
+    }
+}
@@ -27,7 +27,7 @@ void test_primary_ray_gen() {
 
     ray::ConstructCamera(ray::Persp, o, d, 90, &cam);
 
-    std::vector<float> dummy_halton(ray::HaltonSeqLen * 2);
+    std::vector<float> dummy_halton(ray::HaltonSeqLen * ray::HaltonDimsCount);
 
     {
         // test reference
@@ -182,31 +182,34 @@ void test_primary_ray_gen() {
         class TestRenderer : public ray::ocl::Renderer {
         public:
             TestRenderer() : ray::ocl::Renderer(4, 4) {
-                std::vector<float> dummy_halton(ray::HaltonSeqLen * 2);
-                cl_int error = queue_.enqueueWriteBuffer(halton_seq_buf_, CL_TRUE, 0, sizeof(float) * ray::HaltonSeqLen * 2, &dummy_halton[0]);
+                std::vector<float> dummy_halton(ray::HaltonSeqLen * ray::HaltonDimsCount);
+                cl_int error = queue_.enqueueWriteBuffer(halton_seq_buf_, CL_TRUE, 0, sizeof(float) * ray::HaltonSeqLen * ray::HaltonDimsCount, &dummy_halton[0]);
                 require(error == CL_SUCCESS);
 
                 // override host_no_access with host_read_only to check results
-                prim_rays_buf_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, sizeof(ray::ocl::ray_packet_t) * w_ * h_, nullptr, &error);
+                prim_rays_buf_ = cl::Buffer(context_, CL_MEM_WRITE_ONLY | CL_MEM_HOST_READ_ONLY, sizeof(ray::ocl::packed_ray_t) * w_ * h_, nullptr, &error);
             }
 
             void Test(const ray::camera_t &cam, const std::vector<float> &test_data) {
                 ray::ocl::camera_t cl_cam = { cam };
 
-                require(kernel_GeneratePrimaryRays(0, cl_cam, halton_seq_buf_, w_, h_, prim_rays_buf_));
+                require(kernel_GeneratePrimaryRays(0, cl_cam, { 0, 0, w_, h_ }, w_, h_, halton_seq_buf_, prim_rays_buf_));
 
-                std::vector<ray::ocl::ray_packet_t> rays(w_ * h_);
-                cl_int error = queue_.enqueueReadBuffer(prim_rays_buf_, CL_TRUE, 0, rays.size() * sizeof(ray::ocl::ray_packet_t), &rays[0]);
+                std::vector<ray::ocl::packed_ray_t> rays(w_ * h_);
+                cl_int error = queue_.enqueueReadBuffer(prim_rays_buf_, CL_TRUE, 0, rays.size() * sizeof(ray::ocl::packed_ray_t), &rays[0]);
                 require(error == CL_SUCCESS);
 
                 require(rays.size() == 16);
                 for (int i = 0; i < 16; i++) {
-                    require(rays[i].o.x == Approx(primary_ray_gen_test_data[i * 7 + 1]));
-                    require(rays[i].o.y == Approx(primary_ray_gen_test_data[i * 7 + 2]));
-                    require(rays[i].o.z == Approx(primary_ray_gen_test_data[i * 7 + 3]));
-                    require(rays[i].d.x == Approx(primary_ray_gen_test_data[i * 7 + 4]));
-                    require(rays[i].d.y == Approx(primary_ray_gen_test_data[i * 7 + 5]));
-                    require(rays[i].d.z == Approx(primary_ray_gen_test_data[i * 7 + 6]));
+                    float d[3];
+                    ray::ocl::DecodeOctahedral(rays[i].d, d);
+
+                    require(rays[i].o[0] == Approx(primary_ray_gen_test_data[i * 7 + 1]));
+                    require(rays[i].o[1] == Approx(primary_ray_gen_test_data[i * 7 + 2]));
+                    require(rays[i].o[2] == Approx(primary_ray_gen_test_data[i * 7 + 3]));
+                    require(d[0] == Approx(primary_ray_gen_test_data[i * 7 + 4]));
+                    require(d[1] == Approx(primary_ray_gen_test_data[i * 7 + 5]));
+                    require(d[2] == Approx(primary_ray_gen_test_data[i * 7 + 6]));
                 }
             }
         };
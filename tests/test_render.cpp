@@ -0,0 +1,383 @@
+#include "test_common.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "../RendererFactory.h"
+#include "../internal/simd/detect.h"
+
+#if !defined(DISABLE_OCL)
+#include "../internal/MultiRendererOCL.h"
+#endif
+
+// define to print new reference images (rendered with Ref backend) instead of comparing with stored ones
+//#define UPDATE_RENDER_REFERENCES
+
+namespace {
+const int W = 32, H = 32, SamplesCount = 64;
+
+// backends are not bit exact (FMA, packet order of sampling), so per-pixel error allows for noise,
+// while error of block averages catches systematic differences (e.g. wrong shading of material)
+const double MaxPixelRMSE = 0.02, MaxBlockRMSE = 0.005;
+
+/// Triangle list with PxyzNxyzTuv layout, all triangles use one material
+struct geometry_t {
+    std::vector<float> attrs;
+    std::vector<uint32_t> indices;
+};
+
+void Normalize(float v[3]) {
+    const float l = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    v[0] /= l; v[1] /= l; v[2] /= l;
+}
+
+geometry_t GenerateSphere(float radius, int slices, int stacks) {
+    geometry_t g;
+
+    for (int j = 0; j <= stacks; j++) {
+        const float theta = 3.14159265f * j / stacks;
+        for (int i = 0; i <= slices; i++) {
+            const float phi = 2 * 3.14159265f * i / slices;
+            const float n[3] = { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+            g.attrs.insert(g.attrs.end(), { radius * n[0], radius * n[1], radius * n[2], n[0], n[1], n[2], float(i) / slices, float(j) / stacks });
+        }
+    }
+
+    for (int j = 0; j < stacks; j++) {
+        for (int i = 0; i < slices; i++) {
+            const uint32_t i0 = j * (slices + 1) + i, i1 = i0 + slices + 1;
+            if (j != 0) g.indices.insert(g.indices.end(), { i0, i0 + 1, i1 });
+            if (j != stacks - 1) g.indices.insert(g.indices.end(), { i0 + 1, i1 + 1, i1 });
+        }
+    }
+
+    return g;
+}
+
+/// Quad in xz plane, slightly tilted, ray sorting expects scene bounds to have volume
+geometry_t GenerateGround(float size, float y) {
+    geometry_t g;
+    g.attrs = { -size, y - 0.01f, -size,    0, 1, 0,    0, 0,
+                 size, y - 0.01f, -size,    0, 1, 0,    4, 0,
+                 size, y + 0.01f,  size,    0, 1, 0,    4, 4,
+                -size, y + 0.01f,  size,    0, 1, 0,    0, 4 };
+    g.indices = { 0, 2, 1, 0, 3, 2 };
+    return g;
+}
+
+uint32_t AddMesh(ray::SceneBase &scene, const geometry_t &g, uint32_t mat) {
+    ray::mesh_desc_t mesh_desc;
+    mesh_desc.prim_type = ray::TriangleList;
+    mesh_desc.layout = ray::PxyzNxyzTuv;
+    mesh_desc.vtx_attrs = &g.attrs[0];
+    mesh_desc.vtx_attrs_count = g.attrs.size() / 8;
+    mesh_desc.vtx_indices = &g.indices[0];
+    mesh_desc.vtx_indices_count = g.indices.size();
+    mesh_desc.shapes.push_back({ mat, 0, g.indices.size() });
+    return scene.AddMesh(mesh_desc);
+}
+
+void AddInstance(ray::SceneBase &scene, uint32_t mesh, float x, float y, float z, float angle = 0.0f) {
+    const float c = std::cos(angle), s = std::sin(angle);
+    const float xform[16] = { c, 0, -s, 0,
+                              0, 1, 0, 0,
+                              s, 0, c, 0,
+                              x, y, z, 1 };
+    scene.AddMeshInstance(mesh, xform);
+}
+
+/// Procedural scene, filled in the same way for every backend
+struct test_scene_t {
+    const char *name;
+    void (*build)(ray::SceneBase &scene);
+    const std::vector<uint8_t> &reference;  ///< 8-bit RGB image rendered with Ref backend
+};
+
+void SetupEnvironment(ray::SceneBase &scene, float sun_strength) {
+    ray::environment_desc_t env = {};
+    env.sun_dir[0] = 0.3f; env.sun_dir[1] = 1.0f; env.sun_dir[2] = 0.4f;
+    Normalize(env.sun_dir);
+    env.sun_col[0] = env.sun_col[1] = env.sun_col[2] = sun_strength;
+    env.sky_col[0] = 0.4f; env.sky_col[1] = 0.5f; env.sky_col[2] = 0.6f;
+    env.sun_softness = 0.0f;
+    scene.SetEnvironment(env);
+}
+
+/// Checker texture, pass equal colors for plain white or grey texture
+uint32_t AddCheckerTexture(ray::SceneBase &scene, uint8_t c0, uint8_t c1) {
+    std::vector<ray::pixel_color8_t> texels(8 * 8);
+    for (int y = 0; y < 8; y++) {
+        for (int x = 0; x < 8; x++) {
+            const uint8_t c = ((x + y) % 2) ? c1 : c0;
+            texels[y * 8 + x] = { c, c, c, 255 };
+        }
+    }
+
+    ray::tex_desc_t tex_desc = {};
+    tex_desc.data = &texels[0];
+    tex_desc.w = tex_desc.h = 8;
+    tex_desc.generate_mipmaps = true;
+    return scene.AddTexture(tex_desc);
+}
+
+/// Adds camera looking at origin
+void SetCamera(ray::SceneBase &scene, float x, float y, float z, float fov) {
+    const float origin[3] = { x, y, z };
+    float fwd[3] = { -x, -y, -z };
+    Normalize(fwd);
+    scene.set_current_cam(scene.AddCamera(ray::Persp, origin, fwd, fov));
+}
+
+/// Diffuse sphere on textured ground, covers texture sampling and shadows
+void BuildDiffuseScene(ray::SceneBase &scene) {
+    using namespace ray;
+
+    SetupEnvironment(scene, 1.0f);
+
+    mat_desc_t mat_desc;
+    mat_desc.type = DiffuseMaterial;
+    mat_desc.main_texture = AddCheckerTexture(scene, 40, 230);
+    const uint32_t ground_mat = scene.AddMaterial(mat_desc);
+
+    mat_desc.main_texture = AddCheckerTexture(scene, 255, 255);
+    mat_desc.main_color[0] = 0.8f; mat_desc.main_color[1] = 0.3f; mat_desc.main_color[2] = 0.2f;
+    const uint32_t sphere_mat = scene.AddMaterial(mat_desc);
+
+    AddInstance(scene, AddMesh(scene, GenerateGround(4.0f, -1.0f), ground_mat), 0, 0, 0);
+    AddInstance(scene, AddMesh(scene, GenerateSphere(1.0f, 24, 12), sphere_mat), 0, 0, 0);
+
+    SetCamera(scene, 0.0f, 1.5f, 4.0f, 45.0f);
+}
+
+/// Glossy, glass and emissive spheres, covers specular paths and light sources
+void BuildMaterialsScene(ray::SceneBase &scene) {
+    using namespace ray;
+
+    SetupEnvironment(scene, 0.5f);
+
+    mat_desc_t mat_desc;
+    mat_desc.type = DiffuseMaterial;
+    mat_desc.main_texture = AddCheckerTexture(scene, 40, 230);
+    const uint32_t ground_mat = scene.AddMaterial(mat_desc);
+
+    mat_desc.type = GlossyMaterial;
+    mat_desc.main_texture = AddCheckerTexture(scene, 255, 255);
+    mat_desc.main_color[0] = 0.9f; mat_desc.main_color[1] = 0.8f; mat_desc.main_color[2] = 0.5f;
+    mat_desc.roughness = 0.05f;
+    const uint32_t glossy_mat = scene.AddMaterial(mat_desc);
+
+    mat_desc.type = RefractiveMaterial;
+    mat_desc.main_color[0] = mat_desc.main_color[1] = mat_desc.main_color[2] = 1.0f;
+    mat_desc.roughness = 0.0f;
+    mat_desc.ior = 1.5f;
+    const uint32_t glass_mat = scene.AddMaterial(mat_desc);
+
+    mat_desc.type = EmissiveMaterial;
+    mat_desc.main_color[0] = 1.0f; mat_desc.main_color[1] = 0.6f; mat_desc.main_color[2] = 0.3f;
+    mat_desc.strength = 4.0f;
+    const uint32_t light_mat = scene.AddMaterial(mat_desc);
+
+    const geometry_t sphere = GenerateSphere(0.6f, 24, 12);
+
+    AddInstance(scene, AddMesh(scene, GenerateGround(4.0f, -0.6f), ground_mat), 0, 0, 0);
+    AddInstance(scene, AddMesh(scene, sphere, glossy_mat), -1.3f, 0, 0);
+    AddInstance(scene, AddMesh(scene, sphere, glass_mat), 0, 0, 0.5f);
+    AddInstance(scene, AddMesh(scene, sphere, light_mat), 1.3f, 0, 0);
+
+    SetCamera(scene, 0.0f, 1.5f, 4.0f, 60.0f);
+}
+
+/// Grid of rotated instances of one mesh, covers macro tree and ray transformation
+void BuildInstancesScene(ray::SceneBase &scene) {
+    using namespace ray;
+
+    SetupEnvironment(scene, 1.0f);
+
+    mat_desc_t mat_desc;
+    mat_desc.type = DiffuseMaterial;
+    mat_desc.main_texture = AddCheckerTexture(scene, 40, 230);
+    const uint32_t ground_mat = scene.AddMaterial(mat_desc);
+
+    mat_desc.main_texture = AddCheckerTexture(scene, 255, 255);
+    mat_desc.main_color[0] = 0.2f; mat_desc.main_color[1] = 0.4f; mat_desc.main_color[2] = 0.8f;
+    const uint32_t sphere_mat = scene.AddMaterial(mat_desc);
+
+    AddInstance(scene, AddMesh(scene, GenerateGround(8.0f, -0.5f), ground_mat), 0, 0, 0);
+
+    // coarse tessellation, so that rotation of instances is visible
+    const uint32_t sphere = AddMesh(scene, GenerateSphere(0.5f, 8, 4), sphere_mat);
+    for (int z = 0; z < 4; z++) {
+        for (int x = 0; x < 4; x++) {
+            AddInstance(scene, sphere, (x - 1.5f) * 1.5f, 0, (z - 1.5f) * 1.5f, 0.4f * (x + 2 * z));
+        }
+    }
+
+    SetCamera(scene, 0.0f, 5.0f, 5.0f, 60.0f);
+}
+
+/// Renders scene to SamplesCount samples, returns time in milliseconds
+double RenderScene(ray::RendererBase &r, const test_scene_t &ts, std::vector<uint8_t> &out_rgb) {
+    using namespace ray;
+
+    const auto time_start = std::chrono::high_resolution_clock::now();
+
+    auto scene = r.CreateScene();
+    ts.build(*scene);
+
+    r.Resize(W, H);
+    r.Clear();
+
+    RegionContext region({ 0, 0, W, H });
+    for (int i = 0; i < SamplesCount; i++) {
+        r.RenderScene(scene, region);
+    }
+
+    const pixel_color_t *pixels = r.get_pixels_ref();
+    const double elapsed = std::chrono::duration<double, std::milli>{ std::chrono::high_resolution_clock::now() - time_start }.count();
+
+    out_rgb.resize(W * H * 3);
+    for (int i = 0; i < W * H; i++) {
+        out_rgb[i * 3 + 0] = uint8_t(pixels[i].r * 255 + 0.5f);
+        out_rgb[i * 3 + 1] = uint8_t(pixels[i].g * 255 + 0.5f);
+        out_rgb[i * 3 + 2] = uint8_t(pixels[i].b * 255 + 0.5f);
+    }
+
+    return elapsed;
+}
+
+/** Root mean square error of image, block_size > 1 compares averages of blocks,
+    which is insensitive to noise, but shows systematic differences
+*/
+double RMSE(const uint8_t *img1, const uint8_t *img2, int block_size) {
+    double sum = 0.0;
+    int count = 0;
+
+    for (int by = 0; by < H; by += block_size) {
+        for (int bx = 0; bx < W; bx += block_size) {
+            for (int c = 0; c < 3; c++) {
+                double avg1 = 0.0, avg2 = 0.0;
+                for (int y = by; y < by + block_size; y++) {
+                    for (int x = bx; x < bx + block_size; x++) {
+                        avg1 += img1[(y * W + x) * 3 + c];
+                        avg2 += img2[(y * W + x) * 3 + c];
+                    }
+                }
+
+                const double diff = (avg1 - avg2) / (255.0 * block_size * block_size);
+                sum += diff * diff;
+                count++;
+            }
+        }
+    }
+
+    return std::sqrt(sum / count);
+}
+}
+
+void test_render() {
+    using namespace ray;
+
+    extern std::vector<uint8_t> render_diffuse_ref, render_materials_ref, render_instances_ref;
+
+    const test_scene_t scenes[] = {
+        { "diffuse", BuildDiffuseScene, render_diffuse_ref },
+        { "materials", BuildMaterialsScene, render_materials_ref },
+        { "instances", BuildInstancesScene, render_instances_ref },
+    };
+
+    const auto features = GetCpuFeatures();
+
+    struct backend_t {
+        eRendererType type;
+        const char *name;
+        bool supported;
+    } backends[] = {
+        { RendererRef, "Ref", true },
+#if !defined(__ANDROID__)
+        { RendererSSE, "SSE", features.sse2_supported },
+        { RendererAVX, "AVX", features.avx_supported },
+        { RendererAVX2, "AVX2", features.avx2_supported && features.fma_supported },
+        { RendererAVX16, "AVX16", features.avx2_supported && features.fma_supported },
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+        { RendererNEON, "NEON", true },
+#elif defined(__i386__) || defined(__x86_64__)
+        { RendererSSE, "SSE", features.sse2_supported },
+#endif
+#if !defined(DISABLE_OCL)
+        { RendererOCL, "OCL", true },
+#endif
+    };
+
+    settings_t s;
+    s.w = W;
+    s.h = H;
+
+    for (const auto &b : backends) {
+        if (!b.supported) {
+            std::cout << "Cannot test " << b.name << " backend" << std::endl;
+            continue;
+        }
+
+        std::stringstream log;
+        auto r = CreateRenderer(s, b.type, log);
+        if (r->type() != b.type) {
+            std::cout << "Cannot test " << b.name << " backend" << std::endl;
+            continue;
+        }
+
+        for (const test_scene_t &ts : scenes) {
+            std::vector<uint8_t> rgb;
+            const double elapsed = RenderScene(*r, ts, rgb);
+
+#if defined(UPDATE_RENDER_REFERENCES)
+            if (b.type == RendererRef) {
+                printf("std::vector<uint8_t> render_%s_ref = {", ts.name);
+                for (size_t i = 0; i < rgb.size(); i++) {
+                    printf(i % 24 ? " %3u," : "\n    %3u,", rgb[i]);
+                }
+                printf("\n};\n\n");
+            }
+#else
+            require(ts.reference.size() == rgb.size());
+
+            const double rmse = RMSE(&rgb[0], &ts.reference[0], 1), block_rmse = RMSE(&rgb[0], &ts.reference[0], 4);
+            printf("Render %-10s %-5s: %8.2f ms, RMSE %.4f, RMSE of 4x4 blocks %.4f\n", ts.name, b.name, elapsed, rmse, block_rmse);
+
+            require(rmse < MaxPixelRMSE);
+            require(block_rmse < MaxBlockRMSE);
+#endif
+        }
+    }
+
+#if !defined(DISABLE_OCL)
+    {   // frame split between two renderers (the same device is used twice if there is only one) matches single renderer
+        std::unique_ptr<ocl::Renderer> single;
+        std::unique_ptr<ocl::MultiRenderer> multi;
+        try {
+            single.reset(new ocl::Renderer(W, H));
+            multi.reset(new ocl::MultiRenderer(W, H, { { -1, -1 }, { -1, -1 } }));
+        } catch (std::runtime_error &) {
+        }
+
+        if (single && multi) {
+            for (const test_scene_t &ts : scenes) {
+                std::vector<uint8_t> rgb1, rgb2;
+                RenderScene(*single, ts, rgb1);
+                const double elapsed = RenderScene(*multi, ts, rgb2);
+
+                const double rmse = RMSE(&rgb2[0], &rgb1[0], 1), block_rmse = RMSE(&rgb2[0], &rgb1[0], 4);
+                printf("Render %-10s OCLx2: %8.2f ms, RMSE %.4f, RMSE of 4x4 blocks %.4f\n", ts.name, elapsed, rmse, block_rmse);
+
+                require(rmse < MaxPixelRMSE);
+                require(block_rmse < MaxBlockRMSE);
+            }
+        } else {
+            std::cout << "Cannot test OCL backend on several devices" << std::endl;
+        }
+    }
+#endif
+}
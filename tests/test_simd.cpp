@@ -1,8 +1,79 @@
 #include "test_common.h"
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 #include "../internal/Core.h"
+#include "../internal/simd/detect.h"
+
+namespace {
+/// Distance between floats in units in the last place, matching NaNs are equal
+long long UlpDist(float a, float b) {
+    if (std::isnan(a) && std::isnan(b)) return 0;
+
+    int32_t ia, ib;
+    memcpy(&ia, &a, sizeof(float));
+    memcpy(&ib, &b, sizeof(float));
+    // map sign-magnitude to linear order
+    const long long la = ia < 0 ? (long long)INT32_MIN - ia : ia,
+                    lb = ib < 0 ? (long long)INT32_MIN - ib : ib;
+    return std::abs(la - lb);
+}
+
+/** Evaluates vectorized function W arguments at a time on evenly spaced arguments from [lo, hi],
+    returns max error against reference. Function loads and stores values itself, so that it is compiled
+    for instruction set of tested backend
+*/
+template <int W, typename F, typename G>
+long long MaxUlpError(F func, G ref_func, float lo, float hi) {
+    const int N = 1 << 16;
+
+    long long ret = 0;
+    for (int i = 0; i < N; i += W) {
+        float x[W], res[W];
+        for (int j = 0; j < W; j++) {
+            x[j] = lo + (hi - lo) * float(i + j) / (N - 1);
+        }
+        func(x, res);
+        for (int j = 0; j < W; j++) {
+            ret = std::max(ret, UlpDist(res[j], (float)ref_func(double(x[j]))));
+        }
+    }
+    return ret;
+}
+
+/// Same for function of two arguments, evaluated on grid
+template <int W, typename F, typename G>
+long long MaxUlpError(F func, G ref_func, float lo1, float hi1, float lo2, float hi2) {
+    const int N = 1 << 8;
+
+    long long ret = 0;
+    for (int i = 0; i < N; i++) {
+        for (int k = 0; k < N; k += W) {
+            float x1[W], x2[W], res[W];
+            for (int j = 0; j < W; j++) {
+                x1[j] = lo1 + (hi1 - lo1) * float(i) / (N - 1);
+                x2[j] = lo2 + (hi2 - lo2) * float(k + j) / (N - 1);
+            }
+            func(x1, x2, res);
+            for (int j = 0; j < W; j++) {
+                ret = std::max(ret, UlpDist(res[j], (float)ref_func(double(x1[j]), double(x2[j]))));
+            }
+        }
+    }
+    return ret;
+}
+}
+
+#define TEST_ULP1(W, func, lo, hi, max_ulp)                                                                 \
+    require(MaxUlpError<W>([](const float *x, float *out) { func(simd_fvec<W>{ x }).copy_to(out); },       \
+                           [](double x) { return std::func(x); }, lo, hi) <= max_ulp)
+
+#define TEST_ULP2(W, func, lo1, hi1, lo2, hi2, max_ulp)                                                     \
+    require(MaxUlpError<W>([](const float *x1, const float *x2, float *out) {                                \
+                               func(simd_fvec<W>{ x1 }, simd_fvec<W>{ x2 }).copy_to(out);                    \
+                           }, [](double x1, double x2) { return std::func(x1, x2); }, lo1, hi1, lo2, hi2) <= max_ulp)
 
 #if !defined(__ANDROID__)
 
@@ -24,6 +95,13 @@ void test_simd_sse() {
 #undef USE_SSE
 #undef NS
 
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx")
+#endif
+
 #define NS avx
 #define USE_AVX
 #include "../internal/simd/simd_vec.h"
@@ -34,12 +112,54 @@ void test_simd_avx() {
 #undef USE_AVX
 #undef NS
 
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2,fma")
+#endif
+
+#define NS avx2
+#define USE_AVX
+#define USE_AVX2
+#include "../internal/simd/simd_vec.h"
+
+void test_simd_avx2() {
+#include "test_simd.ipp"
+}
+#undef USE_AVX2
+#undef USE_AVX
+#undef NS
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
 #endif
 
 void test_simd() {
 #if !defined(__ANDROID__)
     test_simd_ref();
     test_simd_sse();
-    test_simd_avx();
+
+    const auto features = ray::GetCpuFeatures();
+    if (features.avx_supported) {
+        test_simd_avx();
+    } else {
+        std::cout << "Cannot test AVX" << std::endl;
+    }
+    if (features.avx2_supported && features.fma_supported) {
+        test_simd_avx2();
+    } else {
+        std::cout << "Cannot test AVX2" << std::endl;
+    }
 #endif
 }
\ No newline at end of file
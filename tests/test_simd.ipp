@@ -453,4 +453,193 @@ using namespace ray::NS;
     require(v6[7] == 2);
 
     std::cout << "OK" << std::endl;
-}
\ No newline at end of file
+}
+{
+    std::cout << "Test simd fmadd/gather | ";
+
+    // values are small integers, so fused and separate operations give exact results
+    simd_fvec4 a4 = { 1.0f, 2.0f, 3.0f, 4.0f }, b4 = { 2.0f, 3.0f, 4.0f, 5.0f }, c4 = { 0.5f, -1.0f, 2.0f, 8.0f };
+    simd_fvec8 a8 = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f },
+               b8 = { 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f, 8.0f, 9.0f },
+               c8 = { 0.5f, -1.0f, 2.0f, 8.0f, 0.0f, 1.0f, -2.0f, 4.0f };
+
+    const auto r4 = fmadd(a4, b4, c4), s4 = fmsub(a4, 2.0f, c4);
+    const auto r8 = fmadd(a8, b8, c8), s8 = fmsub(a8, 2.0f, c8);
+
+    for (int i = 0; i < 4; i++) {
+        require(r4[i] == a4[i] * b4[i] + c4[i]);
+        require(s4[i] == a4[i] * 2.0f - c4[i]);
+    }
+    for (int i = 0; i < 8; i++) {
+        require(r8[i] == a8[i] * b8[i] + c8[i]);
+        require(s8[i] == a8[i] * 2.0f - c8[i]);
+    }
+
+    float ftable[32];
+    int itable[32];
+    for (int i = 0; i < 32; i++) {
+        ftable[i] = 1.5f * i;
+        itable[i] = 1000 - i;
+    }
+
+    const simd_ivec4 idx4 = { 3, 0, 31, 7 };
+    const simd_ivec8 idx8 = { 3, 0, 31, 7, 16, 16, 1, 30 };
+
+    const simd_fvec4 fg4 = gather(&ftable[0], idx4);
+    const simd_ivec4 ig4 = gather(&itable[0], idx4);
+    const simd_fvec8 fg8 = gather(&ftable[0], idx8);
+    const simd_ivec8 ig8 = gather(&itable[0], idx8);
+
+    for (int i = 0; i < 4; i++) {
+        require(fg4[i] == ftable[idx4[i]]);
+        require(ig4[i] == itable[idx4[i]]);
+    }
+    for (int i = 0; i < 8; i++) {
+        require(fg8[i] == ftable[idx8[i]]);
+        require(ig8[i] == itable[idx8[i]]);
+    }
+
+    std::cout << "OK" << std::endl;
+}
+
+{
+    std::cout << "Test simd_ivec8 compare/shift | ";
+
+    const simd_ivec8 v1 = { 1, -2, 3, 4, 5, 6, 7, 8 },
+                     v2 = { 1, 2, 3, 0, 9, 6, 0, 8 };
+
+    const simd_ivec8 eq = v1 == v2, lt = v1 < v2, gt = v1 > v2,
+                     vmin = min(v1, v2), vmax = max(v1, v2);
+
+    for (int i = 0; i < 8; i++) {
+        require(eq[i] == (v1[i] == v2[i] ? -1 : 0));
+        require(lt[i] == (v1[i] < v2[i] ? -1 : 0));
+        require(gt[i] == (v1[i] > v2[i] ? -1 : 0));
+        require(vmin[i] == std::min(v1[i], v2[i]));
+        require(vmax[i] == std::max(v1[i], v2[i]));
+    }
+
+    simd_ivec8 v3 = v1;
+    where(gt, v3) = v2;
+
+    // right shift of negative values is not the same across backends
+    const simd_ivec8 v4 = { 1, 200, 3, 4, 5, 6, 7, 1024 };
+    const simd_ivec8 shl = v1 << 3, shr = v4 >> 1,
+                     shlv = v1 << simd_ivec8{ 0, 1, 2, 3, 4, 5, 6, 7 }, shrv = v4 >> simd_ivec8{ 7, 6, 5, 4, 3, 2, 1, 0 };
+
+    for (int i = 0; i < 8; i++) {
+        require(v3[i] == (v1[i] > v2[i] ? v2[i] : v1[i]));
+        require(shl[i] == int(uint32_t(v1[i]) << 3));
+        require(shr[i] == (v4[i] >> 1));
+        require(shlv[i] == int(uint32_t(v1[i]) << i));
+        require(shrv[i] == (v4[i] >> (7 - i)));
+    }
+
+    require((v1 * v2)[4] == 45);
+    require((v1 * 3)[1] == -6);
+
+    std::cout << "OK" << std::endl;
+}
+
+{
+    std::cout << "Test simd_fvec16/simd_ivec16 native? = " << simd_fvec16::is_native() << " | ";
+
+    float fa[16], fb[16];
+    int ia[16], ib[16], ic[16];
+    for (int i = 0; i < 16; i++) {
+        fa[i] = float(i + 1);
+        fb[i] = float(16 - i) * 0.5f;
+        ia[i] = i * 3 - 7;
+        ib[i] = 40 - i * 5;
+        ic[i] = i * 37; // right shift of negative values is not the same across backends
+    }
+
+    const simd_fvec16 v1 = { &fa[0] }, v2 = { &fb[0] };
+    const simd_ivec16 iv1 = { &ia[0] }, iv2 = { &ib[0] };
+
+    const simd_fvec16 sum = v1 + v2, diff = v1 - 2.0f, prod = v1 * v2, quot = 1.0f / v1,
+                      vmin = min(v1, v2), vmax = max(v1, v2), fma = fmadd(v1, v2, v1), fl = floor(v2);
+    const simd_fvec16 lt = v1 < v2, ge = v1 >= 8.0f;
+
+    simd_fvec16 blended = v1;
+    where(lt, blended) = v2;
+
+    const simd_ivec16 isum = iv1 + iv2, iprod = iv1 * 3, ieq = iv1 == iv2, igt = iv1 > iv2,
+                      shl = iv1 << 2, shr = simd_ivec16{ &ic[0] } >> 2;
+    const simd_ivec16 conv = (simd_ivec16)v1;
+    const simd_fvec16 iconv = (simd_fvec16)iv1;
+
+    float out[16];
+    sum.copy_to(&out[0]);
+
+    for (int i = 0; i < 16; i++) {
+        require(out[i] == fa[i] + fb[i]);
+        require(diff[i] == fa[i] - 2.0f);
+        require(prod[i] == fa[i] * fb[i]);
+        require(quot[i] == Approx(1.0f / fa[i]));
+        require(vmin[i] == std::min(fa[i], fb[i]));
+        require(vmax[i] == std::max(fa[i], fb[i]));
+        require(fma[i] == fa[i] * fb[i] + fa[i]);
+        require(fl[i] == std::floor(fb[i]));
+        require(blended[i] == (fa[i] < fb[i] ? fb[i] : fa[i]));
+        require((ge[i] != 0.0f) == (fa[i] >= 8.0f));
+
+        require(isum[i] == ia[i] + ib[i]);
+        require(iprod[i] == ia[i] * 3);
+        require(ieq[i] == (ia[i] == ib[i] ? -1 : 0));
+        require(igt[i] == (ia[i] > ib[i] ? -1 : 0));
+        require(shl[i] == int(uint32_t(ia[i]) << 2));
+        require(shr[i] == (ic[i] >> 2));
+        require(conv[i] == i + 1);
+        require(iconv[i] == float(ia[i]));
+    }
+
+    const simd_ivec16 zeros = { 0 }, last = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -1 };
+    require(zeros.all_zeros());
+    require(!last.all_zeros());
+    require(last.not_all_zeros());
+    require(last.all_zeros(simd_ivec16{ -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0 }));
+
+    int itable[32];
+    for (int i = 0; i < 32; i++) {
+        itable[i] = 1000 - i;
+    }
+    const simd_ivec16 idx = { 3, 0, 31, 7, 16, 16, 1, 30, 2, 9, 11, 5, 28, 17, 4, 22 };
+    const simd_ivec16 g = gather(&itable[0], idx);
+    for (int i = 0; i < 16; i++) {
+        require(g[i] == itable[idx[i]]);
+    }
+
+    std::cout << "OK" << std::endl;
+}
+
+{
+    std::cout << "Test simd math | ";
+
+    // native width along with generic one, bounds are measured error with small margin
+    TEST_ULP1(4, exp, -87.0f, 88.0f, 2);
+    TEST_ULP1(4, exp2, -126.0f, 127.0f, 2);
+    TEST_ULP1(4, log, 0.5f, 2.0f, 3);
+    TEST_ULP1(4, log, 1e-30f, 1e30f, 2);
+    TEST_ULP1(4, log2, 0.5f, 2.0f, 4);
+    TEST_ULP1(4, log2, 1e-30f, 1e30f, 2);
+    TEST_ULP1(4, sin, -100.0f, 100.0f, 2);
+    TEST_ULP1(4, cos, -100.0f, 100.0f, 2);
+    TEST_ULP1(4, acos, -1.0f, 1.0f, 2);
+    TEST_ULP2(4, atan2, -10.0f, 10.0f, -10.0f, 10.0f, 4);
+    TEST_ULP2(4, pow, 0.001f, 16.0f, -2.5f, 2.5f, 16);
+
+    TEST_ULP1(8, exp, -87.0f, 88.0f, 2);
+    TEST_ULP1(8, exp2, -126.0f, 127.0f, 2);
+    TEST_ULP1(8, log, 0.5f, 2.0f, 3);
+    TEST_ULP1(8, log, 1e-30f, 1e30f, 2);
+    TEST_ULP1(8, log2, 0.5f, 2.0f, 4);
+    TEST_ULP1(8, log2, 1e-30f, 1e30f, 2);
+    TEST_ULP1(8, sin, -100.0f, 100.0f, 2);
+    TEST_ULP1(8, cos, -100.0f, 100.0f, 2);
+    TEST_ULP1(8, acos, -1.0f, 1.0f, 2);
+    TEST_ULP2(8, atan2, -10.0f, 10.0f, -10.0f, 10.0f, 4);
+    TEST_ULP2(8, pow, 0.001f, 16.0f, -2.5f, 2.5f, 16);
+
+    std::cout << "OK" << std::endl;
+}
@@ -0,0 +1,80 @@
+#include "test_common.h"
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+#if !defined(__ANDROID__) && !defined(DISABLE_OCL)
+#include "../internal/RendererOCL.h"
+#endif
+
+void test_sort() {
+#if defined(__ANDROID__) || defined(DISABLE_OCL)
+    std::cout << "Skipping OpenCL sort test" << std::endl;
+#else
+    // sort buffers are sized for frame, odd size leaves last tile partially filled
+    const int W = 301, H = 299;
+
+    class TestRenderer : public ray::ocl::Renderer {
+    public:
+        TestRenderer() : ray::ocl::Renderer(W, H) {}
+
+        void Test(bool look_back, const std::vector<uint32_t> &keys) {
+            sort_look_back_ = look_back;
+
+            const cl_int count = (cl_int)keys.size();
+            require(count == w_ * h_);
+
+            std::vector<uint32_t> vals(count);
+            for (cl_int i = 0; i < count; i++) {
+                vals[i] = (uint32_t)i;
+            }
+
+            cl_int error = CL_SUCCESS;
+            cl::Buffer keys_buf(context_, CL_MEM_READ_WRITE, sizeof(uint32_t) * count, nullptr, &error),
+                       keys2_buf(context_, CL_MEM_READ_WRITE, sizeof(uint32_t) * count, nullptr, &error),
+                       vals_buf(context_, CL_MEM_READ_WRITE, sizeof(uint32_t) * count, nullptr, &error),
+                       vals2_buf(context_, CL_MEM_READ_WRITE, sizeof(uint32_t) * count, nullptr, &error);
+            require(error == CL_SUCCESS);
+
+            require(queue_.enqueueWriteBuffer(keys_buf, CL_TRUE, 0, sizeof(uint32_t) * count, &keys[0]) == CL_SUCCESS);
+            require(queue_.enqueueWriteBuffer(vals_buf, CL_TRUE, 0, sizeof(uint32_t) * count, &vals[0]) == CL_SUCCESS);
+
+            require(PerformRadixSort(keys_buf, vals_buf, count, keys2_buf, vals2_buf,
+                                     sort_histogram_buf_, sort_tile_counters_buf_, sort_tile_status_buf_));
+
+            std::vector<uint32_t> sorted_keys(count), sorted_vals(count);
+            require(queue_.enqueueReadBuffer(keys_buf, CL_TRUE, 0, sizeof(uint32_t) * count, &sorted_keys[0]) == CL_SUCCESS);
+            require(queue_.enqueueReadBuffer(vals_buf, CL_TRUE, 0, sizeof(uint32_t) * count, &sorted_vals[0]) == CL_SUCCESS);
+
+            std::vector<uint32_t> expected = keys;
+            std::sort(expected.begin(), expected.end());
+            require(sorted_keys == expected);
+
+            // values follow their keys, order of equal keys is preserved
+            for (cl_int i = 0; i < count; i++) {
+                require(keys[sorted_vals[i]] == sorted_keys[i]);
+                if (i > 0 && sorted_keys[i - 1] == sorted_keys[i]) {
+                    require(sorted_vals[i - 1] < sorted_vals[i]);
+                }
+            }
+        }
+    };
+
+    std::vector<uint32_t> keys(W * H);
+    uint32_t rnd = 1;
+    for (size_t i = 0; i < keys.size(); i++) {
+        rnd = rnd * 1664525u + 1013904223u;
+        // half of keys use narrow range to get many duplicates
+        keys[i] = (i % 2) ? rnd : (rnd >> 20);
+    }
+
+    try {
+        TestRenderer r;
+        r.Test(true, keys);
+        r.Test(false, keys);
+    } catch (std::runtime_error &) {
+        std::cout << "Cannot test OCL backend" << std::endl;
+    }
+#endif
+}
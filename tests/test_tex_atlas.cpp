@@ -0,0 +1,257 @@
+#include "test_common.h"
+
+#include <cmath>
+#include <vector>
+
+#include "../internal/CoreRef.h"
+#include "../internal/TextureAtlasRef.h"
+#include "../internal/TexturePacker.h"
+#include "../internal/TextureSplitter.h"
+#include "../internal/TextureUtilsRef.h"
+
+namespace {
+/// Places textures the way atlas does (first page that fits, new page otherwise), returns occupancy of used pages
+template <typename Packer>
+double PackTextures(const std::vector<std::pair<int, int>> &sizes, const int page_res[2]) {
+    std::vector<Packer> pages;
+    long long used_texels = 0;
+
+    for (const auto &sz : sizes) {
+        const int res[2] = { sz.first, sz.second };
+        int pos[2];
+
+        size_t page = 0;
+        for (; page < pages.size(); page++) {
+            if (pages[page].Allocate(res, pos) != -1) break;
+        }
+        if (page == pages.size()) {
+            pages.emplace_back(page_res);
+            require(pages.back().Allocate(res, pos) != -1);
+        }
+
+        used_texels += (long long)res[0] * res[1];
+    }
+
+    return double(used_texels) / (double(pages.size()) * page_res[0] * page_res[1]);
+}
+}
+
+void test_tex_atlas() {
+    const int res[2] = { 32, 16 };
+
+    std::vector<ray::pixel_color8_t> tex(res[0] * res[1]);
+    for (int y = 0; y < res[1]; y++) {
+        for (int x = 0; x < res[0]; x++) {
+            // color varies along single axis, which is representable by block palette
+            const uint8_t v = uint8_t(4 * (x + y));
+            tex[y * res[0] + x] = { v, uint8_t(v / 2), uint8_t(255 - v), uint8_t(255 - x * 4) };
+        }
+    }
+
+    const ray::eTexCompression formats[] = { ray::TexCompressionNone, ray::TexCompressionBC1, ray::TexCompressionBC3 };
+    const int tolerance[] = { 0, 8, 8 };
+
+    for (int f = 0; f < 3; f++) {
+        ray::ref::TextureAtlas atlas(64, 64, 1, formats[f]);
+
+        int pos[2];
+        const int page = atlas.Allocate(&tex[0], res, pos);
+        require(page == 0);
+        if (formats[f] != ray::TexCompressionNone) {
+            require((pos[0] + 1) % 4 == 0 && (pos[1] + 1) % 4 == 0);
+        }
+
+        for (int y = 0; y < res[1]; y++) {
+            for (int x = 0; x < res[0]; x++) {
+                const auto &expected = tex[y * res[0] + x];
+                const auto col = atlas.Get(page, pos[0] + 1 + x, pos[1] + 1 + y);
+
+                require(std::abs(col.r - expected.r) <= tolerance[f]);
+                require(std::abs(col.g - expected.g) <= tolerance[f]);
+                require(std::abs(col.b - expected.b) <= tolerance[f]);
+                if (formats[f] == ray::TexCompressionBC1) {
+                    require(col.a == 255);
+                } else {
+                    require(std::abs(col.a - expected.a) <= tolerance[f]);
+                }
+
+                // 2x2 fetch should match single texel fetches
+                ray::pixel_color8_t quad[4];
+                atlas.Get2x2(page, pos[0] + x, pos[1] + y, quad);
+                const ray::pixel_color8_t p00 = atlas.Get(page, pos[0] + x, pos[1] + y),
+                                          p11 = atlas.Get(page, pos[0] + x + 1, pos[1] + y + 1);
+                require(quad[0].r == p00.r && quad[0].g == p00.g && quad[0].b == p00.b && quad[0].a == p00.a);
+                require(quad[3].r == p11.r && quad[3].g == p11.g && quad[3].b == p11.b && quad[3].a == p11.a);
+            }
+        }
+    }
+
+    {   // freed space is reused, regions can be moved to lower pages
+        const int small_res[2] = { 24, 24 };
+
+        for (int f = 0; f < 2; f++) {
+            ray::ref::TextureAtlas atlas(64, 64, 2, formats[f]);
+
+            std::vector<ray::pixel_color8_t> data[5];
+            int pages[5], pos[5][2];
+            for (int i = 0; i < 5; i++) {
+                data[i].resize(small_res[0] * small_res[1], { uint8_t(40 * i), uint8_t(255 - 40 * i), 0, 255 });
+                pages[i] = atlas.Allocate(&data[i][0], small_res, pos[i]);
+            }
+
+            // page fits 4 textures
+            require(pages[0] == 0 && pages[3] == 0 && pages[4] == 1);
+            require(atlas.used_pages_count() == 2);
+
+            require(atlas.Free(pages[1], pos[1]));
+            require(!atlas.Free(pages[1], pos[1]));
+
+            int new_pos[2];
+            require(atlas.Move(pages[4], pos[4], 1, new_pos) == 0);
+            require(atlas.used_pages_count() == 1);
+
+            for (int y = 0; y < small_res[1]; y++) {
+                for (int x = 0; x < small_res[0]; x++) {
+                    const auto col = atlas.Get(0, new_pos[0] + 1 + x, new_pos[1] + 1 + y);
+                    require(std::abs(col.r - data[4][0].r) <= tolerance[f]);
+                    require(std::abs(col.g - data[4][0].g) <= tolerance[f]);
+                }
+            }
+
+            // nothing fits anymore without growing
+            require(atlas.Move(0, new_pos, 0, new_pos) == -1);
+            require(atlas.Allocate(&data[0][0], small_res, pos[0]) == 1);
+        }
+    }
+
+    {   // packer regions never overlap and merge back on free
+        const int page_res[2] = { 256, 256 };
+        ray::TexturePacker packer(page_res);
+
+        std::vector<int> owner(page_res[0] * page_res[1], -1);
+        std::vector<std::pair<int, int>> allocated;
+
+        uint32_t rnd = 1;
+        for (int i = 0; i < 200; i++) {
+            rnd = rnd * 1664525u + 1013904223u;
+            const int res[2] = { 2 + int((rnd >> 8) % 30), 2 + int((rnd >> 16) % 30) };
+
+            int pos[2];
+            if (packer.Allocate(res, pos) == -1) continue;
+
+            for (int y = pos[1]; y < pos[1] + res[1]; y++) {
+                for (int x = pos[0]; x < pos[0] + res[0]; x++) {
+                    require(owner[y * page_res[0] + x] == -1);
+                    owner[y * page_res[0] + x] = i;
+                }
+            }
+            allocated.emplace_back(pos[0], pos[1]);
+
+            int size[2];
+            require(packer.FindNode(pos, size) != -1);
+            require(size[0] == res[0] && size[1] == res[1]);
+        }
+        require(!packer.empty());
+
+        for (const auto &p : allocated) {
+            const int pos[2] = { p.first, p.second };
+            require(packer.Free(pos));
+            require(!packer.Free(pos));
+        }
+        require(packer.empty());
+
+        // whole page is available again
+        int pos[2];
+        require(packer.Allocate(page_res, pos) != -1);
+    }
+
+    {   // packer fills pages at least as densely as splitter it replaced
+        std::vector<std::pair<int, int>> sizes;
+
+        uint32_t rnd = 12345;
+        for (int i = 0; i < 2000; i++) {
+            rnd = rnd * 1664525u + 1013904223u;
+            const int size = 4 << ((rnd >> 8) % 5);
+            const int aspect = (rnd >> 16) % 3;
+            const bool flip = ((rnd >> 20) & 1) != 0;
+
+            // 1px border included
+            const int w = size + 2, h = (size >> aspect) + 2;
+            sizes.emplace_back(flip ? h : w, flip ? w : h);
+        }
+
+        const int page_res[2] = { 256, 256 };
+        require(PackTextures<ray::TexturePacker>(sizes, page_res) >= PackTextures<ray::TextureSplitter>(sizes, page_res));
+    }
+
+    {   // fitting leaf is found even if many smaller leaves of the same size class were freed after it
+        const int BlocksCount = 80;
+        const int page_res[2] = { 15 + BlocksCount * 8, 8 }, wide_res[2] = { 15, 8 }, block_res[2] = { 8, 8 };
+        ray::TexturePacker packer(page_res);
+
+        int wide_pos[2], block_pos[BlocksCount][2];
+        require(packer.Allocate(wide_res, wide_pos) != -1);
+        for (int i = 0; i < BlocksCount; i++) {
+            require(packer.Allocate(block_res, block_pos[i]) != -1);
+        }
+
+        require(packer.Free(wide_pos));
+        for (int i = 1; i < BlocksCount; i += 2) {
+            require(packer.Free(block_pos[i]));
+        }
+
+        const int res[2] = { 12, 8 };
+        int pos[2];
+        require(packer.Allocate(res, pos) != -1);
+        require(pos[0] == wide_pos[0] && pos[1] == wide_pos[1]);
+    }
+
+    {   // bilinear sampling of tiled page matches filtering of linear texture data
+        const int TexRes = 64;
+
+        std::vector<ray::pixel_color8_t> tex(TexRes * TexRes);
+        for (int y = 0; y < TexRes; y++) {
+            for (int x = 0; x < TexRes; x++) {
+                tex[y * TexRes + x] = { uint8_t(4 * x), uint8_t(4 * y), uint8_t(4 * (x ^ y)), 255 };
+            }
+        }
+
+        ray::ref::TextureAtlas atlas(256, 256, 1);
+
+        const int tex_res[2] = { TexRes, TexRes };
+        ray::texture_t t;
+        require(ray::ref::AllocateTextureMips(atlas, &tex[0], tex_res, true, t));
+
+        uint32_t rnd = 54321;
+        for (int i = 0; i < 1000; i++) {
+            rnd = rnd * 1664525u + 1013904223u;
+            const float u = float(rnd >> 8) / (1 << 24);
+            rnd = rnd * 1664525u + 1013904223u;
+            const float v = float(rnd >> 8) / (1 << 24);
+
+            const auto col = ray::ref::SampleBilinear(atlas, t, ray::ref::simd_fvec2{ u, v }, 0);
+
+            // texture wraps around
+            const float fx = u * TexRes - 0.5f, fy = v * TexRes - 0.5f;
+            const int x0 = int(std::floor(fx)), y0 = int(std::floor(fy));
+            const float kx = fx - x0, ky = fy - y0;
+
+            const auto &p00 = tex[((y0 + TexRes) % TexRes) * TexRes + (x0 + TexRes) % TexRes],
+                       &p01 = tex[((y0 + TexRes) % TexRes) * TexRes + (x0 + 1) % TexRes],
+                       &p10 = tex[((y0 + 1) % TexRes) * TexRes + (x0 + TexRes) % TexRes],
+                       &p11 = tex[((y0 + 1) % TexRes) * TexRes + (x0 + 1) % TexRes];
+
+            const float expected[3] = { ((p00.r * (1 - kx) + p01.r * kx) * (1 - ky) + (p10.r * (1 - kx) + p11.r * kx) * ky) / 255.0f,
+                                        ((p00.g * (1 - kx) + p01.g * kx) * (1 - ky) + (p10.g * (1 - kx) + p11.g * kx) * ky) / 255.0f,
+                                        ((p00.b * (1 - kx) + p01.b * kx) * (1 - ky) + (p10.b * (1 - kx) + p11.b * kx) * ky) / 255.0f };
+
+            require(std::abs(col[0] - expected[0]) < 0.01f);
+            require(std::abs(col[1] - expected[1]) < 0.01f);
+            require(std::abs(col[2] - expected[2]) < 0.01f);
+        }
+
+        // single tap filters pick level from the longer axis of footprint
+        const float duv_dx[2] = { 4.0f / TexRes, 0.0f }, duv_dy[2] = { 0.0f, 1.0f / TexRes };
+        require(std::abs(ray::IsotropicTextureLod(t, duv_dx, duv_dy) - 2.0f) < 0.001f);
+    }
+}
@@ -0,0 +1,134 @@
+#include "test_common.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#include <vector>
+
+#include "../internal/SceneRef.h"
+#include "../internal/TextureAtlasRef.h"
+#include "../internal/TextureUtilsRef.h"
+
+namespace {
+class TestScene : public ray::ref::Scene {
+public:
+    using ray::ref::Scene::textures_;
+};
+}
+
+void test_tex_mips() {
+    {   // vectorized rows match scalar rounding, odd sizes drop last column and row
+        const int sizes[][2] = { { 64, 64 }, { 37, 9 }, { 18, 2 }, { 3, 3 } };
+        for (const auto &res : sizes) {
+            std::vector<ray::pixel_color8_t> tex(res[0] * res[1]);
+            for (auto &t : tex) {
+                t = { uint8_t(rand()), uint8_t(rand()), uint8_t(rand()), uint8_t(rand()) };
+            }
+
+            const auto down = ray::ref::DownsampleTexture(tex, res);
+            require(down.size() == size_t((res[0] / 2) * (res[1] / 2)));
+
+            for (int y = 0; y < res[1] / 2; y++) {
+                for (int x = 0; x < res[0] / 2; x++) {
+                    const uint8_t *t00 = &tex[(2 * y) * res[0] + 2 * x].r, *t01 = &tex[(2 * y) * res[0] + 2 * x + 1].r,
+                                  *t10 = &tex[(2 * y + 1) * res[0] + 2 * x].r, *t11 = &tex[(2 * y + 1) * res[0] + 2 * x + 1].r;
+                    const uint8_t *out = &down[y * (res[0] / 2) + x].r;
+                    for (int c = 0; c < 4; c++) {
+                        require(out[c] == uint8_t(std::round((t00[c] + t01[c] + t10[c] + t11[c]) * 0.25f)));
+                    }
+                }
+            }
+        }
+    }
+
+    {   // mip chain stops at single texel row
+        std::vector<ray::pixel_color8_t> tex(16 * 4, { 255, 0, 0, 255 });
+        ray::tex_desc_t t = {};
+        t.data = &tex[0];
+        t.w = 16;
+        t.h = 4;
+        t.generate_mipmaps = true;
+
+        ray::ref::mip_chain_t chain;
+        ray::ref::GenerateMipChain(t, chain);
+        require(chain.count == 3);
+        require(chain.res[2][0] == 4 && chain.res[2][1] == 1);
+        require(chain.data.size() == 16 * 4 + 8 * 2 + 4 * 1);
+        require(chain.data.back().r == 255);
+    }
+
+    {   // batch gives same result as textures added one by one
+        std::vector<ray::pixel_color8_t> data[8];
+        ray::tex_desc_t textures[8] = {};
+        for (int i = 0; i < 8; i++) {
+            data[i].resize((16 << i) * 16, { uint8_t(30 * i), 0, 0, 255 });
+            textures[i].data = &data[i][0];
+            textures[i].w = 16 << i;
+            textures[i].h = 16;
+            textures[i].generate_mipmaps = true;
+        }
+
+        TestScene scene1, scene2;
+
+        uint32_t indices[8];
+        scene1.AddTextures(textures, 8, indices);
+        for (int i = 0; i < 8; i++) {
+            require(scene2.AddTexture(textures[i]) == indices[i]);
+        }
+
+        require(scene1.textures_.size() == scene2.textures_.size());
+        for (size_t i = 0; i < scene1.textures_.size(); i++) {
+            require(memcmp(&scene1.textures_[i], &scene2.textures_[i], sizeof(ray::texture_t)) == 0);
+        }
+    }
+
+    {   // texture placed directly from caller's data matches one placed from mip chain, border included
+        const int res[2] = { 20, 12 };
+        std::vector<ray::pixel_color8_t> tex(res[0] * res[1]);
+        for (auto &t : tex) {
+            t = { uint8_t(rand()), uint8_t(rand()), uint8_t(rand()), uint8_t(rand()) };
+        }
+
+        ray::tex_desc_t t = {};
+        t.data = &tex[0];
+        t.w = res[0];
+        t.h = res[1];
+        t.generate_mipmaps = true;
+
+        ray::ref::mip_chain_t chain;
+        ray::ref::GenerateMipChain(t, chain);
+
+        const ray::eTexCompression formats[] = { ray::TexCompressionNone, ray::TexCompressionBC1 };
+        for (const auto f : formats) {
+            ray::ref::TextureAtlas atlas1(64, 64, 1, f), atlas2(64, 64, 1, f);
+
+            ray::texture_t t1, t2;
+            require(ray::ref::AllocateTextureMips(atlas1, chain, t1));
+            require(ray::ref::AllocateTextureMips(atlas2, &tex[0], res, true, t2));
+            require(memcmp(&t1, &t2, sizeof(ray::texture_t)) == 0);
+
+            for (int mip = 0; mip < chain.count; mip++) {
+                for (int y = -1; y <= chain.res[mip][1]; y++) {
+                    for (int x = -1; x <= chain.res[mip][0]; x++) {
+                        const auto c1 = atlas1.Get(t1.page[mip], t1.pos[mip][0] + 1 + x, t1.pos[mip][1] + 1 + y),
+                                   c2 = atlas2.Get(t2.page[mip], t2.pos[mip][0] + 1 + x, t2.pos[mip][1] + 1 + y);
+                        require(c1.r == c2.r && c1.g == c2.g && c1.b == c2.b && c1.a == c2.a);
+                    }
+                }
+            }
+
+            if (f == ray::TexCompressionNone) {
+                // border wraps around
+                for (int y = 0; y < res[1]; y++) {
+                    const auto left = atlas2.Get(t2.page[0], t2.pos[0][0], t2.pos[0][1] + 1 + y),
+                               right = atlas2.Get(t2.page[0], t2.pos[0][0] + res[0] + 1, t2.pos[0][1] + 1 + y);
+                    require(left.r == tex[y * res[0] + res[0] - 1].r && left.a == tex[y * res[0] + res[0] - 1].a);
+                    require(right.r == tex[y * res[0]].r && right.a == tex[y * res[0]].a);
+                }
+                const auto corner = atlas2.Get(t2.page[0], t2.pos[0][0], t2.pos[0][1]);
+                require(corner.g == tex.back().g);
+            }
+        }
+    }
+}
@@ -0,0 +1,135 @@
+#include "test_common.h"
+
+#include <vector>
+
+#include "../internal/SceneRef.h"
+
+namespace {
+struct loader_t {
+    int loads[ray::NUM_MIP_LEVELS] = {};
+};
+
+void LoadMip(void *userdata, int mip_level, int w, int h, ray::pixel_color8_t *out_data) {
+    auto *loader = reinterpret_cast<loader_t *>(userdata);
+    loader->loads[mip_level]++;
+
+    // each level has its own color to know which one is resident
+    for (int i = 0; i < w * h; i++) {
+        out_data[i] = { uint8_t(mip_level * 20), 0, 0, 255 };
+    }
+}
+
+class TestScene : public ray::ref::Scene {
+public:
+    const ray::texture_t &texture(uint32_t i) const { return textures_[i]; }
+    const ray::ref::TextureAtlas &atlas() const { return texture_atlas_; }
+
+    void Request(uint32_t i, int8_t lod) {
+        std::vector<int8_t> requests(textures_.size(), ray::TexNotRequested);
+        requests[i] = lod;
+        RequestTextures(&requests[0]);
+    }
+};
+}
+
+void test_tex_streaming() {
+    TestScene scene;
+
+    loader_t loader1, loader2;
+
+    ray::tex_desc_t t = {};
+    t.data = nullptr;
+    t.w = t.h = 512;
+    t.generate_mipmaps = true;
+    t.load_func = LoadMip;
+
+    t.load_userdata = &loader1;
+    const uint32_t tex1 = scene.AddTexture(t);
+    t.load_userdata = &loader2;
+    const uint32_t tex2 = scene.AddTexture(t);
+
+    // only levels not larger than 64x64 are loaded upfront
+    require(loader1.loads[0] == 0 && loader1.loads[2] == 0);
+    require(loader1.loads[3] == 1 && loader1.loads[9] == 1);
+    require(scene.texture(tex1).size[0] == 64);
+
+    // nothing is requested, nothing changes
+    scene.UpdateTextureResidency();
+    require(scene.texture(tex1).size[0] == 64);
+
+    // enough for finer levels of only one texture
+    scene.SetTextureCacheSize(3 * 512 * 512 / 2 * sizeof(ray::pixel_color8_t));
+
+    scene.Request(tex1, -ray::NUM_MIP_LEVELS);
+    scene.UpdateTextureResidency();
+    require(scene.texture(tex1).size[0] == 512);
+    require(loader1.loads[0] == 1);
+
+    {   // view starts from full resolution level
+        const auto &view = scene.texture(tex1);
+        const auto col = scene.atlas().Get(view.page[0], view.pos[0][0] + 1, view.pos[0][1] + 1);
+        require(col.r == 0);
+        const auto col2 = scene.atlas().Get(view.page[3], view.pos[3][0] + 1, view.pos[3][1] + 1);
+        require(col2.r == 60);
+    }
+
+    // request is relative to the finest resident level
+    scene.Request(tex2, -1);
+    scene.UpdateTextureResidency();
+    require(scene.texture(tex2).size[0] == 128);
+    require(scene.texture(tex1).size[0] == 512);
+
+    // unused texture gives up its finest levels until budget fits
+    scene.Request(tex2, -ray::NUM_MIP_LEVELS);
+    scene.UpdateTextureResidency();
+    require(scene.texture(tex2).size[0] == 512);
+    require(scene.texture(tex1).size[0] == 128);
+
+    {   // evicted texture falls back to coarser level
+        const auto &view = scene.texture(tex1);
+        const auto col = scene.atlas().Get(view.page[0], view.pos[0][0] + 1, view.pos[0][1] + 1);
+        require(col.r == 40);
+    }
+
+    // removed slots are reused
+    scene.RemoveTexture(tex1);
+    require(scene.texture(tex1).size[0] == 0);
+    t.load_userdata = &loader1;
+    require(scene.AddTexture(t) == tex1);
+    require(scene.texture(tex1).size[0] == 64);
+}
+
+void test_tex_compaction() {
+    TestScene scene;
+
+    // textures do not fit on the same page
+    std::vector<ray::pixel_color8_t> data(2100 * 2100, { 255, 0, 0, 255 });
+
+    ray::tex_desc_t t = {};
+    t.data = &data[0];
+    t.w = t.h = 2100;
+    t.generate_mipmaps = false;
+
+    uint32_t textures[3];
+    for (int i = 0; i < 3; i++) {
+        textures[i] = scene.AddTexture(t);
+    }
+    require(scene.atlas().used_pages_count() == 3);
+
+    scene.RemoveTexture(textures[0]);
+    scene.RemoveTexture(textures[2]);
+    require(scene.atlas().used_pages_count() == 2);
+
+    // budget smaller than texture stops compaction
+    require(!scene.CompactTextures(1000));
+    require(scene.texture(textures[1]).page[0] == 1);
+
+    require(scene.CompactTextures(SIZE_MAX));
+    require(scene.atlas().used_pages_count() == 1);
+    require(scene.atlas().pages_count() == 1);
+
+    const auto &view = scene.texture(textures[1]);
+    require(view.page[0] == 0 && view.page[ray::NUM_MIP_LEVELS - 1] == 0);
+    const auto col = scene.atlas().Get(view.page[0], view.pos[0][0] + 1000, view.pos[0][1] + 1000);
+    require(col.r == 255 && col.g == 0);
+}
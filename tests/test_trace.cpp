@@ -0,0 +1,75 @@
+#include "test_common.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../Trace.h"
+#include "../internal/Trace.h"
+
+void test_trace() {
+    using namespace ray;
+
+    std::stringstream ss;
+
+    if (!TracingSupported()) {
+        std::cout << "Cannot test tracing (ENABLE_TRACING is off)" << std::endl;
+        require(!DumpTrace(ss));
+        return;
+    }
+
+#if defined(ENABLE_TRACING)
+    ClearTrace();
+
+    {
+        TRACE_SCOPE("test_trace_scope", rect_t{ 1, 2, 3, 4 });
+    }
+
+    std::thread([]() {
+        TRACE_SCOPE("test_trace_thread");
+    }).join();
+
+    const int track = trace::RegisterTrack("test \"track\"");
+    const uint64_t t = trace::Now();
+    trace::AddTrackEvent(track, "test_trace_track_event", t, t + 1500);
+
+    require(DumpTrace(ss));
+    std::string json = ss.str();
+
+    require(json.find("\"name\":\"test_trace_scope\",\"cat\":\"ray\",\"ph\":\"B\"") != std::string::npos);
+    require(json.find("\"name\":\"test_trace_scope\",\"cat\":\"ray\",\"ph\":\"E\"") != std::string::npos);
+    require(json.find("\"args\":{\"x\":1,\"y\":2,\"w\":3,\"h\":4}") != std::string::npos);
+    require(json.find("\"test_trace_thread\"") != std::string::npos);
+    require(json.find("\"test \\\"track\\\"\"") != std::string::npos);
+    require(json.find("\"dur\":1.500") != std::string::npos);
+
+    {   // every object is closed
+        int depth = 0;
+        for (char c : json) {
+            if (c == '{' || c == '[') depth++;
+            else if (c == '}' || c == ']') depth--;
+            require(depth >= 0);
+        }
+        require(depth == 0);
+    }
+
+    {   // ring buffer keeps only the latest events of thread
+        for (int i = 0; i < trace::TraceBufferSize; i++) {
+            TRACE_SCOPE("test_trace_overflow");
+        }
+
+        ss.str("");
+        require(DumpTrace(ss));
+        json = ss.str();
+
+        require(json.find("\"test_trace_scope\"") == std::string::npos);
+        require(json.find("\"test_trace_thread\"") != std::string::npos);
+    }
+
+    ClearTrace();
+    ss.str("");
+    require(DumpTrace(ss));
+    require(ss.str().find("\"test_trace_thread\"") == std::string::npos);
+#endif
+}
@@ -0,0 +1,132 @@
+#include "test_common.h"
+
+#include <iostream>
+#include <vector>
+
+#include "../internal/BVHSplit.h"
+#include "../internal/Core.h"
+#include "../internal/simd/detect.h"
+
+namespace {
+/// Acceleration structures of one mesh instance, laid out the way scene stores them
+struct traverse_scene_t {
+    std::vector<ray::bvh_node_t> nodes;
+    std::vector<ray::tri_accel_t> tris;
+    std::vector<uint32_t> tri_indices, mi_indices;
+    std::vector<ray::mesh_t> meshes;
+    std::vector<ray::mesh_instance_t> mesh_instances;
+    std::vector<ray::transform_t> transforms;
+    uint32_t macro_tree_root;
+};
+
+float RandomFloat(uint32_t &rnd) {
+    rnd = rnd * 1664525u + 1013904223u;
+    return float(rnd >> 8) / (1 << 24);
+}
+}
+
+#if !defined(__ANDROID__)
+#include "../internal/RendererSSE.h"
+#include "../internal/RendererAVX.h"
+#include "../internal/RendererAVX2.h"
+#include "../internal/RendererAVX16.h"
+
+#define NS sse
+#include "test_traverse.ipp"
+#undef NS
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx")
+#endif
+#define NS avx
+#include "test_traverse.ipp"
+#undef NS
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push (__attribute__((target("avx2,fma"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target ("avx2,fma")
+#endif
+#define NS avx2
+#include "test_traverse.ipp"
+#undef NS
+#define NS avx16
+#include "test_traverse.ipp"
+#undef NS
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+#endif
+
+void test_traverse() {
+    using namespace ray;
+
+    traverse_scene_t s;
+
+    {   // triangle soup, leaves of its tree hold several overlapping triangles
+        uint32_t rnd = 12345;
+
+        std::vector<float> attrs;
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < 256 * 3; i++) {
+            const float p[3] = { RandomFloat(rnd), RandomFloat(rnd), RandomFloat(rnd) };
+            // triangles are kept small, so that some rays miss everything
+            for (int j = 0; j < 3; j++) {
+                const float v = (i % 3) ? attrs[(i - i % 3) * 8 + j] + 0.8f * (p[j] - 0.5f) : 2.0f * p[j] - 1.0f;
+                attrs.push_back(v);
+            }
+            attrs.insert(attrs.end(), { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f });
+            indices.push_back(i);
+        }
+
+        const uint32_t node_count = PreprocessMesh(&attrs[0], indices.size(), &indices[0], indices.size(), PxyzNxyzTuv, s.nodes, s.tris, s.tri_indices);
+
+        const bvh_node_t &root = s.nodes[0];
+        s.meshes.push_back({ 0, node_count });
+        s.mesh_instances.push_back({ { root.bbox[0][0], root.bbox[0][1], root.bbox[0][2] }, 0,
+                                     { root.bbox[1][0], root.bbox[1][1], root.bbox[1][2] }, 0 });
+
+        transform_t tr = {};
+        tr.xform[0] = tr.xform[5] = tr.xform[10] = tr.xform[15] = 1.0f;
+        tr.inv_xform[0] = tr.inv_xform[5] = tr.inv_xform[10] = tr.inv_xform[15] = 1.0f;
+        s.transforms.push_back(tr);
+
+        prim_t prim = { ref::simd_fvec3{ root.bbox[0] }, ref::simd_fvec3{ root.bbox[1] } };
+        s.macro_tree_root = (uint32_t)s.nodes.size();
+        PreprocessPrims(&prim, 1, s.nodes, s.mi_indices);
+    }
+
+#if !defined(__ANDROID__)
+    const auto features = GetCpuFeatures();
+
+    if (features.sse2_supported) {
+        sse::TestTraverse(s);
+    } else {
+        std::cout << "Cannot test SSE" << std::endl;
+    }
+
+    if (features.avx_supported) {
+        avx::TestTraverse(s);
+    } else {
+        std::cout << "Cannot test AVX" << std::endl;
+    }
+
+    if (features.avx2_supported && features.fma_supported) {
+        avx2::TestTraverse(s);
+        avx16::TestTraverse(s);
+    } else {
+        std::cout << "Cannot test AVX2" << std::endl;
+    }
+#endif
+}
@@ -0,0 +1,54 @@
+// Included with NS defined, renderer header of backend must be included before
+
+namespace ray {
+namespace NS {
+/// Traces packets with all rays active, then each ray alone, which takes single-ray path of traversal
+void TestTraverse(const traverse_scene_t &s) {
+    const int S = RayPacketSize;
+
+    uint32_t rnd = 54321;
+    int hits = 0;
+
+    for (int n = 0; n < 256; n++) {
+        ray_packet_t<S> r;
+        for (int j = 0; j < S; j++) {
+            r.o[0][j] = 6.0f * RandomFloat(rnd) - 3.0f;
+            r.o[1][j] = 6.0f * RandomFloat(rnd) - 3.0f;
+            r.o[2][j] = 6.0f * RandomFloat(rnd) - 3.0f;
+            // rays point roughly into the middle of soup
+            const float d[3] = { RandomFloat(rnd) - 0.5f - r.o[0][j], RandomFloat(rnd) - 0.5f - r.o[1][j], RandomFloat(rnd) - 0.5f - r.o[2][j] };
+            const float l = std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+            r.d[0][j] = d[0] / l;
+            r.d[1][j] = d[1] / l;
+            r.d[2][j] = d[2] / l;
+        }
+
+        hit_data_t<S> packet_inter;
+        Traverse_MacroTree_CPU(r, { -1 }, &s.nodes[0], s.macro_tree_root, &s.mesh_instances[0], &s.mi_indices[0], &s.meshes[0],
+                               &s.transforms[0], &s.tris[0], &s.tri_indices[0], packet_inter);
+
+        for (int j = 0; j < S; j++) {
+            simd_ivec<S> mask = { 0 };
+            mask[j] = -1;
+
+            hit_data_t<S> single_inter;
+            Traverse_MacroTree_CPU(r, mask, &s.nodes[0], s.macro_tree_root, &s.mesh_instances[0], &s.mi_indices[0], &s.meshes[0],
+                                   &s.transforms[0], &s.tris[0], &s.tri_indices[0], single_inter);
+
+            require(single_inter.mask[j] == packet_inter.mask[j]);
+            if (!packet_inter.mask[j]) continue;
+
+            require(single_inter.obj_index[j] == packet_inter.obj_index[j]);
+            require(single_inter.prim_index[j] == packet_inter.prim_index[j]);
+            require(single_inter.t[j] == Approx(packet_inter.t[j]));
+            require(single_inter.u[j] == Approx(packet_inter.u[j]));
+            require(single_inter.v[j] == Approx(packet_inter.v[j]));
+            hits++;
+        }
+    }
+
+    // both hits and misses are covered
+    require(hits > 256 * S / 4 && hits < 256 * S);
+}
+}
+}